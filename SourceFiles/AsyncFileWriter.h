@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Writes files on a background thread so the threads producing them don't wait for the disk. Every
+// file is written next to its destination and renamed into place, so a file that exists is complete.
+// Writes happen in the order they were queued.
+class AsyncFileWriter
+{
+public:
+    // Write() blocks while more than max_queued_bytes are waiting to be written.
+    explicit AsyncFileWriter(size_t max_queued_bytes = 256 * 1024 * 1024)
+        : m_max_queued_bytes(max_queued_bytes)
+    {
+        m_thread = std::thread(&AsyncFileWriter::WriterLoop, this);
+    }
+
+    ~AsyncFileWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_queue_changed.notify_all();
+        m_thread.join();
+    }
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    // on_written(success) is called on the writer thread once the file is in place (or failed).
+    void Write(std::filesystem::path path, std::vector<uint8_t> data, std::function<void(bool)> on_written = {})
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queue_changed.wait(lock, [&] { return m_queued_bytes == 0 || m_queued_bytes + data.size() <= m_max_queued_bytes; });
+        m_queued_bytes += data.size();
+        m_jobs.push_back({ std::move(path), std::move(data), std::move(on_written) });
+        lock.unlock();
+        m_queue_changed.notify_all();
+    }
+
+    // Blocks until every queued file has been written.
+    void Flush()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_queue_changed.wait(lock, [this] { return m_jobs.empty() && !m_writing; });
+    }
+
+    int GetNumFailed() const { return m_num_failed; }
+
+private:
+    struct Job
+    {
+        std::filesystem::path path;
+        std::vector<uint8_t> data;
+        std::function<void(bool)> on_written;
+    };
+
+    static bool WriteFile(const std::filesystem::path& path, const std::vector<uint8_t>& data)
+    {
+        std::filesystem::path temp_path = path;
+        temp_path += L".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(data.data()), data.size());
+            if (!file)
+            {
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, path, error);
+        return !error;
+    }
+
+    void WriterLoop()
+    {
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_queue_changed.wait(lock, [this] { return !m_jobs.empty() || m_stopping; });
+                if (m_jobs.empty())
+                {
+                    return;
+                }
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+                m_writing = true;
+            }
+
+            const bool success = WriteFile(job.path, job.data);
+            if (!success)
+            {
+                m_num_failed++;
+            }
+            if (job.on_written)
+            {
+                job.on_written(success);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queued_bytes -= job.data.size();
+                m_writing = false;
+            }
+            m_queue_changed.notify_all();
+        }
+    }
+
+    const size_t m_max_queued_bytes;
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+    std::condition_variable m_queue_changed;
+    std::deque<Job> m_jobs;
+    size_t m_queued_bytes = 0;
+    bool m_writing = false;
+    bool m_stopping = false;
+    std::atomic<int> m_num_failed{ 0 };
+};
@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "AtexDecompress.h"
 #include "AtexAsm.h"
+#include <algorithm>
+#include <bit>
+#include <emmintrin.h>
 
 int ImgFmt(unsigned int Format)
 {
@@ -12,7 +15,7 @@ int ImgFmt(unsigned int Format)
     return ImageFormats[Format];
 }
 
-void AtexDecompress(unsigned int* InputBuffer, unsigned int BufferSize, unsigned int ImageFormat, const SImageDescriptor& ImageDescriptor, unsigned int* OutBuffer)
+void AtexDecompressReference(unsigned int* InputBuffer, unsigned int BufferSize, unsigned int ImageFormat, const SImageDescriptor& ImageDescriptor, unsigned int* OutBuffer)
 {
     unsigned int HeaderSize = 12;
 
@@ -160,4 +163,350 @@ void AtexDecompress(unsigned int* InputBuffer, unsigned int BufferSize, unsigned
     }
 
     delete[] (unsigned char*)DcmpBuffer1;
-}
\ No newline at end of file
+}
+
+namespace
+{
+    // Reads the bitstream MSB first, zeros past its end. The next 64 bits are kept in a window that
+    // is topped up from a 64-bit reserve, which is refilled two words at a time.
+    class AtexBitReader
+    {
+    public:
+        AtexBitReader(const unsigned int* begin, const unsigned int* end)
+            : m_begin(begin)
+            , m_pos(begin)
+            , m_end(end)
+        {
+            unsigned int loaded;
+            m_window = load(loaded);
+            m_reserve = load(m_reserve_bits);
+        }
+
+        // n must be in [1, 32].
+        unsigned int peek(unsigned int n) const { return static_cast<unsigned int>(m_window >> (64 - n)); }
+
+        void skip(unsigned int n)
+        {
+            m_consumed += n;
+            m_window = (m_window << n) | (m_reserve >> (64 - n));
+            if (n <= m_reserve_bits)
+            {
+                m_reserve <<= n;
+                m_reserve_bits -= n;
+                return;
+            }
+
+            const unsigned int missing = n - m_reserve_bits;
+            unsigned int loaded;
+            const uint64_t next = load(loaded);
+            m_window |= next >> (64 - missing);
+            m_reserve = next << missing;
+            m_reserve_bits = loaded > missing ? loaded - missing : 0;
+        }
+
+        unsigned int read(unsigned int n)
+        {
+            const unsigned int value = peek(n);
+            skip(n);
+            return value;
+        }
+
+        // Where SImageData::DataPos ends up after reading the same bits: one word ahead of the
+        // one holding the next unread bit, since the original keeps 32 bits loaded.
+        const unsigned int* data_pos() const
+        {
+            const size_t words = 1 + (m_consumed + 31) / 32;
+            return m_begin + std::min<size_t>(words, m_end - m_begin);
+        }
+
+    private:
+        uint64_t load(unsigned int& bits)
+        {
+            const auto available = m_end - m_pos;
+            if (available >= 2)
+            {
+                const uint64_t value = static_cast<uint64_t>(m_pos[0]) << 32 | m_pos[1];
+                m_pos += 2;
+                bits = 64;
+                return value;
+            }
+            if (available == 1)
+            {
+                bits = 32;
+                return static_cast<uint64_t>(*m_pos++) << 32;
+            }
+            bits = 0;
+            return 0;
+        }
+
+        const unsigned int* m_begin;
+        const unsigned int* m_pos;
+        const unsigned int* m_end;
+        uint64_t m_window = 0;
+        uint64_t m_reserve = 0; // Left aligned, the bits past m_reserve_bits are zero
+        unsigned int m_reserve_bits = 0;
+        size_t m_consumed = 0;
+    };
+
+    unsigned int read_run_length(AtexBitReader& bits)
+    {
+        const unsigned int code = bits.peek(6);
+        bits.skip(byte_79053C[code * 2]);
+        return byte_79053D[code * 2] + 1;
+    }
+
+    // Walks the next run_length blocks from block that aren't flagged in skip, calling
+    // fill(first, count) for every stretch of consecutive ones, then moves past the flagged
+    // blocks that follow. Returns the index of the block the next run starts at.
+    template <typename Fill>
+    unsigned int take_run(const unsigned int* skip, unsigned int block, unsigned int block_count,
+                          unsigned int run_length, Fill&& fill)
+    {
+        while (block < block_count)
+        {
+            const unsigned int unflagged = ~skip[block >> 5] >> (block & 31);
+            if (! unflagged)
+            {
+                block = (block | 31) + 1;
+                continue;
+            }
+
+            const unsigned int first = block + std::countr_zero(unflagged);
+            if (first >= block_count || ! run_length)
+            {
+                return std::min(first, block_count);
+            }
+
+            const unsigned int count = std::min({static_cast<unsigned int>(std::countr_one(unflagged >> (first - block))),
+                                                 run_length, block_count - first});
+            fill(first, count);
+            run_length -= count;
+            block = first + count;
+        }
+        return block_count;
+    }
+
+    // count blocks starting at first all lie in the same flag word, see take_run.
+    void set_flags(unsigned int* flags, unsigned int first, unsigned int count)
+    {
+        const unsigned int bits = count == 32 ? ~0u : (1u << count) - 1;
+        flags[first >> 5] |= bits << (first & 31);
+    }
+
+    // Writes the same 8 bytes into count blocks. DXT1 blocks are contiguous and get two per store.
+    void fill_blocks(unsigned int* out, unsigned int block_size, unsigned int first, unsigned int count,
+                     unsigned int low, unsigned int high)
+    {
+        unsigned int* dst = out + first * block_size;
+        const __m128i value = _mm_set_epi32(static_cast<int>(high), static_cast<int>(low), static_cast<int>(high),
+                                            static_cast<int>(low));
+        if (block_size == 2)
+        {
+            for (; count >= 2; count -= 2, dst += 4)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+            }
+            if (count)
+            {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), value);
+            }
+            return;
+        }
+
+        for (; count > 0; count--, dst += block_size)
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), value);
+        }
+    }
+
+    struct RunValue
+    {
+        bool fill;
+        unsigned int low, high;
+    };
+
+    // Decodes the (run length, value) codes one of the sub-codes is made of. Runs only cover the
+    // blocks not flagged in skip; blocks of runs that have a value get it written to out and are
+    // flagged in set_a and set_b.
+    template <typename ReadValue>
+    void decode_runs(AtexBitReader& bits, unsigned int* out, unsigned int block_size, unsigned int block_count,
+                     const unsigned int* skip, unsigned int* set_a, unsigned int* set_b, ReadValue&& read_value)
+    {
+        unsigned int block = 0;
+        while (block < block_count)
+        {
+            const unsigned int run_length = read_run_length(bits);
+            const RunValue value = read_value(bits);
+            block = take_run(skip, block, block_count, run_length, [&](unsigned int first, unsigned int count) {
+                if (value.fill)
+                {
+                    fill_blocks(out, block_size, first, count, value.low, value.high);
+                    set_flags(set_a, first, count);
+                    set_flags(set_b, first, count);
+                }
+            });
+        }
+    }
+
+    // DXT3/5 alpha runs: no run, a zero run or a run with the constant read up front.
+    RunValue read_alpha_value(AtexBitReader& bits, unsigned int low, unsigned int high)
+    {
+        if (! bits.read(1))
+        {
+            return {false, 0, 0};
+        }
+        if (! bits.read(1))
+        {
+            return {true, 0, 0};
+        }
+        return {true, low, high};
+    }
+
+    // Copies the data of the blocks that aren't flagged from the stream, Words values per block.
+    template <unsigned int Words>
+    const unsigned int* copy_unflagged(const unsigned int* src, unsigned int* out, unsigned int block_size,
+                                       unsigned int block_count, const unsigned int* flags)
+    {
+        for (unsigned int block = 0; block < block_count; block += 32)
+        {
+            unsigned int todo = ~flags[block >> 5];
+            if (block_count - block < 32)
+            {
+                todo &= (1u << (block_count - block)) - 1;
+            }
+
+            if (todo == ~0u)
+            {
+                unsigned int* dst = out + block * block_size;
+                for (unsigned int x = 0; x < 32; x++, dst += block_size, src += Words)
+                {
+                    memcpy(dst, src, Words * sizeof(unsigned int));
+                }
+                continue;
+            }
+
+            while (todo)
+            {
+                unsigned int* dst = out + (block + std::countr_zero(todo)) * block_size;
+                todo &= todo - 1;
+                memcpy(dst, src, Words * sizeof(unsigned int));
+                src += Words;
+            }
+        }
+        return src;
+    }
+} // namespace
+
+void AtexDecompress(const unsigned int* InputBuffer, unsigned int BufferSize, unsigned int ImageFormat,
+                    const SImageDescriptor& ImageDescriptor, unsigned int* OutBuffer, AtexScratch& Scratch)
+{
+    unsigned int HeaderSize = 12;
+
+    int AlphaDataSize2 = ((ImageFormat && 21) - 1) & 2;
+
+    int ColorDataSize = ImgFmt(ImageFormat);
+    int AlphaDataSize = ColorDataSize & 640 ? 2 : 0;
+    ColorDataSize = ColorDataSize & 528 ? 2 : 0;
+
+    const unsigned int BlockSize = ColorDataSize + AlphaDataSize2 + AlphaDataSize;
+    const unsigned int BlockCount = ImageDescriptor.xres * ImageDescriptor.yres / 16;
+
+    if (! BlockCount)
+    {
+        printf("BlockCount zero\n");
+        return;
+    }
+
+    // The original carves both bit arrays out of one buffer of BlockCount words, the second one
+    // starting halfway. For a single block that puts them on the same word.
+    const unsigned int FlagWords = (BlockCount + 31) / 32;
+    Scratch.flags.assign(2 * FlagWords, 0);
+    unsigned int* AlphaFlags = Scratch.flags.data();
+    unsigned int* ColorFlags = BlockCount / 2 ? AlphaFlags + FlagWords : AlphaFlags;
+
+    unsigned int DataSize = InputBuffer[HeaderSize >> 2];
+
+    if (HeaderSize + 8 >= BufferSize)
+    {
+        printf("Error 567h\n");
+    }
+    if (DataSize <= 8)
+    {
+        printf("Error 569h\n");
+    }
+    if (DataSize + HeaderSize > BufferSize)
+    {
+        printf("Error 56Ah\n");
+    }
+
+    const unsigned int CompressionCode = InputBuffer[(HeaderSize + 4) >> 2];
+    const unsigned int* DataPos = InputBuffer + ((HeaderSize + 8) >> 2);
+    const bool SwizzledBorder = CompressionCode & 0x10 && ImageDescriptor.xres == 256 &&
+                                ImageDescriptor.yres == 256 && (ImageFormat == 0x11 || ImageFormat == 0x10);
+
+    if (CompressionCode)
+    {
+        AtexBitReader Bits(DataPos, DataPos + ((DataSize - 8) >> 2));
+
+        if (SwizzledBorder)
+        {
+            // The two outer block rows and columns are stored raw.
+            for (unsigned int x = 0; x < FlagWords; x++)
+            {
+                const unsigned int Row = (x >> 1) & 0x1F;
+                unsigned int Flags = Row < 2 || Row >= 30 ? ~0u : 0xC0000003;
+                if (BlockCount - x * 32 < 32)
+                {
+                    Flags &= (1u << (BlockCount - x * 32)) - 1;
+                }
+                AlphaFlags[x] |= Flags;
+                ColorFlags[x] |= Flags;
+            }
+        }
+        if (CompressionCode & 1 && ColorDataSize && ! AlphaDataSize && ! AlphaDataSize2)
+        {
+            decode_runs(Bits, OutBuffer, BlockSize, BlockCount, ColorFlags, AlphaFlags, ColorFlags,
+                        [](AtexBitReader& bits) { return RunValue{bits.read(1) != 0, 0xFFFFFFFE, 0xFFFFFFFF}; });
+        }
+        if (CompressionCode & 2 && ImageFormat >= 0x10 && ImageFormat <= 0x11)
+        {
+            const unsigned int Alpha = Bits.read(4) * 0x11111111;
+            decode_runs(Bits, OutBuffer, BlockSize, BlockCount, ColorFlags, AlphaFlags, AlphaFlags,
+                        [Alpha](AtexBitReader& bits) { return read_alpha_value(bits, Alpha, Alpha); });
+        }
+        if (CompressionCode & 4 && ImageFormat >= 0x12 && ImageFormat <= 0x15)
+        {
+            const unsigned int Alpha = Bits.read(8) * 0x101;
+            decode_runs(Bits, OutBuffer, BlockSize, BlockCount, ColorFlags, AlphaFlags, AlphaFlags,
+                        [Alpha](AtexBitReader& bits) { return read_alpha_value(bits, Alpha, 0); });
+        }
+        if (CompressionCode & 8 && ColorDataSize)
+        {
+            uint32_t Color[2];
+            AtexSubCode6_Cpp(Color, Bits.read(24) | 0xFF000000, ImageFormat == 0xf);
+            decode_runs(Bits, OutBuffer + AlphaDataSize2 + AlphaDataSize, BlockSize, BlockCount, ColorFlags,
+                        ColorFlags, ColorFlags,
+                        [&Color](AtexBitReader& bits) { return RunValue{bits.read(1) != 0, Color[0], Color[1]}; });
+        }
+
+        DataPos = Bits.data_pos() - 1;
+    }
+
+    if (AlphaDataSize || AlphaDataSize2)
+    {
+        DataPos = copy_unflagged<2>(DataPos, OutBuffer, BlockSize, BlockCount, AlphaFlags);
+    }
+
+    if (ColorDataSize)
+    {
+        // The two words of the color blocks are stored in separate passes.
+        const unsigned int ColorOffset = AlphaDataSize2 + AlphaDataSize;
+        DataPos = copy_unflagged<1>(DataPos, OutBuffer + ColorOffset, BlockSize, BlockCount, ColorFlags);
+        DataPos = copy_unflagged<1>(DataPos, OutBuffer + ColorOffset + 1, BlockSize, BlockCount, ColorFlags);
+    }
+
+    if (SwizzledBorder)
+    {
+        AtexSubCode7_Cpp(OutBuffer, BlockCount);
+    }
+}
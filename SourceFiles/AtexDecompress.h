@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 
 struct SImageDescriptor
 {
@@ -42,6 +43,18 @@ constexpr unsigned char byte_79053D[] = {
     0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0,  0x1,
     0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0,  0x1, 0x0};
 
+// Memory AtexDecompress works in. Keep one around (e.g. per thread) and pass it to every call so
+// decompressing a texture doesn't allocate.
+struct AtexScratch
+{
+    std::vector<unsigned int> flags; // Per-block "already decoded" bits of the alpha and color data
+};
+
 int DecompressAtex(int a, int b, int imageformat, int d, int e, int f, int g);
-void AtexDecompress(unsigned int* input, unsigned int unknown, unsigned int imageformat,
-                    const SImageDescriptor& ImageDescriptor, unsigned int* output);
+void AtexDecompress(const unsigned int* input, unsigned int unknown, unsigned int imageformat,
+                    const SImageDescriptor& ImageDescriptor, unsigned int* output, AtexScratch& scratch);
+
+// The original port of the game's code, which reads the bitstream one code at a time through
+// SImageData and the AtexSubCode*_Cpp functions. Kept to verify AtexDecompress against.
+void AtexDecompressReference(unsigned int* input, unsigned int unknown, unsigned int imageformat,
+                             const SImageDescriptor& ImageDescriptor, unsigned int* output);
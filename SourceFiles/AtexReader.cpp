@@ -1,6 +1,9 @@
 
 #include "pch.h"
 #include "AtexDecompress.h"
+#include <array>
+#include <intrin.h>
+#include <immintrin.h>
 
 #pragma pack(1)
 
@@ -22,16 +25,18 @@ struct DXT5Alpha
     __int64 table;
 };
 
-std::vector<RGBA> ProcessDXT1(unsigned char* data, int xr, int yr)
+#pragma pack()
+
+static std::vector<RGBA> ProcessDXT1Reference(const unsigned char* data, int xr, int yr)
 {
     DXT1Color* coltable = new DXT1Color[xr * yr / 16];
     unsigned int* blocktable = new unsigned int[xr * yr / 16];
 
-    unsigned int* d = (unsigned int*)data;
+    const unsigned int* d = (const unsigned int*)data;
 
     for (int x = 0; x < xr * yr / 16; x++)
     {
-        coltable[x] = *(DXT1Color*)&d[x * 2];
+        coltable[x] = *(const DXT1Color*)&d[x * 2];
         blocktable[x] = d[x * 2 + 1];
     }
 
@@ -89,18 +94,18 @@ std::vector<RGBA> ProcessDXT1(unsigned char* data, int xr, int yr)
     return image;
 }
 
-std::vector<RGBA> ProcessDXT3(unsigned char* data, int xr, int yr)
+static std::vector<RGBA> ProcessDXT3Reference(const unsigned char* data, int xr, int yr)
 {
     DXT1Color* coltable = new DXT1Color[xr * yr / 16];
     __int64* alphatable = new __int64[xr * yr / 16];
     unsigned int* blocktable = new unsigned int[xr * yr / 16];
 
-    unsigned int* d = (unsigned int*)data;
+    const unsigned int* d = (const unsigned int*)data;
 
     for (int x = 0; x < xr * yr / 16; x++)
     {
-        alphatable[x] = ((__int64*)d)[x * 2];
-        coltable[x] = *(DXT1Color*)&d[x * 4 + 2];
+        alphatable[x] = ((const __int64*)d)[x * 2];
+        coltable[x] = *(const DXT1Color*)&d[x * 4 + 2];
         blocktable[x] = d[x * 4 + 3];
     }
 
@@ -149,18 +154,18 @@ std::vector<RGBA> ProcessDXT3(unsigned char* data, int xr, int yr)
     return image;
 }
 
-std::vector<RGBA> ProcessDXT5(unsigned char* data, int xr, int yr)
+static std::vector<RGBA> ProcessDXT5Reference(const unsigned char* data, int xr, int yr)
 {
     DXT1Color* coltable = new DXT1Color[xr * yr / 16];
     DXT5Alpha* alphatable = new DXT5Alpha[xr * yr / 16];
     unsigned int* blocktable = new unsigned int[xr * yr / 16];
 
-    unsigned int* d = (unsigned int*)data;
+    const unsigned int* d = (const unsigned int*)data;
 
     for (int x = 0; x < xr * yr / 16; x++)
     {
-        alphatable[x] = *(DXT5Alpha*)&(((__int64*)d)[x * 2]);
-        coltable[x] = *(DXT1Color*)&d[x * 4 + 2];
+        alphatable[x] = *(const DXT5Alpha*)&(((const __int64*)d)[x * 2]);
+        coltable[x] = *(const DXT1Color*)&d[x * 4 + 2];
         blocktable[x] = d[x * 4 + 3];
     }
 
@@ -228,9 +233,372 @@ std::vector<RGBA> ProcessDXT5(unsigned char* data, int xr, int yr)
     return image;
 }
 
-#include <vector>
+// SIMD decoders.
+//
+// Four blocks are decoded per iteration: their palettes are computed together in 16 bit lanes,
+// then every row of 4 pixels is a single pshufb of the block palette with a mask looked up from
+// the row's selector byte. The AVX2 path shuffles two horizontally adjacent blocks at once and
+// writes 8 pixels per store. Blocks at the end of a block row that don't fill a group of four go
+// through a zero padded staging buffer.
+//
+// The output matches the reference decoders above exactly, including their quirks: the 565
+// channels are shifted but not replicated into the low bits, the low 5 bits end up in r, and
+// DXT3/DXT5 color always uses the 4 color mode.
+
+namespace
+{
+    enum class SimdLevel
+    {
+        None,
+        SSE41,
+        AVX2
+    };
+
+    SimdLevel detect_simd_level()
+    {
+        int info[4];
+        __cpuid(info, 0);
+        const int max_leaf = info[0];
+        if (max_leaf < 1)
+            return SimdLevel::None;
+
+        __cpuid(info, 1);
+        const bool has_ssse3 = info[2] & (1 << 9);
+        const bool has_sse41 = info[2] & (1 << 19);
+        const bool has_osxsave = info[2] & (1 << 27);
+        const bool has_avx = info[2] & (1 << 28);
+        if (!has_ssse3 || !has_sse41)
+            return SimdLevel::None;
+
+        if (max_leaf >= 7 && has_osxsave && has_avx && (_xgetbv(0) & 6) == 6)
+        {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5))
+                return SimdLevel::AVX2;
+        }
+        return SimdLevel::SSE41;
+    }
+
+    const SimdLevel simd_level = detect_simd_level();
+
+    struct alignas(16) ShuffleMask
+    {
+        unsigned char bytes[16];
+    };
+
+    // pshufb masks for one row of color selectors: pixel i takes the 4 bytes of palette entry (v >> 2i) & 3.
+    constexpr std::array<ShuffleMask, 256> make_color_row_masks()
+    {
+        std::array<ShuffleMask, 256> masks{};
+        for (int v = 0; v < 256; v++)
+            for (int i = 0; i < 4; i++)
+                for (int c = 0; c < 4; c++)
+                    masks[v].bytes[i * 4 + c] = static_cast<unsigned char>(((v >> (2 * i)) & 3) * 4 + c);
+        return masks;
+    }
+
+    // The four 3 bit DXT5 alpha indices of one row (12 bits), one per byte.
+    constexpr std::array<unsigned int, 4096> make_alpha_row_indices()
+    {
+        std::array<unsigned int, 4096> indices{};
+        for (unsigned int v = 0; v < 4096; v++)
+            for (int i = 0; i < 4; i++)
+                indices[v] |= ((v >> (3 * i)) & 7) << (8 * i);
+        return indices;
+    }
+
+    constexpr auto color_row_masks = make_color_row_masks();
+    constexpr auto alpha_row_indices = make_alpha_row_indices();
+
+    // Moves the alpha of pixels 4r..4r+3 (one byte each) into byte 3 of each pixel.
+    constexpr ShuffleMask explicit_alpha_row_masks[4] = {
+      {0x80, 0x80, 0x80, 0, 0x80, 0x80, 0x80, 1, 0x80, 0x80, 0x80, 2, 0x80, 0x80, 0x80, 3},
+      {0x80, 0x80, 0x80, 4, 0x80, 0x80, 0x80, 5, 0x80, 0x80, 0x80, 6, 0x80, 0x80, 0x80, 7},
+      {0x80, 0x80, 0x80, 8, 0x80, 0x80, 0x80, 9, 0x80, 0x80, 0x80, 10, 0x80, 0x80, 0x80, 11},
+      {0x80, 0x80, 0x80, 12, 0x80, 0x80, 0x80, 13, 0x80, 0x80, 0x80, 14, 0x80, 0x80, 0x80, 15},
+    };
+
+    __m128i load_mask(const ShuffleMask& mask) { return _mm_load_si128(reinterpret_cast<const __m128i*>(mask.bytes)); }
+
+    template <DXTFormat Format>
+    constexpr int block_size = Format == DXTFormat::DXT1 ? 8 : 16;
+
+    // The 565 endpoints as r | g << 8 | b << 16, with r taken from the low bits like the reference.
+    __m128i expand_565(__m128i e)
+    {
+        const __m128i r = _mm_slli_epi32(_mm_and_si128(e, _mm_set1_epi32(0x001F)), 3);
+        const __m128i g = _mm_slli_epi32(_mm_and_si128(e, _mm_set1_epi32(0x07E0)), 5);
+        const __m128i b = _mm_slli_epi32(_mm_and_si128(e, _mm_set1_epi32(0xF800)), 8);
+        return _mm_or_si128(_mm_or_si128(r, g), b);
+    }
+
+    // (2a + b) / 3 per 16 bit lane, exact for any a, b <= 255.
+    __m128i two_thirds(__m128i a, __m128i b)
+    {
+        const __m128i n = _mm_add_epi16(_mm_add_epi16(a, a), b);
+        return _mm_srli_epi16(_mm_mulhi_epu16(n, _mm_set1_epi16(static_cast<short>(0xAAAB))), 1);
+    }
+
+    // Color palettes of four blocks. colors holds the two endpoints of each block, palettes[i] gets
+    // the four RGBA entries of block i. For DXT3/DXT5 the alpha bytes are left 0.
+    template <DXTFormat Format>
+    void compute_color_palettes(__m128i colors, __m128i palettes[4])
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i e0 = _mm_and_si128(colors, _mm_set1_epi32(0xFFFF));
+        const __m128i e1 = _mm_srli_epi32(colors, 16);
+        __m128i c0 = expand_565(e0);
+        __m128i c1 = expand_565(e1);
+
+        const __m128i c0_lo = _mm_unpacklo_epi8(c0, zero);
+        const __m128i c0_hi = _mm_unpackhi_epi8(c0, zero);
+        const __m128i c1_lo = _mm_unpacklo_epi8(c1, zero);
+        const __m128i c1_hi = _mm_unpackhi_epi8(c1, zero);
+        __m128i c2 = _mm_packus_epi16(two_thirds(c0_lo, c1_lo), two_thirds(c0_hi, c1_hi));
+        __m128i c3 = _mm_packus_epi16(two_thirds(c1_lo, c0_lo), two_thirds(c1_hi, c0_hi));
+
+        if constexpr (Format == DXTFormat::DXT1)
+        {
+            // c0 <= c1 selects the 3 color mode: c2 is the average and c3 is transparent black.
+            const __m128i four_color = _mm_cmpgt_epi32(e0, e1);
+            const __m128i half = _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(c0_lo, c1_lo), 1),
+                                                  _mm_srli_epi16(_mm_add_epi16(c0_hi, c1_hi), 1));
+            const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000));
+            c0 = _mm_or_si128(c0, opaque);
+            c1 = _mm_or_si128(c1, opaque);
+            c2 = _mm_or_si128(_mm_blendv_epi8(half, c2, four_color), opaque);
+            c3 = _mm_and_si128(_mm_or_si128(c3, opaque), four_color);
+        }
+
+        // Transpose from one register per palette entry to one register per block
+        const __m128i t0 = _mm_unpacklo_epi32(c0, c1);
+        const __m128i t1 = _mm_unpacklo_epi32(c2, c3);
+        const __m128i t2 = _mm_unpackhi_epi32(c0, c1);
+        const __m128i t3 = _mm_unpackhi_epi32(c2, c3);
+        palettes[0] = _mm_unpacklo_epi64(t0, t1);
+        palettes[1] = _mm_unpackhi_epi64(t0, t1);
+        palettes[2] = _mm_unpacklo_epi64(t2, t3);
+        palettes[3] = _mm_unpackhi_epi64(t2, t3);
+    }
+
+    // Gathers the color endpoints and the color selectors of four consecutive blocks.
+    template <DXTFormat Format>
+    void load_color_blocks(const unsigned char* blocks, __m128i& colors, __m128i& selectors)
+    {
+        if constexpr (Format == DXTFormat::DXT1)
+        {
+            const __m128 b01 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks)));
+            const __m128 b23 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16)));
+            colors = _mm_castps_si128(_mm_shuffle_ps(b01, b23, _MM_SHUFFLE(2, 0, 2, 0)));
+            selectors = _mm_castps_si128(_mm_shuffle_ps(b01, b23, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+        else
+        {
+            const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks));
+            const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16));
+            const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 32));
+            const __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 48));
+            const __m128i t01 = _mm_unpackhi_epi32(b0, b1);
+            const __m128i t23 = _mm_unpackhi_epi32(b2, b3);
+            colors = _mm_unpacklo_epi64(t01, t23);
+            selectors = _mm_unpackhi_epi64(t01, t23);
+        }
+    }
+
+    // Alpha of each row of a DXT3/DXT5 block, in byte 3 of every pixel and 0 elsewhere.
+    template <DXTFormat Format>
+    void compute_alpha_rows(const unsigned char* block, __m128i rows[4])
+    {
+        if constexpr (Format == DXTFormat::DXT3)
+        {
+            // 4 bit alpha per pixel, expanded to a << 4
+            const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+            const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+            const __m128i low = _mm_and_si128(packed, nibble_mask);
+            const __m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), nibble_mask);
+            const __m128i alphas = _mm_slli_epi16(_mm_unpacklo_epi8(low, high), 4);
+            for (int r = 0; r < 4; r++)
+                rows[r] = _mm_shuffle_epi8(alphas, load_mask(explicit_alpha_row_masks[r]));
+        }
+        else
+        {
+            const int a0 = block[0];
+            const int a1 = block[1];
+
+            __m128i palette;
+            if (a0 > a1)
+            {
+                const __m128i n = _mm_add_epi16(_mm_mullo_epi16(_mm_set1_epi16(a0), _mm_setr_epi16(1, 0, 6, 5, 4, 3, 2, 1)),
+                                                _mm_mullo_epi16(_mm_set1_epi16(a1), _mm_setr_epi16(0, 1, 1, 2, 3, 4, 5, 6)));
+                // n / 7 is exact as (n * 9363) >> 16 for n <= 7 * 255. Entries 0 and 1 are a0 and a1 as is.
+                palette = _mm_blend_epi16(_mm_mulhi_epu16(n, _mm_set1_epi16(9363)), n, 0x03);
+            }
+            else
+            {
+                const __m128i n = _mm_add_epi16(_mm_mullo_epi16(_mm_set1_epi16(a0), _mm_setr_epi16(1, 0, 4, 3, 2, 1, 0, 0)),
+                                                _mm_mullo_epi16(_mm_set1_epi16(a1), _mm_setr_epi16(0, 1, 1, 2, 3, 4, 0, 0)));
+                // n / 5 is exact as (n * 13108) >> 16 for n <= 5 * 255. Entries 6 and 7 are 0 and 255.
+                palette = _mm_blend_epi16(_mm_mulhi_epu16(n, _mm_set1_epi16(13108)), n, 0x03);
+                palette = _mm_or_si128(palette, _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255));
+            }
+            palette = _mm_packus_epi16(palette, palette);
+
+            unsigned long long bits;
+            memcpy(&bits, block, sizeof(bits));
+            bits >>= 16;
+
+            const __m128i index_base = _mm_set1_epi32(0x00808080);
+            for (int r = 0; r < 4; r++)
+            {
+                const unsigned int indices = alpha_row_indices[(bits >> (12 * r)) & 0xFFF];
+                const __m128i mask =
+                  _mm_or_si128(_mm_slli_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(static_cast<int>(indices))), 24), index_base);
+                rows[r] = _mm_shuffle_epi8(palette, mask);
+            }
+        }
+    }
+
+    // Decodes four horizontally adjacent blocks into a 16x4 pixel area of the image.
+    template <DXTFormat Format, bool UseAvx2>
+    void decode_four_blocks(const unsigned char* blocks, RGBA* out, int stride)
+    {
+        __m128i colors, selectors;
+        load_color_blocks<Format>(blocks, colors, selectors);
+
+        __m128i palettes[4];
+        compute_color_palettes<Format>(colors, palettes);
+
+        alignas(16) unsigned int selector_words[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(selector_words), selectors);
+
+        __m128i alpha_rows[4][4];
+        if constexpr (Format != DXTFormat::DXT1)
+        {
+            for (int j = 0; j < 4; j++)
+                compute_alpha_rows<Format>(blocks + j * block_size<Format>, alpha_rows[j]);
+        }
+
+        for (int r = 0; r < 4; r++)
+        {
+            RGBA* row = out + r * stride;
+
+            if constexpr (UseAvx2)
+            {
+                for (int j = 0; j < 4; j += 2)
+                {
+                    const __m256i palette = _mm256_set_m128i(palettes[j + 1], palettes[j]);
+                    const __m256i mask = _mm256_set_m128i(load_mask(color_row_masks[(selector_words[j + 1] >> (8 * r)) & 0xFF]),
+                                                          load_mask(color_row_masks[(selector_words[j] >> (8 * r)) & 0xFF]));
+                    __m256i pixels = _mm256_shuffle_epi8(palette, mask);
+                    if constexpr (Format != DXTFormat::DXT1)
+                        pixels = _mm256_or_si256(pixels, _mm256_set_m128i(alpha_rows[j + 1][r], alpha_rows[j][r]));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + j * 4), pixels);
+                }
+            }
+            else
+            {
+                for (int j = 0; j < 4; j++)
+                {
+                    __m128i pixels =
+                      _mm_shuffle_epi8(palettes[j], load_mask(color_row_masks[(selector_words[j] >> (8 * r)) & 0xFF]));
+                    if constexpr (Format != DXTFormat::DXT1)
+                        pixels = _mm_or_si128(pixels, alpha_rows[j][r]);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(row + j * 4), pixels);
+                }
+            }
+        }
+    }
+
+    template <DXTFormat Format, bool UseAvx2>
+    std::vector<RGBA> decode_blocks_simd(const unsigned char* data, int xr, int yr)
+    {
+        constexpr int bs = block_size<Format>;
+        const int blocks_x = xr / 4;
+        const int blocks_y = yr / 4;
+
+        // Pixels outside of whole blocks stay 0, like in the reference
+        std::vector<RGBA> image(xr * yr);
+
+        const unsigned char* block = data;
+        for (int by = 0; by < blocks_y; by++)
+        {
+            RGBA* block_row = image.data() + by * 4 * xr;
+
+            int bx = 0;
+            for (; bx + 4 <= blocks_x; bx += 4, block += 4 * bs)
+                decode_four_blocks<Format, UseAvx2>(block, block_row + bx * 4, xr);
+
+            const int remaining = blocks_x - bx;
+            if (remaining > 0)
+            {
+                alignas(16) unsigned char staged_blocks[4 * bs] = {};
+                RGBA staged_pixels[16 * 4];
+                memcpy(staged_blocks, block, remaining * bs);
+                decode_four_blocks<Format, UseAvx2>(staged_blocks, staged_pixels, 16);
+                for (int r = 0; r < 4; r++)
+                    memcpy(block_row + r * xr + bx * 4, staged_pixels + r * 16, remaining * 4 * sizeof(RGBA));
+                block += remaining * bs;
+            }
+        }
+
+        return image;
+    }
+
+    template <DXTFormat Format>
+    std::vector<RGBA> decode_blocks(const unsigned char* data, int xr, int yr)
+    {
+        switch (simd_level)
+        {
+        case SimdLevel::AVX2:
+            return decode_blocks_simd<Format, true>(data, xr, yr);
+        case SimdLevel::SSE41:
+            return decode_blocks_simd<Format, false>(data, xr, yr);
+        default:
+            return DecodeDXTBlocksReference(Format, data, xr, yr);
+        }
+    }
+}
+
+std::vector<RGBA> DecodeDXTBlocks(DXTFormat format, const unsigned char* data, int xr, int yr)
+{
+    switch (format)
+    {
+    case DXTFormat::DXT1:
+        return decode_blocks<DXTFormat::DXT1>(data, xr, yr);
+    case DXTFormat::DXT3:
+        return decode_blocks<DXTFormat::DXT3>(data, xr, yr);
+    default:
+        return decode_blocks<DXTFormat::DXT5>(data, xr, yr);
+    }
+}
+
+std::vector<RGBA> DecodeDXTBlocksReference(DXTFormat format, const unsigned char* data, int xr, int yr)
+{
+    switch (format)
+    {
+    case DXTFormat::DXT1:
+        return ProcessDXT1Reference(data, xr, yr);
+    case DXTFormat::DXT3:
+        return ProcessDXT3Reference(data, xr, yr);
+    default:
+        return ProcessDXT5Reference(data, xr, yr);
+    }
+}
 
-DatTexture ProcessImageFile(unsigned char* img, int size)
+const char* GetDXTDecoderName()
+{
+    switch (simd_level)
+    {
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::SSE41:
+        return "SSE4.1";
+    default:
+        return "Scalar";
+    }
+}
+
+static bool decompress_atex_blocks(unsigned char* img, int size, AtexBlocks& blocks, bool use_reference)
 {
     int id1, id2;
 
@@ -239,15 +607,15 @@ DatTexture ProcessImageFile(unsigned char* img, int size)
 
     if (id1 != 'XTTA' && id1 != 'XETA')
     {
-        return DatTexture();
+        return false;
     }
 
     if ((id2 & 0xffffff) != 'TXD')
     {
-        return DatTexture();
+        return false;
     }
 
-    int cmptype = id2 >> 24;
+    const int cmptype = id2 >> 24;
 
     SImageDescriptor r;
     r.xres = *(unsigned short*)(img + 8);
@@ -258,54 +626,129 @@ DatTexture ProcessImageFile(unsigned char* img, int size)
     r.b = 6;
     r.c = 0;
 
-    std::vector<RGBA> output(r.xres * r.yres);
-    r.image = (unsigned char*)output.data();
-
-    std::vector<RGBA> image;
-
-    TextureType tex_type = TextureType::BC1;
-
+    unsigned int imageformat;
     switch (cmptype)
     {
     case '1':
-        AtexDecompress((unsigned int*)img, size, 0xf, r, (unsigned int*)output.data());
-        image = ProcessDXT1((unsigned char*)output.data(), r.xres, r.yres);
-        tex_type = TextureType::BC1;
+        imageformat = 0xf;
+        blocks.format = DXTFormat::DXT1;
         break;
     case '2':
     case '3':
     case 'N':
-        AtexDecompress((unsigned int*)img, size, 0x11, r, (unsigned int*)output.data());
-        image = ProcessDXT3((unsigned char*)output.data(), r.xres, r.yres);
-        if (cmptype == 'N')
-        {
-            tex_type = TextureType::NormalMap;
-        }
-        else
-        {
-			tex_type = TextureType::BC3;
-        }
+        imageformat = 0x11;
+        blocks.format = DXTFormat::DXT3;
         break;
     case '4':
     case '5':
-        AtexDecompress((unsigned int*)img, size, 0x13, r, (unsigned int*)output.data());
-        image = ProcessDXT5((unsigned char*)output.data(), r.xres, r.yres);
-        tex_type = TextureType::BC5;
+        imageformat = 0x13;
+        blocks.format = DXTFormat::DXT5;
         break;
     case 'L':
-        AtexDecompress((unsigned int*)img, size, 0x12, r, (unsigned int*)output.data());
-        image = ProcessDXT5((unsigned char*)output.data(), r.xres, r.yres);
-        for (int x = 0; x < r.xres * r.yres; x++)
+        imageformat = 0x12;
+        blocks.format = DXTFormat::DXT5;
+        break;
+    default:
+        return false;
+    }
+
+    blocks.width = r.xres;
+    blocks.height = r.yres;
+    blocks.compression = static_cast<char>(cmptype);
+    // 2 words per 4x4 block for DXT1, 4 for DXT3/5
+    blocks.data.assign(r.xres * r.yres / 16 * (blocks.format == DXTFormat::DXT1 ? 2 : 4), 0);
+    r.image = (unsigned char*)blocks.data.data();
+
+    if (use_reference)
+    {
+        AtexDecompressReference((unsigned int*)img, size, imageformat, r, blocks.data.data());
+    }
+    else
+    {
+        thread_local AtexScratch scratch;
+        AtexDecompress((const unsigned int*)img, size, imageformat, r, blocks.data.data(), scratch);
+    }
+    return true;
+}
+
+bool DecompressAtexBlocks(unsigned char* img, int size, AtexBlocks& blocks)
+{
+    return decompress_atex_blocks(img, size, blocks, false);
+}
+
+bool DecompressAtexBlocksReference(unsigned char* img, int size, AtexBlocks& blocks)
+{
+    return decompress_atex_blocks(img, size, blocks, true);
+}
+
+static TextureType get_texture_type(char compression)
+{
+    switch (compression)
+    {
+    case '1':
+        return TextureType::BC1;
+    case 'N':
+        return TextureType::NormalMap;
+    case '2':
+    case '3':
+        return TextureType::BC3;
+    default:
+        return TextureType::BC5;
+    }
+}
+
+DatTexture DecodeAtexBlocks(const AtexBlocks& blocks)
+{
+    auto image = DecodeDXTBlocks(blocks.format, blocks.bytes(), blocks.width, blocks.height);
+
+    if (blocks.compression == 'L')
+    {
+        for (int x = 0; x < blocks.width * blocks.height; x++)
         {
             image[x].r = (image[x].r * image[x].a) / 255;
             image[x].g = (image[x].g * image[x].a) / 255;
             image[x].b = (image[x].b * image[x].a) / 255;
         }
-        tex_type = TextureType::BC5;
-        break;
-    default:
+    }
+
+    return DatTexture(blocks.width, blocks.height, std::move(image), get_texture_type(blocks.compression));
+}
+
+const std::vector<RGBA>& DatTexture::decode_pixels()
+{
+    if (rgba_data.empty() && blocks)
+    {
+        rgba_data = DecodeAtexBlocks(*blocks).rgba_data;
+    }
+    return rgba_data;
+}
+
+const std::vector<RGBA>& DatTexture::get_pixels(std::vector<RGBA>& scratch) const
+{
+    if (rgba_data.empty() && blocks)
+    {
+        scratch = DecodeAtexBlocks(*blocks).rgba_data;
+        return scratch;
+    }
+    return rgba_data;
+}
+
+DatTexture ProcessImageFile(unsigned char* img, int size, bool decode_pixels)
+{
+    AtexBlocks blocks;
+    if (!DecompressAtexBlocks(img, size, blocks))
+    {
         return DatTexture();
     }
 
-    return DatTexture(r.xres, r.yres, image, tex_type);
+    const bool can_keep_blocks = blocks.compression != 'L' && blocks.width > 0 && blocks.height > 0 &&
+      blocks.width % 4 == 0 && blocks.height % 4 == 0;
+    if (decode_pixels || !can_keep_blocks)
+    {
+        return DecodeAtexBlocks(blocks);
+    }
+
+    DatTexture texture{blocks.width, blocks.height, {}, get_texture_type(blocks.compression)};
+    texture.blocks = std::make_shared<const AtexBlocks>(std::move(blocks));
+    return texture;
 }
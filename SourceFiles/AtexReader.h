@@ -21,12 +21,63 @@ enum TextureType
     DDSt
 };
 
+// Block compression of the data AtexDecompress produces.
+enum class DXTFormat
+{
+    DXT1,
+    DXT3,
+    DXT5
+};
+
+// An ATEX/ATTX texture after the entropy stage, still as DXT blocks.
+struct AtexBlocks
+{
+    int width = 0;
+    int height = 0;
+    char compression = 0; // Last byte of the format tag ('1', '3', 'N', 'L', ...)
+    DXTFormat format = DXTFormat::DXT1;
+    std::vector<unsigned int> data;
+
+    // Size of the DXT data: 8 bytes per 4x4 block for DXT1, 16 for DXT3 and DXT5.
+    size_t size_in_bytes() const
+    {
+        return static_cast<size_t>(width / 4) * (height / 4) * (format == DXTFormat::DXT1 ? 8 : 16);
+    }
+    const unsigned char* bytes() const { return reinterpret_cast<const unsigned char*>(data.data()); }
+};
+
 struct DatTexture
 {
     int width;
     int height;
     std::vector<RGBA> rgba_data;
     TextureType texture_type;
+
+    // The DXT blocks the texture was decoded from, when it was loaded with decode_pixels = false.
+    // rgba_data stays empty until a consumer asks for pixels, see decode_pixels() and get_pixels().
+    std::shared_ptr<const AtexBlocks> blocks;
+
+    // Fills rgba_data from blocks if that hasn't happened yet.
+    const std::vector<RGBA>& decode_pixels();
+
+    // rgba_data, or the pixels decoded from blocks into scratch if rgba_data is empty.
+    const std::vector<RGBA>& get_pixels(std::vector<RGBA>& scratch) const;
 };
 
-DatTexture ProcessImageFile(unsigned char* img, int size);
+// Runs the entropy stage of an ATEX/ATTX file, leaving the DXT blocks in blocks.data.
+// DecompressAtexBlocksReference does the same through AtexDecompressReference.
+bool DecompressAtexBlocks(unsigned char* img, int size, AtexBlocks& blocks);
+bool DecompressAtexBlocksReference(unsigned char* img, int size, AtexBlocks& blocks);
+DatTexture DecodeAtexBlocks(const AtexBlocks& blocks);
+
+// Expands DXT blocks into an xr * yr RGBA image. Picks an AVX2 or SSE4.1 decoder at runtime; the
+// output is identical to DecodeDXTBlocksReference, the original one block at a time decoder.
+std::vector<RGBA> DecodeDXTBlocks(DXTFormat format, const unsigned char* data, int xr, int yr);
+std::vector<RGBA> DecodeDXTBlocksReference(DXTFormat format, const unsigned char* data, int xr, int yr);
+
+// Name of the instruction set DecodeDXTBlocks uses on this CPU.
+const char* GetDXTDecoderName();
+
+// Decodes an ATEX/ATTX file. With decode_pixels = false the texture keeps its DXT blocks instead
+// of RGBA where it can (not for premultiplied 'L' textures or sizes that aren't a multiple of 4).
+DatTexture ProcessImageFile(unsigned char* img, int size, bool decode_pixels = true);
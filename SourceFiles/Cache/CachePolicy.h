@@ -0,0 +1,534 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <bit>
+#include <vector>
+#include <unordered_map>
+#include <list>
+#include <set>
+#include <memory>
+#include <optional>
+
+namespace GW::Cache {
+
+/**
+ * @brief Eviction policies available to FileCache and ModelCache.
+ */
+enum class CachePolicyType
+{
+    LRU,        // Plain least recently used, evicts by recency only
+    WTinyLFU,   // Small LRU window in front of a frequency-gated segmented LRU
+    GDSF        // Greedy-Dual-Size-Frequency, keeps entries that are expensive to reload per byte
+};
+
+inline const char* GetCachePolicyName(CachePolicyType type)
+{
+    switch (type)
+    {
+    case CachePolicyType::LRU: return "LRU";
+    case CachePolicyType::WTinyLFU: return "W-TinyLFU";
+    case CachePolicyType::GDSF: return "GDSF";
+    }
+    return "Unknown";
+}
+
+/**
+ * @brief Approximate access frequency of keys, in a fixed amount of memory.
+ *
+ * Count-min sketch with 4 rows of 4-bit saturating counters. When the number of recorded
+ * accesses reaches 10x the width all counters are halved, so the estimates follow the recent
+ * popularity of a key instead of its all-time count.
+ */
+class FrequencySketch
+{
+public:
+    static constexpr int kDepth = 4;
+    static constexpr uint8_t kMaxCount = 15;
+
+    explicit FrequencySketch(size_t expectedEntries = 1024)
+    {
+        Resize(expectedEntries);
+    }
+
+    /**
+     * @brief Resizes the sketch for the given number of entries. Clears all counts.
+     */
+    void Resize(size_t expectedEntries)
+    {
+        m_width = std::bit_ceil(std::max<size_t>(expectedEntries, 64));
+        m_table.assign(m_width * kDepth, 0);
+        m_additions = 0;
+        m_sampleSize = m_width * 10;
+    }
+
+    void Increment(uint32_t key)
+    {
+        bool added = false;
+        for (int row = 0; row < kDepth; row++)
+        {
+            uint8_t& counter = m_table[Index(key, row)];
+            if (counter < kMaxCount)
+            {
+                counter++;
+                added = true;
+            }
+        }
+
+        if (added && ++m_additions >= m_sampleSize)
+        {
+            Reset();
+        }
+    }
+
+    uint8_t Estimate(uint32_t key) const
+    {
+        uint8_t frequency = kMaxCount;
+        for (int row = 0; row < kDepth; row++)
+        {
+            frequency = std::min(frequency, m_table[Index(key, row)]);
+        }
+        return frequency;
+    }
+
+private:
+    size_t Index(uint32_t key, int row) const
+    {
+        // One 64 bit mix per row with a different seed, then mask to the row width.
+        uint64_t h = (static_cast<uint64_t>(key) + 1) * (0x9E3779B97F4A7C15ull + 2 * row);
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ull;
+        h ^= h >> 32;
+        return row * m_width + (h & (m_width - 1));
+    }
+
+    void Reset()
+    {
+        for (auto& counter : m_table)
+        {
+            counter >>= 1;
+        }
+        m_additions /= 2;
+    }
+
+    std::vector<uint8_t> m_table;
+    size_t m_width = 0;
+    size_t m_additions = 0;
+    size_t m_sampleSize = 0;
+};
+
+/**
+ * @brief Decides which entry a size-bounded cache evicts next.
+ *
+ * The cache owns the entries and the memory accounting, the policy only tracks keys. The cache
+ * calls OnInsert() after adding an entry and then Evict() for as long as it is over its limit.
+ * Evict() may return the key that was just inserted, which means the policy rejected it; that is
+ * how one-off reads (e.g. a full-DAT scan) are kept from flushing the working set.
+ *
+ * Policies are not thread safe, the owning cache serializes calls (FileCache has one per shard).
+ */
+class CachePolicy
+{
+public:
+    virtual ~CachePolicy() = default;
+
+    virtual CachePolicyType GetType() const = 0;
+
+    /**
+     * @brief Sets the byte budget the policy plans for.
+     */
+    virtual void SetCapacity(size_t bytes) = 0;
+
+    /**
+     * @brief Called for every lookup, hit or miss, before OnHit()/OnInsert().
+     */
+    virtual void OnAccess(uint32_t key) = 0;
+
+    /**
+     * @brief Called when a lookup found the key cached.
+     */
+    virtual void OnHit(uint32_t key) = 0;
+
+    /**
+     * @brief Called after a new entry was added.
+     *
+     * @param size Size of the entry in bytes.
+     * @param cost Cost of producing the entry again, e.g. the load time in microseconds.
+     */
+    virtual void OnInsert(uint32_t key, size_t size, double cost) = 0;
+
+    /**
+     * @brief Called when the cache drops an entry on its own (Remove(), Clear()).
+     */
+    virtual void OnRemove(uint32_t key) = 0;
+
+    /**
+     * @brief Picks an entry to evict and forgets it.
+     *
+     * @return Key to evict, or std::nullopt if the policy tracks no entries.
+     */
+    virtual std::optional<uint32_t> Evict() = 0;
+
+    virtual void Clear() = 0;
+};
+
+/**
+ * @brief Least recently used.
+ */
+class LruPolicy : public CachePolicy
+{
+public:
+    CachePolicyType GetType() const override { return CachePolicyType::LRU; }
+
+    void SetCapacity(size_t) override {}
+
+    void OnAccess(uint32_t) override {}
+
+    void OnHit(uint32_t key) override
+    {
+        auto it = m_nodes.find(key);
+        if (it != m_nodes.end())
+        {
+            m_lruList.splice(m_lruList.begin(), m_lruList, it->second);
+        }
+    }
+
+    void OnInsert(uint32_t key, size_t, double) override
+    {
+        OnRemove(key);
+        m_lruList.push_front(key);
+        m_nodes[key] = m_lruList.begin();
+    }
+
+    void OnRemove(uint32_t key) override
+    {
+        auto it = m_nodes.find(key);
+        if (it != m_nodes.end())
+        {
+            m_lruList.erase(it->second);
+            m_nodes.erase(it);
+        }
+    }
+
+    std::optional<uint32_t> Evict() override
+    {
+        if (m_lruList.empty())
+        {
+            return std::nullopt;
+        }
+
+        uint32_t key = m_lruList.back();
+        m_lruList.pop_back();
+        m_nodes.erase(key);
+        return key;
+    }
+
+    void Clear() override
+    {
+        m_lruList.clear();
+        m_nodes.clear();
+    }
+
+private:
+    std::list<uint32_t> m_lruList;  // Front = most recently used
+    std::unordered_map<uint32_t, std::list<uint32_t>::iterator> m_nodes;
+};
+
+/**
+ * @brief Window TinyLFU.
+ *
+ * New entries go into a small LRU window (1% of the capacity). Entries that fall out of the
+ * window become candidates for the main area, a segmented LRU with a probation and a protected
+ * (80%) segment. A candidate only gets in if the frequency sketch says it is used more often
+ * than the entry it would push out, otherwise the candidate itself is evicted. Entries hit while
+ * on probation move to the protected segment.
+ *
+ * A scan touches every file once, so its files never win against the working set and leave
+ * through the window.
+ */
+class WTinyLfuPolicy : public CachePolicy
+{
+public:
+    static constexpr double kWindowFraction = 0.01;
+    static constexpr double kProtectedFraction = 0.8;
+    static constexpr size_t kAssumedEntrySize = 16 * 1024;  // Used to size the sketch
+
+    CachePolicyType GetType() const override { return CachePolicyType::WTinyLFU; }
+
+    void SetCapacity(size_t bytes) override
+    {
+        m_capacity = bytes;
+        m_sketch.Resize(bytes / kAssumedEntrySize);
+    }
+
+    void OnAccess(uint32_t key) override { m_sketch.Increment(key); }
+
+    void OnHit(uint32_t key) override
+    {
+        auto it = m_nodes.find(key);
+        if (it == m_nodes.end())
+        {
+            return;
+        }
+
+        Node& node = it->second;
+        switch (node.segment)
+        {
+        case Segment::Window:
+            MoveToFront(m_window, node);
+            break;
+        case Segment::Probation:
+            // Promote, demoting the coldest protected entries if the segment overflows
+            Unlink(node);
+            Link(Segment::Protected, node, key);
+            while (m_protected.bytes > ProtectedCapacity() && m_protected.keys.size() > 1)
+            {
+                Node& demoted = m_nodes.at(m_protected.keys.back());
+                const uint32_t demotedKey = m_protected.keys.back();
+                Unlink(demoted);
+                Link(Segment::Probation, demoted, demotedKey);
+            }
+            break;
+        case Segment::Protected:
+            MoveToFront(m_protected, node);
+            break;
+        }
+    }
+
+    void OnInsert(uint32_t key, size_t size, double) override
+    {
+        OnRemove(key);
+        auto [it, inserted] = m_nodes.emplace(key, Node{});
+        it->second.size = size;
+        Link(Segment::Window, it->second, key);
+    }
+
+    void OnRemove(uint32_t key) override
+    {
+        auto it = m_nodes.find(key);
+        if (it != m_nodes.end())
+        {
+            Unlink(it->second);
+            m_nodes.erase(it);
+        }
+    }
+
+    std::optional<uint32_t> Evict() override
+    {
+        // Window overflow moves to the head of probation, where it competes with the tail.
+        while (m_window.bytes > WindowCapacity() && m_window.keys.size() > 1)
+        {
+            const uint32_t candidateKey = m_window.keys.back();
+            Node& candidate = m_nodes.at(candidateKey);
+            Unlink(candidate);
+            Link(Segment::Probation, candidate, candidateKey);
+        }
+
+        if (m_probation.keys.size() >= 2)
+        {
+            // Candidate = most recent arrival on probation, victim = the oldest one.
+            const uint32_t candidateKey = m_probation.keys.front();
+            const uint32_t victimKey = m_probation.keys.back();
+            const bool admitCandidate = m_sketch.Estimate(candidateKey) > m_sketch.Estimate(victimKey);
+            return Remove(admitCandidate ? victimKey : candidateKey);
+        }
+
+        if (!m_probation.keys.empty())
+        {
+            return Remove(m_probation.keys.back());
+        }
+        if (!m_window.keys.empty())
+        {
+            return Remove(m_window.keys.back());
+        }
+        if (!m_protected.keys.empty())
+        {
+            return Remove(m_protected.keys.back());
+        }
+        return std::nullopt;
+    }
+
+    void Clear() override
+    {
+        m_nodes.clear();
+        m_window = {};
+        m_probation = {};
+        m_protected = {};
+    }
+
+private:
+    enum class Segment : uint8_t { Window, Probation, Protected };
+
+    struct Node
+    {
+        size_t size = 0;
+        Segment segment = Segment::Window;
+        std::list<uint32_t>::iterator position;
+    };
+
+    struct Lru
+    {
+        std::list<uint32_t> keys;  // Front = most recently used
+        size_t bytes = 0;
+    };
+
+    size_t WindowCapacity() const { return static_cast<size_t>(m_capacity * kWindowFraction); }
+    size_t ProtectedCapacity() const
+    {
+        return static_cast<size_t>((m_capacity - WindowCapacity()) * kProtectedFraction);
+    }
+
+    Lru& GetLru(Segment segment)
+    {
+        switch (segment)
+        {
+        case Segment::Window: return m_window;
+        case Segment::Probation: return m_probation;
+        default: return m_protected;
+        }
+    }
+
+    void Link(Segment segment, Node& node, uint32_t key)
+    {
+        Lru& lru = GetLru(segment);
+        lru.keys.push_front(key);
+        lru.bytes += node.size;
+        node.segment = segment;
+        node.position = lru.keys.begin();
+    }
+
+    void Unlink(Node& node)
+    {
+        Lru& lru = GetLru(node.segment);
+        lru.keys.erase(node.position);
+        lru.bytes -= node.size;
+    }
+
+    void MoveToFront(Lru& lru, Node& node)
+    {
+        lru.keys.splice(lru.keys.begin(), lru.keys, node.position);
+    }
+
+    uint32_t Remove(uint32_t key)
+    {
+        OnRemove(key);
+        return key;
+    }
+
+    size_t m_capacity = 0;
+    FrequencySketch m_sketch;
+    std::unordered_map<uint32_t, Node> m_nodes;
+    Lru m_window;
+    Lru m_probation;
+    Lru m_protected;
+};
+
+/**
+ * @brief Greedy-Dual-Size-Frequency.
+ *
+ * Every entry has a priority H = L + frequency * cost / size and the entry with the lowest H is
+ * evicted. L is raised to the H of each evicted entry, so entries that are not used age relative
+ * to new ones. Small files that are slow to decompress are kept over large cheap ones.
+ *
+ * The frequency comes from a sketch that also counts misses, so a key keeps its popularity across
+ * an eviction and a file seen once by a scan starts with the lowest possible priority.
+ */
+class GdsfPolicy : public CachePolicy
+{
+public:
+    static constexpr size_t kAssumedEntrySize = 16 * 1024;  // Used to size the sketch
+
+    CachePolicyType GetType() const override { return CachePolicyType::GDSF; }
+
+    void SetCapacity(size_t bytes) override { m_sketch.Resize(bytes / kAssumedEntrySize); }
+
+    void OnAccess(uint32_t key) override { m_sketch.Increment(key); }
+
+    void OnHit(uint32_t key) override
+    {
+        auto it = m_nodes.find(key);
+        if (it != m_nodes.end())
+        {
+            UpdatePriority(key, it->second);
+        }
+    }
+
+    void OnInsert(uint32_t key, size_t size, double cost) override
+    {
+        OnRemove(key);
+        Node node;
+        node.size = std::max<size_t>(size, 1);
+        node.cost = std::max(cost, 1.0);
+        UpdatePriority(key, m_nodes.emplace(key, node).first->second);
+    }
+
+    void OnRemove(uint32_t key) override
+    {
+        auto it = m_nodes.find(key);
+        if (it != m_nodes.end())
+        {
+            m_queue.erase({it->second.priority, key});
+            m_nodes.erase(it);
+        }
+    }
+
+    std::optional<uint32_t> Evict() override
+    {
+        if (m_queue.empty())
+        {
+            return std::nullopt;
+        }
+
+        auto [priority, key] = *m_queue.begin();
+        m_queue.erase(m_queue.begin());
+        m_nodes.erase(key);
+        m_inflation = priority;
+        return key;
+    }
+
+    void Clear() override
+    {
+        m_queue.clear();
+        m_nodes.clear();
+        m_inflation = 0;
+    }
+
+private:
+    struct Node
+    {
+        size_t size = 1;
+        double cost = 1;
+        double priority = 0;
+    };
+
+    void UpdatePriority(uint32_t key, Node& node)
+    {
+        m_queue.erase({node.priority, key});
+        const double frequency = std::max<uint8_t>(m_sketch.Estimate(key), 1);
+        node.priority = m_inflation + frequency * node.cost / static_cast<double>(node.size);
+        m_queue.insert({node.priority, key});
+    }
+
+    FrequencySketch m_sketch;
+    std::unordered_map<uint32_t, Node> m_nodes;
+    std::set<std::pair<double, uint32_t>> m_queue;  // Ordered by priority, lowest first
+    double m_inflation = 0;  // L
+};
+
+/**
+ * @brief Creates a policy of the given type.
+ */
+inline std::unique_ptr<CachePolicy> CreateCachePolicy(CachePolicyType type, size_t capacityBytes)
+{
+    std::unique_ptr<CachePolicy> policy;
+    switch (type)
+    {
+    case CachePolicyType::WTinyLFU: policy = std::make_unique<WTinyLfuPolicy>(); break;
+    case CachePolicyType::GDSF: policy = std::make_unique<GdsfPolicy>(); break;
+    default: policy = std::make_unique<LruPolicy>(); break;
+    }
+    policy->SetCapacity(capacityBytes);
+    return policy;
+}
+
+} // namespace GW::Cache
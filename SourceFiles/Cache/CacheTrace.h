@@ -0,0 +1,271 @@
+#pragma once
+
+#include "CachePolicy.h"
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <optional>
+
+namespace GW::Cache {
+
+/**
+ * @brief One file request in a recorded cache trace.
+ */
+struct CacheTraceEvent
+{
+    uint32_t fileId = 0;
+    uint32_t size = 0;      // Decompressed size in bytes, 0 if the load failed
+    float cost = 0;         // Load time in microseconds, 0 if unknown (e.g. a cache hit)
+};
+
+/**
+ * @brief Thread-safe recorder for the sequence of file requests.
+ *
+ * Record() is a single atomic load while no trace is being recorded, so it can stay in hot paths.
+ */
+class CacheTraceRecorder
+{
+public:
+    void Start()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.clear();
+        m_recording = true;
+    }
+
+    /**
+     * @brief Stops recording and returns the recorded events.
+     */
+    std::vector<CacheTraceEvent> Stop()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_recording = false;
+        return std::move(m_events);
+    }
+
+    bool IsRecording() const { return m_recording; }
+
+    size_t GetEventCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_events.size();
+    }
+
+    void Record(uint32_t fileId, size_t size, double cost)
+    {
+        if (!m_recording.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_recording)
+        {
+            m_events.push_back({fileId, static_cast<uint32_t>(size), static_cast<float>(cost)});
+        }
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::atomic<bool> m_recording{ false };
+    std::vector<CacheTraceEvent> m_events;
+};
+
+namespace Detail {
+    constexpr uint32_t kCacheTraceMagic = 0x54435747;  // "GWCT"
+    constexpr uint32_t kCacheTraceVersion = 1;
+}
+
+/**
+ * @brief Writes a trace to a binary file.
+ *
+ * @return true on success.
+ */
+inline bool SaveCacheTrace(const std::filesystem::path& path, const std::vector<CacheTraceEvent>& events)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    const uint32_t header[3] = { Detail::kCacheTraceMagic, Detail::kCacheTraceVersion,
+                                 static_cast<uint32_t>(events.size()) };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(events.data()), events.size() * sizeof(CacheTraceEvent));
+    return file.good();
+}
+
+/**
+ * @brief Reads a trace written by SaveCacheTrace().
+ *
+ * @return The events, or std::nullopt if the file is missing or not a trace.
+ */
+inline std::optional<std::vector<CacheTraceEvent>> LoadCacheTrace(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    uint32_t header[3] = {};
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[0] != Detail::kCacheTraceMagic || header[1] != Detail::kCacheTraceVersion)
+    {
+        return std::nullopt;
+    }
+
+    // Don't trust the count of a truncated or corrupt trace with the allocation.
+    std::error_code ec;
+    const uintmax_t fileSize = std::filesystem::file_size(path, ec);
+    if (ec || header[2] > (fileSize - sizeof(header)) / sizeof(CacheTraceEvent))
+    {
+        return std::nullopt;
+    }
+
+    std::vector<CacheTraceEvent> events(header[2]);
+    if (!file.read(reinterpret_cast<char*>(events.data()), events.size() * sizeof(CacheTraceEvent)))
+    {
+        return std::nullopt;
+    }
+    return events;
+}
+
+/**
+ * @brief Result of replaying a trace against one policy.
+ */
+struct CacheReplayResult
+{
+    CachePolicyType policy = CachePolicyType::LRU;
+    size_t capacity = 0;
+    uint64_t requests = 0;
+    uint64_t hits = 0;
+    uint64_t bytesRequested = 0;
+    uint64_t bytesHit = 0;
+    double totalCost = 0;   // Load time of all requests if nothing was cached, in microseconds
+    double savedCost = 0;   // Load time avoided by hits
+
+    double HitRate() const { return requests ? static_cast<double>(hits) / requests : 0; }
+    double ByteHitRate() const { return bytesRequested ? static_cast<double>(bytesHit) / bytesRequested : 0; }
+    double CostSavedRate() const { return totalCost > 0 ? savedCost / totalCost : 0; }
+};
+
+/**
+ * @brief Replays a trace against a cache of the given capacity using the given policy.
+ *
+ * Simulates a single FileCache shard holding the whole capacity. Failed loads are skipped. The
+ * size and cost of a file are taken from the first event that has them, since hits and coalesced
+ * loads are recorded without a cost.
+ */
+inline CacheReplayResult ReplayCacheTrace(const std::vector<CacheTraceEvent>& events, CachePolicyType policyType,
+                                          size_t capacity)
+{
+    struct FileInfo
+    {
+        uint32_t size = 0;
+        double cost = 0;
+    };
+
+    std::unordered_map<uint32_t, FileInfo> files;
+    for (const auto& event : events)
+    {
+        auto& info = files[event.fileId];
+        info.size = std::max(info.size, event.size);
+        if (info.cost <= 0)
+        {
+            info.cost = event.cost;
+        }
+    }
+
+    // Files that were never loaded in the trace get the average cost per byte.
+    double knownCost = 0;
+    double knownBytes = 0;
+    for (const auto& [fileId, info] : files)
+    {
+        if (info.cost > 0)
+        {
+            knownCost += info.cost;
+            knownBytes += info.size;
+        }
+    }
+    const double costPerByte = knownBytes > 0 ? knownCost / knownBytes : 1.0;
+    for (auto& [fileId, info] : files)
+    {
+        if (info.cost <= 0)
+        {
+            info.cost = info.size * costPerByte;
+        }
+    }
+
+    CacheReplayResult result;
+    result.policy = policyType;
+    result.capacity = capacity;
+
+    auto policy = CreateCachePolicy(policyType, capacity);
+    std::unordered_map<uint32_t, uint32_t> cached;  // File ID -> size
+    size_t currentMemory = 0;
+
+    for (const auto& event : events)
+    {
+        const FileInfo& info = files.at(event.fileId);
+        if (info.size == 0)
+        {
+            continue;
+        }
+
+        result.requests++;
+        result.bytesRequested += info.size;
+        result.totalCost += info.cost;
+
+        policy->OnAccess(event.fileId);
+        if (cached.contains(event.fileId))
+        {
+            policy->OnHit(event.fileId);
+            result.hits++;
+            result.bytesHit += info.size;
+            result.savedCost += info.cost;
+            continue;
+        }
+
+        cached.emplace(event.fileId, info.size);
+        currentMemory += info.size;
+        policy->OnInsert(event.fileId, info.size, info.cost);
+        while (currentMemory > capacity)
+        {
+            const auto victim = policy->Evict();
+            if (!victim)
+            {
+                break;
+            }
+            auto it = cached.find(*victim);
+            if (it != cached.end())
+            {
+                currentMemory -= it->second;
+                cached.erase(it);
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Replays a trace against every policy.
+ */
+inline std::vector<CacheReplayResult> ReplayCacheTraceAllPolicies(const std::vector<CacheTraceEvent>& events,
+                                                                  size_t capacity)
+{
+    std::vector<CacheReplayResult> results;
+    for (auto type : { CachePolicyType::LRU, CachePolicyType::WTinyLFU, CachePolicyType::GDSF })
+    {
+        results.push_back(ReplayCacheTrace(events, type, capacity));
+    }
+    return results;
+}
+
+} // namespace GW::Cache
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "CachePolicy.h"
+#include "CacheTrace.h"
 #include <cstdint>
+#include <array>
+#include <atomic>
 #include <vector>
 #include <unordered_map>
-#include <list>
 #include <memory>
 #include <mutex>
+#include <future>
 #include <chrono>
 #include <optional>
 #include <functional>
@@ -22,18 +26,20 @@ struct FileCacheEntry
     size_t size;
     std::chrono::steady_clock::time_point lastAccess;
     uint32_t accessCount;
+    double loadCost;  // Time the loader took, in microseconds
 
     FileCacheEntry()
-        : fileId(0), size(0), accessCount(0)
+        : fileId(0), size(0), accessCount(0), loadCost(0)
     {
         lastAccess = std::chrono::steady_clock::now();
     }
 
-    FileCacheEntry(uint32_t id, std::shared_ptr<std::vector<uint8_t>> fileData)
+    FileCacheEntry(uint32_t id, std::shared_ptr<std::vector<uint8_t>> fileData, double cost = 0)
         : data(fileData)
         , fileId(id)
         , size(fileData ? fileData->size() : 0)
         , accessCount(1)
+        , loadCost(cost)
     {
         lastAccess = std::chrono::steady_clock::now();
     }
@@ -46,12 +52,17 @@ struct FileCacheEntry
 };
 
 /**
- * @brief LRU cache for raw file data from DAT files.
+ * @brief Cache for raw file data from DAT files.
  *
  * Features:
- * - Thread-safe access with mutex locking
- * - LRU eviction when memory limit is reached
- * - Configurable maximum memory usage
+ * - Sharded by file ID, each shard with its own lock and eviction policy, so threads working on
+ *   different files don't contend
+ * - The loader runs outside of any lock; a slow load never blocks hits on other files
+ * - Single-flight loading: concurrent misses on the same file ID wait for one load
+ * - Pluggable eviction policy per shard (see CachePolicy), each shard gets an equal part of the
+ *   memory limit. The default W-TinyLFU keeps a one-off scan over the whole DAT from flushing
+ *   the working set; GDSF weighs the measured load time of a file against its size.
+ * - Optional recording of the request sequence, for replaying it against other policies
  * - File loading via callback (to integrate with DATManager)
  */
 class FileCache
@@ -60,17 +71,29 @@ public:
     /**
      * @brief Callback type for loading file data.
      *
+     * May be called from several threads at once, but never twice at the same time for one file ID.
+     *
      * @param fileId File ID to load.
      * @return Shared pointer to file data, or nullptr on failure.
      */
     using FileLoader = std::function<std::shared_ptr<std::vector<uint8_t>>(uint32_t fileId)>;
 
-    FileCache(size_t maxMemory = 512 * 1024 * 1024)  // Default 512 MB
+    static constexpr size_t kNumShards = 16;
+
+    FileCache(size_t maxMemory = 512 * 1024 * 1024,  // Default 512 MB
+              CachePolicyType policyType = CachePolicyType::WTinyLFU)
         : m_maxMemory(maxMemory)
-        , m_currentMemory(0)
+        , m_policyType(policyType)
     {
+        for (auto& shard : m_shards)
+        {
+            shard.policy = CreateCachePolicy(policyType, GetShardMaxMemory());
+        }
     }
 
+    FileCache(const FileCache&) = delete;
+    FileCache& operator=(const FileCache&) = delete;
+
     /**
      * @brief Sets the file loader callback.
      *
@@ -78,8 +101,9 @@ public:
      */
     void SetFileLoader(FileLoader loader)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_fileLoader = std::move(loader);
+        auto newLoader = std::make_shared<const FileLoader>(std::move(loader));
+        std::lock_guard<std::mutex> lock(m_loaderMutex);
+        m_fileLoader = std::move(newLoader);
     }
 
     /**
@@ -89,11 +113,57 @@ public:
      */
     void SetMaxMemory(size_t bytes)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         m_maxMemory = bytes;
-        EvictToLimit();
+        for (auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.policy->SetCapacity(GetShardMaxMemory());
+            EvictToLimit(shard, GetShardMaxMemory());
+        }
+    }
+
+    /**
+     * @brief Switches the eviction policy.
+     *
+     * Cached files are kept; the new policy sees them as freshly inserted, with no access history.
+     */
+    void SetPolicy(CachePolicyType type)
+    {
+        m_policyType = type;
+        for (auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.policy = CreateCachePolicy(type, GetShardMaxMemory());
+            for (const auto& [fileId, entry] : shard.cache)
+            {
+                shard.policy->OnInsert(fileId, entry.size, entry.loadCost);
+            }
+            EvictToLimit(shard, GetShardMaxMemory());
+        }
     }
 
+    CachePolicyType GetPolicy() const { return m_policyType; }
+
+    /**
+     * @brief Starts recording every GetFile() call, see ReplayCacheTrace().
+     */
+    void StartTrace() { m_trace.Start(); }
+
+    /**
+     * @brief Stops recording and returns the recorded requests.
+     */
+    std::vector<CacheTraceEvent> StopTrace() { return m_trace.Stop(); }
+
+    /**
+     * @brief Whether a trace is being recorded.
+     */
+    bool IsTracing() const { return m_trace.IsRecording(); }
+
+    /**
+     * @brief Gets the number of requests recorded so far.
+     */
+    size_t GetTraceEventCount() const { return m_trace.GetEventCount(); }
+
     /**
      * @brief Gets the maximum memory setting.
      */
@@ -109,44 +179,104 @@ public:
      */
     size_t GetCachedCount() const
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_cache.size();
+        size_t count = 0;
+        for (const auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            count += shard.cache.size();
+        }
+        return count;
     }
 
     /**
      * @brief Gets a file from cache, loading it if necessary.
      *
+     * If another thread is already loading the same file this waits for that load instead of
+     * starting a second one.
+     *
      * @param fileId File ID to retrieve.
      * @return Shared pointer to file data, or nullptr on failure.
      */
     std::shared_ptr<std::vector<uint8_t>> GetFile(uint32_t fileId)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& shard = GetShard(fileId);
+        std::shared_future<std::shared_ptr<std::vector<uint8_t>>> pendingLoad;
+        std::promise<std::shared_ptr<std::vector<uint8_t>>> loadPromise;
 
-        // Check if already cached
-        auto it = m_cache.find(fileId);
-        if (it != m_cache.end())
         {
-            // Move to front of LRU list
-            m_lruList.splice(m_lruList.begin(), m_lruList, it->second.lruIterator);
-            it->second.entry.Touch();
-            return it->second.entry.data;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            shard.policy->OnAccess(fileId);
+
+            // Check if already cached
+            auto it = shard.cache.find(fileId);
+            if (it != shard.cache.end())
+            {
+                shard.policy->OnHit(fileId);
+                it->second.Touch();
+                m_totalHits.fetch_add(1, std::memory_order_relaxed);
+                m_trace.Record(fileId, it->second.size, 0);
+                return it->second.data;
+            }
+
+            m_totalMisses.fetch_add(1, std::memory_order_relaxed);
+
+            // Join a load that is already in flight
+            auto pendingIt = shard.pendingLoads.find(fileId);
+            if (pendingIt != shard.pendingLoads.end())
+            {
+                pendingLoad = pendingIt->second;
+                m_totalCoalesced.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                shard.pendingLoads.emplace(fileId, loadPromise.get_future().share());
+            }
+        }
+
+        if (pendingLoad.valid())
+        {
+            auto data = pendingLoad.get();
+            m_trace.Record(fileId, data ? data->size() : 0, 0);
+            return data;
+        }
+
+        // We own the load. Run the loader without holding the shard lock.
+        std::shared_ptr<std::vector<uint8_t>> data;
+        const auto loadStart = std::chrono::steady_clock::now();
+        try
+        {
+            const auto loader = GetFileLoader();
+            if (loader && *loader)
+            {
+                data = (*loader)(fileId);
+            }
+        }
+        catch (...)
+        {
+            data = nullptr;
         }
 
-        // Not cached, try to load
-        if (!m_fileLoader)
+        if (data && data->empty())
         {
-            return nullptr;
+            data = nullptr;
         }
 
-        auto data = m_fileLoader(fileId);
-        if (!data || data->empty())
+        const double loadCost =
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - loadStart).count();
+        m_trace.Record(fileId, data ? data->size() : 0, loadCost);
+
         {
-            return nullptr;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.pendingLoads.erase(fileId);
+            if (data)
+            {
+                AddToCache(shard, fileId, data, loadCost);
+            }
         }
 
-        // Add to cache
-        AddToCache(fileId, data);
+        // Failed loads are not cached, the next request tries again.
+        loadPromise.set_value(data);
         return data;
     }
 
@@ -158,8 +288,9 @@ public:
      */
     bool IsCached(uint32_t fileId) const
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_cache.find(fileId) != m_cache.end();
+        const auto& shard = GetShard(fileId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.cache.find(fileId) != shard.cache.end();
     }
 
     /**
@@ -190,30 +321,38 @@ public:
      */
     bool Remove(uint32_t fileId)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& shard = GetShard(fileId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
 
-        auto it = m_cache.find(fileId);
-        if (it == m_cache.end())
+        auto it = shard.cache.find(fileId);
+        if (it == shard.cache.end())
         {
             return false;
         }
 
-        m_currentMemory -= it->second.entry.size;
-        m_lruList.erase(it->second.lruIterator);
-        m_cache.erase(it);
+        shard.currentMemory -= it->second.size;
+        m_currentMemory -= it->second.size;
+        shard.policy->OnRemove(fileId);
+        shard.cache.erase(it);
 
         return true;
     }
 
     /**
      * @brief Clears all cached files.
+     *
+     * Loads that are in flight still complete and add their file afterwards.
      */
     void Clear()
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_cache.clear();
-        m_lruList.clear();
-        m_currentMemory = 0;
+        for (auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            m_currentMemory -= shard.currentMemory;
+            shard.cache.clear();
+            shard.policy->Clear();
+            shard.currentMemory = 0;
+        }
     }
 
     /**
@@ -226,86 +365,107 @@ public:
         size_t maxMemory;
         uint64_t totalHits;
         uint64_t totalMisses;
+        uint64_t totalEvictions;
+        uint64_t totalCoalesced;  // Misses that waited for another thread's load of the same file
     };
 
     Stats GetStats() const
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         return {
-            m_cache.size(),
+            GetCachedCount(),
             m_currentMemory,
             m_maxMemory,
             m_totalHits,
-            m_totalMisses
+            m_totalMisses,
+            m_totalEvictions,
+            m_totalCoalesced
         };
     }
 
 private:
-    struct CacheItem
+    struct Shard
     {
-        FileCacheEntry entry;
-        std::list<uint32_t>::iterator lruIterator;
+        mutable std::mutex mutex;
+        std::unordered_map<uint32_t, FileCacheEntry> cache;
+        std::unique_ptr<CachePolicy> policy;
+        std::unordered_map<uint32_t, std::shared_future<std::shared_ptr<std::vector<uint8_t>>>> pendingLoads;
+        size_t currentMemory = 0;
     };
 
-    void AddToCache(uint32_t fileId, std::shared_ptr<std::vector<uint8_t>> data)
+    Shard& GetShard(uint32_t fileId) { return m_shards[ShardIndex(fileId)]; }
+    const Shard& GetShard(uint32_t fileId) const { return m_shards[ShardIndex(fileId)]; }
+
+    static size_t ShardIndex(uint32_t fileId)
     {
-        // Evict if necessary to make room
-        size_t dataSize = data->size();
-        while (m_currentMemory + dataSize > m_maxMemory && !m_cache.empty())
-        {
-            EvictLRU();
-        }
+        // File IDs are often sequential, mix the bits so neighbours land in different shards.
+        return (fileId * 0x9E3779B1u) >> 28;
+    }
 
-        // Add to LRU list (front = most recently used)
-        m_lruList.push_front(fileId);
+    size_t GetShardMaxMemory() const { return m_maxMemory / kNumShards; }
 
-        // Add to cache
-        CacheItem item;
-        item.entry = FileCacheEntry(fileId, data);
-        item.lruIterator = m_lruList.begin();
-        m_cache[fileId] = std::move(item);
+    std::shared_ptr<const FileLoader> GetFileLoader() const
+    {
+        std::lock_guard<std::mutex> lock(m_loaderMutex);
+        return m_fileLoader;
+    }
 
+    void AddToCache(Shard& shard, uint32_t fileId, std::shared_ptr<std::vector<uint8_t>> data, double loadCost)
+    {
+        const size_t dataSize = data->size();
+        shard.cache[fileId] = FileCacheEntry(fileId, data, loadCost);
+        shard.currentMemory += dataSize;
         m_currentMemory += dataSize;
+
+        // The policy may pick the new file itself, in which case it is handed to the caller but not kept.
+        shard.policy->OnInsert(fileId, dataSize, loadCost);
+        EvictToLimit(shard, GetShardMaxMemory());
     }
 
-    void EvictLRU()
+    void EvictOne(Shard& shard)
     {
-        if (m_lruList.empty())
+        const auto fileId = shard.policy->Evict();
+        if (!fileId)
         {
+            // The policy lost track of the entries, start over rather than loop forever.
+            m_currentMemory -= shard.currentMemory;
+            shard.currentMemory = 0;
+            shard.cache.clear();
             return;
         }
 
-        // Remove least recently used (back of list)
-        uint32_t fileId = m_lruList.back();
-        m_lruList.pop_back();
-
-        auto it = m_cache.find(fileId);
-        if (it != m_cache.end())
+        auto it = shard.cache.find(*fileId);
+        if (it != shard.cache.end())
         {
-            m_currentMemory -= it->second.entry.size;
-            m_cache.erase(it);
+            shard.currentMemory -= it->second.size;
+            m_currentMemory -= it->second.size;
+            shard.cache.erase(it);
+            m_totalEvictions.fetch_add(1, std::memory_order_relaxed);
         }
     }
 
-    void EvictToLimit()
+    void EvictToLimit(Shard& shard, size_t shardMaxMemory)
     {
-        while (m_currentMemory > m_maxMemory && !m_cache.empty())
+        while (shard.currentMemory > shardMaxMemory && !shard.cache.empty())
         {
-            EvictLRU();
+            EvictOne(shard);
         }
     }
 
 private:
-    mutable std::mutex m_mutex;
-    std::unordered_map<uint32_t, CacheItem> m_cache;
-    std::list<uint32_t> m_lruList;  // Front = most recently used
+    std::array<Shard, kNumShards> m_shards;
+
+    mutable std::mutex m_loaderMutex;
+    std::shared_ptr<const FileLoader> m_fileLoader;
 
-    FileLoader m_fileLoader;
+    std::atomic<size_t> m_maxMemory;
+    std::atomic<CachePolicyType> m_policyType;
+    std::atomic<size_t> m_currentMemory{ 0 };
+    std::atomic<uint64_t> m_totalHits{ 0 };
+    std::atomic<uint64_t> m_totalMisses{ 0 };
+    std::atomic<uint64_t> m_totalEvictions{ 0 };
+    std::atomic<uint64_t> m_totalCoalesced{ 0 };
 
-    size_t m_maxMemory;
-    size_t m_currentMemory;
-    uint64_t m_totalHits = 0;
-    uint64_t m_totalMisses = 0;
+    CacheTraceRecorder m_trace;
 };
 
 } // namespace GW::Cache
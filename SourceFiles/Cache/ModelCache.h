@@ -1,6 +1,7 @@
 #pragma once
 
 #include "FileCache.h"
+#include "CachePolicy.h"
 #include "../Animation/AnimationClip.h"
 #include "../Animation/Skeleton.h"
 #include "../Parsers/BB9AnimationParser.h"
@@ -10,6 +11,7 @@
 #include <mutex>
 #include <optional>
 #include <functional>
+#include <chrono>
 
 namespace GW::Cache {
 
@@ -26,6 +28,12 @@ struct CachedAnimatedModel
     uint32_t modelHash0 = 0;
     uint32_t modelHash1 = 0;
 
+    // Size of the raw animation file, used as the memory estimate of the parsed model
+    size_t sourceSize = 0;
+
+    // Load and parse time in microseconds, the cost the cache policy weighs it by
+    double loadCost = 0;
+
     bool IsValid() const
     {
         return animationClip && animationClip->IsValid();
@@ -40,7 +48,9 @@ struct CachedAnimatedModel
 /**
  * @brief Cache for parsed model and animation data.
  *
- * Uses weak pointers to allow automatic cleanup when models are no longer referenced.
+ * Models in use are found through weak pointers. On top of that the cache keeps strong
+ * references to models that are no longer in use, up to a memory budget; which ones are kept
+ * is decided by a CachePolicy weighing the load and parse time of a model against its size.
  * Integrates with FileCache for raw data loading.
  */
 class ModelCache
@@ -50,10 +60,49 @@ public:
      * @brief Creates a model cache with an associated file cache.
      *
      * @param fileCache File cache for loading raw data.
+     * @param maxRetainedMemory Budget for models kept alive by the cache itself.
      */
-    explicit ModelCache(std::shared_ptr<FileCache> fileCache = nullptr)
+    explicit ModelCache(std::shared_ptr<FileCache> fileCache = nullptr,
+                        size_t maxRetainedMemory = 64 * 1024 * 1024,  // Default 64 MB
+                        CachePolicyType policyType = CachePolicyType::GDSF)
         : m_fileCache(fileCache)
+        , m_maxRetainedMemory(maxRetainedMemory)
+        , m_policy(CreateCachePolicy(policyType, maxRetainedMemory))
+    {
+    }
+
+    /**
+     * @brief Sets the budget for models kept alive by the cache. 0 keeps none.
+     */
+    void SetMaxRetainedMemory(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxRetainedMemory = bytes;
+        m_policy->SetCapacity(bytes);
+        EvictRetainedToLimit();
+    }
+
+    /**
+     * @brief Switches the policy that picks which models to keep alive.
+     */
+    void SetPolicy(CachePolicyType type)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_policy = CreateCachePolicy(type, m_maxRetainedMemory);
+        for (const auto& [fileId, retained] : m_retained)
+        {
+            m_policy->OnInsert(fileId, retained->sourceSize, retained->loadCost);
+        }
+        EvictRetainedToLimit();
+    }
+
+    /**
+     * @brief Gets the memory estimate of the models kept alive by the cache.
+     */
+    size_t GetRetainedMemory() const
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_retainedMemory;
     }
 
     /**
@@ -74,6 +123,7 @@ public:
     std::shared_ptr<CachedAnimatedModel> GetAnimatedModel(uint32_t fileId)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
+        m_policy->OnAccess(fileId);
 
         // Check if already cached
         auto it = m_animatedModels.find(fileId);
@@ -82,6 +132,15 @@ public:
             auto cached = it->second.lock();
             if (cached)
             {
+                if (m_retained.contains(fileId))
+                {
+                    m_policy->OnHit(fileId);
+                }
+                else
+                {
+                    // Still in use elsewhere but was dropped from the budget, offer it again.
+                    Retain(cached);
+                }
                 return cached;
             }
             // Weak pointer expired, remove from cache
@@ -89,10 +148,15 @@ public:
         }
 
         // Load and parse
+        const auto loadStart = std::chrono::steady_clock::now();
         auto model = LoadAnimatedModel(fileId);
         if (model)
         {
+            const double cost =
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - loadStart).count();
+            model->loadCost = cost;
             m_animatedModels[fileId] = model;
+            Retain(model);
         }
 
         return model;
@@ -148,6 +212,8 @@ public:
     bool Remove(uint32_t fileId)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
+        DropRetained(fileId);
+        m_policy->OnRemove(fileId);
         return m_animatedModels.erase(fileId) > 0;
     }
 
@@ -158,6 +224,9 @@ public:
     {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_animatedModels.clear();
+        m_retained.clear();
+        m_retainedMemory = 0;
+        m_policy->Clear();
     }
 
     /**
@@ -231,6 +300,9 @@ private:
         auto model = std::make_shared<CachedAnimatedModel>();
         model->fileId = fileId;
         model->animationClip = std::make_shared<Animation::AnimationClip>(std::move(*clipOpt));
+        // Users share the clip, so it is finished here rather than by each of them.
+        model->animationClip->BuildAnimationGroups();
+        model->sourceSize = fileData->size();
         model->modelHash0 = model->animationClip->modelHash0;
         model->modelHash1 = model->animationClip->modelHash1;
 
@@ -241,10 +313,50 @@ private:
         return model;
     }
 
+    void Retain(const std::shared_ptr<CachedAnimatedModel>& model)
+    {
+        DropRetained(model->fileId);
+        m_retained[model->fileId] = model;
+        m_retainedMemory += model->sourceSize;
+        m_policy->OnInsert(model->fileId, model->sourceSize, model->loadCost);
+        EvictRetainedToLimit();
+    }
+
+    void DropRetained(uint32_t fileId)
+    {
+        auto it = m_retained.find(fileId);
+        if (it != m_retained.end())
+        {
+            m_retainedMemory -= it->second->sourceSize;
+            m_retained.erase(it);
+        }
+    }
+
+    void EvictRetainedToLimit()
+    {
+        // Evicted models stay reachable through m_animatedModels while someone else holds them.
+        while (m_retainedMemory > m_maxRetainedMemory && !m_retained.empty())
+        {
+            const auto fileId = m_policy->Evict();
+            if (!fileId)
+            {
+                m_retained.clear();
+                m_retainedMemory = 0;
+                break;
+            }
+            DropRetained(*fileId);
+        }
+    }
+
 private:
     mutable std::mutex m_mutex;
     std::shared_ptr<FileCache> m_fileCache;
     std::unordered_map<uint32_t, std::weak_ptr<CachedAnimatedModel>> m_animatedModels;
+
+    size_t m_maxRetainedMemory;
+    size_t m_retainedMemory = 0;
+    std::unique_ptr<CachePolicy> m_policy;
+    std::unordered_map<uint32_t, std::shared_ptr<CachedAnimatedModel>> m_retained;
 };
 
 /**
@@ -271,7 +383,8 @@ public:
     {
         m_fileCache.SetMaxMemory(maxMemoryMB * 1024 * 1024);
         m_fileCache.SetFileLoader(std::move(fileLoader));
-        m_modelCache.SetFileCache(std::make_shared<FileCache>(m_fileCache));
+        // Non-owning: the file cache lives as long as the manager.
+        m_modelCache.SetFileCache(std::shared_ptr<FileCache>(std::shared_ptr<FileCache>(), &m_fileCache));
     }
 
     /**
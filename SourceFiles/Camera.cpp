@@ -58,6 +58,19 @@ void Camera::SetFrustumAsOrthographic(float view_width, float view_height, float
     UpdateProjectionMatrix();
 }
 
+void Camera::SetProjectionWindow(float left, float top, float right, float bottom)
+{
+    m_projection_window = XMFLOAT4(left, top, right, bottom);
+    m_use_projection_window = true;
+    UpdateProjectionMatrix();
+}
+
+void Camera::ClearProjectionWindow()
+{
+    m_use_projection_window = false;
+    UpdateProjectionMatrix();
+}
+
 void Camera::LookAt(FXMVECTOR pos, FXMVECTOR target, FXMVECTOR worldUp)
 {
     XMVECTOR look = XMVector3Normalize(XMVectorSubtract(target, pos));
@@ -268,6 +281,18 @@ void Camera::UpdateProjectionMatrix()
             XMStoreFloat4x4(&m_proj, XMMatrixOrthographicLH(m_viewWidth, m_viewHeight, m_nearZ, m_farZ));
         }
     }
+
+    if (m_use_projection_window)
+    {
+        // Maps the window to [-1, 1] in x and y after the perspective divide.
+        const float left = m_projection_window.x;
+        const float top = m_projection_window.y;
+        const float right = m_projection_window.z;
+        const float bottom = m_projection_window.w;
+        const XMMATRIX window = XMMatrixScaling(2 / (right - left), 2 / (top - bottom), 1) *
+          XMMatrixTranslation(-(left + right) / (right - left), -(top + bottom) / (top - bottom), 0);
+        XMStoreFloat4x4(&m_proj, XMLoadFloat4x4(&m_proj) * window);
+    }
 }
 
 void Camera::OnMouseMove(float yaw_angle_radians, float pitch_angle_radians)
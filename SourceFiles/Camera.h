@@ -44,6 +44,12 @@ public:
 
     void SetFrustumAsPerspective(float fovY, float aspect, float zn, float zf, bool reverse_z = true);
     void SetFrustumAsOrthographic(float view_width, float view_height, float zn, float zf, bool reverse_z = true);
+
+    // Narrows the projection to the rectangle [left, right] x [bottom, top] of normalized device
+    // coordinates and stretches it over the whole viewport, so an image can be rendered in tiles.
+    // Stays in effect across frustum changes until ClearProjectionWindow is called.
+    void SetProjectionWindow(float left, float top, float right, float bottom);
+    void ClearProjectionWindow();
     void LookAt(FXMVECTOR pos, FXMVECTOR target, FXMVECTOR worldUp);
     void LookAt(FXMVECTOR target, FXMVECTOR worldUp);
     void SetOrientation(float pitch, float yaw);
@@ -94,6 +100,10 @@ private:
     float m_farZ = 200000;
     bool m_use_reverse_z = true;
 
+    // left, top, right, bottom of the projection window in NDC
+    bool m_use_projection_window = false;
+    XMFLOAT4 m_projection_window = { -1, 1, 1, -1 };
+
     XMFLOAT3 m_position;
     XMFLOAT3 m_right;
     XMFLOAT3 m_up;
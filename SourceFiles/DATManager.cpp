@@ -1,5 +1,39 @@
 #include "pch.h"
 #include "DATManager.h"
+#include "DatIndexCache.h"
+#include "MurmurHash3.h"
+#include "xentax.h"
+#include <chrono>
+#include <fstream>
+
+std::shared_ptr<std::vector<uint8_t>> DATManager::load_file(uint32_t index)
+{
+    const MFTEntry* mft_entry = m_dat.get_MFT_entry_ptr(index);
+    if (!mft_entry)
+        return nullptr;
+
+    std::unique_ptr<unsigned char[]> data(m_dat.readFile(index, true));
+    if (!data)
+        return nullptr;
+
+    return std::make_shared<std::vector<uint8_t>>(data.get(), data.get() + mft_entry->uncompressedSize);
+}
+
+std::shared_ptr<std::vector<uint8_t>> DATManager::get_file(int index)
+{
+    return m_file_cache.GetFile(index);
+}
+
+unsigned char* DATManager::read_file(int index)
+{
+    const auto file = get_file(index);
+    if (!file)
+        return nullptr;
+
+    unsigned char* data = new unsigned char[file->size()];
+    std::memcpy(data, file->data(), file->size());
+    return data;
+}
 
 FFNA_MapFile DATManager::parse_ffna_map_file(int index)
 {
@@ -8,15 +42,26 @@ FFNA_MapFile DATManager::parse_ffna_map_file(int index)
         throw "mft_entry not found.";
 
     // Get decompressed file data
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    auto data = m_dat.readFile(file_handle, index, true);
-    std::span<unsigned char> file_data(data, mft_entry->uncompressedSize);
-    CloseHandle(file_handle);
+    const auto file = get_file(index);
+    if (! file)
+        return {};
+    std::span<unsigned char> file_data(file->data(), file->size());
+
+    return FFNA_MapFile(0, file_data);
+}
+
+FFNA_MapFileView DATManager::parse_ffna_map_file_view(int index)
+{
+    MFTEntry* mft_entry = m_dat.get_MFT_entry_ptr(index);
+    if (! mft_entry)
+        throw "mft_entry not found.";
 
-    FFNA_MapFile ffna_map_file(0, file_data);
-    delete[] data;
+    // The view shares the cached data, nothing is copied.
+    const auto file = get_file(index);
+    if (! file)
+        return {};
 
-    return ffna_map_file;
+    return FFNA_MapFileView(std::shared_ptr<const unsigned char[]>(file, file->data()), file->size());
 }
 
 FFNA_ModelFile DATManager::parse_ffna_model_file(int index)
@@ -26,15 +71,25 @@ FFNA_ModelFile DATManager::parse_ffna_model_file(int index)
         throw "mft_entry not found.";
 
     // Get decompressed file data
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    auto data = m_dat.readFile(file_handle, index, true);
-    std::span<unsigned char> file_data(data, mft_entry->uncompressedSize);
-    CloseHandle(file_handle);
+    const auto file = get_file(index);
+    if (! file)
+        return {};
+    std::span<unsigned char> file_data(file->data(), file->size());
+
+    return FFNA_ModelFile(0, file_data);
+}
+
+FFNA_ModelFile DATManager::parse_ffna_model_file_lazy(int index)
+{
+    MFTEntry* mft_entry = m_dat.get_MFT_entry_ptr(index);
+    if (! mft_entry)
+        throw "mft_entry not found.";
 
-    FFNA_ModelFile ffna_model_file(0, file_data);
-    delete[] data;
+    const auto file = get_file(index);
+    if (! file)
+        return {};
 
-    return ffna_model_file;
+    return FFNA_ModelFile(std::shared_ptr<const unsigned char[]>(file, file->data()), file->size());
 }
 
 FFNA_ModelFile_Other DATManager::parse_ffna_model_file_other(int index)
@@ -44,15 +99,12 @@ FFNA_ModelFile_Other DATManager::parse_ffna_model_file_other(int index)
         throw "mft_entry not found.";
 
     // Get decompressed file data
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    auto data = m_dat.readFile(file_handle, index, true);
-    std::span<unsigned char> file_data(data, mft_entry->uncompressedSize);
-    CloseHandle(file_handle);
+    const auto file = get_file(index);
+    if (!file)
+        return {};
+    std::span<unsigned char> file_data(file->data(), file->size());
 
-    FFNA_ModelFile_Other ffna_model_file_other(0, file_data);
-    delete[] data;
-
-    return ffna_model_file_other;
+    return FFNA_ModelFile_Other(0, file_data);
 }
 
 bool DATManager::is_other_model_format(int index)
@@ -62,15 +114,12 @@ bool DATManager::is_other_model_format(int index)
         return false;
 
     // Get decompressed file data
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    auto data = m_dat.readFile(file_handle, index, true);
-    std::span<unsigned char> file_data(data, mft_entry->uncompressedSize);
-    CloseHandle(file_handle);
-
-    bool is_other = IsOtherModelFormat(file_data);
-    delete[] data;
+    const auto file = get_file(index);
+    if (!file)
+        return false;
+    std::span<unsigned char> file_data(file->data(), file->size());
 
-    return is_other;
+    return IsOtherModelFormat(file_data);
 }
 
 AMAT_file DATManager::parse_amat_file(int index)
@@ -80,35 +129,26 @@ AMAT_file DATManager::parse_amat_file(int index)
         throw "mft_entry not found.";
 
     // Get decompressed file data
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    auto data = m_dat.readFile(file_handle, index, true);
-    std::span<unsigned char> file_data(data, mft_entry->uncompressedSize);
-    CloseHandle(file_handle);
-
-    AMAT_file amat_file(file_data.data(), file_data.size());
-    delete[] data;
+    const auto file = get_file(index);
+    if (! file)
+        return {};
 
-    return amat_file;
+    return AMAT_file(file->data(), file->size());
 }
 
-DatTexture DATManager::parse_ffna_texture_file(int index)
+DatTexture DATManager::parse_ffna_texture_file(int index, bool decode_pixels)
 {
     MFTEntry* mft_entry = m_dat.get_MFT_entry_ptr(index);
     if (! mft_entry)
         throw "mft_entry not found.";
 
     // Get decompressed file data
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    auto data = m_dat.readFile(file_handle, index, true);
-    std::span<unsigned char> file_data(data, mft_entry->uncompressedSize);
-    CloseHandle(file_handle);
+    const auto file = get_file(index);
+    if (! file)
+        return {};
 
     // Process texture data
-    auto dat_texture = ProcessImageFile(file_data.data(), mft_entry->uncompressedSize);
-
-    delete[] data;
-
-    return dat_texture;
+    return ProcessImageFile(file->data(), static_cast<int>(file->size()), decode_pixels);
 }
 
 std::vector<uint8_t> DATManager::parse_dds_file(int index)
@@ -118,27 +158,17 @@ std::vector<uint8_t> DATManager::parse_dds_file(int index)
         throw "mft_entry not found.";
 
     // Get decompressed file data
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    auto data = m_dat.readFile(file_handle, index, true);
-    std::vector<uint8_t> file_data(data, data + mft_entry->uncompressedSize);
-    CloseHandle(file_handle);
-
-    delete[] data;
+    const auto file = get_file(index);
+    if (! file)
+        return {};
 
-    return file_data;
+    return *file;
 }
 
 bool DATManager::save_raw_decompressed_data_to_file(int index, std::wstring filepath)
 {
-    MFTEntry* mft_entry = m_dat.get_MFT_entry_ptr(index);
-    if (! mft_entry)
-    {
-        return false;
-    }
-
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    std::unique_ptr<unsigned char[]> data(m_dat.readFile(file_handle, index, true));
-    if (!data)
+    const auto file = get_file(index);
+    if (!file)
     {
         // Handle error in reading file
         return false;
@@ -147,7 +177,7 @@ bool DATManager::save_raw_decompressed_data_to_file(int index, std::wstring file
     std::ofstream output_file(filepath, std::ios::out | std::ios::binary);
     if (output_file.is_open())
     {
-        output_file.write(reinterpret_cast<char*>(data.get()), mft_entry->uncompressedSize);
+        output_file.write(reinterpret_cast<const char*>(file->data()), file->size());
         output_file.close();
         return true;
     }
@@ -157,23 +187,271 @@ bool DATManager::save_raw_decompressed_data_to_file(int index, std::wstring file
         return false;
     }
 }
+DecompressionBenchmarkResult DATManager::benchmark_decompression(std::atomic<int>* files_done)
+{
+    DecompressionBenchmarkResult result;
+
+    const auto& mft = get_MFT();
+    std::unordered_set<__int64> seen_offsets;
+    std::vector<unsigned char> raw;
+
+    for (unsigned int i = 0; i < mft.size(); ++i)
+    {
+        if (files_done)
+            files_done->fetch_add(1, std::memory_order_relaxed);
+
+        const auto& entry = mft[i];
+        if (!entry.a || !entry.b || entry.Size <= 0 || !seen_offsets.insert(entry.Offset).second)
+            continue;
+
+        if (!m_dat.readRawFile(i, raw))
+            continue;
+
+        unsigned char* output = nullptr;
+        int output_size = 0;
+        const auto start = std::chrono::high_resolution_clock::now();
+        UnpackGWDat(raw.data(), static_cast<int>(raw.size()), output, output_size);
+        const auto mid = std::chrono::high_resolution_clock::now();
+
+        unsigned char* reference_output = nullptr;
+        int reference_output_size = 0;
+        UnpackGWDatReference(raw.data(), static_cast<int>(raw.size()), reference_output, reference_output_size);
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        result.seconds += std::chrono::duration<double>(mid - start).count();
+        result.reference_seconds += std::chrono::duration<double>(end - mid).count();
+        result.num_files += 1;
+        result.compressed_bytes += raw.size();
+        if (output)
+            result.decompressed_bytes += output_size;
+
+        const bool same = (output == nullptr) == (reference_output == nullptr) &&
+          (!output || (output_size == reference_output_size && memcmp(output, reference_output, output_size) == 0));
+        if (!same)
+            result.num_mismatches += 1;
+
+        delete[] output;
+        delete[] reference_output;
+    }
+
+    return result;
+}
+
+template <typename Fn>
+void DATManager::for_each_texture_file(std::atomic<int>* files_done, Fn&& fn)
+{
+    const auto& mft = get_MFT();
+    std::unordered_set<__int64> seen_offsets;
+
+    for (unsigned int i = 0; i < mft.size(); ++i)
+    {
+        if (files_done)
+            files_done->fetch_add(1, std::memory_order_relaxed);
+
+        const auto& entry = mft[i];
+        if (entry.type < ATEXDXT1 || entry.type > ATTXDXTL || !seen_offsets.insert(entry.Offset).second)
+            continue;
+
+        std::unique_ptr<unsigned char[]> data(m_dat.readFile(i, true));
+        if (data)
+            fn(entry, data.get());
+    }
+}
+
+TextureDecodeBenchmarkResult DATManager::benchmark_texture_decoding(std::atomic<int>* files_done)
+{
+    TextureDecodeBenchmarkResult result;
+    result.decoder_name = GetDXTDecoderName();
+
+    for_each_texture_file(files_done, [&](const MFTEntry& entry, unsigned char* data) {
+        AtexBlocks blocks;
+        if (!DecompressAtexBlocks(data, entry.uncompressedSize, blocks))
+            return;
+
+        const auto* block_data = reinterpret_cast<const unsigned char*>(blocks.data.data());
+        const auto start = std::chrono::high_resolution_clock::now();
+        const auto image = DecodeDXTBlocks(blocks.format, block_data, blocks.width, blocks.height);
+        const auto mid = std::chrono::high_resolution_clock::now();
+        const auto reference_image = DecodeDXTBlocksReference(blocks.format, block_data, blocks.width, blocks.height);
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        result.seconds += std::chrono::duration<double>(mid - start).count();
+        result.reference_seconds += std::chrono::duration<double>(end - mid).count();
+        result.num_textures += 1;
+        result.num_pixels += image.size();
+
+        if (image.size() != reference_image.size() ||
+            memcmp(image.data(), reference_image.data(), image.size() * sizeof(RGBA)) != 0)
+            result.num_mismatches += 1;
+    });
+
+    return result;
+}
+
+AtexDecompressBenchmarkResult DATManager::benchmark_atex_decompression(std::atomic<int>* files_done)
+{
+    AtexDecompressBenchmarkResult result;
+
+    for_each_texture_file(files_done, [&](const MFTEntry& entry, unsigned char* data) {
+        AtexBlocks blocks;
+        AtexBlocks reference_blocks;
+        const auto start = std::chrono::high_resolution_clock::now();
+        const bool ok = DecompressAtexBlocks(data, entry.uncompressedSize, blocks);
+        const auto mid = std::chrono::high_resolution_clock::now();
+        const bool reference_ok = DecompressAtexBlocksReference(data, entry.uncompressedSize, reference_blocks);
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        if (!ok && !reference_ok)
+            return;
+
+        result.seconds += std::chrono::duration<double>(mid - start).count();
+        result.reference_seconds += std::chrono::duration<double>(end - mid).count();
+        result.num_textures += 1;
+        result.num_blocks += blocks.width * blocks.height / 16;
+
+        if (ok != reference_ok || blocks.data != reference_blocks.data)
+            result.num_mismatches += 1;
+    });
+
+    return result;
+}
+
+namespace
+{
+    constexpr uint32_t atex_golden_corpus_magic = 'GAWG'; // "GWAG"
+    constexpr uint32_t atex_golden_corpus_version = 1;
+
+    struct AtexGoldenCorpusEntry
+    {
+        uint32_t file_hash;
+        uint32_t file_size;
+        uint32_t blocks_hash;
+        uint32_t blocks_size;
+    };
+
+    uint64_t get_atex_golden_corpus_key(uint32_t file_hash, uint32_t file_size)
+    {
+        return static_cast<uint64_t>(file_size) << 32 | file_hash;
+    }
+
+    AtexGoldenCorpusEntry hash_atex_texture(const unsigned char* data, int size, const AtexBlocks& blocks)
+    {
+        AtexGoldenCorpusEntry entry{0, static_cast<uint32_t>(size), 0,
+                                    static_cast<uint32_t>(blocks.data.size() * sizeof(unsigned int))};
+        MurmurHash3_x86_32(data, size, 0, &entry.file_hash);
+        MurmurHash3_x86_32(blocks.data.data(), static_cast<int>(entry.blocks_size), 0, &entry.blocks_hash);
+        return entry;
+    }
+}
+
+bool DATManager::save_atex_golden_corpus(const std::filesystem::path& path, std::atomic<int>* files_done)
+{
+    std::vector<AtexGoldenCorpusEntry> entries;
+    for_each_texture_file(files_done, [&](const MFTEntry& entry, unsigned char* data) {
+        AtexBlocks blocks;
+        if (DecompressAtexBlocksReference(data, entry.uncompressedSize, blocks))
+            entries.push_back(hash_atex_texture(data, entry.uncompressedSize, blocks));
+    });
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    const uint32_t header[3] = {atex_golden_corpus_magic, atex_golden_corpus_version,
+                                static_cast<uint32_t>(entries.size())};
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AtexGoldenCorpusEntry));
+    return file.good();
+}
+
+AtexGoldenCorpusResult DATManager::check_atex_golden_corpus(const std::filesystem::path& path,
+                                                            std::atomic<int>* files_done)
+{
+    AtexGoldenCorpusResult result;
+
+    std::ifstream file(path, std::ios::binary);
+    uint32_t header[3] = {};
+    if (!file || !file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[0] != atex_golden_corpus_magic || header[1] != atex_golden_corpus_version)
+        return result;
+
+    // Don't trust the count of a truncated or corrupt corpus with the allocation.
+    std::error_code ec;
+    const uintmax_t file_size = std::filesystem::file_size(path, ec);
+    if (ec || header[2] > (file_size - sizeof(header)) / sizeof(AtexGoldenCorpusEntry))
+    {
+        result.corrupt = true;
+        return result;
+    }
+
+    std::vector<AtexGoldenCorpusEntry> entries(header[2]);
+    if (!file.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(AtexGoldenCorpusEntry)))
+    {
+        result.corrupt = true;
+        return result;
+    }
+
+    std::unordered_map<uint64_t, AtexGoldenCorpusEntry> corpus;
+    for (const auto& entry : entries)
+        corpus.emplace(get_atex_golden_corpus_key(entry.file_hash, entry.file_size), entry);
+
+    result.loaded = true;
+    result.num_entries = static_cast<int>(entries.size());
+
+    for_each_texture_file(files_done, [&](const MFTEntry& entry, unsigned char* data) {
+        AtexBlocks blocks;
+        if (!DecompressAtexBlocks(data, entry.uncompressedSize, blocks))
+            return;
+
+        const auto hashed = hash_atex_texture(data, entry.uncompressedSize, blocks);
+        const auto it = corpus.find(get_atex_golden_corpus_key(hashed.file_hash, hashed.file_size));
+        if (it == corpus.end())
+            return;
+
+        result.num_checked += 1;
+        if (it->second.blocks_hash != hashed.blocks_hash || it->second.blocks_size != hashed.blocks_size)
+            result.num_mismatches += 1;
+    });
+
+    return result;
+}
+
 void DATManager::read_all_files()
 {
     const auto num_files = m_dat.getNumFiles();
+    auto& mft = get_MFT();
+
+    // Restore what we can from the index cache of a previous launch so only new or changed
+    // files have to be decompressed.
+    DatFingerprint fingerprint;
+    const bool has_fingerprint = compute_dat_fingerprint(m_dat_filepath, fingerprint);
+    const auto index_cache_path = get_dat_index_cache_path(m_dat_filepath);
+    DatIndexCacheLoadResult cache_result;
+    if (has_fingerprint)
+    {
+        cache_result = load_dat_index_cache(index_cache_path, fingerprint, mft);
+        m_num_types_read = cache_result.num_restored;
+    }
 
     // Get the number of available threads
     const auto num_threads = std::thread::hardware_concurrency();
 
-    // Fill the concurrent queue with file indices
+    // Fill the concurrent queue with the indices of the files we still have to read
     Concurrency::concurrent_queue<int> file_indices_queue;
+    int num_files_to_decompress = 0;
     for (int i = 0; i < num_files; ++i)
     {
-        file_indices_queue.push(i);
+        if (mft[i].type == NOTREAD)
+        {
+            file_indices_queue.push(i);
+            if (mft[i].b)
+                num_files_to_decompress += 1;
+        }
     }
 
     // Start the file reading threads
     std::vector<std::thread> threads;
-    for (int i = 0; i < num_threads; ++i)
+    for (int i = 0; i < num_threads && !file_indices_queue.empty(); ++i)
     {
         threads.emplace_back(&DATManager::read_files_thread, this, std::ref(file_indices_queue));
     }
@@ -184,7 +462,6 @@ void DATManager::read_all_files()
         thread.join();
     }
 
-    const auto& mft = get_MFT();
     for (const auto& entry : mft) {
         const auto num_files_for_type_it = num_files_per_type.find(static_cast<FileType>(entry.type));
         if (num_files_for_type_it != num_files_per_type.end()) {
@@ -195,6 +472,18 @@ void DATManager::read_all_files()
         }
     }
 
+    if (has_fingerprint && (num_files_to_decompress > 0 || !cache_result.fingerprint_matched))
+    {
+        save_dat_index_cache(index_cache_path, fingerprint, mft);
+    }
+
+    // A previous launch may already have stored the content info of every file.
+    if (std::ranges::all_of(mft, [](const MFTEntry& entry) { return entry.has_content_info || !entry.b; }))
+    {
+        m_num_content_info_read = num_files;
+        m_content_info_state = InitializationState::Completed;
+    }
+
     if (file_indices_queue.empty())
     {
         m_initialization_state = InitializationState::Completed;
@@ -203,8 +492,9 @@ void DATManager::read_all_files()
 
 void DATManager::read_files_thread(Concurrency::concurrent_queue<int>& file_indices_queue)
 {
-    HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-    unsigned char* data;
+    // With the dat mapped every thread reads straight from the shared view, otherwise each
+    // thread keeps one handle open for the whole scan.
+    HANDLE file_handle = m_dat.isMapped() ? NULL : m_dat.get_dat_filehandle(m_dat_filepath.c_str());
     int index;
 
 
@@ -212,8 +502,7 @@ void DATManager::read_files_thread(Concurrency::concurrent_queue<int>& file_indi
     {
         try
         {
-            data = m_dat.readFile(file_handle, index, false);
-            delete[] data;
+            file_handle ? m_dat.readType(file_handle, index) : m_dat.readType(index);
             auto _ = m_num_types_read.fetch_add(1, std::memory_order_relaxed);
         }
         catch (...)
@@ -221,7 +510,89 @@ void DATManager::read_files_thread(Concurrency::concurrent_queue<int>& file_indi
         }
     }
 
-    CloseHandle(file_handle);
+    if (file_handle)
+        CloseHandle(file_handle);
 
     auto remaining_threads = m_num_running_dat_reader_threads.fetch_sub(1, std::memory_order_relaxed);
 }
+
+void DATManager::request_content_info()
+{
+    if (m_initialization_state != InitializationState::Completed)
+        return;
+
+    auto expected = InitializationState::NotStarted;
+    if (!m_content_info_state.compare_exchange_strong(expected, InitializationState::Started))
+        return;
+
+    auto content_info_thread = std::thread(&DATManager::read_all_content_info, this);
+    content_info_thread.detach();
+}
+
+void DATManager::read_all_content_info()
+{
+    const auto num_files = m_dat.getNumFiles();
+    const auto& mft = get_MFT();
+
+    Concurrency::concurrent_queue<int> file_indices_queue;
+    int num_files_done = 0;
+    for (int i = 0; i < num_files; ++i)
+    {
+        if (mft[i].has_content_info || !mft[i].b)
+            num_files_done += 1;
+        else
+            file_indices_queue.push(i);
+    }
+    m_num_content_info_read = num_files_done;
+
+    const bool has_work = !file_indices_queue.empty();
+
+    const auto num_threads = std::thread::hardware_concurrency();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads && has_work; ++i)
+    {
+        threads.emplace_back(&DATManager::read_content_info_thread, this, std::ref(file_indices_queue));
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (has_work)
+    {
+        save_index_cache();
+    }
+
+    m_content_info_state = InitializationState::Completed;
+}
+
+void DATManager::read_content_info_thread(Concurrency::concurrent_queue<int>& file_indices_queue)
+{
+    HANDLE file_handle = m_dat.isMapped() ? NULL : m_dat.get_dat_filehandle(m_dat_filepath.c_str());
+    int index;
+
+    while (file_indices_queue.try_pop(index))
+    {
+        try
+        {
+            file_handle ? m_dat.readContentInfo(file_handle, index) : m_dat.readContentInfo(index);
+        }
+        catch (...)
+        {
+        }
+        m_num_content_info_read.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (file_handle)
+        CloseHandle(file_handle);
+}
+
+void DATManager::save_index_cache()
+{
+    DatFingerprint fingerprint;
+    if (compute_dat_fingerprint(m_dat_filepath, fingerprint))
+    {
+        save_dat_index_cache(get_dat_index_cache_path(m_dat_filepath), fingerprint, get_MFT());
+    }
+}
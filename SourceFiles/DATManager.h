@@ -1,8 +1,10 @@
 #pragma once
 #include "AMAT_file.h"
 #include "FFNA_MapFile.h"
+#include "FFNA_MapFileView.h"
 #include "FFNA_ModelFile.h"
 #include "FFNA_ModelFile_Other.h"
+#include "Cache/ModelCache.h"
 #include <ppl.h>
 #include <concurrent_queue.h>
 
@@ -13,6 +15,62 @@ enum InitializationState
     Completed
 };
 
+struct DecompressionBenchmarkResult
+{
+    int num_files = 0;
+    int num_mismatches = 0; // Files where UnpackGWDat and UnpackGWDatReference disagree
+    uint64_t compressed_bytes = 0;
+    uint64_t decompressed_bytes = 0;
+    double seconds = 0;
+    double reference_seconds = 0;
+
+    double mb_per_second() const { return seconds > 0 ? decompressed_bytes / seconds / 1e6 : 0; }
+    double reference_mb_per_second() const
+    {
+        return reference_seconds > 0 ? decompressed_bytes / reference_seconds / 1e6 : 0;
+    }
+};
+
+struct TextureDecodeBenchmarkResult
+{
+    int num_textures = 0;
+    int num_mismatches = 0; // Textures where DecodeDXTBlocks and DecodeDXTBlocksReference disagree
+    uint64_t num_pixels = 0;
+    double seconds = 0;
+    double reference_seconds = 0;
+    const char* decoder_name = "";
+
+    double mpixels_per_second() const { return seconds > 0 ? num_pixels / seconds / 1e6 : 0; }
+    double reference_mpixels_per_second() const
+    {
+        return reference_seconds > 0 ? num_pixels / reference_seconds / 1e6 : 0;
+    }
+};
+
+struct AtexDecompressBenchmarkResult
+{
+    int num_textures = 0;
+    int num_mismatches = 0; // Textures where AtexDecompress and AtexDecompressReference disagree
+    uint64_t num_blocks = 0;
+    double seconds = 0;
+    double reference_seconds = 0;
+
+    double mblocks_per_second() const { return seconds > 0 ? num_blocks / seconds / 1e6 : 0; }
+    double reference_mblocks_per_second() const
+    {
+        return reference_seconds > 0 ? num_blocks / reference_seconds / 1e6 : 0;
+    }
+};
+
+struct AtexGoldenCorpusResult
+{
+    bool loaded = false;    // false if the corpus file couldn't be read
+    bool corrupt = false;   // The file is a corpus, but truncated or with an entry count that doesn't fit it
+    int num_entries = 0;    // Textures in the corpus
+    int num_checked = 0;    // Textures of this dat that are in the corpus
+    int num_mismatches = 0; // Of those, the ones AtexDecompress now decodes differently
+};
+
 class DATManager
 {
 public:
@@ -28,6 +86,12 @@ public:
             return false;
         }
 
+        // Map the dat once so reads don't need their own file handle. If this fails we
+        // fall back to opening a handle per read.
+        m_dat.mapDat(m_dat_filepath.c_str());
+
+        m_file_cache.SetFileLoader([this](uint32_t index) { return load_file(index); });
+
         auto read_all_thread = std::thread(&DATManager::read_all_files, this);
         read_all_thread.detach();
 
@@ -37,46 +101,124 @@ public:
     std::atomic<InitializationState> m_initialization_state{NotStarted};
 
     int get_num_files_type_read() { return m_num_types_read; }
+
     int get_num_files() { return m_dat.getNumFiles(); }
 
+    // MFTEntry::murmurhash3 and chunk_ids need every file fully decompressed, so the startup scan
+    // leaves them out. request_content_info() starts a background pass that fills them in once the
+    // scan has completed; calling it again is a no-op. is_content_info_ready() tells when they are valid.
+    void request_content_info();
+    bool is_content_info_ready() const { return m_content_info_state == InitializationState::Completed; }
+    bool is_reading_content_info() const { return m_content_info_state == InitializationState::Started; }
+    int get_num_files_content_info_read() { return m_num_content_info_read; }
+
     const std::wstring get_filepath() {
         return m_dat_filepath;
     }
 
+    // Unique for every DATManager created during the session. Unlike the address, it is never reused by a
+    // manager created after this one is destroyed.
+    uint64_t get_instance_id() const { return m_instance_id; }
+
     std::vector<MFTEntry>& get_MFT() { return m_dat.get_MFT(); }
 
     FFNA_MapFile parse_ffna_map_file(int index);
+    // Zero-copy alternative to parse_ffna_map_file, see FFNA_MapFileView.
+    FFNA_MapFileView parse_ffna_map_file_view(int index);
     FFNA_ModelFile parse_ffna_model_file(int index);
+    // Only reads the chunk directory, the chunks are decoded on first use. See FFNA_ModelFile.
+    FFNA_ModelFile parse_ffna_model_file_lazy(int index);
     FFNA_ModelFile_Other parse_ffna_model_file_other(int index);
     bool is_other_model_format(int index);
     AMAT_file parse_amat_file(int index);
-    DatTexture parse_ffna_texture_file(int index);
+    // With decode_pixels = false the texture keeps its DXT blocks and skips the RGBA expansion,
+    // see ProcessImageFile.
+    DatTexture parse_ffna_texture_file(int index, bool decode_pixels = true);
     std::vector<uint8_t> parse_dds_file(int index);
 
     bool save_raw_decompressed_data_to_file(int index, std::wstring filepath);
 
-    unsigned char* read_file(int index)
-    {
-        HANDLE file_handle = m_dat.get_dat_filehandle(m_dat_filepath.c_str());
-        unsigned char* data = m_dat.readFile(file_handle, index, true);
-        CloseHandle(file_handle);
-        return data;
-    }
+    // Decompresses every compressed MFT entry with both the table-driven decoder and the
+    // reference port, checks that they agree and measures their throughput. Single threaded
+    // and slow; meant to be run on demand. files_done is updated as files are processed.
+    DecompressionBenchmarkResult benchmark_decompression(std::atomic<int>* files_done = nullptr);
+
+    // Runs the DXT block stage of every ATEX/ATTX texture through both DecodeDXTBlocks and the
+    // reference decoder, checks that their output is identical and measures their throughput.
+    // Only the block decoding is timed, not the file or ATEX decompression.
+    TextureDecodeBenchmarkResult benchmark_texture_decoding(std::atomic<int>* files_done = nullptr);
+
+    // Runs the entropy stage of every ATEX/ATTX texture through both AtexDecompress and
+    // AtexDecompressReference, checks that they produce the same blocks and measures their throughput.
+    AtexDecompressBenchmarkResult benchmark_atex_decompression(std::atomic<int>* files_done = nullptr);
+
+    // The golden corpus records a hash of the blocks AtexDecompressReference produces for every
+    // ATEX/ATTX texture, keyed by the hash of the file, so later changes to the entropy stage can be
+    // checked against it (on this or any other dat) without the reference.
+    bool save_atex_golden_corpus(const std::filesystem::path& path, std::atomic<int>* files_done = nullptr);
+    AtexGoldenCorpusResult check_atex_golden_corpus(const std::filesystem::path& path,
+                                                    std::atomic<int>* files_done = nullptr);
+
+    // Decompressed contents of an MFT entry, or nullptr if it can't be read. Goes through the file cache, so a
+    // file that is still cached isn't decompressed again. The buffer is shared with the cache, don't modify it.
+    std::shared_ptr<std::vector<uint8_t>> get_file(int index);
+
+    // Decompresses an MFT entry. The caller owns the returned buffer (delete[]). This is a copy of get_file(),
+    // for callers that want a buffer of their own.
+    unsigned char* read_file(int index);
+
+    // Both caches are keyed by MFT index. The model cache loads animation files through the file cache.
+    GW::Cache::FileCache& get_file_cache() { return m_file_cache; }
+    GW::Cache::ModelCache& get_model_cache() { return m_model_cache; }
+
+    // Records the file cache's GetFile sequence (every get_file, read_file and parse_* call) with sizes and
+    // load times, so the access pattern of a session can be replayed against the cache policies in
+    // Cache/CachePolicy.h.
+    void start_cache_trace() { m_file_cache.StartTrace(); }
+    std::vector<GW::Cache::CacheTraceEvent> stop_cache_trace() { return m_file_cache.StopTrace(); }
+    bool is_recording_cache_trace() const { return m_file_cache.IsTracing(); }
+    size_t get_cache_trace_event_count() const { return m_file_cache.GetTraceEventCount(); }
+
+    // Raw (compressed) bytes of an MFT entry. Only available when the dat is memory-mapped.
+    std::span<const unsigned char> get_raw_file_view(int index) const { return m_dat.getRawFileView(index); }
 
     int get_num_files_for_type(FileType type) {
         return num_files_per_type[type];
     }
 
 private:
+    // Calls fn(entry, data) for every ATEX/ATTX file, once per distinct file offset.
+    template <typename Fn>
+    void for_each_texture_file(std::atomic<int>* files_done, Fn&& fn);
+
+    static inline std::atomic<uint64_t> s_next_instance_id{1};
+    const uint64_t m_instance_id = s_next_instance_id.fetch_add(1);
+
     std::wstring m_dat_filepath;
     GWDat m_dat;
 
     std::atomic<int> m_num_types_read{0};
     std::atomic<int> m_num_running_dat_reader_threads{0};
 
+    std::atomic<InitializationState> m_content_info_state{NotStarted};
+    std::atomic<int> m_num_content_info_read{0};
+
     std::unordered_map<FileType, int> num_files_per_type;
 
+    GW::Cache::FileCache m_file_cache{256 * 1024 * 1024};
+    // Non-owning: the file cache lives as long as this manager.
+    GW::Cache::ModelCache m_model_cache{std::shared_ptr<GW::Cache::FileCache>(std::shared_ptr<GW::Cache::FileCache>(), &m_file_cache)};
+
+    // The file cache's loader, decompresses an MFT entry.
+    std::shared_ptr<std::vector<uint8_t>> load_file(uint32_t index);
+
     void read_all_files();
 
     void read_files_thread(Concurrency::concurrent_queue<int>& file_indices_queue);
+
+    void read_all_content_info();
+
+    void read_content_info_thread(Concurrency::concurrent_queue<int>& file_indices_queue);
+
+    void save_index_cache();
 };
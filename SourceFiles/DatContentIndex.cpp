@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "DatContentIndex.h"
+
+bool DatContentIndex::sync(const std::map<int, std::unique_ptr<DATManager>>& dat_managers)
+{
+    bool changed = false;
+
+    // Forget dats that were closed
+    std::vector<uint64_t> closed_dats;
+    for (const auto& [dat_id, alias] : m_aliases)
+    {
+        const auto it = dat_managers.find(alias);
+        if (it == dat_managers.end() || it->second->get_instance_id() != dat_id)
+        {
+            const bool still_open = std::ranges::any_of(
+              dat_managers, [dat_id](const auto& pair) { return pair.second->get_instance_id() == dat_id; });
+            if (!still_open)
+                closed_dats.push_back(dat_id);
+        }
+    }
+    for (const uint64_t dat_id : closed_dats)
+    {
+        remove_dat(dat_id);
+        changed = true;
+    }
+
+    // Aliases shift when a dat before them is closed, so refresh them. Then index the new dats.
+    for (const auto& [alias, dat_manager] : dat_managers)
+    {
+        const auto it = m_aliases.find(dat_manager->get_instance_id());
+        if (it != m_aliases.end())
+        {
+            it->second = alias;
+        }
+        else if (dat_manager->is_content_info_ready())
+        {
+            add_dat(dat_manager.get());
+            m_aliases.emplace(dat_manager->get_instance_id(), alias);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+bool DatContentIndex::is_indexed(int alias) const
+{
+    return std::ranges::any_of(m_aliases, [alias](const auto& pair) { return pair.second == alias; });
+}
+
+std::vector<DatContentLocation> DatContentIndex::find(const DatContentKey& key) const
+{
+    std::vector<DatContentLocation> locations;
+    const auto it = m_entries.find(key);
+    if (it != m_entries.end())
+    {
+        to_locations(it->second, locations);
+    }
+    return locations;
+}
+
+void DatContentIndex::add_dat(DATManager* dat_manager)
+{
+    const auto& mft = dat_manager->get_MFT();
+    for (int i = 0; i < mft.size(); ++i)
+    {
+        // Entries without content info (the header entries and the ones that failed to decompress)
+        // all have a zero hash and would end up as one bogus payload.
+        if (!mft[i].has_content_info)
+            continue;
+
+        m_entries[get_key(mft[i])].push_back({dat_manager->get_instance_id(), i});
+    }
+}
+
+void DatContentIndex::remove_dat(const DATManager* dat_manager)
+{
+    if (dat_manager && m_aliases.contains(dat_manager->get_instance_id()))
+        remove_dat(dat_manager->get_instance_id());
+}
+
+void DatContentIndex::remove_dat(uint64_t dat_id)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        std::erase_if(it->second, [dat_id](const IndexedFile& file) { return file.dat_id == dat_id; });
+        if (it->second.empty())
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+    m_aliases.erase(dat_id);
+}
+
+void DatContentIndex::to_locations(const std::vector<IndexedFile>& files,
+                                   std::vector<DatContentLocation>& locations_out) const
+{
+    locations_out.clear();
+    for (const auto& file : files)
+    {
+        locations_out.push_back({m_aliases.at(file.dat_id), file.mft_index});
+    }
+
+    std::ranges::sort(locations_out, [](const DatContentLocation& a, const DatContentLocation& b) {
+        return a.alias != b.alias ? a.alias < b.alias : a.mft_index < b.mft_index;
+    });
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "DATManager.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Content-addressed index over all loaded dats. Files are keyed by the murmurhash3 and size of
+// their decompressed payload, so identical files in different dats (or at different MFT indices
+// in the same dat) end up under the same key no matter their file id.
+//
+// Each dat is indexed once, after its content info pass has completed. Comparing dats is then a
+// lookup over the precomputed keys, and anything that caches decoded assets can use the key to
+// share them between dats.
+
+struct DatContentKey
+{
+    uint32_t murmurhash3 = 0;
+    uint32_t size = 0;
+
+    bool operator==(const DatContentKey&) const = default;
+};
+
+struct DatContentKeyHash
+{
+    size_t operator()(const DatContentKey& key) const
+    {
+        return std::hash<uint64_t>{}(static_cast<uint64_t>(key.size) << 32 | key.murmurhash3);
+    }
+};
+
+struct DatContentLocation
+{
+    int alias;
+    int mft_index;
+};
+
+class DatContentIndex
+{
+public:
+    // Indexes the dats whose content info has become ready and forgets the ones that were closed.
+    // Dats that are still open keep their entries even if their alias changed. Returns true if the
+    // set of indexed dats changed.
+    bool sync(const std::map<int, std::unique_ptr<DATManager>>& dat_managers);
+
+    // Forgets the files of a dat that is about to be closed.
+    void remove_dat(const DATManager* dat_manager);
+
+    // Number of distinct payloads.
+    size_t size() const { return m_entries.size(); }
+
+    bool is_indexed(int alias) const;
+
+    // Every file with the given content, in alias order.
+    std::vector<DatContentLocation> find(const DatContentKey& key) const;
+
+    // Calls fn(key, locations) for every distinct payload.
+    template <typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        std::vector<DatContentLocation> locations;
+        for (const auto& [key, files] : m_entries)
+        {
+            to_locations(files, locations);
+            fn(key, locations);
+        }
+    }
+
+    static DatContentKey get_key(const MFTEntry& entry)
+    {
+        return {entry.murmurhash3, static_cast<uint32_t>(entry.uncompressedSize)};
+    }
+
+private:
+    struct IndexedFile
+    {
+        uint64_t dat_id; // DATManager::get_instance_id()
+        int mft_index;
+    };
+
+    void add_dat(DATManager* dat_manager);
+    void remove_dat(uint64_t dat_id);
+    void to_locations(const std::vector<IndexedFile>& files, std::vector<DatContentLocation>& locations_out) const;
+
+    std::unordered_map<DatContentKey, std::vector<IndexedFile>, DatContentKeyHash> m_entries;
+    std::unordered_map<uint64_t, int> m_aliases; // Indexed dats by instance id, and their current alias
+};
@@ -0,0 +1,228 @@
+#include "pch.h"
+#include "DatIndexCache.h"
+#include "MurmurHash3.h"
+#include <fstream>
+
+namespace
+{
+constexpr uint32_t kIndexCacheMagic = 'XIWG';
+constexpr uint32_t kIndexCacheVersion = 2;
+
+constexpr uint32_t kEntryHasContentInfo = 1 << 0;
+
+#pragma pack(push, 1)
+struct IndexCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t file_size;
+    int64_t last_write_time;
+    uint32_t header_hash;
+    uint32_t num_entries;
+};
+
+struct IndexCacheEntry
+{
+    int64_t offset;
+    int32_t size;
+    int32_t crc;
+    int32_t type;
+    int32_t uncompressed_size;
+    uint32_t flags;
+    uint32_t murmurhash3;
+    uint32_t num_chunk_ids; // Followed by num_chunk_ids uint32_t chunk ids
+};
+#pragma pack(pop)
+
+struct EntryKey
+{
+    int64_t offset;
+    int32_t size;
+    int32_t crc;
+
+    bool operator==(const EntryKey&) const = default;
+};
+
+struct EntryKeyHash
+{
+    size_t operator()(const EntryKey& key) const
+    {
+        return std::hash<int64_t>()(key.offset) ^ (std::hash<int32_t>()(key.size) * 31) ^
+          (std::hash<int32_t>()(key.crc) * 131);
+    }
+};
+} // namespace
+
+bool compute_dat_fingerprint(const std::wstring& dat_filepath, DatFingerprint& fingerprint_out)
+{
+    std::error_code ec;
+    const auto file_size = std::filesystem::file_size(dat_filepath, ec);
+    if (ec)
+        return false;
+
+    const auto last_write_time = std::filesystem::last_write_time(dat_filepath, ec);
+    if (ec)
+        return false;
+
+    std::ifstream file(dat_filepath, std::ios::binary);
+    MainHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+
+    fingerprint_out.file_size = file_size;
+    fingerprint_out.last_write_time = last_write_time.time_since_epoch().count();
+    MurmurHash3_x86_32(&header, sizeof(header), 0, &fingerprint_out.header_hash);
+    return true;
+}
+
+std::filesystem::path get_dat_index_cache_path(const std::wstring& dat_filepath)
+{
+    wchar_t exePath[MAX_PATH];
+    GetModuleFileNameW(NULL, exePath, MAX_PATH);
+    std::filesystem::path exeDir = std::filesystem::path(exePath).parent_path();
+
+    // Several dats can be loaded at once (compare panel), so each full path gets its own file.
+    std::wstring normalized_path = std::filesystem::absolute(dat_filepath).wstring();
+    std::transform(normalized_path.begin(), normalized_path.end(), normalized_path.begin(), ::towlower);
+    uint32_t path_hash = 0;
+    MurmurHash3_x86_32(normalized_path.data(), static_cast<int>(normalized_path.size() * sizeof(wchar_t)), 0, &path_hash);
+
+    const auto filename =
+      std::format(L"{}_{:08x}.idx", std::filesystem::path(dat_filepath).stem().wstring(), path_hash);
+    return exeDir / "dat_index" / filename;
+}
+
+DatIndexCacheLoadResult load_dat_index_cache(const std::filesystem::path& cache_path,
+                                             const DatFingerprint& fingerprint, std::vector<MFTEntry>& mft)
+{
+    DatIndexCacheLoadResult result;
+
+    std::ifstream file(cache_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return result;
+
+    const auto file_size = static_cast<size_t>(file.tellg());
+    std::vector<uint8_t> data(file_size);
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(data.data()), file_size))
+        return result;
+
+    if (data.size() < sizeof(IndexCacheHeader))
+        return result;
+
+    IndexCacheHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != kIndexCacheMagic || header.version != kIndexCacheVersion)
+        return result;
+
+    const DatFingerprint cached_fingerprint{header.file_size, header.last_write_time, header.header_hash};
+    result.fingerprint_matched = cached_fingerprint == fingerprint;
+
+    // Index the MFT by the fields that identify a file's contents.
+    std::unordered_map<EntryKey, std::vector<size_t>, EntryKeyHash> mft_lookup;
+    mft_lookup.reserve(mft.size());
+    for (size_t i = 0; i < mft.size(); ++i)
+    {
+        mft_lookup[{mft[i].Offset, mft[i].Size, mft[i].CRC}].push_back(i);
+    }
+
+    size_t pos = sizeof(IndexCacheHeader);
+    for (uint32_t n = 0; n < header.num_entries; ++n)
+    {
+        IndexCacheEntry entry;
+        if (pos + sizeof(entry) > data.size())
+            break;
+        memcpy(&entry, data.data() + pos, sizeof(entry));
+        pos += sizeof(entry);
+
+        if (entry.num_chunk_ids > (data.size() - pos) / sizeof(uint32_t))
+            break;
+        const size_t chunk_ids_size = static_cast<size_t>(entry.num_chunk_ids) * sizeof(uint32_t);
+        const uint8_t* chunk_ids = data.data() + pos;
+        pos += chunk_ids_size;
+
+        const auto it = mft_lookup.find({entry.offset, entry.size, entry.crc});
+        if (it == mft_lookup.end())
+            continue;
+
+        for (const size_t index : it->second)
+        {
+            MFTEntry& mft_entry = mft[index];
+            if (mft_entry.type != NOTREAD || !mft_entry.b)
+                continue;
+
+            mft_entry.type = entry.type;
+            mft_entry.uncompressedSize = entry.uncompressed_size;
+            if (entry.flags & kEntryHasContentInfo)
+            {
+                mft_entry.murmurhash3 = entry.murmurhash3;
+                mft_entry.chunk_ids.resize(entry.num_chunk_ids);
+                memcpy(mft_entry.chunk_ids.data(), chunk_ids, chunk_ids_size);
+                mft_entry.has_content_info = true;
+            }
+            result.num_restored += 1;
+        }
+    }
+
+    return result;
+}
+
+bool save_dat_index_cache(const std::filesystem::path& cache_path, const DatFingerprint& fingerprint,
+                          const std::vector<MFTEntry>& mft)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(cache_path.parent_path(), ec);
+
+    auto temp_path = cache_path;
+    temp_path += L".tmp";
+
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        IndexCacheHeader header{kIndexCacheMagic,           kIndexCacheVersion,     fingerprint.file_size,
+                                fingerprint.last_write_time, fingerprint.header_hash, 0};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // Entries that share their data (same offset, size and CRC) only need to be stored once.
+        std::unordered_set<EntryKey, EntryKeyHash> written;
+        for (const auto& mft_entry : mft)
+        {
+            // MFTBASE entries are classified from their flags alone, no need to store them.
+            if (mft_entry.type == NOTREAD || !mft_entry.b)
+                continue;
+
+            const EntryKey key{mft_entry.Offset, mft_entry.Size, mft_entry.CRC};
+            if (!written.insert(key).second)
+                continue;
+
+            const IndexCacheEntry entry{mft_entry.Offset,
+                                        mft_entry.Size,
+                                        mft_entry.CRC,
+                                        mft_entry.type,
+                                        mft_entry.uncompressedSize,
+                                        mft_entry.has_content_info ? kEntryHasContentInfo : 0,
+                                        mft_entry.has_content_info ? mft_entry.murmurhash3 : 0,
+                                        static_cast<uint32_t>(mft_entry.has_content_info ? mft_entry.chunk_ids.size() : 0)};
+            file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            file.write(reinterpret_cast<const char*>(mft_entry.chunk_ids.data()),
+                       entry.num_chunk_ids * sizeof(uint32_t));
+            header.num_entries += 1;
+        }
+
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!file.good())
+            return false;
+    }
+
+    std::filesystem::rename(temp_path, cache_path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+
+    return true;
+}
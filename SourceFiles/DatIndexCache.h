@@ -0,0 +1,44 @@
+#pragma once
+#include "GWUnpacker.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Sidecar cache of DATManager's startup type scan and its content info pass. Together they
+// decompress every file in gw.dat just to fill in MFTEntry::type, uncompressedSize, murmurhash3
+// and chunk_ids, so the results are stored in a small binary file next to the executable and
+// reused on the next launch.
+//
+// The cache records a fingerprint of the dat (size, last write time and a hash of the main
+// header). Entries are matched on their offset, size and CRC, so after a game update only the
+// files that actually changed have to be scanned again.
+
+struct DatFingerprint
+{
+    uint64_t file_size = 0;
+    int64_t last_write_time = 0;
+    uint32_t header_hash = 0;
+
+    bool operator==(const DatFingerprint&) const = default;
+};
+
+struct DatIndexCacheLoadResult
+{
+    int num_restored = 0;
+    bool fingerprint_matched = false;
+};
+
+bool compute_dat_fingerprint(const std::wstring& dat_filepath, DatFingerprint& fingerprint_out);
+
+std::filesystem::path get_dat_index_cache_path(const std::wstring& dat_filepath);
+
+// Copies the cached scan results into every MFT entry whose offset, size and CRC match a cached
+// entry. Entries that are not restored keep their NOTREAD type.
+DatIndexCacheLoadResult load_dat_index_cache(const std::filesystem::path& cache_path,
+                                             const DatFingerprint& fingerprint, std::vector<MFTEntry>& mft);
+
+// Writes the scan results of all entries that have been read. The file is written to a
+// temporary name first and then moved into place, so an interrupted write never leaves a
+// truncated cache behind.
+bool save_dat_index_cache(const std::filesystem::path& cache_path, const DatFingerprint& fingerprint,
+                          const std::vector<MFTEntry>& mft);
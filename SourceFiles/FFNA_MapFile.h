@@ -1287,7 +1287,7 @@ struct EnvironmentInfoChunk {
     uint8_t end_byte_0xFF;
 
     EnvironmentInfoChunk() = default;
-    EnvironmentInfoChunk(int offset, unsigned char* data) {
+    EnvironmentInfoChunk(int offset, const unsigned char* data) {
         std::memcpy(&chunk_id, &data[offset], sizeof(chunk_id));
         offset += sizeof(chunk_id);
 
@@ -1861,17 +1861,19 @@ struct FFNA_MapFile
         std::memcpy(&ffna_type, &data[offset], sizeof(ffna_type));
         current_offset += 5;
 
-        // Read all chunks
-        while (current_offset < data.size())
+        // Read all chunks. Only the chunk headers are needed here, the bodies are parsed below.
+        while (current_offset + 8 <= data.size())
         {
-            // Create a GeneralChunk instance using the current offset and data pointer
-            GeneralChunk chunk(current_offset, data.data());
+            uint32_t chunk_id;
+            uint32_t chunk_size;
+            std::memcpy(&chunk_id, &data[current_offset], sizeof(chunk_id));
+            std::memcpy(&chunk_size, &data[current_offset + 4], sizeof(chunk_size));
 
-            // Add the GeneralChunk instance to the riff_chunks map using its chunk_id as the key
-            riff_chunks.emplace(chunk.chunk_id, current_offset);
+            // Add the chunk offset to the riff_chunks map using its chunk_id as the key
+            riff_chunks.emplace(chunk_id, current_offset);
 
             // Move to the next chunk by updating the current_offset
-            current_offset += 8 + chunk.chunk_size;
+            current_offset += 8 + chunk_size;
         }
 
         //Check if the CHUNK_ID_20000000 is in the riff_chunks map
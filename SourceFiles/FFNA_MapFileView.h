@@ -0,0 +1,281 @@
+#pragma once
+#include "FFNA_MapFile.h"
+#include <memory>
+#include <span>
+
+// Zero-copy alternative to FFNA_MapFile.
+//
+// FFNA_MapFile copies every chunk body into its own vectors, so a parsed map takes about twice
+// the memory of the decompressed file and hundreds of small allocations. FFNA_MapFileView keeps
+// the decompressed file in one ref-counted buffer instead: chunks and fixed-layout arrays are
+// std::spans that point straight into it, and only small headers are copied out.
+//
+// Copies of a view share the buffer. Spans taken from a view are only valid while a view that
+// owns the buffer is alive.
+//
+// The member names mirror FFNA_MapFile so code that only reads the terrain, the props and the
+// filename tables works with either. Chunks without a view (shore, pathfinding, ...) can be
+// parsed from get_chunk() with the FFNA_MapFile chunk structs.
+
+// Bounds-checked cursor over a chunk. Reading past the end returns zeros/empty spans and marks
+// the reader as failed instead of reading out of bounds.
+class MapChunkReader
+{
+public:
+    explicit MapChunkReader(std::span<const uint8_t> data)
+        : m_data(data)
+    {
+    }
+
+    template <typename T>
+    T read()
+    {
+        T value{};
+        if (has_bytes(sizeof(T)))
+            std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return value;
+    }
+
+    // The array is not copied. All callers run on x86/x64, where unaligned loads are fine.
+    template <typename T>
+    std::span<const T> read_array(size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (count > (m_data.size() - std::min(m_offset, m_data.size())) / sizeof(T))
+        {
+            m_failed = true;
+            m_offset = m_data.size();
+            return {};
+        }
+
+        const auto* first = reinterpret_cast<const T*>(m_data.data() + m_offset);
+        m_offset += count * sizeof(T);
+        return {first, count};
+    }
+
+    void skip(size_t num_bytes) { m_offset += num_bytes; }
+    size_t offset() const { return m_offset; }
+    bool failed() const { return m_failed || m_offset > m_data.size(); }
+
+private:
+    bool has_bytes(size_t num_bytes)
+    {
+        if (m_offset > m_data.size() || num_bytes > m_data.size() - m_offset)
+        {
+            m_failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    std::span<const uint8_t> m_data;
+    size_t m_offset = 0;
+    bool m_failed = false;
+};
+
+static_assert(sizeof(Chunk4DataElement) == 6, "Chunk4DataElement is read in place from the file");
+
+struct TerrainChunkView
+{
+    uint32_t terrain_x_dims = 0;
+    uint32_t terrain_y_dims = 0;
+    std::span<const float> terrain_heightmap;
+    std::span<const uint8_t> terrain_texture_indices_maybe;
+    std::span<const uint8_t> terrain_shadow_map;
+
+    TerrainChunkView() = default;
+
+    // Same layout as Chunk8.
+    explicit TerrainChunkView(std::span<const uint8_t> chunk)
+    {
+        MapChunkReader reader(chunk);
+        reader.skip(8 + 4 + 4 + 1 + 4); // chunk header, magic numbers, tag, some_size
+        terrain_x_dims = reader.read<uint32_t>();
+        terrain_y_dims = reader.read<uint32_t>();
+        reader.skip(4 + 4 + 2 + 4 + 4 + 1 + 4); // floats, sizes and tag up to the heightmap
+        terrain_heightmap = reader.read_array<float>(static_cast<size_t>(terrain_x_dims) * terrain_y_dims);
+
+        reader.skip(1); // tag2
+        const auto num_terrain_tiles = reader.read<uint32_t>();
+        terrain_texture_indices_maybe = reader.read_array<uint8_t>(num_terrain_tiles);
+
+        reader.skip(1 + 4); // tag3, some_size2
+        reader.skip(reader.read<uint8_t>());
+        reader.skip(1); // tag4
+        reader.skip(reader.read<uint32_t>());
+        reader.skip(1); // tag5
+        reader.skip(reader.read<uint32_t>());
+
+        reader.skip(1); // tag6
+        const auto num_terrain_tiles1 = reader.read<uint32_t>();
+        terrain_shadow_map = reader.read_array<uint8_t>(num_terrain_tiles1);
+    }
+};
+
+struct FilenamesChunkView
+{
+    std::span<const Chunk4DataElement> array;
+
+    FilenamesChunkView() = default;
+
+    // Same layout as Chunk4.
+    explicit FilenamesChunkView(std::span<const uint8_t> chunk)
+    {
+        MapChunkReader reader(chunk);
+        reader.skip(4);
+        const auto chunk_size = reader.read<uint32_t>();
+        reader.skip(sizeof(Chunk4DataHeader));
+        if (chunk_size >= sizeof(Chunk4DataHeader))
+            array = reader.read_array<Chunk4DataElement>((chunk_size - sizeof(Chunk4DataHeader)) / 6);
+    }
+};
+
+// PropInfo without the copy of its trailing structs.
+struct PropInfoView
+{
+    static constexpr size_t header_size = 48;
+
+    uint16_t filename_index;
+    float x;
+    float y;
+    float z;
+    float f4;
+    float f5;
+    float f6;
+    float sin_angle;
+    float cos_angle;
+    float f9;
+    float scaling_factor;
+    float f11;
+    uint8_t f12;
+    uint8_t num_some_structs;
+    std::span<const uint8_t> some_structs; // has size: num_some_structs * 8
+
+    PropInfoView() = default;
+    PropInfoView(MapChunkReader& reader)
+    {
+        filename_index = reader.read<uint16_t>();
+        x = reader.read<float>();
+        z = reader.read<float>();
+        y = -reader.read<float>();
+        f4 = reader.read<float>();
+        f5 = reader.read<float>();
+        f6 = reader.read<float>();
+        sin_angle = reader.read<float>();
+        cos_angle = reader.read<float>();
+        f9 = reader.read<float>();
+        scaling_factor = reader.read<float>();
+        f11 = reader.read<float>();
+        f12 = reader.read<uint8_t>();
+        num_some_structs = reader.read<uint8_t>();
+        some_structs = reader.read_array<uint8_t>(static_cast<size_t>(num_some_structs) * 8);
+    }
+};
+
+struct PropArrayView
+{
+    uint16_t num_props = 0;
+    std::vector<PropInfoView> props_info;
+};
+
+struct PropsInfoChunkView
+{
+    PropArrayView prop_array;
+
+    PropsInfoChunkView() = default;
+
+    // Same layout as Chunk3. Only the prop array is read.
+    explicit PropsInfoChunkView(std::span<const uint8_t> chunk)
+    {
+        MapChunkReader reader(chunk);
+        reader.skip(8 + 4 + 2 + 4); // chunk header, magic numbers, prop_array_size_in_bytes
+
+        prop_array.num_props = reader.read<uint16_t>();
+        prop_array.props_info.reserve(prop_array.num_props);
+        for (int i = 0; i < prop_array.num_props && !reader.failed(); i++)
+        {
+            prop_array.props_info.emplace_back(reader);
+        }
+
+        if (reader.failed())
+            prop_array.props_info.clear();
+    }
+};
+
+struct FFNA_MapFileView
+{
+    Chunk2 map_info_chunk{};
+    PropsInfoChunkView props_info_chunk;
+    FilenamesChunkView prop_filenames_chunk;
+    FilenamesChunkView more_filnames_chunk;
+    TerrainChunkView terrain_chunk;
+    FilenamesChunkView terrain_texture_filenames;
+    EnvironmentInfoChunk environment_info_chunk{};
+    EnvironmentInfoFilenamesChunk environment_info_filenames_chunk{};
+
+    // Whole chunks (including their 8 byte header) by chunk id.
+    std::unordered_map<uint32_t, std::span<const uint8_t>> riff_chunks;
+
+    FFNA_MapFileView() = default;
+    FFNA_MapFileView(std::shared_ptr<const unsigned char[]> buffer, size_t size)
+        : m_buffer(std::move(buffer))
+        , m_data(m_buffer.get(), m_buffer ? size : 0)
+    {
+        // Skip the 'ffna' signature and the type byte.
+        size_t offset = 5;
+        while (offset + 8 <= m_data.size())
+        {
+            uint32_t chunk_id;
+            uint32_t chunk_size;
+            std::memcpy(&chunk_id, &m_data[offset], sizeof(chunk_id));
+            std::memcpy(&chunk_size, &m_data[offset + 4], sizeof(chunk_size));
+            if (chunk_size > m_data.size() - offset - 8)
+                break;
+
+            riff_chunks.emplace(chunk_id, m_data.subspan(offset, 8 + static_cast<size_t>(chunk_size)));
+            offset += 8 + static_cast<size_t>(chunk_size);
+        }
+
+        if (const auto chunk = get_chunk(CHUNK_ID_MAP_INFO); chunk.size() >= 49)
+            map_info_chunk = Chunk2(0, chunk.data());
+
+        if (const auto chunk = get_chunk(CHUNK_ID_PROPS_INFO); !chunk.empty())
+            props_info_chunk = PropsInfoChunkView(chunk);
+
+        if (const auto chunk = get_chunk(CHUNK_ID_PROPS_FILENAMES); !chunk.empty())
+            prop_filenames_chunk = FilenamesChunkView(chunk);
+
+        if (const auto chunk = get_chunk(CHUNK_ID_PROPS_FILENAMES0); !chunk.empty())
+            more_filnames_chunk = FilenamesChunkView(chunk);
+
+        if (const auto chunk = get_chunk(CHUNK_ID_TERRAIN); !chunk.empty())
+            terrain_chunk = TerrainChunkView(chunk);
+
+        if (const auto chunk = get_chunk(CHUNK_ID_TERRAIN_FILENAMES); !chunk.empty())
+            terrain_texture_filenames = FilenamesChunkView(chunk);
+
+        // These are small and parsed into their own structs, same as FFNA_MapFile.
+        if (const auto chunk = get_chunk(CHUNK_ID_ENVIRONMENT_INFO); !chunk.empty())
+            environment_info_chunk = EnvironmentInfoChunk(0, chunk.data());
+
+        if (const auto chunk = get_chunk(CHUNK_ID_ENVIRONMENT_INFO_FILENAMES); !chunk.empty())
+        {
+            int chunk_offset = 0;
+            environment_info_filenames_chunk = EnvironmentInfoFilenamesChunk(chunk_offset, chunk.data());
+        }
+    }
+
+    // The whole chunk including its 8 byte header, or an empty span if the file doesn't have it.
+    std::span<const uint8_t> get_chunk(uint32_t chunk_id) const
+    {
+        const auto it = riff_chunks.find(chunk_id);
+        return it != riff_chunks.end() ? it->second : std::span<const uint8_t>{};
+    }
+
+    std::span<const uint8_t> data() const { return m_data; }
+
+private:
+    std::shared_ptr<const unsigned char[]> m_buffer;
+    std::span<const uint8_t> m_data;
+};
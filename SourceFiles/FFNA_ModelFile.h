@@ -1136,10 +1136,8 @@ struct FFNA_ModelFile
 {
     char ffna_signature[4];
     FFNAType ffna_type;
-    GeometryChunk geometry_chunk;
-    TextureFileNamesChunk texture_filenames_chunk;
-    TextureFileNamesChunk AMAT_filenames_chunk;
 
+    // Set while decoding the geometry, texture and AMAT filename chunks respectively.
     bool parsed_correctly = true;
     bool textures_parsed_correctly = true;
     bool AMATs_parsed_correctly = true;
@@ -1149,57 +1147,68 @@ struct FFNA_ModelFile
     std::unordered_set<int> seen_model_ids;
 
     FFNA_ModelFile() = default;
+
+    // Decodes every chunk right away.
     FFNA_ModelFile(int offset, std::span<unsigned char>& data)
     {
-        uint32_t current_offset = offset;
+        read_chunk_directory(offset, data.data(), data.size());
+        decode_all_chunks(data.data(), data.size());
+    }
 
-        std::memcpy(ffna_signature, &data[offset], sizeof(ffna_signature));
-        current_offset += 4;
-        std::memcpy(&ffna_type, &data[offset], sizeof(ffna_type));
-        current_offset += 1;
+    // Only builds the chunk directory. Chunks are decoded from the shared buffer the first time one
+    // of the get_* accessors asks for them, so callers that never look at the geometry don't pay
+    // for it. The buffer is released once every chunk has been decoded.
+    FFNA_ModelFile(std::shared_ptr<const unsigned char[]> buffer, size_t size)
+        : m_buffer(std::move(buffer))
+        , m_buffer_size(m_buffer ? size : 0)
+    {
+        read_chunk_directory(0, m_buffer.get(), m_buffer_size);
+    }
 
-        // Read all chunks
-        while (current_offset < data.size())
+    // Check parsed_correctly after calling this.
+    const GeometryChunk& get_geometry_chunk()
+    {
+        if (!m_geometry_decoded)
         {
-            // Create a GeneralChunk instance using the current offset and data pointer
-            GeneralChunk chunk(current_offset, data.data());
-
-            // Add the GeneralChunk instance to the riff_chunks map using its chunk_id as the key
-            riff_chunks.emplace(chunk.chunk_id, current_offset);
-
-            // Move to the next chunk by updating the current_offset
-            current_offset += 8 + chunk.chunk_size;
+            decode_geometry_chunk(m_buffer.get(), m_buffer_size);
+            release_buffer_if_decoded();
         }
+        return geometry_chunk;
+    }
 
-        // Check if the CHUNK_ID_TERRAIN is in the riff_chunks map
-        auto it = riff_chunks.find(CHUNK_ID_GEOMETRY);
-        if (it != riff_chunks.end())
+    // Check textures_parsed_correctly after calling this.
+    const TextureFileNamesChunk& get_texture_filenames_chunk()
+    {
+        if (!m_texture_filenames_decoded)
         {
-            int offset = it->second;
-            geometry_chunk = GeometryChunk(offset, data.data(), data.size_bytes(), parsed_correctly);
+            decode_texture_filenames_chunk(m_buffer.get(), m_buffer_size);
+            release_buffer_if_decoded();
         }
+        return texture_filenames_chunk;
+    }
 
-        // Check if the CHUNK_ID_TEXTURE_FILENAMES is in the riff_chunks map
-        it = riff_chunks.find(CHUNK_ID_TEXTURE_FILENAMES);
-        if (it != riff_chunks.end())
+    // Check AMATs_parsed_correctly after calling this.
+    const TextureFileNamesChunk& get_AMAT_filenames_chunk()
+    {
+        if (!m_AMAT_filenames_decoded)
         {
-            int offset = it->second;
-            texture_filenames_chunk =
-              TextureFileNamesChunk(offset, data.data(), data.size_bytes(), textures_parsed_correctly);
+            decode_AMAT_filenames_chunk(m_buffer.get(), m_buffer_size);
+            release_buffer_if_decoded();
         }
+        return AMAT_filenames_chunk;
+    }
 
-        // Check if the CHUNK_ID_AMAT_FILENAMES is in the riff_chunks map
-        it = riff_chunks.find(CHUNK_ID_AMAT_FILENAMES);
-        if (it != riff_chunks.end())
-        {
-            int offset = it->second;
-            AMAT_filenames_chunk =
-              TextureFileNamesChunk(offset, data.data(), data.size_bytes(), AMATs_parsed_correctly);
-        }
+    void decode_all_chunks()
+    {
+        get_geometry_chunk();
+        get_texture_filenames_chunk();
+        get_AMAT_filenames_chunk();
     }
 
     Mesh GetMesh(int model_index, AMAT_file& amat_file)
     {
+        decode_all_chunks();
+
         std::vector<GWVertex> vertices;
         std::vector<uint32_t> indices;
         std::vector<uint32_t> indices1;
@@ -1574,4 +1583,85 @@ struct FFNA_ModelFile
         return Mesh(vertices, indices, indices1, indices2, uv_coords_indices, tex_indices, blend_flags, texture_types, should_cull, blend_state,
                     tex_indices.size());
     }
+
+private:
+    // Private so that every read goes through the get_* accessors, which decode on first use.
+    GeometryChunk geometry_chunk;
+    TextureFileNamesChunk texture_filenames_chunk;
+    TextureFileNamesChunk AMAT_filenames_chunk;
+
+    std::shared_ptr<const unsigned char[]> m_buffer;
+    size_t m_buffer_size = 0;
+    bool m_geometry_decoded = false;
+    bool m_texture_filenames_decoded = false;
+    bool m_AMAT_filenames_decoded = false;
+
+    void read_chunk_directory(int offset, const unsigned char* data, size_t data_size)
+    {
+        if (!data || data_size < static_cast<size_t>(offset) + 5)
+            return;
+
+        std::memcpy(ffna_signature, &data[offset], sizeof(ffna_signature));
+        std::memcpy(&ffna_type, &data[offset + 4], sizeof(ffna_type));
+
+        // Only the 8 byte chunk headers are read here.
+        size_t current_offset = offset + 5;
+        while (current_offset + 8 <= data_size)
+        {
+            uint32_t chunk_id;
+            uint32_t chunk_size;
+            std::memcpy(&chunk_id, &data[current_offset], sizeof(chunk_id));
+            std::memcpy(&chunk_size, &data[current_offset + 4], sizeof(chunk_size));
+
+            riff_chunks.emplace(chunk_id, static_cast<int>(current_offset));
+
+            current_offset += 8 + static_cast<size_t>(chunk_size);
+        }
+    }
+
+    void decode_all_chunks(const unsigned char* data, size_t data_size)
+    {
+        decode_geometry_chunk(data, data_size);
+        decode_texture_filenames_chunk(data, data_size);
+        decode_AMAT_filenames_chunk(data, data_size);
+    }
+
+    void decode_geometry_chunk(const unsigned char* data, size_t data_size)
+    {
+        m_geometry_decoded = true;
+        const auto it = riff_chunks.find(CHUNK_ID_GEOMETRY);
+        if (it != riff_chunks.end())
+        {
+            geometry_chunk = GeometryChunk(it->second, data, data_size, parsed_correctly);
+        }
+    }
+
+    void decode_texture_filenames_chunk(const unsigned char* data, size_t data_size)
+    {
+        m_texture_filenames_decoded = true;
+        const auto it = riff_chunks.find(CHUNK_ID_TEXTURE_FILENAMES);
+        if (it != riff_chunks.end())
+        {
+            texture_filenames_chunk = TextureFileNamesChunk(it->second, data, data_size, textures_parsed_correctly);
+        }
+    }
+
+    void decode_AMAT_filenames_chunk(const unsigned char* data, size_t data_size)
+    {
+        m_AMAT_filenames_decoded = true;
+        const auto it = riff_chunks.find(CHUNK_ID_AMAT_FILENAMES);
+        if (it != riff_chunks.end())
+        {
+            AMAT_filenames_chunk = TextureFileNamesChunk(it->second, data, data_size, AMATs_parsed_correctly);
+        }
+    }
+
+    void release_buffer_if_decoded()
+    {
+        if (m_geometry_decoded && m_texture_filenames_decoded && m_AMAT_filenames_decoded)
+        {
+            m_buffer.reset();
+            m_buffer_size = 0;
+        }
+    }
 };
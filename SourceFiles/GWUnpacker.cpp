@@ -67,17 +67,77 @@ void GWDat::read(HANDLE file_handle, void* buffer, int size, int count)
 	}
 }
 
-unsigned char* GWDat::readFile(HANDLE file_handle, unsigned int n, bool translate)
+bool GWDat::mapDat(const TCHAR* file)
 {
-	MFTEntry& m = MFT[n];
+	unmapDat();
+
+	m_mapped_file = CreateFile(file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (m_mapped_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(m_mapped_file, &file_size) || file_size.QuadPart == 0 ||
+		(unsigned __int64)file_size.QuadPart > (unsigned __int64)SIZE_MAX)
+	{
+		unmapDat();
+		return false;
+	}
+
+	m_mapping = CreateFileMapping(m_mapped_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m_mapping)
+	{
+		unmapDat();
+		return false;
+	}
+
+	// This can fail in 32-bit builds where there is no contiguous address range large enough for the dat.
+	m_mapped_view = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_mapped_view)
+	{
+		unmapDat();
+		return false;
+	}
+
+	m_mapped_size = file_size.QuadPart;
+	return true;
+}
+
+void GWDat::unmapDat()
+{
+	if (m_mapped_view)
+		UnmapViewOfFile(m_mapped_view);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_mapped_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_mapped_file);
+
+	m_mapped_view = nullptr;
+	m_mapping = NULL;
+	m_mapped_file = INVALID_HANDLE_VALUE;
+	m_mapped_size = 0;
+}
+
+std::span<const unsigned char> GWDat::getRawFileView(unsigned int n) const
+{
+	if (!m_mapped_view || n >= MFT.size())
+		return {};
+
+	const MFTEntry& m = MFT[n];
+	if (m.Offset < 0 || m.Size <= 0 || (unsigned __int64)m.Offset + (unsigned __int64)m.Size > m_mapped_size)
+		return {};
+
+	return {m_mapped_view + m.Offset, (size_t)m.Size};
+}
 
+bool GWDat::needsRead(MFTEntry& m, bool translate)
+{
 	if (m.type == NOTREAD)
 		filesRead += 1;
 
 	//Don't read files that were already read if we just need the type
 	if (m.type != NOTREAD && !translate)
 	{
-		return NULL;
+		return false;
 	}
 
 	if (!m.b)
@@ -85,16 +145,163 @@ unsigned char* GWDat::readFile(HANDLE file_handle, unsigned int n, bool translat
 		m.type = MFTBASE;
 		m.uncompressedSize = 0;
 		mftBaseFiles += 1;
-		return NULL;
+		return false;
 	}
 
+	return true;
+}
+
+unsigned char* GWDat::readFile(HANDLE file_handle, unsigned int n, bool translate)
+{
+	MFTEntry& m = MFT[n];
+
+	if (!needsRead(m, translate))
+		return NULL;
+
 	unsigned char* Input = new unsigned char[m.Size];
-	unsigned char* Output = NULL;
-	int OutSize = 0;
 
 	seek(file_handle, m.Offset, 0);
 	read(file_handle, Input, m.Size, 1);
 
+	int OutSize = 0;
+	unsigned char* Output = decodeFile(m, Input, OutSize);
+
+	delete[] Input;
+
+	return Output;
+}
+
+unsigned char* GWDat::readFile(unsigned int n, bool translate)
+{
+	if (!m_mapped_view)
+	{
+		HANDLE file_handle = get_dat_filehandle(m_filepath.c_str());
+		if (!file_handle)
+			return NULL;
+
+		unsigned char* data = readFile(file_handle, n, translate);
+		CloseHandle(file_handle);
+		return data;
+	}
+
+	MFTEntry& m = MFT[n];
+
+	if (!needsRead(m, translate))
+		return NULL;
+
+	const auto Input = getRawFileView(n);
+	if (Input.empty())
+		return NULL;
+
+	int OutSize = 0;
+	return decodeFile(m, Input.data(), OutSize);
+}
+
+bool GWDat::readType(HANDLE file_handle, unsigned int n)
+{
+	MFTEntry& m = MFT[n];
+
+	if (!needsRead(m, false))
+		return false;
+
+	std::vector<unsigned char> Input(m.Size);
+	seek(file_handle, m.Offset, 0);
+	read(file_handle, Input.data(), m.Size, 1);
+
+	return sniffFile(m, Input.data());
+}
+
+bool GWDat::readType(unsigned int n)
+{
+	if (!m_mapped_view)
+	{
+		HANDLE file_handle = get_dat_filehandle(m_filepath.c_str());
+		if (!file_handle)
+			return false;
+
+		const bool result = readType(file_handle, n);
+		CloseHandle(file_handle);
+		return result;
+	}
+
+	MFTEntry& m = MFT[n];
+
+	if (!needsRead(m, false))
+		return false;
+
+	// Only the pages holding the start and the end of the file are touched.
+	const auto Input = getRawFileView(n);
+	if (Input.empty())
+		return false;
+
+	return sniffFile(m, Input.data());
+}
+
+bool GWDat::readContentInfo(HANDLE file_handle, unsigned int n)
+{
+	MFTEntry& m = MFT[n];
+	if (m.has_content_info || !m.b || m.Size <= 0)
+		return false;
+
+	std::vector<unsigned char> Input(m.Size);
+	seek(file_handle, m.Offset, 0);
+	read(file_handle, Input.data(), m.Size, 1);
+
+	return computeContentInfo(m, Input.data());
+}
+
+bool GWDat::readContentInfo(unsigned int n)
+{
+	if (!m_mapped_view)
+	{
+		HANDLE file_handle = get_dat_filehandle(m_filepath.c_str());
+		if (!file_handle)
+			return false;
+
+		const bool result = readContentInfo(file_handle, n);
+		CloseHandle(file_handle);
+		return result;
+	}
+
+	MFTEntry& m = MFT[n];
+	if (m.has_content_info || !m.b)
+		return false;
+
+	const auto Input = getRawFileView(n);
+	if (Input.empty())
+		return false;
+
+	return computeContentInfo(m, Input.data());
+}
+
+bool GWDat::readRawFile(unsigned int n, std::vector<unsigned char>& out)
+{
+	if (n >= MFT.size() || MFT[n].Size <= 0)
+		return false;
+
+	if (m_mapped_view)
+	{
+		const auto view = getRawFileView(n);
+		out.assign(view.begin(), view.end());
+		return !view.empty();
+	}
+
+	HANDLE file_handle = get_dat_filehandle(m_filepath.c_str());
+	if (!file_handle)
+		return false;
+
+	out.resize(MFT[n].Size);
+	seek(file_handle, MFT[n].Offset, 0);
+	read(file_handle, out.data(), MFT[n].Size, 1);
+	CloseHandle(file_handle);
+	return true;
+}
+
+unsigned char* GWDat::decodeFile(MFTEntry& m, const unsigned char* Input, int& OutSize)
+{
+	unsigned char* Output = NULL;
+	OutSize = 0;
+
 	if (m.a)
 		UnpackGWDat(Input, m.Size, Output, OutSize);
 	else
@@ -104,164 +311,197 @@ unsigned char* GWDat::readFile(HANDLE file_handle, unsigned int n, bool translat
 		OutSize = m.Size;
 	}
 
+	if (Output && m.type == NOTREAD)
+	{
+		unsigned char Header[FILE_HEADER_SIZE] = {};
+		memcpy(Header, Output, min(OutSize, FILE_HEADER_SIZE));
+		classifyFile(m, Header, OutSize);
+	}
+	return Output;
+}
 
-	delete[] Input;
+bool GWDat::sniffFile(MFTEntry& m, const unsigned char* Input)
+{
+	unsigned char Header[FILE_HEADER_SIZE] = {};
+	int OutSize = 0;
 
-	if (Output)
+	if (m.a)
 	{
-		// Use murmurhash3 for comparing files
-		MurmurHash3_x86_32(Output, OutSize, 0, &m.murmurhash3);
+		if (UnpackGWDatPrefix(Input, m.Size, Header, FILE_HEADER_SIZE, OutSize) < 0)
+			return false;
+	}
+	else
+	{
+		OutSize = m.Size;
+		memcpy(Header, Input, min(OutSize, FILE_HEADER_SIZE));
+	}
 
-		if (m.type == NOTREAD)
-		{
-			int type = 0;
-			auto sub_type = ((unsigned char*)Output)[4];
-			unsigned int i = ((unsigned int*)Output)[0];
-			unsigned int k = ((unsigned int*)Output)[1];
-			int i2 = i & 0xffff;
-			int i3 = i & 0xffffff;
-
-			switch (i)
-			{
-			case 'XTTA':
-				textureFiles += 1;
-				switch (k)
-				{
-				case '1TXD':
-					type = ATTXDXT1;
-					break;
-				case '3TXD':
-					type = ATTXDXT3;
-					break;
-				case '5TXD':
-					type = ATTXDXT5;
-					break;
-				case 'NTXD':
-					type = ATTXDXTN;
-					break;
-				case 'ATXD':
-					type = ATTXDXTA;
-					break;
-				case 'LTXD':
-					type = ATTXDXTL;
-					break;
-				}
-				break;
-			case 'XETA':
-				textureFiles += 1;
-				switch (k)
-				{
-				case '1TXD':
-					type = ATEXDXT1;
-					break;
-				case '2TXD':
-					type = ATEXDXT2;
-					break;
-				case '3TXD':
-					type = ATEXDXT3;
-					break;
-				case '4TXD':
-					type = ATEXDXT4;
-					break;
-				case '5TXD':
-					type = ATEXDXT5;
-					break;
-				case 'NTXD':
-					type = ATEXDXTN;
-					break;
-				case 'ATXD':
-					type = ATEXDXTA;
-					break;
-				case 'LTXD':
-					type = ATEXDXTL;
-					break;
-				}
-				break;
-			case '===;':
-			case '***;':
-				type = TEXT;
-				textFiles += 1;
-				break;
-			case 'anff':
-				if (sub_type == 2)
-				{
-					type = FFNA_Type2;
-				}
-				else if (sub_type == 3)
-				{
-					type = FFNA_Type3;
-				}
-				else
-				{
-					type = FFNA_Unknown;
-				}
-				ffnaFiles += 1;
-				break;
-			case ' SDD':
-				type = DDS;
-				textureFiles += 1;
-				break;
-			case 'TAMA':
-				type = AMAT;
-				amatFiles += 1;
-				break;
-			default:
-				type = UNKNOWN;
-			}
-			switch (i2)
-			{
-			case 0xFAFF:
-			case 0xFBFF:
-				type = SOUND;
-				break;
-			default:
-				break;
-			}
+	classifyFile(m, Header, OutSize);
+	return true;
+}
 
-			switch (i3)
-			{
-			case 'PMA':
-				type = AMP;
-				break;
-			case 0x334449:
-				type = SOUND;
-				break;
-			default:
-				break;
-			}
+bool GWDat::computeContentInfo(MFTEntry& m, const unsigned char* Input)
+{
+	int OutSize = 0;
+	unsigned char* Output = decodeFile(m, Input, OutSize);
+	if (!Output)
+		return false;
 
-			if (type == AMP || type == SOUND)
-				soundFiles += 1;
-			else if (type == UNKNOWN)
-				unknownFiles += 1;
+	// Use murmurhash3 for comparing files
+	MurmurHash3_x86_32(Output, OutSize, 0, &m.murmurhash3);
 
-			m.type = type;
-			m.uncompressedSize = OutSize;
+	// Extract chunk IDs from FFNA files (Type2 models and Type3 maps)
+	m.chunk_ids.clear();
+	if (m.type == FFNA_Type2 || m.type == FFNA_Type3)
+	{
+		int offset = 5;  // Skip FFNA header (4 bytes 'ffna' + 1 byte type)
+		while (offset + 8 <= OutSize)
+		{
+			uint32_t chunk_id = *reinterpret_cast<uint32_t*>(&Output[offset]);
+			uint32_t chunk_size = *reinterpret_cast<uint32_t*>(&Output[offset + 4]);
+			m.chunk_ids.push_back(chunk_id);
+			offset += 8 + chunk_size;
+		}
+	}
 
-			// Extract chunk IDs from FFNA files (Type2 models and Type3 maps)
-			if (type == FFNA_Type2 || type == FFNA_Type3)
-			{
-				m.chunk_ids.clear();
-				int offset = 5;  // Skip FFNA header (4 bytes 'ffna' + 1 byte type)
-				while (offset + 8 <= OutSize)
-				{
-					uint32_t chunk_id = *reinterpret_cast<uint32_t*>(&Output[offset]);
-					uint32_t chunk_size = *reinterpret_cast<uint32_t*>(&Output[offset + 4]);
-					m.chunk_ids.push_back(chunk_id);
-					offset += 8 + chunk_size;
-				}
-			}
+	m.has_content_info = true;
+	delete[] Output;
+	return true;
+}
 
-			//saveToFile(typeToString(m.type), m.Hash, n, Output, OutSize);
+void GWDat::classifyFile(MFTEntry& m, const unsigned char* Header, int OutSize)
+{
+	int type = 0;
+	auto sub_type = Header[4];
+	unsigned int i = ((const unsigned int*)Header)[0];
+	unsigned int k = ((const unsigned int*)Header)[1];
+	int i2 = i & 0xffff;
+	int i3 = i & 0xffffff;
+
+	switch (i)
+	{
+	case 'XTTA':
+		textureFiles += 1;
+		switch (k)
+		{
+		case '1TXD':
+			type = ATTXDXT1;
+			break;
+		case '3TXD':
+			type = ATTXDXT3;
+			break;
+		case '5TXD':
+			type = ATTXDXT5;
+			break;
+		case 'NTXD':
+			type = ATTXDXTN;
+			break;
+		case 'ATXD':
+			type = ATTXDXTA;
+			break;
+		case 'LTXD':
+			type = ATTXDXTL;
+			break;
+		}
+		break;
+	case 'XETA':
+		textureFiles += 1;
+		switch (k)
+		{
+		case '1TXD':
+			type = ATEXDXT1;
+			break;
+		case '2TXD':
+			type = ATEXDXT2;
+			break;
+		case '3TXD':
+			type = ATEXDXT3;
+			break;
+		case '4TXD':
+			type = ATEXDXT4;
+			break;
+		case '5TXD':
+			type = ATEXDXT5;
+			break;
+		case 'NTXD':
+			type = ATEXDXTN;
+			break;
+		case 'ATXD':
+			type = ATEXDXTA;
+			break;
+		case 'LTXD':
+			type = ATEXDXTL;
+			break;
+		}
+		break;
+	case '===;':
+	case '***;':
+		type = TEXT;
+		textFiles += 1;
+		break;
+	case 'anff':
+		if (sub_type == 2)
+		{
+			type = FFNA_Type2;
+		}
+		else if (sub_type == 3)
+		{
+			type = FFNA_Type3;
+		}
+		else
+		{
+			type = FFNA_Unknown;
 		}
+		ffnaFiles += 1;
+		break;
+	case ' SDD':
+		type = DDS;
+		textureFiles += 1;
+		break;
+	case 'TAMA':
+		type = AMAT;
+		amatFiles += 1;
+		break;
+	default:
+		type = UNKNOWN;
 	}
-	return Output;
+	switch (i2)
+	{
+	case 0xFAFF:
+	case 0xFBFF:
+		type = SOUND;
+		break;
+	default:
+		break;
+	}
+
+	switch (i3)
+	{
+	case 'PMA':
+		type = AMP;
+		break;
+	case 0x334449:
+		type = SOUND;
+		break;
+	default:
+		break;
+	}
+
+	if (type == AMP || type == SOUND)
+		soundFiles += 1;
+	else if (type == UNKNOWN)
+		unknownFiles += 1;
+
+	m.type = type;
+	m.uncompressedSize = OutSize;
 }
 
 bool compareH(MFTExpansion& a, MFTExpansion b) { return a.FileOffset < b.FileOffset; }
 
 unsigned int GWDat::readDat(const TCHAR* file)
 {
+	m_filepath = file;
+
 	auto file_handle = get_dat_filehandle(file);
 
 	read(file_handle, &GWHead, sizeof(GWHead), 1);
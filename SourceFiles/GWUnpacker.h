@@ -1,5 +1,7 @@
 #pragma once
 #include <vector>
+#include <span>
+#include <string>
 
 struct MainHeader
 {
@@ -66,6 +68,7 @@ struct MFTEntry
 	__int32 Hash;
 	uint32_t murmurhash3;
 	std::vector<uint32_t> chunk_ids;  // Chunk IDs found in FFNA files
+	bool has_content_info = false;    // murmurhash3 and chunk_ids are valid, see GWDat::readContentInfo
 };
 
 struct MFTExpansion
@@ -77,9 +80,41 @@ struct MFTExpansion
 class GWDat
 {
 public:
+	GWDat() = default;
+	GWDat(const GWDat&) = delete;
+	GWDat& operator=(const GWDat&) = delete;
+	~GWDat() { unmapDat(); }
+
 	unsigned int readDat(const TCHAR* file);
 	unsigned char* readFile(HANDLE file_handle, unsigned int n, bool translate = true);
 
+	// Maps the whole dat read-only. While mapped, readFile(n) decodes straight from the view
+	// without any per-call handle or seek state, so any number of threads can read at once.
+	// Returns false if the file could not be mapped (e.g. a 4 GB dat in a 32-bit build);
+	// readFile(n) then falls back to opening a handle per call.
+	bool mapDat(const TCHAR* file);
+	void unmapDat();
+	bool isMapped() const { return m_mapped_view != nullptr; }
+
+	// Raw (still compressed) bytes of MFT entry n inside the mapped view. Empty if not mapped
+	// or if the entry lies outside the file.
+	std::span<const unsigned char> getRawFileView(unsigned int n) const;
+
+	unsigned char* readFile(unsigned int n, bool translate = true);
+
+	// Sets the type and uncompressed size of entry n by decompressing only the first
+	// FILE_HEADER_SIZE bytes of the file. Used by the startup scan.
+	bool readType(HANDLE file_handle, unsigned int n);
+	bool readType(unsigned int n);
+
+	// Fully decompresses entry n to fill in its murmurhash3 and chunk_ids. Much slower than
+	// readType, so it is done lazily for the features that need it.
+	bool readContentInfo(HANDLE file_handle, unsigned int n);
+	bool readContentInfo(unsigned int n);
+
+	// Copies the raw (still compressed) bytes of MFT entry n, from the mapped view if available.
+	bool readRawFile(unsigned int n, std::vector<unsigned char>& out);
+
 	MFTEntry& operator[](const int n) { return MFT[n]; }
 
 	MFTEntry* get_MFT_entry_ptr(const int n)
@@ -113,22 +148,38 @@ protected:
 	std::vector<MFTExpansion> MFTX;
 	std::vector<MFTEntry> MFT;
 
-	//Critical Section to make readFile thread safe
+	std::wstring m_filepath;
+
+	// Memory-mapped view of the dat, see mapDat()
+	HANDLE m_mapped_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = NULL;
+	const unsigned char* m_mapped_view = nullptr;
+	unsigned __int64 m_mapped_size = 0;
 
 	//Counters for statistics
-	unsigned int filesRead;
-	unsigned int textureFiles;
-	unsigned int soundFiles;
-	unsigned int ffnaFiles;
-	unsigned int unknownFiles;
-	unsigned int textFiles;
-	unsigned int mftBaseFiles;
-	unsigned int amatFiles;
+	unsigned int filesRead = 0;
+	unsigned int textureFiles = 0;
+	unsigned int soundFiles = 0;
+	unsigned int ffnaFiles = 0;
+	unsigned int unknownFiles = 0;
+	unsigned int textFiles = 0;
+	unsigned int mftBaseFiles = 0;
+	unsigned int amatFiles = 0;
 
 protected:
 	//wrappers for the OS seek and read functions
 	void seek(HANDLE file_handle, __int64 offset, int origin);
 	void read(HANDLE file_handle, void* buffer, int size, int count);
+
+	// Enough to tell the file type from its FourCC and sub type.
+	static constexpr int FILE_HEADER_SIZE = 8;
+
+	// Shared by the handle and the mapped readFile paths.
+	bool needsRead(MFTEntry& m, bool translate);
+	unsigned char* decodeFile(MFTEntry& m, const unsigned char* Input, int& OutSize);
+	bool sniffFile(MFTEntry& m, const unsigned char* Input);
+	bool computeContentInfo(MFTEntry& m, const unsigned char* Input);
+	void classifyFile(MFTEntry& m, const unsigned char* Header, int OutSize);
 };
 
 inline std::string typeToString(int type)
@@ -0,0 +1,723 @@
+#include "pch.h"
+#include "GzipInflate.h"
+#include <algorithm>
+
+namespace {
+
+// The longest match, so a match can always be copied whole once there is this much room.
+constexpr size_t kMaxMatch = 258;
+
+constexpr uint16_t kLenBase[29] = {
+    3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,
+    35,43,51,59,67,83,99,115,131,163,195,227,258
+};
+constexpr uint8_t kLenExtra[29] = {
+    0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0
+};
+constexpr uint16_t kDistBase[30] = {
+    1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,
+    257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577
+};
+constexpr uint8_t kDistExtra[30] = {
+    0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13
+};
+
+uint32_t ReverseBits(uint32_t code, int length)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++)
+    {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+} // anonymous namespace
+
+InflateStream::InflateStream(const uint8_t* src, size_t srcLen)
+    : m_src(src)
+    , m_srcLen(srcLen)
+{
+}
+
+bool InflateStream::BuildHuff(HuffTable& t, const uint8_t* lengths, int num)
+{
+    memset(t.counts, 0, sizeof(t.counts));
+    memset(t.fast, 0, sizeof(t.fast));
+    for (int i = 0; i < num; i++)
+        t.counts[lengths[i]]++;
+    t.counts[0] = 0;
+
+    uint16_t offsets[kMaxBits + 1];
+    offsets[0] = 0;
+    offsets[1] = 0;
+    for (int i = 1; i < kMaxBits; i++)
+        offsets[i + 1] = offsets[i] + t.counts[i];
+
+    // Canonical codes: the first code of each length follows the last code of the length before.
+    uint32_t nextCode[kMaxBits + 2] = {};
+    uint32_t code = 0;
+    for (int len = 1; len <= kMaxBits; len++)
+    {
+        code = (code + t.counts[len - 1]) << 1;
+        nextCode[len] = code;
+    }
+
+    for (int i = 0; i < num; i++)
+    {
+        const int len = lengths[i];
+        if (!len)
+            continue;
+
+        t.symbols[offsets[len]++] = static_cast<uint16_t>(i);
+
+        // The stream sends codes most significant bit first, so the table is indexed by the reversed code.
+        const uint32_t symbolCode = nextCode[len]++;
+        if (len <= kFastBits)
+        {
+            const uint16_t entry = static_cast<uint16_t>(i << 4 | len);
+            for (uint32_t index = ReverseBits(symbolCode, len); index < (1u << kFastBits); index += 1u << len)
+                t.fast[index] = entry;
+        }
+    }
+    return true;
+}
+
+void InflateStream::Refill()
+{
+    if (m_pos + 8 <= m_srcLen)
+    {
+        // Top the buffer up to at least 56 bits with one unaligned load.
+        uint64_t word;
+        memcpy(&word, m_src + m_pos, sizeof(word));
+        m_bitBuf |= word << m_bits;
+        m_pos += (63 - m_bits) >> 3;
+        m_bits |= 56;
+        return;
+    }
+
+    while (m_bits <= 56)
+    {
+        if (m_pos < m_srcLen)
+            m_bitBuf |= static_cast<uint64_t>(m_src[m_pos++]) << m_bits;
+        else
+            m_padding++;
+        m_bits += 8;
+    }
+}
+
+uint32_t InflateStream::ReadBits(int n)
+{
+    if (m_bits < n)
+        Refill();
+    const uint32_t val = static_cast<uint32_t>(m_bitBuf & ((1ull << n) - 1));
+    m_bitBuf >>= n;
+    m_bits -= n;
+    return val;
+}
+
+int InflateStream::DecodeSymbol(const HuffTable& t)
+{
+    if (m_bits < kMaxBits)
+        Refill();
+
+    const uint16_t entry = t.fast[m_bitBuf & ((1u << kFastBits) - 1)];
+    if (entry)
+    {
+        const int len = entry & 15;
+        m_bitBuf >>= len;
+        m_bits -= len;
+        return entry >> 4;
+    }
+
+    // Longer than kFastBits: walk the canonical code one bit at a time.
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= kMaxBits; len++)
+    {
+        code |= static_cast<int>(m_bitBuf & 1);
+        m_bitBuf >>= 1;
+        m_bits--;
+        const int count = t.counts[len];
+        if (code < first + count)
+            return t.symbols[index + (code - first)];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+bool InflateStream::ReadBlockHeader()
+{
+    m_finalBlock = ReadBits(1) != 0;
+    const int btype = ReadBits(2);
+
+    if (btype == 0) // stored
+    {
+        // Give back the whole bytes still in the bit buffer and read the lengths straight from the input.
+        const int discard = m_bits & 7;
+        m_bitBuf >>= discard;
+        m_bits -= discard;
+        const size_t buffered = m_bits / 8;
+        if (m_padding > buffered)
+            return false;
+        m_pos -= buffered - m_padding;
+        m_padding = 0;
+        m_bitBuf = 0;
+        m_bits = 0;
+
+        if (m_pos + 4 > m_srcLen) return false;
+        const uint16_t len = m_src[m_pos] | (m_src[m_pos + 1] << 8);
+        const uint16_t nlen = m_src[m_pos + 2] | (m_src[m_pos + 3] << 8);
+        m_pos += 4;
+        if (static_cast<uint16_t>(~nlen) != len) return false;
+        if (m_pos + len > m_srcLen) return false;
+        m_storedRemaining = len;
+        m_state = State::Stored;
+        return true;
+    }
+
+    if (btype == 1) // fixed Huffman
+    {
+        uint8_t lengths[288];
+        int i = 0;
+        for (; i < 144; i++) lengths[i] = 8;
+        for (; i < 256; i++) lengths[i] = 9;
+        for (; i < 280; i++) lengths[i] = 7;
+        for (; i < 288; i++) lengths[i] = 8;
+        BuildHuff(m_litLen, lengths, 288);
+
+        uint8_t dlengths[32];
+        for (i = 0; i < 32; i++) dlengths[i] = 5;
+        BuildHuff(m_dist, dlengths, 32);
+
+        m_state = State::Huffman;
+        return true;
+    }
+
+    if (btype == 2) // dynamic Huffman
+    {
+        if (!ReadDynamicTables())
+            return false;
+        m_state = State::Huffman;
+        return !InputOverrun();
+    }
+
+    return false;
+}
+
+bool InflateStream::ReadDynamicTables()
+{
+    const int hlit = ReadBits(5) + 257;
+    const int hdist = ReadBits(5) + 1;
+    const int hclen = ReadBits(4) + 4;
+
+    static const int kCodeOrder[19] = {
+        16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15
+    };
+    uint8_t clLengths[19] = {};
+    for (int i = 0; i < hclen; i++)
+        clLengths[kCodeOrder[i]] = static_cast<uint8_t>(ReadBits(3));
+
+    HuffTable clTable;
+    BuildHuff(clTable, clLengths, 19);
+
+    uint8_t lengths[288 + 32] = {};
+    const int total = hlit + hdist;
+    for (int i = 0; i < total;)
+    {
+        const int sym = DecodeSymbol(clTable);
+        if (sym < 0) return false;
+        if (sym < 16)
+        {
+            lengths[i++] = static_cast<uint8_t>(sym);
+        }
+        else if (sym == 16)
+        {
+            if (i == 0) return false;
+            const int rep = ReadBits(2) + 3;
+            const uint8_t prev = lengths[i - 1];
+            for (int j = 0; j < rep && i < total; j++)
+                lengths[i++] = prev;
+        }
+        else if (sym == 17)
+        {
+            const int rep = ReadBits(3) + 3;
+            for (int j = 0; j < rep && i < total; j++)
+                lengths[i++] = 0;
+        }
+        else if (sym == 18)
+        {
+            const int rep = ReadBits(7) + 11;
+            for (int j = 0; j < rep && i < total; j++)
+                lengths[i++] = 0;
+        }
+        else return false;
+    }
+
+    BuildHuff(m_litLen, lengths, hlit);
+    BuildHuff(m_dist, lengths + hlit, hdist);
+    return true;
+}
+
+void InflateStream::Decode()
+{
+    char* const out = m_buffer.data();
+    // Up to and including the limit there is room for one more match. Decoding at the limit itself matters:
+    // output that ends exactly there still has its end of block code (and maybe a block header) to read.
+    const size_t limit = m_buffer.size() - kMaxMatch;
+
+    while (m_size <= limit)
+    {
+        if (m_state == State::BlockHeader)
+        {
+            if (!ReadBlockHeader())
+            {
+                m_state = State::Failed;
+                return;
+            }
+        }
+        else if (m_state == State::Stored)
+        {
+            const size_t count = std::min(m_storedRemaining, m_buffer.size() - m_size);
+            memcpy(out + m_size, m_src + m_pos, count);
+            m_size += count;
+            m_pos += count;
+            m_storedRemaining -= count;
+            if (m_storedRemaining == 0)
+                m_state = m_finalBlock ? State::Done : State::BlockHeader;
+        }
+        else if (m_state == State::Huffman)
+        {
+            while (m_size <= limit)
+            {
+                // One refill covers a length code, its extra bits, a distance code and its extra bits.
+                if (m_bits < 48)
+                {
+                    Refill();
+                    // Out of real input in the middle of a block: the stream is truncated.
+                    if (m_padding * 8 >= static_cast<size_t>(m_bits))
+                    {
+                        m_state = State::Failed;
+                        return;
+                    }
+                }
+
+                const int sym = DecodeSymbol(m_litLen);
+                if (sym < 256)
+                {
+                    if (sym < 0)
+                    {
+                        m_state = State::Failed;
+                        return;
+                    }
+                    out[m_size++] = static_cast<char>(sym);
+                    continue;
+                }
+                if (sym == 256)
+                {
+                    if (InputOverrun())
+                    {
+                        m_state = State::Failed;
+                        return;
+                    }
+                    m_state = m_finalBlock ? State::Done : State::BlockHeader;
+                    break;
+                }
+
+                const int lenSym = sym - 257;
+                if (lenSym >= 29)
+                {
+                    m_state = State::Failed;
+                    return;
+                }
+                const size_t length = kLenBase[lenSym] + ReadBits(kLenExtra[lenSym]);
+
+                const int dsym = DecodeSymbol(m_dist);
+                if (dsym < 0 || dsym >= 30)
+                {
+                    m_state = State::Failed;
+                    return;
+                }
+                const size_t distance = kDistBase[dsym] + ReadBits(kDistExtra[dsym]);
+                if (distance > m_size)
+                {
+                    m_state = State::Failed;
+                    return;
+                }
+
+                char* dst = out + m_size;
+                const char* src = dst - distance;
+                if (distance >= length)
+                {
+                    memcpy(dst, src, length);
+                }
+                else
+                {
+                    // Overlapping copy, repeats the last distance bytes.
+                    for (size_t j = 0; j < length; j++)
+                        dst[j] = src[j];
+                }
+                m_size += length;
+            }
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+bool InflateStream::Next(std::string_view& chunk)
+{
+    if (m_buffer.empty())
+        m_buffer.resize(kWindowSize + kChunkSize + kMaxMatch);
+
+    // Keep the last kWindowSize bytes as history and decode the next chunk after them.
+    if (m_size > kWindowSize)
+    {
+        const size_t shift = m_size - kWindowSize;
+        memmove(m_buffer.data(), m_buffer.data() + shift, kWindowSize);
+        m_size -= shift;
+        m_delivered -= shift;
+    }
+
+    Decode();
+
+    chunk = std::string_view(m_buffer.data() + m_delivered, m_size - m_delivered);
+    m_delivered = m_size;
+    return !chunk.empty();
+}
+
+bool InflateStream::ReadAll(std::string& out, size_t sizeHint)
+{
+    // DEFLATE can't expand data by more than about 1032:1, so a corrupt size hint can't cause a huge allocation.
+    const size_t maxSize = m_srcLen * 1032 + kMaxMatch;
+    const size_t initialSize = sizeHint ? std::min(sizeHint, maxSize) : m_srcLen * 4;
+    m_buffer.resize(std::max<size_t>(initialSize, 4096) + kMaxMatch);
+
+    while (true)
+    {
+        Decode();
+        if (m_state == State::Done || m_state == State::Failed)
+            break;
+        m_buffer.resize(m_buffer.size() * 2);
+    }
+
+    m_buffer.resize(m_size);
+    // Only a wrong size hint leaves much unused capacity behind, the buffer of an exact one is kMaxMatch too big.
+    if (m_buffer.capacity() - m_size > m_size / 8 + kMaxMatch)
+        m_buffer.shrink_to_fit();
+    out = std::move(m_buffer);
+    m_buffer.clear();
+    m_size = 0;
+    return m_state == State::Done;
+}
+
+bool InflateRaw(const uint8_t* src, size_t srcLen, std::string& out, size_t sizeHint)
+{
+    InflateStream stream(src, srcLen);
+    return stream.ReadAll(out, sizeHint);
+}
+
+bool ParseGzipHeader(const uint8_t* data, size_t size, size_t& deflateOffset, size_t& deflateSize, uint32_t& isize)
+{
+    if (size < 18) return false;
+    if (data[0] != 0x1F || data[1] != 0x8B) return false;
+    if (data[2] != 0x08) return false;
+
+    const uint8_t flags = data[3];
+    size_t pos = 10;
+
+    if (flags & 0x04) // FEXTRA
+    {
+        if (pos + 2 > size) return false;
+        const uint16_t xlen = data[pos] | (data[pos + 1] << 8);
+        pos += 2 + xlen;
+    }
+    if (flags & 0x08) // FNAME
+    {
+        while (pos < size && data[pos] != 0) pos++;
+        pos++;
+    }
+    if (flags & 0x10) // FCOMMENT
+    {
+        while (pos < size && data[pos] != 0) pos++;
+        pos++;
+    }
+    if (flags & 0x02) // FHCRC
+        pos += 2;
+
+    if (pos >= size - 8) return false;
+
+    deflateOffset = pos;
+    deflateSize = size - 8 - pos;
+    isize = data[size - 4] | (data[size - 3] << 8) | (data[size - 2] << 16) | (static_cast<uint32_t>(data[size - 1]) << 24);
+    return true;
+}
+
+std::string DecompressGzipBuffer(const uint8_t* data, size_t size)
+{
+    size_t deflateOffset, deflateSize;
+    uint32_t isize;
+    if (!ParseGzipHeader(data, size, deflateOffset, deflateSize, isize))
+        return {};
+
+    std::string inflated;
+    if (!InflateRaw(data + deflateOffset, deflateSize, inflated, isize))
+        return {};
+    return inflated;
+}
+
+namespace {
+
+bool ReadBinaryFile(const std::filesystem::path& path, std::string& out)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+    const auto size = static_cast<size_t>(file.tellg());
+    out.resize(size);
+    file.seekg(0);
+    file.read(out.data(), size);
+    return static_cast<bool>(file);
+}
+
+} // anonymous namespace
+
+std::string ReadGzipFile(const std::filesystem::path& path)
+{
+    std::string compressed;
+    if (!ReadBinaryFile(path, compressed))
+        return {};
+    return DecompressGzipBuffer(reinterpret_cast<const uint8_t*>(compressed.data()), compressed.size());
+}
+
+std::string ReadTextOrGzipFile(const std::filesystem::path& path)
+{
+    if (path.extension() == ".gz")
+        return ReadGzipFile(path);
+
+    std::string content;
+    if (!ReadBinaryFile(path, content))
+        return {};
+    // Same as reading in text mode: "\r\n" line endings become "\n".
+    size_t out = 0;
+    for (size_t i = 0; i < content.size(); i++)
+    {
+        if (content[i] == '\r' && i + 1 < content.size() && content[i + 1] == '\n')
+            continue;
+        content[out++] = content[i];
+    }
+    content.resize(out);
+    return content;
+}
+
+bool TextChunkReader::Open(const std::filesystem::path& path)
+{
+    m_inflate.reset();
+    m_file.close();
+    m_failed = false;
+
+    if (path.extension() == ".gz")
+    {
+        size_t deflateOffset, deflateSize;
+        uint32_t isize;
+        if (!ReadBinaryFile(path, m_compressed) ||
+            !ParseGzipHeader(reinterpret_cast<const uint8_t*>(m_compressed.data()), m_compressed.size(),
+                             deflateOffset, deflateSize, isize))
+        {
+            m_failed = true;
+            return false;
+        }
+        m_inflate = std::make_unique<InflateStream>(
+            reinterpret_cast<const uint8_t*>(m_compressed.data()) + deflateOffset, deflateSize);
+        return true;
+    }
+
+    m_file.open(path, std::ios::binary);
+    m_failed = !m_file.is_open();
+    return !m_failed;
+}
+
+bool TextChunkReader::Next(std::string_view& chunk)
+{
+    if (m_inflate)
+    {
+        if (m_inflate->Next(chunk))
+            return true;
+        m_failed |= m_inflate->Failed();
+        return false;
+    }
+
+    if (!m_file.is_open())
+        return false;
+    m_fileBuffer.resize(InflateStream::kChunkSize);
+    m_file.read(m_fileBuffer.data(), m_fileBuffer.size());
+    chunk = std::string_view(m_fileBuffer.data(), static_cast<size_t>(m_file.gcount()));
+    return !chunk.empty();
+}
+
+TextLineReader::~TextLineReader()
+{
+    StopReadAhead();
+}
+
+bool TextLineReader::Open(const std::filesystem::path& path, bool readAhead)
+{
+    StopReadAhead();
+    m_chunk = {};
+    m_cursor = 0;
+    m_partial.clear();
+    m_returnedPartial = false;
+
+    m_failed = !m_reader.Open(path);
+    if (m_failed)
+        return false;
+
+    if (readAhead)
+    {
+        m_readAhead = std::make_unique<ReadAhead>();
+        m_readAhead->free.resize(kReadAheadBlocks);
+        m_readAheadThread = std::thread(&TextLineReader::ReadAheadThread, this);
+    }
+    return true;
+}
+
+void TextLineReader::ReadAheadThread()
+{
+    ReadAhead& ra = *m_readAhead;
+    while (true)
+    {
+        std::string block;
+        {
+            std::unique_lock<std::mutex> lock(ra.mutex);
+            ra.cv.wait(lock, [&ra] { return ra.stop || !ra.free.empty(); });
+            if (ra.stop)
+                return;
+            block = std::move(ra.free.back());
+            ra.free.pop_back();
+        }
+
+        std::string_view chunk;
+        const bool more = m_reader.Next(chunk);
+        if (more)
+            block.assign(chunk);
+
+        {
+            std::lock_guard<std::mutex> lock(ra.mutex);
+            if (more)
+            {
+                ra.ready.push_back(std::move(block));
+            }
+            else
+            {
+                ra.done = true;
+                ra.failed = m_reader.Failed();
+            }
+        }
+        ra.cv.notify_all();
+        if (!more)
+            return;
+    }
+}
+
+void TextLineReader::StopReadAhead()
+{
+    if (!m_readAhead)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_readAhead->mutex);
+        m_readAhead->stop = true;
+    }
+    m_readAhead->cv.notify_all();
+    if (m_readAheadThread.joinable())
+        m_readAheadThread.join();
+    m_readAhead.reset();
+    m_block.clear();
+}
+
+bool TextLineReader::NextChunk()
+{
+    m_cursor = 0;
+    if (!m_readAhead)
+    {
+        if (m_reader.Next(m_chunk))
+            return true;
+        m_failed |= m_reader.Failed();
+        return false;
+    }
+
+    ReadAhead& ra = *m_readAhead;
+    {
+        std::unique_lock<std::mutex> lock(ra.mutex);
+        // The block that was being read goes back to the reading thread.
+        if (!m_block.empty())
+        {
+            ra.free.push_back(std::move(m_block));
+            m_block.clear();
+        }
+        ra.cv.notify_all();
+        ra.cv.wait(lock, [&ra] { return ra.done || !ra.ready.empty(); });
+        if (ra.ready.empty())
+        {
+            m_failed |= ra.failed;
+            m_chunk = {};
+            return false;
+        }
+        m_block = std::move(ra.ready.front());
+        ra.ready.pop_front();
+    }
+    m_chunk = m_block;
+    return true;
+}
+
+bool TextLineReader::NextLine(std::string_view& line)
+{
+    if (m_returnedPartial)
+    {
+        m_partial.clear();
+        m_returnedPartial = false;
+    }
+
+    while (true)
+    {
+        if (m_cursor < m_chunk.size())
+        {
+            const size_t newline = m_chunk.find('\n', m_cursor);
+            if (newline != std::string_view::npos)
+            {
+                if (m_partial.empty())
+                {
+                    line = m_chunk.substr(m_cursor, newline - m_cursor);
+                }
+                else
+                {
+                    m_partial.append(m_chunk.substr(m_cursor, newline - m_cursor));
+                    line = m_partial;
+                    m_returnedPartial = true;
+                }
+                m_cursor = newline + 1;
+                if (!line.empty() && line.back() == '\r')
+                    line.remove_suffix(1);
+                return true;
+            }
+
+            m_partial.append(m_chunk.substr(m_cursor));
+            m_cursor = m_chunk.size();
+        }
+
+        if (!NextChunk())
+        {
+            // The last line of a file without a trailing newline.
+            if (m_partial.empty())
+                return false;
+            line = m_partial;
+            m_returnedPartial = true;
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// DEFLATE (RFC 1951) and gzip (RFC 1952) decoder shared by the replay parsers. Huffman codes of up to
+// kFastBits bits are decoded with a single table lookup, longer ones by walking the canonical code.
+
+// Decodes a raw DEFLATE stream that is entirely in memory, producing its output a chunk at a time. The
+// last 32 KB of output are kept as history for back references, so memory use doesn't depend on the
+// size of the output.
+class InflateStream
+{
+public:
+    static constexpr size_t kWindowSize = 32 * 1024;
+    static constexpr size_t kChunkSize = 256 * 1024;
+
+    InflateStream(const uint8_t* src, size_t srcLen);
+
+    // Decompresses the next chunk into chunk, which stays valid until the next call. Returns false once
+    // the stream has ended; Failed() tells if it ended because the data was corrupt.
+    bool Next(std::string_view& chunk);
+
+    // Decompresses the whole stream into out. sizeHint is the expected output size, if known.
+    bool ReadAll(std::string& out, size_t sizeHint = 0);
+
+    bool Failed() const { return m_state == State::Failed; }
+
+private:
+    static constexpr int kMaxBits = 15;
+    static constexpr int kFastBits = 10;
+
+    struct HuffTable
+    {
+        // Indexed by the next kFastBits bits of input: symbol << 4 | code length, 0 for longer codes.
+        uint16_t fast[1 << kFastBits] = {};
+        uint16_t counts[kMaxBits + 1] = {};
+        uint16_t symbols[288] = {};
+    };
+
+    enum class State
+    {
+        BlockHeader,
+        Stored,
+        Huffman,
+        Done,
+        Failed,
+    };
+
+    static bool BuildHuff(HuffTable& t, const uint8_t* lengths, int num);
+
+    void Refill();
+    uint32_t ReadBits(int n);
+    int DecodeSymbol(const HuffTable& t);
+    bool ReadBlockHeader();
+    bool ReadDynamicTables();
+    bool InputOverrun() const { return m_padding * 8 > static_cast<size_t>(m_bits); }
+
+    // Decodes into m_buffer until it has less than the room for one match left, or the stream ends.
+    void Decode();
+
+    const uint8_t* m_src;
+    size_t m_srcLen;
+    size_t m_pos = 0;
+    uint64_t m_bitBuf = 0;
+    int m_bits = 0;
+    size_t m_padding = 0; // Zero bytes read past the end of the input
+
+    State m_state = State::BlockHeader;
+    bool m_finalBlock = false;
+    size_t m_storedRemaining = 0;
+    HuffTable m_litLen;
+    HuffTable m_dist;
+
+    // History followed by the output not handed out yet.
+    std::string m_buffer;
+    size_t m_size = 0;
+    size_t m_delivered = 0;
+};
+
+// Inflates a raw DEFLATE stream into out.
+bool InflateRaw(const uint8_t* src, size_t srcLen, std::string& out, size_t sizeHint = 0);
+
+// Finds the DEFLATE stream inside a gzip member. isize is the uncompressed size from the trailer.
+bool ParseGzipHeader(const uint8_t* data, size_t size, size_t& deflateOffset, size_t& deflateSize,
+                     uint32_t& isize);
+
+// Returns the decompressed contents, or an empty string if the data isn't valid gzip.
+std::string DecompressGzipBuffer(const uint8_t* data, size_t size);
+std::string ReadGzipFile(const std::filesystem::path& path);
+
+// Reads a text file, decompressing it first if it has a .gz extension.
+std::string ReadTextOrGzipFile(const std::filesystem::path& path);
+
+// Reads a text file in blocks of up to InflateStream::kChunkSize bytes, decompressing .gz files as it goes.
+// Only the compressed file is held in memory.
+class TextChunkReader
+{
+public:
+    bool Open(const std::filesystem::path& path);
+
+    // chunk stays valid until the next call. Returns false at the end of the file.
+    bool Next(std::string_view& chunk);
+
+    // True if the file couldn't be read or the compressed data was corrupt.
+    bool Failed() const { return m_failed; }
+
+private:
+    std::string m_compressed;
+    std::unique_ptr<InflateStream> m_inflate;
+    std::ifstream m_file;
+    std::string m_fileBuffer;
+    bool m_failed = false;
+};
+
+// Reads a text file one line at a time, without holding the whole file in memory. Lines don't include
+// the '\n' or a trailing '\r'.
+class TextLineReader
+{
+public:
+    TextLineReader() = default;
+    ~TextLineReader();
+
+    TextLineReader(const TextLineReader&) = delete;
+    TextLineReader& operator=(const TextLineReader&) = delete;
+
+    // With readAhead the file is read and decompressed on a separate thread, up to kReadAheadBlocks
+    // blocks ahead of the caller, so decompression overlaps with parsing the lines.
+    bool Open(const std::filesystem::path& path, bool readAhead = false);
+
+    // line stays valid until the next call. Returns false at the end of the file.
+    bool NextLine(std::string_view& line);
+
+    // True if the file couldn't be read or the compressed data was corrupt.
+    bool Failed() const { return m_failed; }
+
+private:
+    static constexpr size_t kReadAheadBlocks = 2;
+
+    struct ReadAhead
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::string> ready;
+        std::vector<std::string> free;
+        bool done = false;
+        bool failed = false;
+        bool stop = false;
+    };
+
+    bool NextChunk();
+    void ReadAheadThread();
+    void StopReadAhead();
+
+    TextChunkReader m_reader;
+    std::unique_ptr<ReadAhead> m_readAhead;
+    std::thread m_readAheadThread;
+    std::string m_block; // The read ahead block m_chunk points into
+
+    std::string_view m_chunk;
+    size_t m_cursor = 0;
+    std::string m_partial; // A line that continues into the next chunk
+    bool m_returnedPartial = false;
+    bool m_failed = false;
+};
@@ -7,9 +7,11 @@
 #include "InputManager.h"
 #include "ModelViewer/ModelViewer.h"
 #include "Extract_BASS_DLL_resource.h"
+#include "batch_map_exporter.h"
 #include "imgui.h"
 #include <filesystem>
 #include <DbgHelp.h>
+#include <shellapi.h>
 
 LONG WINAPI UnhandledExceptionHandler(EXCEPTION_POINTERS* pExceptionPointers) {
     // Create mini dump file
@@ -158,6 +160,109 @@ extern "C"
     __declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
 }
 
+// Headless batch export, for running the map export on a machine without a display:
+//   GuildWarsObserver.exe --export-maps <Gw.dat> <output dir> [--maps <hash>,<hash>,...] [--threads <n>]
+//                         [--compress | --json]
+// Exports every map in the dat unless --maps is given. Hashes can be decimal or 0x prefixed hex. Maps are
+// written as binary .gwmb files, zlib compressed with --compress, or as .json with --json.
+// Each map goes into its own map_<hash> directory together with the models and textures it uses, so it can be
+// imported on its own. Those are written once to <output dir>/files and hard linked into the map directories.
+// A hash listed more than once in --maps is exported once and reported as a duplicate.
+// Returns the process exit code, or -1 if the command line isn't a batch export.
+int RunBatchMapExport()
+{
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv)
+        return -1;
+
+    // argv[0] is the executable.
+    std::vector<std::wstring> args(argv + std::min(argc, 1), argv + argc);
+    LocalFree(argv);
+    if (args.empty() || args[0] != L"--export-maps")
+        return -1;
+
+    // Report to the console we were started from, if any.
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE* console = nullptr;
+        freopen_s(&console, "CONOUT$", "w", stdout);
+        freopen_s(&console, "CONOUT$", "w", stderr);
+    }
+
+    if (args.size() < 3) {
+        fwprintf(stderr, L"Usage: --export-maps <Gw.dat> <output dir> [--maps <hash>,<hash>,...] [--threads <n>] [--compress | --json]\n");
+        return 1;
+    }
+
+    std::vector<int> map_filehashes;
+    unsigned num_threads = 0;
+    gwmb_map_format map_format = gwmb_map_format::binary;
+    try {
+        for (size_t i = 3; i < args.size(); i++) {
+            if (args[i] == L"--maps" && i + 1 < args.size()) {
+                std::wstringstream hashes(args[++i]);
+                std::wstring hash;
+                while (std::getline(hashes, hash, L',')) {
+                    map_filehashes.push_back(static_cast<int>(std::stoul(hash, nullptr, 0)));
+                }
+            }
+            else if (args[i] == L"--threads" && i + 1 < args.size()) {
+                num_threads = std::stoul(args[++i]);
+            }
+            else if (args[i] == L"--compress") {
+                map_format = gwmb_map_format::binary_compressed;
+            }
+            else if (args[i] == L"--json") {
+                map_format = gwmb_map_format::json;
+            }
+        }
+    }
+    catch (const std::exception&) {
+        fwprintf(stderr, L"Invalid map hash or thread count.\n");
+        return 1;
+    }
+
+    DATManager dat_manager;
+    if (!dat_manager.Init(args[1])) {
+        fwprintf(stderr, L"Could not read %s\n", args[1].c_str());
+        return 1;
+    }
+    while (dat_manager.m_initialization_state != InitializationState::Completed) {
+        Sleep(100);
+    }
+
+    std::unordered_map<int, std::vector<int>> hash_index;
+    const auto& mft = dat_manager.get_MFT();
+    for (int i = 0; i < mft.size(); i++) {
+        // Only add entries with non-zero hash, as hash 0 can have duplicates
+        if (mft[i].Hash != 0) {
+            hash_index[mft[i].Hash].push_back(i);
+        }
+    }
+
+    if (map_filehashes.empty()) {
+        // Several MFT entries can share a hash, list each map once.
+        std::unordered_set<int> listed_maps;
+        for (const auto& entry : mft) {
+            if (entry.type == FFNA_Type3 && entry.Hash != 0 && listed_maps.insert(entry.Hash).second) {
+                map_filehashes.push_back(entry.Hash);
+            }
+        }
+    }
+
+    wprintf(L"Exporting %zu maps to %s\n", map_filehashes.size(), args[2].c_str());
+    batch_map_exporter exporter(&dat_manager, hash_index, args[2], num_threads, map_format);
+    const bool success = exporter.export_maps(map_filehashes);
+
+    const auto& progress = exporter.get_progress();
+    wprintf(L"Maps: %d exported, %d skipped, %d duplicates, %d failed. Models: %d. Textures: %d.\n",
+        progress.maps_exported.load(), progress.maps_skipped.load(), progress.maps_duplicate.load(),
+        progress.maps_failed.load(),
+        progress.models_exported.load(), progress.textures_exported.load());
+
+    return success ? 0 : 1;
+}
+
 // Entry point
 int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPWSTR lpCmdLine,
     _In_ int nCmdShow)
@@ -174,6 +279,13 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     if (FAILED(hr))
         return 1;
 
+    // Batch exports run without creating a window or a D3D device.
+    const int batch_export_result = RunBatchMapExport();
+    if (batch_export_result >= 0) {
+        CoUninitialize();
+        return batch_export_result;
+    }
+
 
     // Register class and create window
     {
@@ -172,6 +172,10 @@ extern std::unordered_map<uint32_t, uint32_t> object_id_to_prop_index;
 extern std::unordered_map<uint32_t, uint32_t> object_id_to_submodel_index;
 extern int selected_map_file_index;
 
+// Map exports are rendered in tiles of at most this many pixels per side. Only one row of tiles is
+// held in memory while it is passed on to the PNG/DDS writer.
+static constexpr int map_export_tile_size = 1024;
+
 MapBrowser::MapBrowser(InputManager* input_manager) noexcept(false)
     : m_input_manager(input_manager),
     m_dat_manager_to_show_in_dat_browser(0),
@@ -1002,143 +1006,88 @@ void MapBrowser::Render()
             auto dim_x = m_map_renderer->GetTerrain()->m_grid_dim_x;
             auto dim_z = m_map_renderer->GetTerrain()->m_grid_dim_z;
 
+            int res_x = dim_x * m_extract_panel_info.pixels_per_tile_x;
+            int res_y = dim_z * m_extract_panel_info.pixels_per_tile_y;
+            float aspectRatio = static_cast<float>(res_x) / static_cast<float>(res_y);
+
             switch (m_extract_panel_info.map_render_extract_map_type) {
             case ExtractPanel::AllMapsTopDownOrthographic:
             case ExtractPanel::CurrentMapTopDownOrthographic:
-            {
-                int res_x = dim_x * m_extract_panel_info.pixels_per_tile_x;
-                int res_y = dim_z * m_extract_panel_info.pixels_per_tile_y;
-                float aspectRatio = static_cast<float>(res_x) / static_cast<float>(res_y);
-                // Disable MSAA for exports to allow higher resolution (up to 16384x16384 instead of 8192x8192)
-                m_deviceResources->UpdateOffscreenResources(res_x, res_y, aspectRatio, true);
                 m_map_renderer->SetShouldRenderSky(false);
                 m_map_renderer->SetShouldRenderFog(false);
                 m_map_renderer->SetShouldRenderShadows(false);
                 m_map_renderer->SetShouldRenderShadowsForModels(false);
-            }
-            break;
+                break;
             case ExtractPanel::CurrentMapNoViewChange:
-            {
-                int res_x = dim_x * m_extract_panel_info.pixels_per_tile_x;
-                float cameraAspectRatio = m_map_renderer->GetCamera()->GetAspectRatio();
-                int res_y = static_cast<int>(res_x / cameraAspectRatio);
-                // Disable MSAA for exports to allow higher resolution
-                m_deviceResources->UpdateOffscreenResources(res_x, res_y, cameraAspectRatio, true);
+                aspectRatio = m_map_renderer->GetCamera()->GetAspectRatio();
+                res_y = static_cast<int>(res_x / aspectRatio);
                 break;
-            }
             default:
                 break;
             }
 
-            RenderShadows();
-            RenderWaterReflection();
-
-            ClearOffscreen();
-
-            m_map_renderer->Render(m_deviceResources->GetOffscreenRenderTargetView(), nullptr, m_deviceResources->GetOffscreenDepthStencilView());
-
-            m_map_renderer->SetShouldRenderSky(should_render_sky);
-            m_map_renderer->SetShouldRenderFog(should_render_fog);
-            m_map_renderer->SetShouldRenderShadows(should_render_shadows);
-            m_map_renderer->SetShouldRenderShadowsForModels(should_render_model_shadows);
-
-            m_deviceResources->GetD3DDeviceContext()->Flush();
+            // The map is rendered in tiles, so the export size is only limited by what D3D11 can load back
+            // (16384x16384). Clamp to that while maintaining the aspect ratio.
+            constexpr int max_export_dimension = D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION;
+            if (res_x > max_export_dimension || res_y > max_export_dimension) {
+                if (aspectRatio > 1.0f) {
+                    res_x = max_export_dimension;
+                    res_y = static_cast<int>(res_x / aspectRatio);
+                }
+                else {
+                    res_y = max_export_dimension;
+                    res_x = static_cast<int>(res_y * aspectRatio);
+                }
+            }
+            res_x = std::clamp(res_x, 1, max_export_dimension);
+            res_y = std::clamp(res_y, 1, max_export_dimension);
 
-            ID3D11ShaderResourceView* shaderResourceView = nullptr;
-            ID3D11Texture2D* texture = m_deviceResources->GetOffscreenRenderTarget();
+            // Disable MSAA for exports, it is not needed for static renders
+            m_deviceResources->UpdateOffscreenResources(std::min(res_x, map_export_tile_size),
+                std::min(res_y, map_export_tile_size), aspectRatio, true);
 
-            ComPtr<ID3D11Texture2D> resolvedTextureCom;
-            ID3D11Texture2D* textureToSave = nullptr;
+            // Shadows are rendered for the whole map before the projection is narrowed to a tile.
+            RenderShadows();
 
-            // UpdateOffscreenResources always creates MSAA textures when hardware supports it,
-            // regardless of the user's MSAA setting. So we must always resolve to non-MSAA.
             D3D11_TEXTURE2D_DESC offscreenDesc;
-            texture->GetDesc(&offscreenDesc);
-            if (offscreenDesc.SampleDesc.Count > 1) {
-                resolvedTextureCom = m_deviceResources->GetOffscreenNonMsaaRenderTarget();
-                m_deviceResources->GetD3DDeviceContext()->ResolveSubresource(
-                    resolvedTextureCom.Get(), 0, texture, 0, m_deviceResources->GetBackBufferFormat());
-                textureToSave = resolvedTextureCom.Get();
-            }
-            else {
-                textureToSave = texture;
-                textureToSave->AddRef();
-            }
-
+            m_deviceResources->GetOffscreenRenderTarget()->GetDesc(&offscreenDesc);
 
+            const auto file_id = m_dat_managers[m_dat_manager_to_show_in_dat_browser]->get_MFT()[index].Hash;
+            HRESULT hr = S_OK;
             if (m_extract_panel_info.map_render_extract_file_type == ExtractPanel::PNG) {
-                D3D11_TEXTURE2D_DESC textureDesc;
-                textureToSave->GetDesc(&textureDesc);
-
-                D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-                ZeroMemory(&srvDesc, sizeof(srvDesc));
-                srvDesc.Format = textureDesc.Format;
-                srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-                srvDesc.Texture2D.MostDetailedMip = 0;
-                srvDesc.Texture2D.MipLevels = 1;
-
-                // Create the shader resource view.
-                HRESULT hr = m_deviceResources->GetD3DDevice()->CreateShaderResourceView(
-                    textureToSave, &srvDesc, &shaderResourceView);
-                if (SUCCEEDED(hr))
-                {
-                    const auto file_id = m_dat_managers[m_dat_manager_to_show_in_dat_browser]->get_MFT()[index].Hash;
-                    auto filename = std::format(L"{}\\map_texture_0x{:X}.png", m_extract_panel_info.save_directory, file_id);
-                    std::wstring wsFilename = filename;
-                    SaveTextureToPng(shaderResourceView, wsFilename, m_map_renderer->GetTextureManager());
-
-                    shaderResourceView->Release();
+                const auto filename = std::format(L"{}\\map_texture_0x{:X}.png", m_extract_panel_info.save_directory, file_id);
+                PngStripWriter writer;
+                hr = writer.Open(filename, res_x, res_y, offscreenDesc.Format);
+                if (SUCCEEDED(hr)) {
+                    hr = RenderMapInTiles(res_x, res_y, writer);
                 }
-                else {
-                    // Handle error (unable to save to png)
-                    m_error_msg = std::format("Failed to create SRV for map extraction (PNG). HRESULT: 0x{:X}", hr);
-                    m_show_error_msg = true;
-                    m_mft_indices_to_extract.clear();
+                if (SUCCEEDED(hr)) {
+                    hr = writer.Finish();
                 }
             }
             else { // DDS
-                DirectX::ScratchImage capturedImage;
-                HRESULT hrCapture = DirectX::CaptureTexture(m_deviceResources->GetD3DDevice(), m_deviceResources->GetD3DDeviceContext(), textureToSave, capturedImage);
-
-                if (SUCCEEDED(hrCapture)) {
-                    DirectX::ScratchImage mipmappedImage;
-                    HRESULT hrMip = DirectX::GenerateMipMaps(*capturedImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, mipmappedImage);
-                    if (SUCCEEDED(hrMip)) {
-                        DirectX::ScratchImage compressedImage;
-                        HRESULT hrCompress = DirectX::Compress(mipmappedImage.GetImages(), mipmappedImage.GetImageCount(), mipmappedImage.GetMetadata(), DXGI_FORMAT_BC3_UNORM, DirectX::TEX_COMPRESS_DEFAULT, 0.5f, compressedImage);
-                        if (SUCCEEDED(hrCompress)) {
-                            const auto file_id = m_dat_managers[m_dat_manager_to_show_in_dat_browser]->get_MFT()[index].Hash;
-                            auto filename = std::format(L"{}\\map_texture_0x{:X}.dds", m_extract_panel_info.save_directory, file_id);
-
-                            HRESULT hrSave = DirectX::SaveToDDSFile(compressedImage.GetImages(), compressedImage.GetImageCount(), compressedImage.GetMetadata(), DirectX::DDS_FLAGS_NONE, filename.c_str());
-                            if (FAILED(hrSave)) {
-                                m_mft_indices_to_extract.clear();
-                                m_error_msg = std::format("SaveToDDSFile failed. HRESULT: 0x{:X}. Try lowering the resolution (i.e. use less pixels per tile).", hrSave);
-                                m_show_error_msg = true;
-                            }
-                        }
-                        else {
-                            m_mft_indices_to_extract.clear();
-                            m_error_msg = std::format("Compress failed. HRESULT: 0x{:X}. Try lowering the resolution (i.e. use less pixels per tile).", hrCompress);
-                            m_show_error_msg = true;
-                        }
-                    }
-                    else {
-                        m_mft_indices_to_extract.clear();
-                        m_error_msg = std::format("GenerateMipMaps failed. HRESULT: 0x{:X}. Try lowering the resolution (i.e. use less pixels per tile).", hrMip);
-                        m_show_error_msg = true;
-                    }
+                const auto filename = std::format(L"{}\\map_texture_0x{:X}.dds", m_extract_panel_info.save_directory, file_id);
+                DdsStripWriter writer;
+                hr = writer.Open(filename, res_x, res_y, offscreenDesc.Format, m_extract_panel_info.dds_mip_filter);
+                if (SUCCEEDED(hr)) {
+                    hr = RenderMapInTiles(res_x, res_y, writer);
                 }
-                else {
-                    m_mft_indices_to_extract.clear();
-                    m_error_msg = std::format("CaptureTexture failed. HRESULT: 0x{:X}. Not enough VRAM, try lowering the resolution (i.e. use less pixels per tile).", hrCapture);
-                    m_show_error_msg = true;
+                if (SUCCEEDED(hr)) {
+                    hr = writer.Finish();
                 }
             }
 
-            // Release texture if we added a ref (non-MSAA case)
-            if (textureToSave && offscreenDesc.SampleDesc.Count == 1) {
-                textureToSave->Release();
+            m_map_renderer->SetShouldRenderSky(should_render_sky);
+            m_map_renderer->SetShouldRenderFog(should_render_fog);
+            m_map_renderer->SetShouldRenderShadows(should_render_shadows);
+            m_map_renderer->SetShouldRenderShadowsForModels(should_render_model_shadows);
+
+            if (FAILED(hr)) {
+                m_mft_indices_to_extract.clear();
+                m_error_msg = std::format("Map export to {} failed. HRESULT: 0x{:X}.",
+                    m_extract_panel_info.map_render_extract_file_type == ExtractPanel::PNG ? "PNG" : "DDS",
+                    static_cast<uint32_t>(hr));
+                m_show_error_msg = true;
             }
         }
     }
@@ -1156,6 +1105,70 @@ void MapBrowser::Render()
     }
 }
 
+HRESULT MapBrowser::RenderMapInTiles(int width, int height, ImageStripWriter& writer)
+{
+    const D3D11_VIEWPORT tile_viewport = m_deviceResources->GetOffscreenViewport();
+    const int tile_width = static_cast<int>(tile_viewport.Width);
+    const int tile_height = static_cast<int>(tile_viewport.Height);
+
+    D3D11_TEXTURE2D_DESC offscreenDesc;
+    m_deviceResources->GetOffscreenRenderTarget()->GetDesc(&offscreenDesc);
+
+    Camera* camera = m_map_renderer->GetCamera();
+    std::vector<uint8_t> band(static_cast<size_t>(width) * tile_height * 4);
+    HRESULT hr = S_OK;
+
+    for (int band_y = 0; band_y < height && SUCCEEDED(hr); band_y += tile_height) {
+        const int band_rows = std::min(tile_height, height - band_y);
+
+        for (int tile_x = 0; tile_x < width && SUCCEEDED(hr); tile_x += tile_width) {
+            const int tile_columns = std::min(tile_width, width - tile_x);
+
+            // The part of the full view this tile covers, in normalized device coordinates. Tiles on the
+            // right and bottom edges reach past the image, only their top left part is kept.
+            camera->SetProjectionWindow(
+                -1.0f + 2.0f * tile_x / width,
+                1.0f - 2.0f * band_y / height,
+                -1.0f + 2.0f * (tile_x + tile_width) / width,
+                1.0f - 2.0f * (band_y + tile_height) / height);
+            m_map_renderer->Update(0); // Update camera CB
+
+            RenderWaterReflection();
+
+            ClearOffscreen();
+
+            m_map_renderer->Render(m_deviceResources->GetOffscreenRenderTargetView(), nullptr, m_deviceResources->GetOffscreenDepthStencilView());
+
+            ID3D11Texture2D* texture = m_deviceResources->GetOffscreenRenderTarget();
+            if (offscreenDesc.SampleDesc.Count > 1) {
+                ID3D11Texture2D* resolved = m_deviceResources->GetOffscreenNonMsaaRenderTarget();
+                m_deviceResources->GetD3DDeviceContext()->ResolveSubresource(
+                    resolved, 0, texture, 0, m_deviceResources->GetBackBufferFormat());
+                texture = resolved;
+            }
+
+            DirectX::ScratchImage captured_tile;
+            hr = DirectX::CaptureTexture(m_deviceResources->GetD3DDevice(), m_deviceResources->GetD3DDeviceContext(), texture, captured_tile);
+            if (SUCCEEDED(hr)) {
+                const DirectX::Image* image = captured_tile.GetImage(0, 0, 0);
+                for (int y = 0; y < band_rows; y++) {
+                    memcpy(band.data() + (static_cast<size_t>(y) * width + tile_x) * 4,
+                        image->pixels + y * image->rowPitch, static_cast<size_t>(tile_columns) * 4);
+                }
+            }
+        }
+
+        if (SUCCEEDED(hr)) {
+            hr = writer.WriteRows(band.data(), static_cast<size_t>(width) * 4, band_rows);
+        }
+    }
+
+    camera->ClearProjectionWindow();
+    m_map_renderer->Update(0); // Update camera CB
+
+    return hr;
+}
+
 void MapBrowser::RenderWaterReflection()
 {
     if (m_map_renderer->GetTerrain() && m_map_renderer->GetWaterMeshId() >= 0 && m_map_renderer->GetShouldRenderWaterReflectionEffective()) {
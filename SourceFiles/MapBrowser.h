@@ -16,6 +16,7 @@
 #include "ReplayLibrary.h"
 #include "ReplayWindow.h"
 #include <draw_extract_panel.h>
+#include "TiledImageWriter.h"
 
 using namespace std::chrono;
 
@@ -64,6 +65,10 @@ private:
 
     void RenderShadows();
 
+    // Renders the current view at width x height one offscreen sized tile at a time and passes the
+    // image to writer a row of tiles at a time.
+    HRESULT RenderMapInTiles(int width, int height, ImageStripWriter& writer);
+
     void Clear();
     void ClearOffscreen();
     void ClearShadow();
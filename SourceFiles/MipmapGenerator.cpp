@@ -0,0 +1,422 @@
+#include "pch.h"
+#include "MipmapGenerator.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <execution>
+#include <numeric>
+#include <thread>
+#include <emmintrin.h>
+
+namespace
+{
+    // Levels with fewer destination pixels than this are filtered on the calling thread.
+    constexpr size_t min_parallel_pixels = 256 * 256;
+
+    // Calls fn(yBegin, yEnd) for bands of destination rows, in parallel for large levels.
+    template <typename Fn>
+    void for_each_row_band(size_t dstWidth, size_t dstHeight, Fn&& fn)
+    {
+        if (dstWidth * dstHeight < min_parallel_pixels)
+        {
+            fn(size_t{0}, dstHeight);
+            return;
+        }
+
+        const size_t numBands = std::min<size_t>(dstHeight, std::max(1u, std::thread::hardware_concurrency()) * 4);
+        std::vector<size_t> bands(numBands);
+        std::iota(bands.begin(), bands.end(), size_t{0});
+        std::for_each(std::execution::par, bands.begin(), bands.end(), [&](size_t band) {
+            fn(band * dstHeight / numBands, (band + 1) * dstHeight / numBands);
+        });
+    }
+
+    // Rows of an image of which only rows [first, ...) are in memory, the first of them at data.
+    template <typename T>
+    struct RowWindow
+    {
+        T* data;
+        size_t first;
+        size_t pitch;
+
+        T* row(size_t y) const { return data + (y - first) * pitch; }
+    };
+
+    using SourceRows = RowWindow<const uint8_t>;
+    using DestRows = RowWindow<uint8_t>;
+
+    // ---- Box ----
+
+    // a and b hold the same 4 pixels of two rows. Returns the averages of the two 2x2 squares as
+    // 16-bit channels.
+    __m128i box_average(__m128i a, __m128i b)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        const __m128i sum01 = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        const __m128i sum23 = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+        return _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum01, sum23), _mm_set1_epi16(2)), 2);
+    }
+
+    void box_rows(const SourceRows& src, size_t width, size_t height, const DestRows& dst, size_t dstWidth,
+                  size_t yBegin, size_t yEnd)
+    {
+        for (size_t y = yBegin; y < yEnd; y++)
+        {
+            const uint8_t* row0 = src.row(std::min(2 * y, height - 1));
+            const uint8_t* row1 = src.row(std::min(2 * y + 1, height - 1));
+            uint8_t* out = dst.row(y);
+
+            size_t x = 0;
+            for (; 2 * x + 8 <= width; x += 4)
+            {
+                const uint8_t* p0 = row0 + 8 * x;
+                const uint8_t* p1 = row1 + 8 * x;
+                const __m128i left = box_average(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0)),
+                                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1)));
+                const __m128i right = box_average(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + 16)),
+                                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + 16)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * x), _mm_packus_epi16(left, right));
+            }
+
+            // The odd last column of odd widths is repeated.
+            for (; x < dstWidth; x++)
+            {
+                const size_t x0 = std::min(2 * x, width - 1) * 4;
+                const size_t x1 = std::min(2 * x + 1, width - 1) * 4;
+                for (size_t c = 0; c < 4; c++)
+                {
+                    out[4 * x + c] = static_cast<uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+                }
+            }
+        }
+    }
+
+    // ---- Kaiser ----
+
+    constexpr int kaiser_taps = 8;
+
+    double bessel_i0(double x)
+    {
+        double sum = 1;
+        double term = 1;
+        for (int k = 1; k < 32; k++)
+        {
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Weights of the source pixels 2x - 3 .. 2x + 4 for destination pixel x: a sinc at the
+    // destination rate under a Kaiser window (alpha 4, 2 destination pixels wide), normalized.
+    std::array<float, kaiser_taps> compute_kaiser_weights()
+    {
+        constexpr double pi = 3.14159265358979323846;
+        constexpr double alpha = 4;
+        constexpr double window_width = 2;
+
+        std::array<double, kaiser_taps> weights;
+        double sum = 0;
+        for (int k = 0; k < kaiser_taps; k++)
+        {
+            const double t = (k - 3.5) / 2;
+            const double sinc = std::sin(pi * t) / (pi * t);
+            const double r = t / window_width;
+            weights[k] = sinc * bessel_i0(alpha * std::sqrt(1 - r * r)) / bessel_i0(alpha);
+            sum += weights[k];
+        }
+
+        std::array<float, kaiser_taps> normalized;
+        for (int k = 0; k < kaiser_taps; k++)
+        {
+            normalized[k] = static_cast<float>(weights[k] / sum);
+        }
+        return normalized;
+    }
+
+    const std::array<float, kaiser_taps>& kaiser_weights()
+    {
+        static const auto weights = compute_kaiser_weights();
+        return weights;
+    }
+
+    __m128 load_pixel(const uint8_t* pixel)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bytes = _mm_cvtsi32_si128(*reinterpret_cast<const int*>(pixel));
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+    }
+
+    void store_pixel(uint8_t* pixel, __m128 value)
+    {
+        const __m128i channels = _mm_cvtps_epi32(value);
+        const __m128i words = _mm_packs_epi32(channels, channels);
+        *reinterpret_cast<int*>(pixel) = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+    }
+
+    void kaiser_rows(const SourceRows& src, size_t width, size_t height, const DestRows& dst, size_t dstWidth,
+                     size_t yBegin, size_t yEnd)
+    {
+        const auto& weights = kaiser_weights();
+        __m128 w[kaiser_taps];
+        for (int k = 0; k < kaiser_taps; k++)
+        {
+            w[k] = _mm_set1_ps(weights[k]);
+        }
+
+        // A source row with its edge pixels repeated 3 to the left and 4 to the right, so the
+        // horizontal pass needs no bounds checks.
+        std::vector<__m128> padded(width + kaiser_taps - 1);
+        // The horizontally filtered source rows the current destination row needs. Source row r
+        // (unclamped) lives in slot r mod 8; consecutive destination rows share 6 of them.
+        std::vector<__m128> filtered(kaiser_taps * dstWidth);
+        std::array<ptrdiff_t, kaiser_taps> slotRows;
+        slotRows.fill(PTRDIFF_MIN);
+
+        const auto filter_row = [&](ptrdiff_t r, __m128* out) {
+            const ptrdiff_t clamped = std::clamp<ptrdiff_t>(r, 0, static_cast<ptrdiff_t>(height) - 1);
+            const uint8_t* row = src.row(clamped);
+            for (size_t i = 0; i < padded.size(); i++)
+            {
+                const ptrdiff_t x = std::clamp<ptrdiff_t>(static_cast<ptrdiff_t>(i) - 3, 0, static_cast<ptrdiff_t>(width) - 1);
+                padded[i] = load_pixel(row + 4 * x);
+            }
+
+            for (size_t x = 0; x < dstWidth; x++)
+            {
+                const __m128* taps = padded.data() + 2 * x;
+                __m128 sum = _mm_mul_ps(taps[0], w[0]);
+                for (int k = 1; k < kaiser_taps; k++)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(taps[k], w[k]));
+                }
+                out[x] = sum;
+            }
+        };
+
+        for (size_t y = yBegin; y < yEnd; y++)
+        {
+            const __m128* rows[kaiser_taps];
+            for (int k = 0; k < kaiser_taps; k++)
+            {
+                const ptrdiff_t r = static_cast<ptrdiff_t>(2 * y) - 3 + k;
+                const size_t slot = static_cast<size_t>(r & (kaiser_taps - 1));
+                __m128* row = filtered.data() + slot * dstWidth;
+                if (slotRows[slot] != r)
+                {
+                    filter_row(r, row);
+                    slotRows[slot] = r;
+                }
+                rows[k] = row;
+            }
+
+            uint8_t* out = dst.row(y);
+            for (size_t x = 0; x < dstWidth; x++)
+            {
+                __m128 sum = _mm_mul_ps(rows[0][x], w[0]);
+                for (int k = 1; k < kaiser_taps; k++)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(rows[k][x], w[k]));
+                }
+                store_pixel(out + 4 * x, sum);
+            }
+        }
+    }
+
+    // ---- Median ----
+
+    // Median of the source pixels around (2x, 2y) that are inside the image, per channel.
+    void median_pixel(const SourceRows& src, size_t width, size_t height, size_t x, size_t y, uint8_t* out)
+    {
+        for (size_t c = 0; c < 4; c++)
+        {
+            std::array<uint8_t, 9> values;
+            size_t count = 0;
+            for (int dy = -1; dy <= 1; dy++)
+            {
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    const ptrdiff_t nx = static_cast<ptrdiff_t>(2 * x) + dx;
+                    const ptrdiff_t ny = static_cast<ptrdiff_t>(2 * y) + dy;
+                    if (nx < 0 || ny < 0 || nx >= static_cast<ptrdiff_t>(width) || ny >= static_cast<ptrdiff_t>(height))
+                        continue;
+
+                    values[count++] = src.row(ny)[4 * nx + c];
+                }
+            }
+
+            std::sort(values.begin(), values.begin() + count);
+            out[c] = values[count / 2];
+        }
+    }
+
+    void sort2(__m128i& a, __m128i& b)
+    {
+        const __m128i lo = _mm_min_epu8(a, b);
+        b = _mm_max_epu8(a, b);
+        a = lo;
+    }
+
+    // Loads the left, center and right neighbours of the source pixels 2x .. 2x + 6 (step 2).
+    void load_neighbours(const uint8_t* row, size_t x, __m128i* out)
+    {
+        const auto load = [row](size_t pixel) {
+            return _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 4 * pixel)));
+        };
+        const __m128 before = load(2 * x - 2);
+        const __m128 middle = load(2 * x + 2);
+        const __m128 center0 = load(2 * x);
+        const __m128 center1 = load(2 * x + 4);
+        out[0] = _mm_castps_si128(_mm_shuffle_ps(before, middle, _MM_SHUFFLE(3, 1, 3, 1)));
+        out[1] = _mm_castps_si128(_mm_shuffle_ps(center0, center1, _MM_SHUFFLE(2, 0, 2, 0)));
+        out[2] = _mm_castps_si128(_mm_shuffle_ps(center0, center1, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    void median_rows(const SourceRows& src, size_t width, size_t height, const DestRows& dst, size_t dstWidth,
+                     size_t yBegin, size_t yEnd)
+    {
+        for (size_t y = yBegin; y < yEnd; y++)
+        {
+            uint8_t* out = dst.row(y);
+            size_t x = 0;
+
+            // All 9 samples are inside the image away from the top and left edges (and the bottom
+            // and right edges of odd sizes). There the median of 4 destination pixels is taken at
+            // once with the 19 compare-exchange network.
+            if (y > 0 && 2 * y + 1 < height)
+            {
+                median_pixel(src, width, height, 0, y, out);
+                for (x = 1; 2 * x + 8 <= width; x += 4)
+                {
+                    __m128i p[9];
+                    for (int r = 0; r < 3; r++)
+                    {
+                        load_neighbours(src.row(2 * y - 1 + r), x, p + 3 * r);
+                    }
+
+                    sort2(p[1], p[2]); sort2(p[4], p[5]); sort2(p[7], p[8]);
+                    sort2(p[0], p[1]); sort2(p[3], p[4]); sort2(p[6], p[7]);
+                    sort2(p[1], p[2]); sort2(p[4], p[5]); sort2(p[7], p[8]);
+                    sort2(p[0], p[3]); sort2(p[5], p[8]); sort2(p[4], p[7]);
+                    sort2(p[3], p[6]); sort2(p[1], p[4]); sort2(p[2], p[5]);
+                    sort2(p[4], p[7]); sort2(p[4], p[2]); sort2(p[6], p[4]);
+                    sort2(p[4], p[2]);
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * x), p[4]);
+                }
+            }
+
+            for (; x < dstWidth; x++)
+            {
+                median_pixel(src, width, height, x, y, out + 4 * x);
+            }
+        }
+    }
+}
+
+const char* GetMipFilterName(MipFilter filter)
+{
+    switch (filter)
+    {
+    case MipFilter::Box:
+        return "Box";
+    case MipFilter::Kaiser:
+        return "Kaiser";
+    case MipFilter::Median:
+        return "Median";
+    default:
+        return "Unknown";
+    }
+}
+
+void GenerateMipLevel(const uint8_t* src, size_t width, size_t height, size_t srcRowPitch, uint8_t* dst,
+                      size_t dstRowPitch, MipFilter filter)
+{
+    GenerateMipRows(src, 0, width, height, srcRowPitch, dst, dstRowPitch, 0, std::max<size_t>(1, height / 2), filter);
+}
+
+std::pair<size_t, size_t> GetMipSourceRows(MipFilter filter, size_t height, size_t dstBegin, size_t dstEnd)
+{
+    const auto clamp_row = [height](ptrdiff_t row) {
+        return static_cast<size_t>(std::clamp<ptrdiff_t>(row, 0, static_cast<ptrdiff_t>(height) - 1));
+    };
+
+    const ptrdiff_t first = 2 * static_cast<ptrdiff_t>(dstBegin);
+    const ptrdiff_t last = 2 * static_cast<ptrdiff_t>(dstEnd) - 2;
+    switch (filter)
+    {
+    case MipFilter::Kaiser:
+        return { clamp_row(first - 3), clamp_row(last + 4) + 1 };
+    case MipFilter::Median:
+        return { clamp_row(first - 1), clamp_row(last + 1) + 1 };
+    default:
+        return { clamp_row(first), clamp_row(last + 1) + 1 };
+    }
+}
+
+void GenerateMipRows(const uint8_t* src, size_t srcFirstRow, size_t width, size_t height, size_t srcRowPitch,
+                     uint8_t* dst, size_t dstRowPitch, size_t dstBegin, size_t dstEnd, MipFilter filter)
+{
+    const size_t dstWidth = std::max<size_t>(1, width / 2);
+    const SourceRows srcRows{ src, srcFirstRow, srcRowPitch };
+    const DestRows dstRows{ dst, dstBegin, dstRowPitch };
+
+    for_each_row_band(dstWidth, dstEnd - dstBegin, [&](size_t yBegin, size_t yEnd) {
+        yBegin += dstBegin;
+        yEnd += dstBegin;
+        switch (filter)
+        {
+        case MipFilter::Kaiser:
+            kaiser_rows(srcRows, width, height, dstRows, dstWidth, yBegin, yEnd);
+            break;
+        case MipFilter::Median:
+            median_rows(srcRows, width, height, dstRows, dstWidth, yBegin, yEnd);
+            break;
+        default:
+            box_rows(srcRows, width, height, dstRows, dstWidth, yBegin, yEnd);
+            break;
+        }
+    });
+}
+
+HRESULT GenerateMipChain(const DirectX::Image& image, MipFilter filter, DirectX::ScratchImage& mipChain)
+{
+    switch (image.format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+        break;
+    default:
+        return DirectX::GenerateMipMaps(image, DirectX::TEX_FILTER_DEFAULT, 0, mipChain);
+    }
+
+    size_t levels = 1;
+    for (size_t size = std::max(image.width, image.height); size > 1; size /= 2)
+    {
+        levels++;
+    }
+
+    HRESULT hr = mipChain.Initialize2D(image.format, image.width, image.height, 1, levels);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    const DirectX::Image* base = mipChain.GetImage(0, 0, 0);
+    for (size_t y = 0; y < image.height; y++)
+    {
+        memcpy(base->pixels + y * base->rowPitch, image.pixels + y * image.rowPitch, image.width * 4);
+    }
+
+    for (size_t level = 1; level < levels; level++)
+    {
+        const DirectX::Image* src = mipChain.GetImage(level - 1, 0, 0);
+        const DirectX::Image* dst = mipChain.GetImage(level, 0, 0);
+        GenerateMipLevel(src->pixels, src->width, src->height, src->rowPitch, dst->pixels, dst->rowPitch, filter);
+    }
+
+    return S_OK;
+}
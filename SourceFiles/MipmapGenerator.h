@@ -0,0 +1,33 @@
+#pragma once
+#include "DirectXTex/DirectXTex.h"
+#include <cstdint>
+#include <utility>
+
+// CPU mipmap generation for 8-bit RGBA/BGRA images, used for DDS exports. Every level is split into
+// bands of rows that are filtered in parallel; the rows themselves are processed with SSE2.
+enum class MipFilter
+{
+    Box,    // 2x2 average
+    Kaiser, // Separable 8-tap Kaiser-windowed sinc, sharper than the box filter
+    Median, // 3x3 per-channel median around each even source pixel, drops isolated outlier pixels
+};
+
+const char* GetMipFilterName(MipFilter filter);
+
+// Downsamples src (width x height, 4 bytes per pixel) to max(1, width / 2) x max(1, height / 2).
+void GenerateMipLevel(const uint8_t* src, size_t width, size_t height, size_t srcRowPitch, uint8_t* dst,
+                      size_t dstRowPitch, MipFilter filter);
+
+// The source rows [first, last) that destination rows [dstBegin, dstEnd) of the next level read from a
+// level that is height rows tall. Lets a level be filtered a few rows at a time.
+std::pair<size_t, size_t> GetMipSourceRows(MipFilter filter, size_t height, size_t dstBegin, size_t dstEnd);
+
+// Like GenerateMipLevel, but only writes destination rows [dstBegin, dstEnd) to dst (which points at row
+// dstBegin). src points at source row srcFirstRow and must hold the rows GetMipSourceRows returns for them.
+// The result is the same as filtering the whole level at once.
+void GenerateMipRows(const uint8_t* src, size_t srcFirstRow, size_t width, size_t height, size_t srcRowPitch,
+                     uint8_t* dst, size_t dstRowPitch, size_t dstBegin, size_t dstEnd, MipFilter filter);
+
+// Builds the full mip chain of image, like DirectX::GenerateMipMaps with levels = 0. Formats other
+// than R8G8B8A8_UNORM, B8G8R8A8_UNORM and B8G8R8X8_UNORM are passed on to DirectX::GenerateMipMaps.
+HRESULT GenerateMipChain(const DirectX::Image& image, MipFilter filter, DirectX::ScratchImage& mipChain);
@@ -0,0 +1,922 @@
+#include "pch.h"
+#include "ReplayCache.h"
+#include "GzipInflate.h"
+#include <array>
+#include <bit>
+#include <fstream>
+
+// Defined in writeHeighMapBMP.cpp, which compiles the stb_image_write implementation.
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+namespace {
+
+constexpr uint32_t kCacheVersion = 2;
+constexpr const char* kAgentCacheName = "agents.gwrc";
+constexpr const char* kStoCCacheName = "stoc.gwrc";
+
+// How a block stores its time column.
+constexpr uint8_t kTimeMillis = 0;   // Whole milliseconds, the resolution of the exported timestamps
+constexpr uint8_t kTimeFloatBits = 1;
+
+// Compression level of stbi_zlib_compress for the StoC raw lines.
+constexpr int kZlibQuality = 5;
+
+struct CacheHeader
+{
+    char     magic[4];
+    uint32_t version;
+    char     content[4];
+    uint32_t numBlocks;
+    uint64_t sourceStamp;
+    uint64_t fileSize;
+};
+static_assert(sizeof(CacheHeader) == 32);
+
+struct CacheBlockEntry
+{
+    int32_t  id;
+    uint32_t count;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t crc;       // CRC-32 of id, count and the block bytes
+    uint32_t reserved;
+};
+static_assert(sizeof(CacheBlockEntry) == 32);
+
+struct CacheBlock
+{
+    CacheBlockEntry  entry;
+    std::string_view bytes;
+};
+
+// ---------------------------------------------------------------------------
+// Byte and column coding
+// ---------------------------------------------------------------------------
+
+class ByteWriter
+{
+public:
+    void PutVarint(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            m_bytes.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        m_bytes.push_back(static_cast<char>(v));
+    }
+
+    void PutU8(uint8_t v) { m_bytes.push_back(static_cast<char>(v)); }
+
+    void PutString(std::string_view s)
+    {
+        PutVarint(s.size());
+        m_bytes.append(s);
+    }
+
+    std::string& Bytes() { return m_bytes; }
+
+private:
+    std::string m_bytes;
+};
+
+class ByteReader
+{
+public:
+    explicit ByteReader(std::string_view bytes) : m_bytes(bytes) {}
+
+    uint64_t GetVarint()
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64 && m_pos < m_bytes.size(); shift += 7)
+        {
+            const uint8_t b = static_cast<uint8_t>(m_bytes[m_pos++]);
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        m_failed = true;
+        return 0;
+    }
+
+    uint8_t GetU8()
+    {
+        if (m_pos >= m_bytes.size())
+        {
+            m_failed = true;
+            return 0;
+        }
+        return static_cast<uint8_t>(m_bytes[m_pos++]);
+    }
+
+    std::string_view GetString()
+    {
+        const uint64_t size = GetVarint();
+        if (m_failed || size > m_bytes.size() - m_pos)
+        {
+            m_failed = true;
+            return {};
+        }
+        const std::string_view s = m_bytes.substr(m_pos, static_cast<size_t>(size));
+        m_pos += static_cast<size_t>(size);
+        return s;
+    }
+
+    bool Failed() const { return m_failed; }
+
+private:
+    std::string_view m_bytes;
+    size_t m_pos = 0;
+    bool m_failed = false;
+};
+
+// A column of 32-bit values. A value that differs from the previous one is written as
+// zigzag(delta) << 1, a run of n unchanged values as n << 1 | 1.
+class ColumnEncoder
+{
+public:
+    void Put(uint32_t value)
+    {
+        if (value == m_prev)
+        {
+            m_run++;
+            return;
+        }
+        FlushRun();
+        const uint32_t delta = value - m_prev;
+        const uint32_t zigzag = (delta << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(delta) >> 31);
+        m_out.PutVarint(static_cast<uint64_t>(zigzag) << 1);
+        m_prev = value;
+    }
+
+    std::string& Finish()
+    {
+        FlushRun();
+        return m_out.Bytes();
+    }
+
+private:
+    void FlushRun()
+    {
+        if (m_run)
+        {
+            m_out.PutVarint(static_cast<uint64_t>(m_run) << 1 | 1);
+            m_run = 0;
+        }
+    }
+
+    ByteWriter m_out;
+    uint32_t m_prev = 0;
+    uint32_t m_run = 0;
+};
+
+class ColumnDecoder
+{
+public:
+    explicit ColumnDecoder(std::string_view bytes) : m_in(bytes) {}
+
+    uint32_t Get()
+    {
+        if (m_run)
+        {
+            m_run--;
+            return m_prev;
+        }
+
+        const uint64_t v = m_in.GetVarint();
+        if (v & 1)
+        {
+            m_run = static_cast<uint32_t>(v >> 1);
+            if (m_run == 0)
+                m_failed = true;
+            else
+                m_run--;
+            return m_prev;
+        }
+        const uint32_t zigzag = static_cast<uint32_t>(v >> 1);
+        m_prev += (zigzag >> 1) ^ (0u - (zigzag & 1));
+        return m_prev;
+    }
+
+    bool Failed() const { return m_failed || m_in.Failed(); }
+
+private:
+    ByteReader m_in;
+    uint32_t m_prev = 0;
+    uint32_t m_run = 0;
+    bool m_failed = false;
+};
+
+// ---------------------------------------------------------------------------
+// Checksums
+// ---------------------------------------------------------------------------
+
+constexpr auto kCrc32Table = []()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[i] = c;
+    }
+    return table;
+}();
+
+uint32_t Crc32(uint32_t crc, const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = kCrc32Table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t BlockCrc(const CacheBlockEntry& entry, std::string_view bytes)
+{
+    uint32_t crc = Crc32(0, &entry.id, sizeof(entry.id));
+    crc = Crc32(crc, &entry.count, sizeof(entry.count));
+    return Crc32(crc, bytes.data(), bytes.size());
+}
+
+uint32_t Adler32(std::string_view bytes)
+{
+    uint32_t a = 1, b = 0;
+    while (!bytes.empty())
+    {
+        // 5552 is the most bytes that can be summed before b can overflow.
+        const size_t n = std::min<size_t>(bytes.size(), 5552);
+        for (size_t i = 0; i < n; i++)
+        {
+            a += static_cast<uint8_t>(bytes[i]);
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        bytes.remove_prefix(n);
+    }
+    return b << 16 | a;
+}
+
+template <typename T>
+uint32_t ToColumnValue(const T& v)
+{
+    if constexpr (std::is_same_v<T, float>)
+        return std::bit_cast<uint32_t>(v);
+    else
+        return static_cast<uint32_t>(v);
+}
+
+template <typename T>
+void FromColumnValue(uint32_t v, T& out)
+{
+    if constexpr (std::is_same_v<T, float>)
+        out = std::bit_cast<float>(v);
+    else if constexpr (std::is_same_v<T, bool>)
+        out = v != 0;
+    else
+        out = static_cast<T>(v);
+}
+
+// Same arithmetic as the parsers' ParseTimestamp, so a time read back from milliseconds is bit for bit
+// the one that was parsed.
+float TimeFromMillis(uint32_t ms)
+{
+    const uint32_t minutes = ms / 60000;
+    const uint32_t seconds = ms / 1000 % 60;
+    const uint32_t millis = ms % 1000;
+    return static_cast<float>(minutes) * 60.f + static_cast<float>(seconds) +
+           static_cast<float>(millis) / 1000.f;
+}
+
+bool IsWholeMillis(float t)
+{
+    if (!(t >= 0.f && t < 4.0e6f))
+        return false;
+    return std::bit_cast<uint32_t>(TimeFromMillis(static_cast<uint32_t>(std::lround(t * 1000.0)))) ==
+           std::bit_cast<uint32_t>(t);
+}
+
+uint32_t TimeToColumnValue(float t, uint8_t timeEncoding)
+{
+    return timeEncoding == kTimeMillis ? static_cast<uint32_t>(std::lround(t * 1000.0)) : std::bit_cast<uint32_t>(t);
+}
+
+float TimeFromColumnValue(uint32_t v, uint8_t timeEncoding)
+{
+    return timeEncoding == kTimeMillis ? TimeFromMillis(v) : std::bit_cast<float>(v);
+}
+
+// ---------------------------------------------------------------------------
+// Field lists
+// ---------------------------------------------------------------------------
+
+// Every AgentSnapshot field except time, which is coded separately.
+template <typename Snapshot, typename F>
+void VisitSnapshotFields(Snapshot& s, F&& f)
+{
+    f(s.x); f(s.y); f(s.z); f(s.rotation);
+    f(s.weapon_id); f(s.model_id); f(s.gadget_id);
+    f(s.is_alive); f(s.is_dead); f(s.health_pct); f(s.is_knocked); f(s.max_hp);
+    f(s.has_condition); f(s.has_deep_wound); f(s.has_bleeding); f(s.has_crippled); f(s.has_blind);
+    f(s.has_poison); f(s.has_hex); f(s.has_degen_hex); f(s.has_enchantment); f(s.has_weapon_spell);
+    f(s.is_holding); f(s.is_casting); f(s.skill_id);
+    f(s.weapon_item_type); f(s.offhand_item_type); f(s.weapon_item_id); f(s.offhand_item_id);
+    f(s.move_x); f(s.move_y); f(s.visual_effects); f(s.team_id); f(s.weapon_type);
+    f(s.weapon_attack_speed); f(s.attack_speed_modifier); f(s.dagger_status); f(s.hp_pips);
+    f(s.model_state); f(s.animation_code); f(s.animation_id); f(s.animation_speed); f(s.animation_type);
+    f(s.in_spirit_range); f(s.agent_model_type); f(s.item_id); f(s.item_extra_type); f(s.gadget_extra_type);
+}
+
+// Every StoC event field except time and raw_line, which are coded separately.
+template <typename Event, typename F>
+void VisitEventFields(Event& e, F&& f)
+{
+    using T = std::remove_const_t<Event>;
+    if constexpr (std::is_same_v<T, AgentMovementEvent>)
+    {
+        f(e.agent_id); f(e.x); f(e.y); f(e.plane);
+    }
+    else if constexpr (std::is_same_v<T, SkillActivationEvent> || std::is_same_v<T, AttackSkillEvent>)
+    {
+        f(e.type); f(e.skill_id); f(e.caster_id); f(e.target_id);
+    }
+    else if constexpr (std::is_same_v<T, BasicAttackEvent>)
+    {
+        f(e.type); f(e.caster_id); f(e.target_id); f(e.skill_id);
+    }
+    else if constexpr (std::is_same_v<T, CombatEvent>)
+    {
+        f(e.type); f(e.caster_id); f(e.target_id); f(e.value); f(e.damage_type);
+    }
+    else if constexpr (std::is_same_v<T, JumboMessageEvent>)
+    {
+        f(e.message); f(e.party_value);
+    }
+    else
+    {
+        static_assert(std::is_same_v<T, UnknownEvent>);
+    }
+}
+
+template <typename Record, typename Visit>
+size_t CountFields(Visit visit)
+{
+    Record record;
+    size_t count = 0;
+    visit(record, [&count](auto&) { count++; });
+    return count;
+}
+
+template <typename Data, typename F>
+void ForEachStoCCategory(Data& d, F&& f)
+{
+    f(StoCCategory::AgentMovement, d.agentMovement);
+    f(StoCCategory::Skill, d.skill);
+    f(StoCCategory::AttackSkill, d.attackSkill);
+    f(StoCCategory::BasicAttack, d.basicAttack);
+    f(StoCCategory::Combat, d.combat);
+    f(StoCCategory::Jumbo, d.jumbo);
+    f(StoCCategory::Unknown, d.unknown);
+}
+
+// ---------------------------------------------------------------------------
+// Files
+// ---------------------------------------------------------------------------
+
+// FNV-1a over the names, sizes and write times of the files in dir. 0 if there are none.
+uint64_t SourceStamp(const std::filesystem::path& dir)
+{
+    struct SourceFile { std::wstring name; uint64_t size; int64_t writeTime; };
+    std::vector<SourceFile> files;
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec))
+    {
+        if (!entry.is_regular_file(ec)) continue;
+        files.push_back({ entry.path().filename().wstring(), entry.file_size(ec),
+                          static_cast<int64_t>(entry.last_write_time(ec).time_since_epoch().count()) });
+    }
+    if (ec || files.empty()) return 0;
+
+    // Directory order isn't guaranteed to be stable.
+    std::sort(files.begin(), files.end(), [](const SourceFile& a, const SourceFile& b) { return a.name < b.name; });
+
+    uint64_t hash = 0xCBF29CE484222325ull;
+    auto mix = [&hash](const void* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<const uint8_t*>(data)[i];
+            hash *= 0x100000001B3ull;
+        }
+    };
+    mix(&kCacheVersion, sizeof(kCacheVersion));
+    for (const auto& file : files)
+    {
+        mix(file.name.data(), file.name.size() * sizeof(wchar_t));
+        mix(&file.size, sizeof(file.size));
+        mix(&file.writeTime, sizeof(file.writeTime));
+    }
+    return hash ? hash : 1;
+}
+
+void WriteCacheFile(const std::filesystem::path& path, const char* content, uint64_t sourceStamp,
+                    std::vector<CacheBlockEntry>& entries, const std::vector<std::string>& blocks)
+{
+    uint64_t offset = sizeof(CacheHeader) + entries.size() * sizeof(CacheBlockEntry);
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        entries[i].offset = offset;
+        entries[i].size = blocks[i].size();
+        entries[i].crc = BlockCrc(entries[i], blocks[i]);
+        entries[i].reserved = 0;
+        offset += blocks[i].size();
+    }
+
+    CacheHeader header;
+    memcpy(header.magic, "GWRC", 4);
+    header.version = kCacheVersion;
+    memcpy(header.content, content, 4);
+    header.numBlocks = static_cast<uint32_t>(entries.size());
+    header.sourceStamp = sourceStamp;
+    header.fileSize = offset;
+
+    // Write to a temporary file first so an interrupted write never leaves a truncated cache behind.
+    auto tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() * sizeof(CacheBlockEntry)));
+        for (const auto& block : blocks)
+            file.write(block.data(), static_cast<std::streamsize>(block.size()));
+        if (!file.good())
+        {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+        std::filesystem::remove(tempPath, ec);
+}
+
+class MappedCacheFile
+{
+public:
+    MappedCacheFile() = default;
+    MappedCacheFile(const MappedCacheFile&) = delete;
+    MappedCacheFile& operator=(const MappedCacheFile&) = delete;
+    ~MappedCacheFile() { Close(); }
+
+    bool Open(const std::filesystem::path& path)
+    {
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            Close();
+            return false;
+        }
+
+        m_mapping = CreateFileMapping(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!m_mapping)
+        {
+            Close();
+            return false;
+        }
+
+        m_view = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_view)
+        {
+            Close();
+            return false;
+        }
+
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+        return true;
+    }
+
+    std::string_view Bytes() const { return std::string_view(m_view, m_size); }
+
+private:
+    void Close()
+    {
+        if (m_view)
+            UnmapViewOfFile(m_view);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+
+        m_view = nullptr;
+        m_mapping = NULL;
+        m_file = INVALID_HANDLE_VALUE;
+        m_size = 0;
+    }
+
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = NULL;
+    const char* m_view = nullptr;
+    size_t m_size = 0;
+};
+
+// Maps the cache file and checks that it is complete and was made from the current source files.
+bool OpenCacheFile(MappedCacheFile& file, const std::filesystem::path& path, const char* content,
+                   uint64_t sourceStamp, std::vector<CacheBlock>& blocks)
+{
+    if (sourceStamp == 0)
+        return false;
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec) || !file.Open(path))
+        return false;
+
+    const std::string_view bytes = file.Bytes();
+    if (bytes.size() < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    if (memcmp(header.magic, "GWRC", 4) != 0 || header.version != kCacheVersion ||
+        memcmp(header.content, content, 4) != 0 || header.sourceStamp != sourceStamp ||
+        header.fileSize != bytes.size())
+        return false;
+
+    if (header.numBlocks > (bytes.size() - sizeof(CacheHeader)) / sizeof(CacheBlockEntry))
+        return false;
+
+    // The blocks follow the index back to back up to the end of the file, so a damaged block count or
+    // offset can't make blocks go missing unnoticed.
+    uint64_t expectedOffset = sizeof(CacheHeader) + uint64_t(header.numBlocks) * sizeof(CacheBlockEntry);
+    blocks.resize(header.numBlocks);
+    for (uint32_t i = 0; i < header.numBlocks; i++)
+    {
+        CacheBlockEntry& entry = blocks[i].entry;
+        memcpy(&entry, bytes.data() + sizeof(CacheHeader) + i * sizeof(CacheBlockEntry), sizeof(entry));
+        if (entry.offset != expectedOffset || entry.size > bytes.size() - entry.offset)
+            return false;
+        expectedOffset += entry.size;
+        blocks[i].bytes = bytes.substr(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.size));
+        if (BlockCrc(entry, blocks[i].bytes) != entry.crc)
+            return false;
+    }
+    return expectedOffset == bytes.size();
+}
+
+// ---------------------------------------------------------------------------
+// Agent blocks
+// ---------------------------------------------------------------------------
+
+const size_t kNumSnapshotFields = CountFields<AgentSnapshot>(
+    [](auto& s, auto&& f) { VisitSnapshotFields(s, f); });
+
+std::string EncodeAgentBlock(const AgentReplayData& ard)
+{
+    const auto& snaps = ard.snapshots;
+
+    uint8_t timeEncoding = kTimeMillis;
+    for (float t : snaps.times())
+    {
+        if (!IsWholeMillis(t))
+        {
+            timeEncoding = kTimeFloatBits;
+            break;
+        }
+    }
+
+    // Time, the other fields, then the line offsets.
+    std::vector<ColumnEncoder> columns(kNumSnapshotFields + 2);
+    for (size_t i = 0; i < snaps.size(); i++)
+    {
+        const AgentSnapshot s = snaps[i];
+        columns[0].Put(TimeToColumnValue(s.time, timeEncoding));
+        size_t c = 1;
+        VisitSnapshotFields(s, [&](const auto& field) { columns[c++].Put(ToColumnValue(field)); });
+        columns[c].Put(snaps.lineOffset(i));
+    }
+
+    ByteWriter out;
+    out.PutString(ard.sourcePath.filename().string());
+    out.PutU8(timeEncoding);
+    out.PutVarint(columns.size());
+    for (auto& column : columns)
+        out.PutString(column.Finish());
+    return std::move(out.Bytes());
+}
+
+bool DecodeAgentBlock(std::string_view bytes, uint32_t count, const std::filesystem::path& agentsDir,
+                      AgentReplayData& ard)
+{
+    ByteReader in(bytes);
+    ard.sourcePath = agentsDir / std::filesystem::path(in.GetString());
+    const uint8_t timeEncoding = in.GetU8();
+    if (in.GetVarint() != kNumSnapshotFields + 2)
+        return false;
+
+    std::vector<ColumnDecoder> columns;
+    columns.reserve(kNumSnapshotFields + 2);
+    for (size_t i = 0; i < kNumSnapshotFields + 2; i++)
+        columns.emplace_back(in.GetString());
+    if (in.Failed())
+        return false;
+
+    // Every snapshot has its own line, so the line offset column takes at least a byte per snapshot.
+    if (count > bytes.size())
+        return false;
+    ard.snapshots.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        AgentSnapshot s;
+        s.time = TimeFromColumnValue(columns[0].Get(), timeEncoding);
+        size_t c = 1;
+        VisitSnapshotFields(s, [&](auto& field) { FromColumnValue(columns[c++].Get(), field); });
+        ard.snapshots.push_back(s, columns[c].Get());
+    }
+
+    for (const auto& column : columns)
+    {
+        if (column.Failed())
+            return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// StoC blocks
+// ---------------------------------------------------------------------------
+
+template <typename Event>
+size_t NumEventFields()
+{
+    return CountFields<Event>([](auto& e, auto&& f) { VisitEventFields(e, f); });
+}
+
+template <typename Event>
+std::string EncodeEventBlock(const std::vector<Event>& events)
+{
+    uint8_t timeEncoding = kTimeMillis;
+    for (const auto& ev : events)
+    {
+        if (!IsWholeMillis(ev.time))
+        {
+            timeEncoding = kTimeFloatBits;
+            break;
+        }
+    }
+
+    // Event types and messages only take a handful of values; each one is stored once and the columns
+    // hold indices into that list.
+    std::vector<std::string_view> strings;
+    std::unordered_map<std::string_view, uint32_t> stringIds;
+
+    std::vector<ColumnEncoder> columns(NumEventFields<Event>() + 1);
+    std::string rawText;
+    for (const auto& ev : events)
+    {
+        columns[0].Put(TimeToColumnValue(ev.time, timeEncoding));
+        size_t c = 1;
+        VisitEventFields(ev, [&](const auto& field)
+        {
+            if constexpr (std::is_same_v<std::decay_t<decltype(field)>, std::string>)
+            {
+                auto [it, added] = stringIds.try_emplace(field, static_cast<uint32_t>(strings.size()));
+                if (added)
+                    strings.push_back(field);
+                columns[c++].Put(it->second);
+            }
+            else
+            {
+                columns[c++].Put(ToColumnValue(field));
+            }
+        });
+        rawText.append(ev.raw_line);
+        rawText.push_back('\n');
+    }
+
+    ByteWriter out;
+    out.PutU8(timeEncoding);
+    out.PutVarint(strings.size());
+    for (const auto& s : strings)
+        out.PutString(s);
+    out.PutVarint(columns.size());
+    for (auto& column : columns)
+        out.PutString(column.Finish());
+
+    // The raw lines are shown as they are in the StoC window, so they are kept, zlib compressed.
+    out.PutVarint(rawText.size());
+    int compressedSize = 0;
+    unsigned char* compressed = nullptr;
+    if (!rawText.empty() && rawText.size() <= INT_MAX)
+    {
+        compressed = stbi_zlib_compress(reinterpret_cast<unsigned char*>(rawText.data()),
+                                        static_cast<int>(rawText.size()), &compressedSize, kZlibQuality);
+    }
+    if (compressed)
+    {
+        out.PutU8(1);
+        out.PutString(std::string_view(reinterpret_cast<const char*>(compressed), compressedSize));
+        free(compressed);
+    }
+    else
+    {
+        out.PutU8(0);
+        out.PutString(rawText);
+    }
+    return std::move(out.Bytes());
+}
+
+template <typename Event>
+bool DecodeEventBlock(std::string_view bytes, uint32_t count, std::vector<Event>& events)
+{
+    ByteReader in(bytes);
+    const uint8_t timeEncoding = in.GetU8();
+
+    std::vector<std::string> strings(static_cast<size_t>(std::min<uint64_t>(in.GetVarint(), bytes.size())));
+    for (auto& s : strings)
+        s = in.GetString();
+
+    const size_t numColumns = NumEventFields<Event>() + 1;
+    if (in.GetVarint() != numColumns)
+        return false;
+    std::vector<ColumnDecoder> columns;
+    columns.reserve(numColumns);
+    for (size_t i = 0; i < numColumns; i++)
+        columns.emplace_back(in.GetString());
+
+    const uint64_t rawSize = in.GetVarint();
+    const bool compressed = in.GetU8() != 0;
+    const std::string_view stored = in.GetString();
+    if (in.Failed())
+        return false;
+
+    std::string rawText;
+    if (compressed)
+    {
+        // A zlib stream: a 2 byte header, the DEFLATE data and a 4 byte checksum.
+        if (stored.size() < 6 || rawSize > stored.size() * 1032ull)
+            return false;
+        if (!InflateRaw(reinterpret_cast<const uint8_t*>(stored.data()) + 2, stored.size() - 6, rawText,
+                        static_cast<size_t>(rawSize)))
+            return false;
+
+        const uint8_t* trailer = reinterpret_cast<const uint8_t*>(stored.data() + stored.size() - 4);
+        const uint32_t adler = uint32_t(trailer[0]) << 24 | uint32_t(trailer[1]) << 16 | uint32_t(trailer[2]) << 8 | trailer[3];
+        if (Adler32(rawText) != adler)
+            return false;
+    }
+    else
+    {
+        rawText = stored;
+    }
+    if (rawText.size() != rawSize || count > rawSize)
+        return false;
+
+    bool valid = true;
+    std::string_view rawLines = rawText;
+    events.reserve(count);
+    for (uint32_t i = 0; i < count && valid; i++)
+    {
+        Event ev;
+        ev.time = TimeFromColumnValue(columns[0].Get(), timeEncoding);
+        size_t c = 1;
+        VisitEventFields(ev, [&](auto& field)
+        {
+            const uint32_t v = columns[c++].Get();
+            if constexpr (std::is_same_v<std::decay_t<decltype(field)>, std::string>)
+            {
+                if (v < strings.size())
+                    field = strings[v];
+                else
+                    valid = false;
+            }
+            else
+            {
+                FromColumnValue(v, field);
+            }
+        });
+
+        const size_t lineEnd = rawLines.find('\n');
+        if (lineEnd == std::string_view::npos)
+            return false;
+        ev.raw_line = rawLines.substr(0, lineEnd);
+        rawLines.remove_prefix(lineEnd + 1);
+
+        events.push_back(std::move(ev));
+    }
+
+    for (const auto& column : columns)
+    {
+        if (column.Failed())
+            return false;
+    }
+    return valid;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+bool LoadAgentCache(const std::filesystem::path& matchFolder,
+                    std::unordered_map<int, AgentReplayData>& agents)
+{
+    const auto agentsDir = matchFolder / "Agents";
+    MappedCacheFile file;
+    std::vector<CacheBlock> blocks;
+    if (!OpenCacheFile(file, matchFolder / kAgentCacheName, "AGNT", SourceStamp(agentsDir), blocks))
+        return false;
+
+    std::unordered_map<int, AgentReplayData> loaded;
+    loaded.reserve(blocks.size());
+    for (const auto& block : blocks)
+    {
+        AgentReplayData ard;
+        ard.agent_id = block.entry.id;
+        if (!DecodeAgentBlock(block.bytes, block.entry.count, agentsDir, ard))
+            return false;
+        loaded[ard.agent_id] = std::move(ard);
+    }
+
+    agents = std::move(loaded);
+    return true;
+}
+
+void WriteAgentCache(const std::filesystem::path& matchFolder,
+                     const std::unordered_map<int, AgentReplayData>& agents)
+{
+    const uint64_t sourceStamp = SourceStamp(matchFolder / "Agents");
+    if (sourceStamp == 0)
+        return;
+
+    // In agent order, so the same match always gives the same file.
+    std::vector<const AgentReplayData*> sorted;
+    sorted.reserve(agents.size());
+    for (const auto& [id, ard] : agents)
+        sorted.push_back(&ard);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const AgentReplayData* a, const AgentReplayData* b) { return a->agent_id < b->agent_id; });
+
+    std::vector<CacheBlockEntry> entries;
+    std::vector<std::string> blocks;
+    for (const AgentReplayData* ard : sorted)
+    {
+        entries.push_back({ ard->agent_id, static_cast<uint32_t>(ard->snapshots.size()), 0, 0 });
+        blocks.push_back(EncodeAgentBlock(*ard));
+    }
+
+    WriteCacheFile(matchFolder / kAgentCacheName, "AGNT", sourceStamp, entries, blocks);
+}
+
+bool LoadStoCCache(const std::filesystem::path& matchFolder, StoCData& data)
+{
+    MappedCacheFile file;
+    std::vector<CacheBlock> blocks;
+    if (!OpenCacheFile(file, matchFolder / kStoCCacheName, "STOC", SourceStamp(matchFolder / "StoC"), blocks))
+        return false;
+
+    StoCData loaded;
+    bool valid = true;
+    for (const auto& block : blocks)
+    {
+        ForEachStoCCategory(loaded, [&](StoCCategory category, auto& events)
+        {
+            if (static_cast<int>(category) == block.entry.id)
+                valid = valid && DecodeEventBlock(block.bytes, block.entry.count, events);
+        });
+    }
+    if (!valid)
+        return false;
+
+    data = std::move(loaded);
+    return true;
+}
+
+void WriteStoCCache(const std::filesystem::path& matchFolder, const StoCData& data)
+{
+    const uint64_t sourceStamp = SourceStamp(matchFolder / "StoC");
+    if (sourceStamp == 0)
+        return;
+
+    std::vector<CacheBlockEntry> entries;
+    std::vector<std::string> blocks;
+    ForEachStoCCategory(data, [&](StoCCategory category, const auto& events)
+    {
+        entries.push_back({ static_cast<int32_t>(category), static_cast<uint32_t>(events.size()), 0, 0 });
+        blocks.push_back(EncodeEventBlock(events));
+    });
+
+    WriteCacheFile(matchFolder / kStoCCacheName, "STOC", sourceStamp, entries, blocks);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "ReplayMapData.h"
+#include <filesystem>
+#include <unordered_map>
+
+// Binary cache of a parsed match, so the text exports only have to be parsed the first time a match is
+// opened. The agents and the StoC events each get a file in the match folder (agents.gwrc, stoc.gwrc):
+//
+//   header    "GWRC", version, content tag, block count, source stamp, file size    (32 bytes)
+//   index     one entry per block: id, item count, offset, size, CRC-32              (32 bytes each)
+//   blocks    one per agent or StoC category
+//
+// Inside a block every field is a column of its own. Each value is stored as the difference to the
+// previous one, zigzag and varint coded, and runs of unchanged values collapse into a single varint, so
+// fields that rarely change cost next to nothing. The source stamp is a hash of the names, sizes and
+// write times of the exported files; a cache whose stamp doesn't match, or with a block that fails its
+// CRC, is ignored and the match is parsed again.
+// The files are read through a memory mapping and decoded straight from it.
+
+// Fill agents from matchFolder/agents.gwrc. Returns false if there is no usable cache.
+bool LoadAgentCache(const std::filesystem::path& matchFolder,
+                    std::unordered_map<int, AgentReplayData>& agents);
+
+// Writes matchFolder/agents.gwrc for agents parsed from matchFolder/Agents/. Failures are ignored;
+// the match is just parsed again next time.
+void WriteAgentCache(const std::filesystem::path& matchFolder,
+                     const std::unordered_map<int, AgentReplayData>& agents);
+
+bool LoadStoCCache(const std::filesystem::path& matchFolder, StoCData& data);
+void WriteStoCCache(const std::filesystem::path& matchFolder, const StoCData& data);
@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <string>
 #include <filesystem>
@@ -318,8 +320,283 @@ struct AgentSnapshot
     uint32_t item_id = 0;
     uint32_t item_extra_type = 0;
     uint32_t gadget_extra_type = 0;
+};
 
-    std::string raw_line;
+// The boolean fields of AgentSnapshot, as bit indices into AgentSnapshotTimeline's flag column.
+enum class SnapshotFlag : uint8_t
+{
+    Alive, Dead, Knocked,
+    Condition, DeepWound, Bleeding, Crippled, Blind, Poison,
+    Hex, DegenHex, Enchantment, WeaponSpell,
+    Holding, Casting,
+};
+
+// The AgentSnapshot fields nobody reads per frame, ordered by size so the record has no padding.
+struct AgentSnapshotCold
+{
+    float rotation;
+    float health_pct;
+    float move_x, move_y;
+    float weapon_attack_speed;
+    float attack_speed_modifier;
+    float hp_pips;
+    float animation_speed;
+    float animation_type;
+    uint32_t weapon_id;
+    uint32_t model_id;
+    uint32_t gadget_id;
+    uint32_t max_hp;
+    uint32_t skill_id;
+    uint32_t model_state;
+    uint32_t animation_code;
+    uint32_t animation_id;
+    uint32_t in_spirit_range;
+    uint32_t item_id;
+    uint32_t item_extra_type;
+    uint32_t gadget_extra_type;
+    uint16_t weapon_item_id;
+    uint16_t offhand_item_id;
+    uint16_t visual_effects;
+    uint16_t weapon_type;
+    uint16_t agent_model_type;
+    uint8_t  weapon_item_type;
+    uint8_t  offhand_item_type;
+    uint8_t  team_id;
+    uint8_t  dagger_status;
+};
+
+// An agent's snapshots stored column by column. Time and position, which interpolation reads every
+// frame, are separate contiguous arrays, the booleans are packed into one bitmask per snapshot and the
+// remaining fields sit in a cold array. The raw lines aren't kept, only where each one starts in the
+// agent's (decompressed) file. operator[] reassembles a full AgentSnapshot for code that wants the
+// whole record.
+//
+// findIndex is called for every agent several times a frame. It first tries the snapshot it returned
+// last time and the few after it, which is all forward playback ever needs. A seek falls back to a
+// per-second bucket index that narrows the search to the snapshots of one bucket.
+class AgentSnapshotTimeline
+{
+public:
+    size_t size() const { return m_time.size(); }
+    bool empty() const { return m_time.empty(); }
+
+    void reserve(size_t count)
+    {
+        m_time.reserve(count);
+        m_x.reserve(count);
+        m_y.reserve(count);
+        m_z.reserve(count);
+        m_flags.reserve(count);
+        m_cold.reserve(count);
+        m_lineOffsets.reserve(count);
+    }
+
+    void shrink_to_fit()
+    {
+        m_time.shrink_to_fit();
+        m_x.shrink_to_fit();
+        m_y.shrink_to_fit();
+        m_z.shrink_to_fit();
+        m_flags.shrink_to_fit();
+        m_cold.shrink_to_fit();
+        m_lineOffsets.shrink_to_fit();
+        m_bucketFirst.shrink_to_fit();
+    }
+
+    void push_back(const AgentSnapshot& s, uint32_t lineOffset = 0)
+    {
+        if (m_time.empty())
+            m_bucketOrigin = s.time;
+        const uint32_t index = static_cast<uint32_t>(m_time.size());
+        for (size_t b = bucketOf(s.time); m_bucketFirst.size() <= b; )
+            m_bucketFirst.push_back(index);
+
+        m_time.push_back(s.time);
+        m_x.push_back(s.x);
+        m_y.push_back(s.y);
+        m_z.push_back(s.z);
+
+        const bool flags[] = {
+            s.is_alive, s.is_dead, s.is_knocked,
+            s.has_condition, s.has_deep_wound, s.has_bleeding, s.has_crippled, s.has_blind, s.has_poison,
+            s.has_hex, s.has_degen_hex, s.has_enchantment, s.has_weapon_spell,
+            s.is_holding, s.is_casting,
+        };
+        uint16_t bits = 0;
+        for (int i = 0; i < static_cast<int>(std::size(flags)); i++)
+            bits |= static_cast<uint16_t>(flags[i]) << i;
+        m_flags.push_back(bits);
+
+        AgentSnapshotCold c;
+        c.rotation              = s.rotation;
+        c.health_pct            = s.health_pct;
+        c.move_x                = s.move_x;
+        c.move_y                = s.move_y;
+        c.weapon_attack_speed   = s.weapon_attack_speed;
+        c.attack_speed_modifier = s.attack_speed_modifier;
+        c.hp_pips               = s.hp_pips;
+        c.animation_speed       = s.animation_speed;
+        c.animation_type        = s.animation_type;
+        c.weapon_id             = s.weapon_id;
+        c.model_id              = s.model_id;
+        c.gadget_id             = s.gadget_id;
+        c.max_hp                = s.max_hp;
+        c.skill_id              = s.skill_id;
+        c.model_state           = s.model_state;
+        c.animation_code        = s.animation_code;
+        c.animation_id          = s.animation_id;
+        c.in_spirit_range       = s.in_spirit_range;
+        c.item_id               = s.item_id;
+        c.item_extra_type       = s.item_extra_type;
+        c.gadget_extra_type     = s.gadget_extra_type;
+        c.weapon_item_id        = s.weapon_item_id;
+        c.offhand_item_id       = s.offhand_item_id;
+        c.visual_effects        = s.visual_effects;
+        c.weapon_type           = s.weapon_type;
+        c.agent_model_type      = s.agent_model_type;
+        c.weapon_item_type      = s.weapon_item_type;
+        c.offhand_item_type     = s.offhand_item_type;
+        c.team_id               = s.team_id;
+        c.dagger_status         = s.dagger_status;
+        m_cold.push_back(c);
+        m_lineOffsets.push_back(lineOffset);
+    }
+
+    AgentSnapshot operator[](size_t i) const
+    {
+        AgentSnapshot s;
+        s.time = m_time[i];
+        s.x = m_x[i];
+        s.y = m_y[i];
+        s.z = m_z[i];
+
+        s.is_alive         = hasFlag(i, SnapshotFlag::Alive);
+        s.is_dead          = hasFlag(i, SnapshotFlag::Dead);
+        s.is_knocked       = hasFlag(i, SnapshotFlag::Knocked);
+        s.has_condition    = hasFlag(i, SnapshotFlag::Condition);
+        s.has_deep_wound   = hasFlag(i, SnapshotFlag::DeepWound);
+        s.has_bleeding     = hasFlag(i, SnapshotFlag::Bleeding);
+        s.has_crippled     = hasFlag(i, SnapshotFlag::Crippled);
+        s.has_blind        = hasFlag(i, SnapshotFlag::Blind);
+        s.has_poison       = hasFlag(i, SnapshotFlag::Poison);
+        s.has_hex          = hasFlag(i, SnapshotFlag::Hex);
+        s.has_degen_hex    = hasFlag(i, SnapshotFlag::DegenHex);
+        s.has_enchantment  = hasFlag(i, SnapshotFlag::Enchantment);
+        s.has_weapon_spell = hasFlag(i, SnapshotFlag::WeaponSpell);
+        s.is_holding       = hasFlag(i, SnapshotFlag::Holding);
+        s.is_casting       = hasFlag(i, SnapshotFlag::Casting);
+
+        const AgentSnapshotCold& c = m_cold[i];
+        s.rotation              = c.rotation;
+        s.health_pct            = c.health_pct;
+        s.move_x                = c.move_x;
+        s.move_y                = c.move_y;
+        s.weapon_attack_speed   = c.weapon_attack_speed;
+        s.attack_speed_modifier = c.attack_speed_modifier;
+        s.hp_pips               = c.hp_pips;
+        s.animation_speed       = c.animation_speed;
+        s.animation_type        = c.animation_type;
+        s.weapon_id             = c.weapon_id;
+        s.model_id              = c.model_id;
+        s.gadget_id             = c.gadget_id;
+        s.max_hp                = c.max_hp;
+        s.skill_id              = c.skill_id;
+        s.model_state           = c.model_state;
+        s.animation_code        = c.animation_code;
+        s.animation_id          = c.animation_id;
+        s.in_spirit_range       = c.in_spirit_range;
+        s.item_id               = c.item_id;
+        s.item_extra_type       = c.item_extra_type;
+        s.gadget_extra_type     = c.gadget_extra_type;
+        s.weapon_item_id        = c.weapon_item_id;
+        s.offhand_item_id       = c.offhand_item_id;
+        s.visual_effects        = c.visual_effects;
+        s.weapon_type           = c.weapon_type;
+        s.agent_model_type      = c.agent_model_type;
+        s.weapon_item_type      = c.weapon_item_type;
+        s.offhand_item_type     = c.offhand_item_type;
+        s.team_id               = c.team_id;
+        s.dagger_status         = c.dagger_status;
+        return s;
+    }
+
+    AgentSnapshot front() const { return (*this)[0]; }
+    AgentSnapshot back() const { return (*this)[size() - 1]; }
+
+    float time(size_t i) const { return m_time[i]; }
+    float x(size_t i) const { return m_x[i]; }
+    float y(size_t i) const { return m_y[i]; }
+    float z(size_t i) const { return m_z[i]; }
+    float startTime() const { return m_time.front(); }
+    float endTime() const { return m_time.back(); }
+    const std::vector<float>& times() const { return m_time; }
+
+    bool hasFlag(size_t i, SnapshotFlag flag) const
+    {
+        return (m_flags[i] >> static_cast<int>(flag)) & 1;
+    }
+
+    const AgentSnapshotCold& cold(size_t i) const { return m_cold[i]; }
+
+    // Where the snapshot's line starts in the text of AgentReplayData::sourcePath.
+    uint32_t lineOffset(size_t i) const { return m_lineOffsets[i]; }
+
+    // Index of the last snapshot with time <= t, or 0 if t is before the first one. Only reads the
+    // time column.
+    int findIndex(float t) const
+    {
+        if (m_time.empty())
+            return 0;
+
+        const size_t count = m_time.size();
+        size_t i = m_cursor < count ? m_cursor : 0;
+        if (m_time[i] <= t)
+        {
+            for (int step = 0; step < kCursorSteps; step++)
+            {
+                if (i + 1 == count || m_time[i + 1] > t)
+                {
+                    m_cursor = static_cast<uint32_t>(i);
+                    return static_cast<int>(i);
+                }
+                i++;
+            }
+        }
+
+        // Snapshot indices [first, last) are the ones in t's bucket; everything before is earlier than t.
+        const size_t b = std::min(bucketOf(t), m_bucketFirst.size() - 1);
+        const size_t first = m_bucketFirst[b];
+        const size_t last = b + 1 < m_bucketFirst.size() ? m_bucketFirst[b + 1] : count;
+        const auto it = std::upper_bound(m_time.begin() + first, m_time.begin() + last, t);
+        const size_t found = it == m_time.begin() ? 0 : static_cast<size_t>(it - m_time.begin()) - 1;
+        m_cursor = static_cast<uint32_t>(found);
+        return static_cast<int>(found);
+    }
+
+private:
+    static constexpr float kBucketSeconds = 1.f;
+    static constexpr size_t kMaxBuckets = 1 << 20;
+    // How far past the last result findIndex walks before it uses the bucket index.
+    static constexpr int kCursorSteps = 4;
+
+    size_t bucketOf(float t) const
+    {
+        const float b = (t - m_bucketOrigin) / kBucketSeconds;
+        if (!(b > 0.f)) return 0;
+        return b >= static_cast<float>(kMaxBuckets - 1) ? kMaxBuckets - 1 : static_cast<size_t>(b);
+    }
+
+    std::vector<float>    m_time;
+    std::vector<float>    m_x, m_y, m_z;
+    std::vector<uint16_t> m_flags;
+    std::vector<AgentSnapshotCold> m_cold;
+    std::vector<uint32_t> m_lineOffsets;
+
+    // m_bucketFirst[b] is the first snapshot at or after m_bucketOrigin + b * kBucketSeconds.
+    float m_bucketOrigin = 0.f;
+    std::vector<uint32_t> m_bucketFirst;
+    // Last findIndex result. Only the render thread looks snapshots up.
+    mutable uint32_t m_cursor = 0;
 };
 
 // MOVE_TO_POINT target extracted from StoC agent movement events.
@@ -340,10 +617,59 @@ struct CastInterval
     int   skillId = 0;
 };
 
+// An agent's cast intervals flattened into sorted, non-overlapping ones, so the interval holding a
+// time is found with one binary search. Where casts overlap (a skill and an attack skill, say) the one
+// that started first wins, as it did when the intervals were scanned in start order.
+class CastIntervalSet
+{
+public:
+    void assign(std::vector<CastInterval> intervals)
+    {
+        std::sort(intervals.begin(), intervals.end(),
+                  [](const CastInterval& a, const CastInterval& b) { return a.start < b.start; });
+
+        m_intervals.clear();
+        m_intervals.reserve(intervals.size());
+        for (CastInterval ci : intervals)
+        {
+            if (!(ci.end >= ci.start)) continue;
+            if (!m_intervals.empty())
+            {
+                // Everything the earlier casts cover from ci.start on ends at the last interval's end.
+                const float coveredEnd = m_intervals.back().end;
+                if (ci.end <= coveredEnd) continue;
+                if (ci.start <= coveredEnd)
+                    ci.start = std::nextafter(coveredEnd, ci.end);
+            }
+            m_intervals.push_back(ci);
+        }
+        m_intervals.shrink_to_fit();
+    }
+
+    size_t size() const { return m_intervals.size(); }
+    bool empty() const { return m_intervals.empty(); }
+    const std::vector<CastInterval>& intervals() const { return m_intervals; }
+
+    // The interval with start <= t <= end, or nullptr.
+    const CastInterval* find(float t) const
+    {
+        auto it = std::upper_bound(m_intervals.begin(), m_intervals.end(), t,
+                                   [](float time, const CastInterval& ci) { return time < ci.start; });
+        if (it == m_intervals.begin()) return nullptr;
+        --it;
+        return t <= it->end ? &*it : nullptr;
+    }
+
+private:
+    std::vector<CastInterval> m_intervals;
+};
+
 struct AgentReplayData
 {
     int agent_id = 0;
-    std::vector<AgentSnapshot> snapshots;
+    AgentSnapshotTimeline snapshots;
+    // The file the snapshots were parsed from, read again when the raw lines are shown
+    std::filesystem::path sourcePath;
 
     AgentType type = AgentType::Unknown;
     std::string categoryName;
@@ -366,20 +692,17 @@ struct AgentReplayData
     bool  overlapIsNewest     = false;  // true if this is the newest of its group
 
     // Per-agent casting intervals (built from StoC skill events)
-    std::vector<CastInterval> castHistory;
+    CastIntervalSet castHistory;
 
     bool isCastingAtTime(float t) const
     {
-        for (auto& ci : castHistory)
-            if (t >= ci.start && t <= ci.end) return true;
-        return false;
+        return castHistory.find(t) != nullptr;
     }
 
     int castingSkillAtTime(float t) const
     {
-        for (auto& ci : castHistory)
-            if (t >= ci.start && t <= ci.end) return ci.skillId;
-        return 0;
+        const CastInterval* ci = castHistory.find(t);
+        return ci ? ci->skillId : 0;
     }
 
     // Returns true if the agent is dead at time t, based on the nearest
@@ -388,15 +711,7 @@ struct AgentReplayData
     bool isDeadAtTime(float t) const
     {
         if (snapshots.empty()) return false;
-        if (t <= snapshots.front().time) return snapshots.front().is_dead;
-        if (t >= snapshots.back().time)  return snapshots.back().is_dead;
-        // Binary search for last snapshot with time <= t
-        int lo = 0, hi = static_cast<int>(snapshots.size()) - 1;
-        while (lo < hi) {
-            int mid = lo + (hi - lo + 1) / 2;
-            if (snapshots[mid].time <= t) lo = mid; else hi = mid - 1;
-        }
-        return snapshots[lo].is_dead;
+        return snapshots.hasFlag(snapshots.findIndex(t), SnapshotFlag::Dead);
     }
 };
 
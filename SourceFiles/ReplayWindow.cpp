@@ -2,6 +2,7 @@
 #include "ReplayWindow.h"
 #include "AgentSnapshotParser.h"
 #include "StoCParser.h"
+#include "GzipInflate.h"
 #include "SkillDatabase.h"
 #include "DXMathHelpers.h"
 #include <d3dcompiler.h>
@@ -154,6 +155,7 @@ ReplayWindow* ReplayWindow::Create(HINSTANCE hInstance, const MatchMeta& match,
 
 ReplayWindow::~ReplayWindow()
 {
+    StopPropDecodeJob();
     ShutdownImGui();
     if (m_hwnd)
         SetWindowLongPtr(m_hwnd, GWLP_USERDATA, 0);
@@ -401,7 +403,7 @@ void ReplayWindow::StepLoadInit()
     auto it = m_hashIndex->find(static_cast<int>(datFileHash));
     int mftIndex = it->second.at(0);
 
-    m_mapFile = m_datManager->parse_ffna_map_file(mftIndex);
+    m_mapFile = m_datManager->parse_ffna_map_file_view(mftIndex);
 
     if (m_mapFile.terrain_chunk.terrain_heightmap.empty() ||
         m_mapFile.terrain_chunk.terrain_heightmap.size() !=
@@ -544,10 +546,9 @@ void ReplayWindow::StepLoadInit()
                 return map_renderer->GetTextureManager()->GetTexture(texId);
         }
         else {
-            DatTexture dt = m_datManager->parse_ffna_texture_file(ti);
+            DatTexture dt = m_datManager->parse_ffna_texture_file(ti, false);
             if (dt.width > 0 && dt.height > 0) {
-                auto hr = map_renderer->GetTextureManager()->CreateTextureFromRGBA(
-                    dt.width, dt.height, dt.rgba_data.data(), &texId, decoded);
+                auto hr = map_renderer->GetTextureManager()->CreateTextureFromDatTexture(dt, &texId, decoded);
                 if (SUCCEEDED(hr) && texId >= 0)
                     return map_renderer->GetTextureManager()->GetTexture(texId);
             }
@@ -715,58 +716,203 @@ void ReplayWindow::StepLoadInit()
     m_terrain = std::move(terrain);
 
     // Prepare for prop loading phases
-    m_totalPropFilenames = static_cast<int>(m_mapFile.prop_filenames_chunk.array.size()
-        + m_mapFile.more_filnames_chunk.array.size());
     m_totalPropInstances = static_cast<int>(m_mapFile.props_info_chunk.prop_array.props_info.size());
-    m_propModelLoadIndex = 0;
     m_propPlaceIndex = 0;
-    m_propModelFiles.clear();
-    m_propModelFiles.reserve(m_totalPropFilenames);
+    StartPropDecodeJob();
 
     m_loadProgress = 0.05f;
     m_loadingPhase = LoadingPhase::PropModels;
 }
 
 // ---------------------------------------------------------------------------
-// Loading phase: parse prop model files from DAT (batched)
+// Loading phase: decode prop models, AMATs and textures on a worker pool
 // ---------------------------------------------------------------------------
 
-void ReplayWindow::StepLoadPropModels()
+// Calls fn(i) for every i in [0, count) from one thread per core. Stops handing out work once
+// cancelled is set.
+template <typename Fn>
+static void ParallelFor(int count, const std::atomic<bool>& cancelled, Fn&& fn)
+{
+    const int numThreads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, std::max(count, 1));
+    std::atomic<int> next{ 0 };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&]()
+        {
+            for (int i = next.fetch_add(1); i < count && !cancelled.load(); i = next.fetch_add(1))
+            {
+                try
+                {
+                    fn(i);
+                }
+                catch (...)
+                {
+                    // A broken file just doesn't get placed.
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void ReplayWindow::StartPropDecodeJob()
 {
+    StopPropDecodeJob();
+
+    m_preparedPropModels.clear();
+    m_preparedPropTextures.clear();
+
+    auto job = std::make_unique<PropDecodeJob>();
+
+    // PropInfo::filename_index counts only the filenames that resolve to a model file.
     const auto& propFN = m_mapFile.prop_filenames_chunk.array;
     const auto& moreFN = m_mapFile.more_filnames_chunk.array;
-    int total = m_totalPropFilenames;
-    int end = std::min(m_propModelLoadIndex + kPropModelBatchSize, total);
-
-    for (int i = m_propModelLoadIndex; i < end; i++)
+    const auto& mft = m_datManager->get_MFT();
+    for (size_t i = 0; i < propFN.size() + moreFN.size(); i++)
     {
-        const auto& fn = (i < (int)propFN.size())
-            ? propFN[i]
-            : moreFN[i - (int)propFN.size()];
+        const auto& fn = i < propFN.size() ? propFN[i] : moreFN[i - propFN.size()];
+        auto mit = m_hashIndex->find(decode_filename(fn.filename.id0, fn.filename.id1));
+        if (mit != m_hashIndex->end() && mft[mit->second.at(0)].type == FFNA_Type2)
+            job->modelMftIndices.push_back(mit->second.at(0));
+    }
+    job->models.resize(job->modelMftIndices.size());
 
-        auto decoded = decode_filename(fn.filename.id0, fn.filename.id1);
-        auto mit = m_hashIndex->find(decoded);
-        if (mit != m_hashIndex->end()) {
-            auto type = m_datManager->get_MFT()[mit->second.at(0)].type;
-            if (type == FFNA_Type2)
-                m_propModelFiles.emplace_back(m_datManager->parse_ffna_model_file(mit->second.at(0)));
+    // Only decode models that some prop instance places.
+    std::vector<int> usedModels;
+    std::vector<bool> isUsed(job->models.size(), false);
+    for (const auto& prop_info : m_mapFile.props_info_chunk.prop_array.props_info)
+    {
+        if (prop_info.filename_index < isUsed.size() && !isUsed[prop_info.filename_index])
+        {
+            isUsed[prop_info.filename_index] = true;
+            usedModels.push_back(prop_info.filename_index);
         }
     }
+    job->itemsTotal = static_cast<int>(usedModels.size());
 
-    m_propModelLoadIndex = end;
+    m_propDecodeJob = std::move(job);
+    m_propDecodeThread = std::thread([job = m_propDecodeJob.get(), datManager = m_datManager, hashIndex = m_hashIndex,
+                                      usedModels = std::move(usedModels)]()
+    {
+        ParallelFor(static_cast<int>(usedModels.size()), job->cancelled, [&](int n)
+        {
+            const int modelIndex = usedModels[n];
+            auto& prepared = job->models[modelIndex];
+            auto modelFile = datManager->parse_ffna_model_file_lazy(job->modelMftIndices[modelIndex]);
 
+            const auto& geom = modelFile.get_geometry_chunk();
+            prepared.parsed_correctly = modelFile.parsed_correctly;
+            if (prepared.parsed_correctly)
+            {
+                const auto& amatFilenames = modelFile.get_AMAT_filenames_chunk().texture_filenames;
+                for (size_t j = 0; j < geom.models.size(); j++)
+                {
+                    AMAT_file amat;
+                    if (!amatFilenames.empty()) {
+                        int subIdx = geom.models[j].unknown;
+                        if (!geom.tex_and_vertex_shader_struct.uts0.empty())
+                            subIdx %= (int)geom.tex_and_vertex_shader_struct.uts0.size();
+                        const auto& uts1 = geom.uts1[subIdx % geom.uts1.size()];
+                        int amatIdx = ((uts1.some_flags0 >> 8) & 0xFF) % (int)amatFilenames.size();
+                        auto amatFn = amatFilenames[amatIdx];
+                        auto amatHash = decode_filename(amatFn.id0, amatFn.id1);
+                        auto aIt = hashIndex->find(amatHash);
+                        if (aIt != hashIndex->end())
+                            amat = datManager->parse_amat_file(aIt->second.at(0));
+                    }
+                    Mesh mesh = modelFile.GetMesh((int)j, amat);
+                    if (mesh.indices.size() % 3 == 0)
+                        prepared.meshes.push_back(std::move(mesh));
+                }
+
+                // The lazy model file only sets textures_parsed_correctly once the texture filenames chunk
+                // has been decoded.
+                const auto& textureFilenames = modelFile.get_texture_filenames_chunk().texture_filenames;
+                prepared.textures_parsed_correctly = modelFile.textures_parsed_correctly;
+                if (prepared.textures_parsed_correctly) {
+                    for (const auto& tf : textureFilenames) {
+                        auto decoded = decode_filename(tf.id0, tf.id1);
+                        if (hashIndex->contains(decoded))
+                            prepared.textureHashes.push_back(decoded);
+                    }
+                }
+
+                prepared.pixelShaderType = geom.unknown_tex_stuff1.empty() ? PixelShaderType::OldModel : PixelShaderType::NewModel;
+            }
+
+            job->itemsDone.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        // Textures are shared between models, decode each one once.
+        std::vector<int> textureHashes;
+        std::unordered_set<int> seenTextures;
+        for (const auto& prepared : job->models)
+        {
+            if (prepared.meshes.empty())
+                continue;
+            for (int hash : prepared.textureHashes)
+            {
+                if (seenTextures.insert(hash).second)
+                    textureHashes.push_back(hash);
+            }
+        }
+        job->itemsTotal.fetch_add(static_cast<int>(textureHashes.size()));
+
+        std::vector<DatTexture> textures(textureHashes.size());
+        ParallelFor(static_cast<int>(textureHashes.size()), job->cancelled, [&](int n)
+        {
+            auto mit = hashIndex->find(textureHashes[n]);
+            // Decode here so the upload on the main thread doesn't have to, the cache keeps the blocks.
+            textures[n] = datManager->parse_ffna_texture_file(mit->second.at(0), false);
+            textures[n].decode_pixels();
+            job->itemsDone.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        for (size_t n = 0; n < textureHashes.size(); n++)
+            job->textures.emplace(textureHashes[n], std::move(textures[n]));
+
+        job->finished.store(true);
+    });
+}
+
+void ReplayWindow::StopPropDecodeJob()
+{
+    if (m_propDecodeJob)
+        m_propDecodeJob->cancelled.store(true);
+    if (m_propDecodeThread.joinable())
+        m_propDecodeThread.join();
+    m_propDecodeJob.reset();
+}
+
+void ReplayWindow::StepLoadPropModels()
+{
+    // The decode job runs on its own, the UI thread only reports progress until it is done.
+    const auto* job = m_propDecodeJob.get();
+    if (!job)
+        return;
+
+    const int total = job->itemsTotal.load();
     if (total > 0)
-        m_loadProgress = 0.05f + 0.25f * (static_cast<float>(m_propModelLoadIndex) / total);
+        m_loadProgress = 0.05f + 0.25f * (static_cast<float>(job->itemsDone.load()) / total);
 
-    if (m_propModelLoadIndex >= total)
+    if (job->finished.load())
     {
+        m_propDecodeThread.join();
+        m_preparedPropModels = std::move(m_propDecodeJob->models);
+        m_preparedPropTextures = std::move(m_propDecodeJob->textures);
+        m_propDecodeJob.reset();
+
         m_loadProgress = 0.30f;
         m_loadingPhase = LoadingPhase::PlaceProps;
     }
 }
 
 // ---------------------------------------------------------------------------
-// Loading phase: place prop instances (batched)
+// Loading phase: upload and place prop instances (batched)
 // ---------------------------------------------------------------------------
 
 void ReplayWindow::StepPlaceProps()
@@ -778,52 +924,30 @@ void ReplayWindow::StepPlaceProps()
 
     for (int i = m_propPlaceIndex; i < end; i++)
     {
-        PropInfo prop_info = propsInfo[i];
+        const auto& prop_info = propsInfo[i];
 
-        if (prop_info.filename_index >= m_propModelFiles.size()) continue;
-        auto* modelFilePtr = std::get_if<FFNA_ModelFile>(&m_propModelFiles[prop_info.filename_index]);
-        if (!modelFilePtr || !modelFilePtr->parsed_correctly) continue;
+        if (prop_info.filename_index >= m_preparedPropModels.size()) continue;
+        const auto& prepared = m_preparedPropModels[prop_info.filename_index];
+        if (!prepared.parsed_correctly) continue;
 
-        const auto& geom = modelFilePtr->geometry_chunk;
-        std::vector<Mesh> propMeshes;
-        for (size_t j = 0; j < geom.models.size(); j++)
-        {
-            AMAT_file amat;
-            if (!modelFilePtr->AMAT_filenames_chunk.texture_filenames.empty()) {
-                int subIdx = geom.models[j].unknown;
-                if (!geom.tex_and_vertex_shader_struct.uts0.empty())
-                    subIdx %= (int)geom.tex_and_vertex_shader_struct.uts0.size();
-                const auto& uts1 = geom.uts1[subIdx % geom.uts1.size()];
-                int amatIdx = ((uts1.some_flags0 >> 8) & 0xFF) % (int)modelFilePtr->AMAT_filenames_chunk.texture_filenames.size();
-                auto amatFn = modelFilePtr->AMAT_filenames_chunk.texture_filenames[amatIdx];
-                auto amatHash = decode_filename(amatFn.id0, amatFn.id1);
-                auto aIt = m_hashIndex->find(amatHash);
-                if (aIt != m_hashIndex->end())
-                    amat = m_datManager->parse_amat_file(aIt->second.at(0));
-            }
-            Mesh mesh = modelFilePtr->GetMesh((int)j, amat);
-            if (mesh.indices.size() % 3 == 0)
-                propMeshes.push_back(mesh);
-        }
+        std::vector<Mesh> propMeshes = prepared.meshes;
         if (propMeshes.empty()) continue;
 
-        // Load textures for this model
+        // Upload textures for this model. The decode job already decoded them.
         std::vector<int> textureIds;
-        if (modelFilePtr->textures_parsed_correctly) {
-            for (size_t t = 0; t < modelFilePtr->texture_filenames_chunk.texture_filenames.size(); t++) {
-                auto tf = modelFilePtr->texture_filenames_chunk.texture_filenames[t];
-                auto decoded = decode_filename(tf.id0, tf.id1);
+        if (prepared.textures_parsed_correctly) {
+            for (int decoded : prepared.textureHashes) {
                 int texId = map_renderer->GetTextureManager()->GetTextureIdByHash(decoded);
                 if (texId >= 0) { textureIds.push_back(texId); continue; }
-                auto mit = m_hashIndex->find(decoded);
-                if (mit != m_hashIndex->end()) {
-                    DatTexture dt = m_datManager->parse_ffna_texture_file(mit->second.at(0));
+                auto tit = m_preparedPropTextures.find(decoded);
+                if (tit != m_preparedPropTextures.end()) {
+                    const DatTexture& dt = tit->second;
                     if (dt.width > 0 && dt.height > 0) {
-                        map_renderer->GetTextureManager()->CreateTextureFromRGBA(
-                            dt.width, dt.height, dt.rgba_data.data(), &texId, decoded);
+                        map_renderer->GetTextureManager()->CreateTextureFromDatTexture(dt, &texId, decoded);
                     }
-                    textureIds.push_back(texId);
+                    m_preparedPropTextures.erase(tit);
                 }
+                textureIds.push_back(texId);
             }
         }
 
@@ -870,7 +994,7 @@ void ReplayWindow::StepPlaceProps()
             auto& mesh = propMeshes[j];
             if (mesh.uv_coord_indices.size() == mesh.tex_indices.size() &&
                 mesh.uv_coord_indices.size() < MAX_NUM_TEX_INDICES &&
-                modelFilePtr->textures_parsed_correctly) {
+                prepared.textures_parsed_correctly) {
                 perObjectCBs[j].num_uv_texture_pairs = (uint32_t)mesh.uv_coord_indices.size();
                 for (size_t k = 0; k < mesh.uv_coord_indices.size(); k++) {
                     perObjectCBs[j].uv_indices[k / 4][k % 4] = (uint32_t)mesh.uv_coord_indices[k];
@@ -881,10 +1005,9 @@ void ReplayWindow::StepPlaceProps()
             }
         }
 
-        auto pst = geom.unknown_tex_stuff1.empty() ? PixelShaderType::OldModel : PixelShaderType::NewModel;
-        auto meshIds = map_renderer->AddProp(propMeshes, perObjectCBs, (uint32_t)i, pst);
+        auto meshIds = map_renderer->AddProp(propMeshes, perObjectCBs, (uint32_t)i, prepared.pixelShaderType);
 
-        if (modelFilePtr->textures_parsed_correctly) {
+        if (prepared.textures_parsed_correctly) {
             for (size_t l = 0; l < meshIds.size() && l < perMeshTexIds.size(); l++) {
                 map_renderer->GetMeshManager()->SetTexturesForMesh(
                     meshIds[l], map_renderer->GetTextureManager()->GetTextures(perMeshTexIds[l]), 3);
@@ -982,6 +1105,7 @@ void ReplayWindow::Tick()
     {
         // Track open (unfinished) casts per caster_id
         std::unordered_map<int, CastInterval> openCasts;
+        std::unordered_map<int, std::vector<CastInterval>> finishedCasts;
 
         auto processStart = [&](int casterId, float time, int skillId) {
             openCasts[casterId] = CastInterval{ time, time, skillId };
@@ -990,9 +1114,8 @@ void ReplayWindow::Tick()
             auto oc = openCasts.find(casterId);
             if (oc != openCasts.end()) {
                 oc->second.end = time;
-                auto it = m_replayCtx.agents.find(casterId);
-                if (it != m_replayCtx.agents.end())
-                    it->second.castHistory.push_back(oc->second);
+                if (m_replayCtx.agents.count(casterId))
+                    finishedCasts[casterId].push_back(oc->second);
                 openCasts.erase(oc);
             }
         };
@@ -1013,14 +1136,8 @@ void ReplayWindow::Tick()
                 processEnd(ev.caster_id, ev.time);
         }
 
-        // Sort each agent's cast history by start time
-        for (auto& [id, ard] : m_replayCtx.agents)
-        {
-            std::sort(ard.castHistory.begin(), ard.castHistory.end(),
-                      [](const CastInterval& a, const CastInterval& b) {
-                          return a.start < b.start;
-                      });
-        }
+        for (auto& [id, casts] : finishedCasts)
+            m_replayCtx.agents[id].castHistory.assign(std::move(casts));
         m_castIntervalsBuilt = true;
     }
 
@@ -1324,17 +1441,6 @@ static ImU32 GetAgentTeamColor(uint8_t teamId)
     }
 }
 
-// Binary search: find index of last snapshot with time <= t
-static int FindSnapshotIndex(const std::vector<AgentSnapshot>& snaps, float t)
-{
-    int lo = 0, hi = static_cast<int>(snaps.size()) - 1;
-    while (lo < hi) {
-        int mid = lo + (hi - lo + 1) / 2;
-        if (snaps[mid].time <= t) lo = mid; else hi = mid - 1;
-    }
-    return lo;
-}
-
 // Snap to the nearest snapshot <= t (no blending). Used for flags and
 // when interpolation is disabled.
 static void SnapAgentPosition(const AgentReplayData& ard, float t,
@@ -1342,14 +1448,12 @@ static void SnapAgentPosition(const AgentReplayData& ard, float t,
 {
     const auto& snaps = ard.snapshots;
     if (snaps.empty()) { outX = outY = outZ = 0.f; return; }
-    if (t <= snaps.front().time) {
-        outX = snaps.front().x; outY = snaps.front().y; outZ = snaps.front().z; return;
-    }
-    if (t >= snaps.back().time) {
-        outX = snaps.back().x; outY = snaps.back().y; outZ = snaps.back().z; return;
-    }
-    int idx = FindSnapshotIndex(snaps, t);
-    outX = snaps[idx].x; outY = snaps[idx].y; outZ = snaps[idx].z;
+    int idx = 0;
+    if (t >= snaps.endTime())
+        idx = static_cast<int>(snaps.size()) - 1;
+    else if (t > snaps.startTime())
+        idx = snaps.findIndex(t);
+    outX = snaps.x(idx); outY = snaps.y(idx); outZ = snaps.z(idx);
 }
 
 // Original linear interpolation (legacy behavior).
@@ -1358,23 +1462,19 @@ static void LinearInterpolatePosition(const AgentReplayData& ard, float t,
 {
     const auto& snaps = ard.snapshots;
     if (snaps.empty()) { outX = outY = outZ = 0.f; return; }
-    if (t <= snaps.front().time) {
-        outX = snaps.front().x; outY = snaps.front().y; outZ = snaps.front().z; return;
-    }
-    if (t >= snaps.back().time) {
-        outX = snaps.back().x; outY = snaps.back().y; outZ = snaps.back().z; return;
+    if (t <= snaps.startTime() || t >= snaps.endTime()) {
+        SnapAgentPosition(ard, t, outX, outY, outZ);
+        return;
     }
-    int lo = FindSnapshotIndex(snaps, t);
-    auto& s0 = snaps[lo];
+    int lo = snaps.findIndex(t);
     if (lo + 1 < static_cast<int>(snaps.size())) {
-        auto& s1 = snaps[lo + 1];
-        float dt = s1.time - s0.time;
-        float a = (dt > 0.001f) ? (t - s0.time) / dt : 0.f;
-        outX = s0.x + (s1.x - s0.x) * a;
-        outY = s0.y + (s1.y - s0.y) * a;
-        outZ = s0.z + (s1.z - s0.z) * a;
+        float dt = snaps.time(lo + 1) - snaps.time(lo);
+        float a = (dt > 0.001f) ? (t - snaps.time(lo)) / dt : 0.f;
+        outX = snaps.x(lo) + (snaps.x(lo + 1) - snaps.x(lo)) * a;
+        outY = snaps.y(lo) + (snaps.y(lo + 1) - snaps.y(lo)) * a;
+        outZ = snaps.z(lo) + (snaps.z(lo + 1) - snaps.z(lo)) * a;
     } else {
-        outX = s0.x; outY = s0.y; outZ = s0.z;
+        outX = snaps.x(lo); outY = snaps.y(lo); outZ = snaps.z(lo);
     }
 }
 
@@ -1403,21 +1503,21 @@ static void ImprovedInterpolatePosition(const AgentReplayData& ard, float t,
 {
     const auto& snaps = ard.snapshots;
     if (snaps.empty()) { outX = outY = outZ = 0.f; return; }
-    if (t <= snaps.front().time) {
-        outX = snaps.front().x; outY = snaps.front().y; outZ = snaps.front().z; return;
-    }
-    if (t >= snaps.back().time) {
-        outX = snaps.back().x; outY = snaps.back().y; outZ = snaps.back().z; return;
+    if (t <= snaps.startTime() || t >= snaps.endTime()) {
+        SnapAgentPosition(ard, t, outX, outY, outZ);
+        return;
     }
 
-    int lo = FindSnapshotIndex(snaps, t);
-    auto& prev = snaps[lo];
-
+    int lo = snaps.findIndex(t);
     if (lo + 1 >= static_cast<int>(snaps.size())) {
-        outX = prev.x; outY = prev.y; outZ = prev.z;
+        outX = snaps.x(lo); outY = snaps.y(lo); outZ = snaps.z(lo);
         return;
     }
-    auto& next = snaps[lo + 1];
+
+    // Only the time and position columns are needed here.
+    struct SnapPos { float time, x, y, z; };
+    const SnapPos prev{ snaps.time(lo), snaps.x(lo), snaps.y(lo), snaps.z(lo) };
+    const SnapPos next{ snaps.time(lo + 1), snaps.x(lo + 1), snaps.y(lo + 1), snaps.z(lo + 1) };
     float gap = next.time - prev.time;
     float alpha = (gap > 0.001f) ? (t - prev.time) / gap : 0.f;
 
@@ -1645,15 +1745,15 @@ void ReplayWindow::DrawAgentOverlay()
             ard.overlapThreshold  = 0.f;
 
             if (ard.snapshots.empty()) continue;
-            if (m_debugTimeline < ard.snapshots.front().time ||
-                m_debugTimeline > ard.snapshots.back().time)
+            if (m_debugTimeline < ard.snapshots.startTime() ||
+                m_debugTimeline > ard.snapshots.endTime())
                 continue;
 
             float sx, sy, sz;
             SnapAgentPosition(ard, m_debugTimeline, sx, sy, sz);
 
             uint64_t key = (static_cast<uint64_t>(ard.teamId) << 32) | ard.modelId;
-            groups[key].push_back({ id, ard.snapshots.front().time, sx, sy });
+            groups[key].push_back({ id, ard.snapshots.startTime(), sx, sy });
         }
 
         for (auto& [key, entries] : groups)
@@ -1703,8 +1803,8 @@ void ReplayWindow::DrawAgentOverlay()
         // Flags and Spirits only exist within their snapshot time range
         if (ard.type == AgentType::Flag || ard.type == AgentType::Spirit)
         {
-            if (m_debugTimeline < ard.snapshots.front().time ||
-                m_debugTimeline > ard.snapshots.back().time)
+            if (m_debugTimeline < ard.snapshots.startTime() ||
+                m_debugTimeline > ard.snapshots.endTime())
                 continue;
         }
 
@@ -1997,22 +2097,30 @@ static const char* GetDaggerStatusName(uint8_t ds)
     }
 }
 
-static const AgentSnapshot* FindSnapshotAtTime(const AgentReplayData& ard, float t)
+// Index of the snapshot shown for time t, or -1 if the agent has none.
+static int FindSnapshotAtTime(const AgentReplayData& ard, float t)
 {
-    if (ard.snapshots.empty()) return nullptr;
-    // Binary search for the last snapshot with time <= t
-    int lo = 0, hi = static_cast<int>(ard.snapshots.size()) - 1;
-    if (t < ard.snapshots[0].time) return &ard.snapshots[0];
-    if (t >= ard.snapshots.back().time) return &ard.snapshots.back();
-    while (lo < hi)
-    {
-        int mid = lo + (hi - lo + 1) / 2;
-        if (ard.snapshots[mid].time <= t)
-            lo = mid;
-        else
-            hi = mid - 1;
+    if (ard.snapshots.empty()) return -1;
+    if (t >= ard.snapshots.endTime()) return static_cast<int>(ard.snapshots.size()) - 1;
+    return ard.snapshots.findIndex(t);
+}
+
+std::string_view ReplayWindow::GetRawSnapshotLine(const AgentReplayData& ard, int snapIdx)
+{
+    // Snapshots only remember where their line starts, so read the agent's file again. Parsing used
+    // ReadTextOrGzipFile as well, so the offsets match.
+    if (m_rawTextPath != ard.sourcePath)
+    {
+        m_rawText = ReadTextOrGzipFile(ard.sourcePath);
+        m_rawTextPath = ard.sourcePath;
     }
-    return &ard.snapshots[lo];
+
+    const size_t begin = ard.snapshots.lineOffset(snapIdx);
+    if (begin >= m_rawText.size()) return {};
+    size_t end = m_rawText.find('\n', begin);
+    if (end == std::string::npos) end = m_rawText.size();
+    if (end > begin && m_rawText[end - 1] == '\r') end--;
+    return std::string_view(m_rawText).substr(begin, end - begin);
 }
 
 void ReplayWindow::DrawAgentDataWindow()
@@ -2233,12 +2341,12 @@ void ReplayWindow::DrawAgentDataWindow()
         else if (ard.type == AgentType::Item)
         {
             ImGui::Text("Item: %s  |  item_id: %u", ard.categoryName.c_str(),
-                        ard.snapshots.empty() ? 0u : ard.snapshots[0].item_id);
+                        ard.snapshots.empty() ? 0u : ard.snapshots.cold(0).item_id);
         }
         else if (ard.type == AgentType::Gadget)
         {
             ImGui::Text("Gadget: %s  |  gadget_id: %u", ard.categoryName.c_str(),
-                        ard.snapshots.empty() ? 0u : ard.snapshots[0].gadget_id);
+                        ard.snapshots.empty() ? 0u : ard.snapshots.cold(0).gadget_id);
         }
         else if (!ard.categoryName.empty() && ard.categoryName != "Unknown")
         {
@@ -2248,16 +2356,17 @@ void ReplayWindow::DrawAgentDataWindow()
         {
             ImGui::Text("agent_model_type: 0x%X  |  model_id: %u  |  gadget_id: %u",
                         ard.agentModelType, ard.modelId,
-                        ard.snapshots.empty() ? 0u : ard.snapshots[0].gadget_id);
+                        ard.snapshots.empty() ? 0u : ard.snapshots.cold(0).gadget_id);
         }
 
         ImGui::Separator();
 
         // Snapshot at current timeline
-        const AgentSnapshot* snap = FindSnapshotAtTime(ard, m_debugTimeline);
-        if (snap)
+        const int snapIdx = FindSnapshotAtTime(ard, m_debugTimeline);
+        if (snapIdx >= 0)
         {
-            ImGui::Text("Snapshot at t=%.3fs:", snap->time);
+            const AgentSnapshot snap = ard.snapshots[snapIdx];
+            ImGui::Text("Snapshot at t=%.3fs:", snap.time);
             ImGui::Separator();
 
             if (m_showParsedView)
@@ -2279,92 +2388,93 @@ void ReplayWindow::DrawAgentDataWindow()
                         ImGui::Text(fmt, args...);
                     };
 
-                    Row("Position", "%.3f, %.3f, %.3f", snap->x, snap->y, snap->z);
-                    Row("Rotation", "%.3f rad", snap->rotation);
-                    Row("Alive / Dead", "%s / %s", snap->is_alive ? "Yes" : "No", snap->is_dead ? "Yes" : "No");
-                    Row("Health", "%.1f%%  (max %u)", snap->health_pct * 100.f, snap->max_hp);
-                    Row("HP Pips", "%.3f", snap->hp_pips);
-                    Row("Is Knocked", "%s", snap->is_knocked ? "Yes" : "No");
-                    Row("Model ID", "%u", snap->model_id);
-                    Row("Gadget ID", "%u", snap->gadget_id);
-                    Row("Team", "%s (%u)", GetTeamName(snap->team_id), snap->team_id);
+                    Row("Position", "%.3f, %.3f, %.3f", snap.x, snap.y, snap.z);
+                    Row("Rotation", "%.3f rad", snap.rotation);
+                    Row("Alive / Dead", "%s / %s", snap.is_alive ? "Yes" : "No", snap.is_dead ? "Yes" : "No");
+                    Row("Health", "%.1f%%  (max %u)", snap.health_pct * 100.f, snap.max_hp);
+                    Row("HP Pips", "%.3f", snap.hp_pips);
+                    Row("Is Knocked", "%s", snap.is_knocked ? "Yes" : "No");
+                    Row("Model ID", "%u", snap.model_id);
+                    Row("Gadget ID", "%u", snap.gadget_id);
+                    Row("Team", "%s (%u)", GetTeamName(snap.team_id), snap.team_id);
 
                     ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
                     ImGui::TextColored(ImVec4(1, 0.8f, 0.3f, 1), "--- Conditions ---");
 
-                    Row("Condition", "%s", snap->has_condition ? "Yes" : "No");
-                    Row("Deep Wound", "%s", snap->has_deep_wound ? "Yes" : "No");
-                    Row("Bleeding", "%s", snap->has_bleeding ? "Yes" : "No");
-                    Row("Crippled", "%s", snap->has_crippled ? "Yes" : "No");
-                    Row("Blind", "%s", snap->has_blind ? "Yes" : "No");
-                    Row("Poison", "%s", snap->has_poison ? "Yes" : "No");
+                    Row("Condition", "%s", snap.has_condition ? "Yes" : "No");
+                    Row("Deep Wound", "%s", snap.has_deep_wound ? "Yes" : "No");
+                    Row("Bleeding", "%s", snap.has_bleeding ? "Yes" : "No");
+                    Row("Crippled", "%s", snap.has_crippled ? "Yes" : "No");
+                    Row("Blind", "%s", snap.has_blind ? "Yes" : "No");
+                    Row("Poison", "%s", snap.has_poison ? "Yes" : "No");
 
                     ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
                     ImGui::TextColored(ImVec4(0.6f, 0.3f, 1, 1), "--- Hex/Enchant ---");
 
-                    Row("Hex", "%s", snap->has_hex ? "Yes" : "No");
-                    Row("Degen Hex", "%s", snap->has_degen_hex ? "Yes" : "No");
-                    Row("Enchantment", "%s", snap->has_enchantment ? "Yes" : "No");
-                    Row("Weapon Spell", "%s", snap->has_weapon_spell ? "Yes" : "No");
+                    Row("Hex", "%s", snap.has_hex ? "Yes" : "No");
+                    Row("Degen Hex", "%s", snap.has_degen_hex ? "Yes" : "No");
+                    Row("Enchantment", "%s", snap.has_enchantment ? "Yes" : "No");
+                    Row("Weapon Spell", "%s", snap.has_weapon_spell ? "Yes" : "No");
 
                     ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
                     ImGui::TextColored(ImVec4(0.3f, 1, 0.6f, 1), "--- Casting ---");
 
-                    Row("Is Casting", "%s", snap->is_casting ? "Yes" : "No");
-                    Row("Skill ID", "%u", snap->skill_id);
-                    Row("Is Holding", "%s", snap->is_holding ? "Yes" : "No");
+                    Row("Is Casting", "%s", snap.is_casting ? "Yes" : "No");
+                    Row("Skill ID", "%u", snap.skill_id);
+                    Row("Is Holding", "%s", snap.is_holding ? "Yes" : "No");
 
                     ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
                     ImGui::TextColored(ImVec4(0.8f, 0.8f, 0.8f, 1), "--- Weapon ---");
 
-                    Row("Weapon Type", "%s (%u)", GetWeaponTypeName(snap->weapon_type), snap->weapon_type);
-                    Row("Weapon Item Type", "%u", snap->weapon_item_type);
-                    Row("Offhand Item Type", "%u", snap->offhand_item_type);
-                    Row("Weapon Item ID", "%u", snap->weapon_item_id);
-                    Row("Offhand Item ID", "%u", snap->offhand_item_id);
-                    Row("Weapon Attack Spd", "%.3f", snap->weapon_attack_speed);
-                    Row("Attack Spd Mod", "%.3f", snap->attack_speed_modifier);
-                    Row("Dagger Status", "%s (%u)", GetDaggerStatusName(snap->dagger_status), snap->dagger_status);
+                    Row("Weapon Type", "%s (%u)", GetWeaponTypeName(snap.weapon_type), snap.weapon_type);
+                    Row("Weapon Item Type", "%u", snap.weapon_item_type);
+                    Row("Offhand Item Type", "%u", snap.offhand_item_type);
+                    Row("Weapon Item ID", "%u", snap.weapon_item_id);
+                    Row("Offhand Item ID", "%u", snap.offhand_item_id);
+                    Row("Weapon Attack Spd", "%.3f", snap.weapon_attack_speed);
+                    Row("Attack Spd Mod", "%.3f", snap.attack_speed_modifier);
+                    Row("Dagger Status", "%s (%u)", GetDaggerStatusName(snap.dagger_status), snap.dagger_status);
 
                     ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
                     ImGui::TextColored(ImVec4(0.5f, 0.9f, 1, 1), "--- Movement ---");
 
-                    Row("Velocity", "%.3f, %.3f", snap->move_x, snap->move_y);
-                    float speed = std::sqrtf(snap->move_x * snap->move_x + snap->move_y * snap->move_y);
+                    Row("Velocity", "%.3f, %.3f", snap.move_x, snap.move_y);
+                    float speed = std::sqrtf(snap.move_x * snap.move_x + snap.move_y * snap.move_y);
                     Row("Speed", "%.1f", speed);
 
                     ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
                     ImGui::TextColored(ImVec4(1, 0.6f, 0.8f, 1), "--- Animation ---");
 
-                    Row("Model State", "%u", snap->model_state);
-                    Row("Animation Code", "%u", snap->animation_code);
-                    Row("Animation ID", "%u", snap->animation_id);
-                    Row("Animation Speed", "%.3f", snap->animation_speed);
-                    Row("Animation Type", "%.3f", snap->animation_type);
+                    Row("Model State", "%u", snap.model_state);
+                    Row("Animation Code", "%u", snap.animation_code);
+                    Row("Animation ID", "%u", snap.animation_id);
+                    Row("Animation Speed", "%.3f", snap.animation_speed);
+                    Row("Animation Type", "%.3f", snap.animation_type);
 
                     ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
                     ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1), "--- Other ---");
 
-                    Row("Visual Effects", "%u", snap->visual_effects);
-                    Row("In Spirit Range", "%u", snap->in_spirit_range);
-                    Row("Agent Model Type", "0x%X", snap->agent_model_type);
-                    Row("Item ID", "%u", snap->item_id);
-                    Row("Item Extra Type", "%u", snap->item_extra_type);
-                    Row("Gadget Extra Type", "%u", snap->gadget_extra_type);
+                    Row("Visual Effects", "%u", snap.visual_effects);
+                    Row("In Spirit Range", "%u", snap.in_spirit_range);
+                    Row("Agent Model Type", "0x%X", snap.agent_model_type);
+                    Row("Item ID", "%u", snap.item_id);
+                    Row("Item Extra Type", "%u", snap.item_extra_type);
+                    Row("Gadget Extra Type", "%u", snap.gadget_extra_type);
 
                     ImGui::EndTable();
                 }
             }
             else
             {
-                ImGui::TextWrapped("Raw: %s", snap->raw_line.c_str());
+                const std::string_view raw = GetRawSnapshotLine(ard, snapIdx);
+                ImGui::TextWrapped("Raw: %.*s", static_cast<int>(raw.size()), raw.data());
             }
         }
 
@@ -2393,7 +2503,7 @@ void ReplayWindow::DrawAgentDataWindow()
             {
                 for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
                 {
-                    auto& s = ard.snapshots[row];
+                    const AgentSnapshot s = ard.snapshots[row];
                     ImGui::TableNextRow();
 
                     bool isNearTimeline = std::fabsf(s.time - m_debugTimeline) < 0.15f;
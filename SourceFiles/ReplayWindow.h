@@ -8,12 +8,12 @@
 #include "Terrain.h"
 #include "ReplayMapData.h"
 #include "ReplayLibrary.h"
-#include "FFNA_MapFile.h"
+#include "FFNA_MapFileView.h"
 #include "FFNA_ModelFile.h"
 #include "AMAT_file.h"
 #include <string>
 #include <memory>
-#include <variant>
+#include <thread>
 
 class ReplayWindow final : public DX::IDeviceNotify
 {
@@ -58,12 +58,16 @@ private:
     void StepLoadPropModels();
     void StepPlaceProps();
 
+    void StartPropDecodeJob();
+    void StopPropDecodeJob();
+
     void Update(double elapsedMs);
     void Render();
     void RenderLoadingScreen();
     void Clear();
     void DrawImGuiOverlay();
     void DrawAgentDataWindow();
+    std::string_view GetRawSnapshotLine(const AgentReplayData& ard, int snapIdx);
     void DrawStoCWindow();
     void DrawAgentOverlay();
     void DrawMapCalibrationWindow();
@@ -93,17 +97,41 @@ private:
     float m_loadProgress = 0.0f;
 
     // Intermediate state for phased loading (persists across Ticks)
-    FFNA_MapFile m_mapFile;
-    using ModelVariant = std::variant<FFNA_ModelFile>;
-    std::vector<ModelVariant> m_propModelFiles;
-    int m_propModelLoadIndex = 0;
+    FFNA_MapFileView m_mapFile;
     int m_propPlaceIndex = 0;
-    int m_totalPropFilenames = 0;
     int m_totalPropInstances = 0;
 
-    static constexpr int kPropModelBatchSize = 15;
     static constexpr int kPropPlaceBatchSize = 10;
 
+    // What StepPlaceProps needs from one prop model. Built off the UI thread.
+    struct PreparedPropModel
+    {
+        bool parsed_correctly = false;
+        bool textures_parsed_correctly = false;
+        PixelShaderType pixelShaderType = PixelShaderType::OldModel;
+        std::vector<Mesh> meshes;
+        std::vector<int> textureHashes; // Only the textures found in the hash index, in model order
+    };
+
+    // The prop decode job decompresses and parses every referenced prop model, its AMAT files and
+    // its textures on a worker pool. Workers write models/textures before setting finished.
+    struct PropDecodeJob
+    {
+        std::atomic<int> itemsDone{ 0 };
+        std::atomic<int> itemsTotal{ 0 };
+        std::atomic<bool> finished{ false };
+        std::atomic<bool> cancelled{ false };
+
+        std::vector<int> modelMftIndices; // Indexed by PropInfo::filename_index
+        std::vector<PreparedPropModel> models;
+        std::unordered_map<int, DatTexture> textures;
+    };
+
+    std::unique_ptr<PropDecodeJob> m_propDecodeJob;
+    std::thread m_propDecodeThread;
+    std::vector<PreparedPropModel> m_preparedPropModels;
+    std::unordered_map<int, DatTexture> m_preparedPropTextures;
+
     // --- ImGui state ---
     bool m_imguiInitialized = false;
     ImGuiContext* m_imguiContext = nullptr;
@@ -111,6 +139,9 @@ private:
     int  m_selectedAgentId = -1;
     float m_debugTimeline = 0.f;
     bool m_showParsedView = true;
+    // Text of the agent file shown in the raw snapshot view, loaded when first needed
+    std::filesystem::path m_rawTextPath;
+    std::string m_rawText;
     float m_agentListWidth = 220.f;
     std::vector<int> m_sortedAgentIds;
     std::vector<int> m_playerIds;
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <span>
 #include <DirectXMath.h>
 #include "MeshInstance.h"
 #include "FFNA_MapFile.h"
@@ -9,14 +10,15 @@
 class Terrain
 {
 public:
-    Terrain(int32_t grid_dim_x, uint32_t grid_dim_y, const std::vector<float>& height_map,
-            const std::vector<uint8_t>& terrain_texture_indices,
-            const std::vector<uint8_t>& terrain_shadow_map, const MapBounds& bounds)
+    // Takes spans so it can be built from either FFNA_MapFile or FFNA_MapFileView.
+    Terrain(int32_t grid_dim_x, uint32_t grid_dim_y, std::span<const float> height_map,
+            std::span<const uint8_t> terrain_texture_indices,
+            std::span<const uint8_t> terrain_shadow_map, const MapBounds& bounds)
         : m_grid_dim_x(grid_dim_x)
         , m_grid_dim_z(grid_dim_y)
-        , m_height_map(height_map)
-        , m_terrain_texture_indices(terrain_texture_indices)
-        , m_terrain_shadow_map(terrain_shadow_map)
+        , m_height_map(height_map.begin(), height_map.end())
+        , m_terrain_texture_indices(terrain_texture_indices.begin(), terrain_texture_indices.end())
+        , m_terrain_shadow_map(terrain_shadow_map.begin(), terrain_shadow_map.end())
         , m_bounds(bounds),
         grid(m_grid_dim_z + 1, std::vector<float>(m_grid_dim_x + 1, 0.0f))
     {
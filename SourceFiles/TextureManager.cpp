@@ -13,7 +13,9 @@ HRESULT TextureManager::CreateTextureFromDDSInMemory(const uint8_t* ddsData, siz
         *textureID_out = textureData.textureID;
         *width_out = textureData.width;
         *height_out = textureData.height;
-        rgba_data_out = textureData.rgba_data;
+        rgba_data_out = textureData.rgba_data.empty() && textureData.blocks
+                          ? DecodeAtexBlocks(*textureData.blocks).rgba_data
+                          : textureData.rgba_data;
 
         return S_OK;
     }
@@ -220,7 +222,8 @@ DatTexture TextureManager::BuildTextureAtlas(const std::vector<DatTexture>& terr
             if (textureIndex < numTextures)
             {
                 const auto& texture = terrain_dat_textures[textureIndex];
-                const std::vector<RGBA>& textureData = texture.rgba_data;
+                std::vector<RGBA> decoded;
+                const std::vector<RGBA>& textureData = texture.get_pixels(decoded);
                 int texWidth = texture.width;
                 int texHeight = texture.height;
 
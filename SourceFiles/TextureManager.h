@@ -1,6 +1,7 @@
 #pragma once
 #include "AtexReader.h"
 #include "DirectXTex/DirectXTex.h"
+#include "MipmapGenerator.h"
 
 inline UINT BytesPerPixel(DXGI_FORMAT format)
 {
@@ -25,6 +26,8 @@ struct TextureData
 	int width;
 	int height;
 	std::vector<RGBA> rgba_data;
+	// For textures created from DXT blocks the cache keeps the blocks instead of rgba_data.
+	std::shared_ptr<const AtexBlocks> blocks;
 };
 
 class TextureManager
@@ -212,11 +215,20 @@ public:
 		return nullptr;
 	}
 
+	// Decodes the pixels of textures that were cached as DXT blocks.
 	std::optional<TextureData> GetTextureDataByHash(int file_hash) const
 	{
 		auto it = cached_textures.find(file_hash);
 
-		if (it != cached_textures.end()) { return it->second; }
+		if (it != cached_textures.end())
+		{
+			TextureData textureData = it->second;
+			if (textureData.rgba_data.empty() && textureData.blocks)
+			{
+				textureData.rgba_data = DecodeAtexBlocks(*textureData.blocks).rgba_data;
+			}
+			return textureData;
+		}
 		return std::nullopt;
 	}
 
@@ -257,12 +269,48 @@ public:
 		return E_FAIL;
 	}
 
+	// Like CreateTextureFromRGBA, but for textures loaded with their DXT blocks the pixels are only
+	// decoded if the texture isn't cached yet, and the cache keeps the blocks instead of an RGBA copy.
+	HRESULT CreateTextureFromDatTexture(const DatTexture& dat_texture, int* textureID, int file_hash)
+	{
+		if (!dat_texture.blocks)
+		{
+			return CreateTextureFromRGBA(dat_texture.width, dat_texture.height, dat_texture.rgba_data.data(), textureID, file_hash);
+		}
+
+		if (cached_textures.contains(file_hash))
+		{
+			*textureID = cached_textures[file_hash].textureID;
+			return S_OK;
+		}
+
+		if (dat_texture.width <= 0 || dat_texture.height <= 0) { return E_FAIL; }
+
+		// GenerateMips needs an uncompressed render target, so the upload itself still takes RGBA.
+		std::vector<RGBA> scratch;
+		const std::vector<RGBA>& pixels = dat_texture.get_pixels(scratch);
+		*textureID = AddTexture(pixels.data(), dat_texture.width, dat_texture.height, DXGI_FORMAT_B8G8R8A8_UNORM, -1);
+		if (*textureID < 0) { return E_FAIL; }
+
+		if (file_hash >= 0)
+		{
+			TextureData textureData;
+			textureData.textureID = *textureID;
+			textureData.width = dat_texture.width;
+			textureData.height = dat_texture.height;
+			textureData.blocks = dat_texture.blocks;
+			cached_textures[file_hash] = std::move(textureData);
+		}
+
+		return S_OK;
+	}
+
 	HRESULT CreateTextureFromDDSInMemory(const uint8_t* ddsData, size_t ddsDataSize, int* textureID_out,
 	                                     int* width_out, int* height_out, std::vector<RGBA>& rgba_data_out,
 	                                     int file_hash);
 	HRESULT SaveTextureToFile(ID3D11ShaderResourceView* srv, const wchar_t* filename);
 
-	DatTexture BuildTextureAtlas(const std::vector<DatTexture>& terrain_dat_textures, int num_cols,
+	static DatTexture BuildTextureAtlas(const std::vector<DatTexture>& terrain_dat_textures, int num_cols,
 	                             int num_rows);
 
 	void Clear() { 
@@ -277,55 +325,6 @@ private:
 	std::unordered_map<int, TextureData> cached_textures;
 
 	std::unordered_map<int, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> m_textures;
-
-	void GenerateMipmapLevel(const std::vector<uint8_t>& higherLevelData,
-                         std::vector<uint8_t>& lowerLevelData,
-                         UINT higherWidth, UINT higherHeight, UINT bytesPerPixel)
-{
-    if (bytesPerPixel != 4)
-    {
-        return; // Unsupported format
-    }
-
-    UINT lowerWidth = higherWidth / 2;
-    UINT lowerHeight = higherHeight / 2;
-    lowerLevelData.resize(lowerWidth * lowerHeight * bytesPerPixel);
-
-    const uint8_t* src = higherLevelData.data();
-    uint8_t* dst = lowerLevelData.data();
-
-    for (UINT y = 0; y < lowerHeight; ++y)
-    {
-        for (UINT x = 0; x < lowerWidth; ++x)
-        {
-            UINT dstIdx = 4 * (y * lowerWidth + x);
-
-            for (UINT channel = 0; channel < 4; ++channel)
-            {
-                std::vector<uint8_t> values;
-                for (int dy = -1; dy <= 1; dy++)
-                {
-                    for (int dx = -1; dx <= 1; dx++)
-                    {
-                        int nx = 2 * x + dx;
-                        int ny = 2 * y + dy;
-
-                        if (nx < 0 || ny < 0 || nx >= higherWidth || ny >= higherHeight)
-                            continue;
-
-                        UINT srcIdx = 4 * (ny * higherWidth + nx);
-                        values.push_back(src[srcIdx + channel]);
-                    }
-                }
-
-                // Sort and find the median
-                std::sort(values.begin(), values.end());
-                dst[dstIdx + channel] = values[values.size() / 2];
-            }
-        }
-    }
-}
-
 };
 
 inline bool SaveTextureToPng(ID3D11ShaderResourceView* texture, std::wstring& filename,
@@ -346,11 +345,39 @@ enum class CompressionFormat {
 	BC1, // DXGI_FORMAT_BC1_UNORM
 	BC3, // DXGI_FORMAT_BC3_UNORM
 	BC5, // DXGI_FORMAT_BC5_UNORM
+	Original, // The DXT blocks from the dat as they are, no mipmaps. Uncompressed if there are none.
 };
 
+// Writes the DXT blocks of a texture to a DDS file without decoding and re-encoding them.
+inline bool SaveDXTBlocksToDDS(const AtexBlocks& blocks, const std::wstring& filename)
+{
+	DirectX::Image image;
+	image.width = static_cast<size_t>(blocks.width);
+	image.height = static_cast<size_t>(blocks.height);
+	switch (blocks.format) {
+	case DXTFormat::DXT1: image.format = DXGI_FORMAT_BC1_UNORM; break;
+	case DXTFormat::DXT3: image.format = DXGI_FORMAT_BC2_UNORM; break;
+	default: image.format = DXGI_FORMAT_BC3_UNORM; break;
+	}
+	image.rowPitch = (blocks.width / 4) * (blocks.format == DXTFormat::DXT1 ? 8 : 16);
+	image.slicePitch = blocks.size_in_bytes();
+	image.pixels = const_cast<uint8_t*>(blocks.bytes());
+
+	HRESULT hr = DirectX::SaveToDDSFile(image, DirectX::DDS_FLAGS_NONE, filename.c_str());
+	return SUCCEEDED(hr);
+}
+
 
-inline bool SaveTextureToDDS(const TextureData& textureData, const std::wstring& filename, CompressionFormat compressionFormat)
+inline bool SaveTextureToDDS(const TextureData& textureData, const std::wstring& filename, CompressionFormat compressionFormat,
+	MipFilter mipFilter = MipFilter::Box)
 {
+	if (compressionFormat == CompressionFormat::Original) {
+		if (textureData.blocks) {
+			return SaveDXTBlocksToDDS(*textureData.blocks, filename);
+		}
+		compressionFormat = CompressionFormat::None;
+	}
+
 	size_t totalSize = textureData.rgba_data.size() * sizeof(RGBA);
 	std::vector<uint8_t> pixelData(totalSize);
 
@@ -375,7 +402,7 @@ inline bool SaveTextureToDDS(const TextureData& textureData, const std::wstring&
 
 	// Generate mipmaps
 	DirectX::ScratchImage mipmappedImage;
-	hr = DirectX::GenerateMipMaps(*scratchImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, mipmappedImage);
+	hr = GenerateMipChain(*scratchImage.GetImage(0, 0, 0), mipFilter, mipmappedImage);
 	if (FAILED(hr)) {
 		return false;
 	}
@@ -0,0 +1,400 @@
+#include "pch.h"
+#include "TiledImageWriter.h"
+#include <atomic>
+#include <execution>
+#include <numeric>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Width in pixels of the column tiles a strip of a level is split into for BC3 compression.
+    constexpr size_t compress_tile_width = 256;
+}
+
+HRESULT PngStripWriter::Open(const std::wstring& filename, size_t width, size_t height, DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        m_swapRedBlue = true;
+        break;
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        m_swapRedBlue = false;
+        break;
+    default:
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    }
+
+    bool iswic2 = false;
+    IWICImagingFactory* factory = DirectX::GetWICFactory(iswic2);
+    if (! factory)
+    {
+        return E_NOINTERFACE;
+    }
+
+    HRESULT hr = factory->CreateStream(m_stream.ReleaseAndGetAddressOf());
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = m_stream->InitializeFromFilename(filename.c_str(), GENERIC_WRITE);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, m_encoder.ReleaseAndGetAddressOf());
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = m_encoder->Initialize(m_stream.Get(), WICBitmapEncoderNoCache);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ComPtr<IPropertyBag2> props;
+    hr = m_encoder->CreateNewFrame(m_frame.ReleaseAndGetAddressOf(), props.GetAddressOf());
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = m_frame->Initialize(props.Get());
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = m_frame->SetSize(static_cast<UINT>(width), static_cast<UINT>(height));
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    WICPixelFormatGUID pixelFormat = GUID_WICPixelFormat32bppBGRA;
+    hr = m_frame->SetPixelFormat(&pixelFormat);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    if (pixelFormat != GUID_WICPixelFormat32bppBGRA)
+    {
+        return WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT;
+    }
+
+    // Tag the file as sRGB, like SaveToWICFile with WIC_FLAGS_FORCE_SRGB.
+    ComPtr<IWICMetadataQueryWriter> metadataWriter;
+    if (SUCCEEDED(m_frame->GetMetadataQueryWriter(metadataWriter.GetAddressOf())))
+    {
+        PROPVARIANT value;
+        PropVariantInit(&value);
+        value.vt = VT_UI1;
+        value.bVal = 0;
+        metadataWriter->SetMetadataByName(L"/sRGB/RenderingIntent", &value);
+    }
+
+    m_width = width;
+    m_height = height;
+    m_rowsWritten = 0;
+    return S_OK;
+}
+
+HRESULT PngStripWriter::WriteRows(const uint8_t* pixels, size_t rowPitch, size_t rowCount)
+{
+    if (! m_frame)
+    {
+        return E_UNEXPECTED;
+    }
+    if (m_rowsWritten + rowCount > m_height)
+    {
+        return E_INVALIDARG;
+    }
+
+    const size_t rowBytes = m_width * 4;
+    if (m_swapRedBlue)
+    {
+        m_swizzled.resize(rowBytes * rowCount);
+        for (size_t y = 0; y < rowCount; y++)
+        {
+            const uint8_t* in = pixels + y * rowPitch;
+            uint8_t* out = m_swizzled.data() + y * rowBytes;
+            for (size_t x = 0; x < rowBytes; x += 4)
+            {
+                out[x + 0] = in[x + 2];
+                out[x + 1] = in[x + 1];
+                out[x + 2] = in[x + 0];
+                out[x + 3] = in[x + 3];
+            }
+        }
+        pixels = m_swizzled.data();
+        rowPitch = rowBytes;
+    }
+
+    const HRESULT hr = m_frame->WritePixels(static_cast<UINT>(rowCount), static_cast<UINT>(rowPitch),
+                                            static_cast<UINT>(rowPitch * rowCount), const_cast<BYTE*>(pixels));
+    if (SUCCEEDED(hr))
+    {
+        m_rowsWritten += rowCount;
+    }
+    return hr;
+}
+
+HRESULT PngStripWriter::Finish()
+{
+    if (! m_frame || m_rowsWritten != m_height)
+    {
+        return E_UNEXPECTED;
+    }
+
+    HRESULT hr = m_frame->Commit();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = m_encoder->Commit();
+    m_frame.Reset();
+    m_encoder.Reset();
+    m_stream.Reset();
+    return hr;
+}
+
+HRESULT DdsStripWriter::Open(const std::wstring& filename, size_t width, size_t height, DXGI_FORMAT format,
+                             MipFilter mipFilter)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+        break;
+    default:
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    }
+
+    size_t levels = 1;
+    for (size_t size = std::max(width, height); size > 1; size /= 2)
+    {
+        levels++;
+    }
+
+    DirectX::TexMetadata metadata = {};
+    metadata.width = width;
+    metadata.height = height;
+    metadata.depth = 1;
+    metadata.arraySize = 1;
+    metadata.mipLevels = levels;
+    metadata.format = DXGI_FORMAT_BC3_UNORM;
+    metadata.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+
+    size_t headerSize = 0;
+    HRESULT hr = DirectX::EncodeDDSHeader(metadata, DirectX::DDS_FLAGS_NONE, nullptr, 0, headerSize);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    std::vector<uint8_t> header(headerSize);
+    hr = DirectX::EncodeDDSHeader(metadata, DirectX::DDS_FLAGS_NONE, header.data(), header.size(), headerSize);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    m_levels.assign(levels, {});
+    uint64_t offset = headerSize;
+    for (size_t i = 0; i < levels; i++)
+    {
+        Level& level = m_levels[i];
+        level.width = width;
+        level.height = height;
+        level.fileOffset = offset;
+
+        size_t slicePitch = 0;
+        hr = DirectX::ComputePitch(DXGI_FORMAT_BC3_UNORM, width, height, level.blockRowBytes, slicePitch);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        offset += slicePitch;
+
+        width = std::max<size_t>(1, width / 2);
+        height = std::max<size_t>(1, height / 2);
+    }
+
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if (! m_file)
+    {
+        return HRESULT_FROM_WIN32(ERROR_CANNOT_MAKE);
+    }
+    m_file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+    m_format = format;
+    m_mipFilter = mipFilter;
+    return m_file.good() ? S_OK : HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+}
+
+HRESULT DdsStripWriter::WriteRows(const uint8_t* pixels, size_t rowPitch, size_t rowCount)
+{
+    if (m_levels.empty() || ! m_file.is_open())
+    {
+        return E_UNEXPECTED;
+    }
+
+    Level& top = m_levels[0];
+    if (top.endRow + rowCount > top.height)
+    {
+        return E_INVALIDARG;
+    }
+
+    const size_t rowBytes = top.width * 4;
+    const size_t oldSize = top.rows.size();
+    top.rows.resize(oldSize + rowCount * rowBytes);
+    for (size_t y = 0; y < rowCount; y++)
+    {
+        memcpy(top.rows.data() + oldSize + y * rowBytes, pixels + y * rowPitch, rowBytes);
+    }
+    top.endRow += rowCount;
+
+    for (size_t i = 0; i < m_levels.size(); i++)
+    {
+        const HRESULT hr = ProcessLevel(i);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+    return S_OK;
+}
+
+HRESULT DdsStripWriter::Finish()
+{
+    if (! m_file.is_open())
+    {
+        return E_UNEXPECTED;
+    }
+
+    for (const Level& level : m_levels)
+    {
+        if (level.compressedRows != level.height)
+        {
+            m_file.close();
+            return E_UNEXPECTED;
+        }
+    }
+
+    m_file.close();
+    m_levels.clear();
+    return m_file.fail() ? HRESULT_FROM_WIN32(ERROR_WRITE_FAULT) : S_OK;
+}
+
+HRESULT DdsStripWriter::ProcessLevel(size_t index)
+{
+    Level& level = m_levels[index];
+    const size_t rowBytes = level.width * 4;
+    const bool complete = level.endRow == level.height;
+
+    // BC3 blocks are 4 rows tall, so only the last block row may be partial.
+    const size_t compressEnd = complete ? level.endRow : level.endRow / 4 * 4;
+    if (compressEnd > level.compressedRows)
+    {
+        const HRESULT hr = CompressRows(level, level.compressedRows, compressEnd);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        level.compressedRows = compressEnd;
+    }
+
+    size_t keepFrom = level.compressedRows;
+    if (index + 1 < m_levels.size())
+    {
+        Level& next = m_levels[index + 1];
+
+        // Filter every row of the next level whose source rows are all known.
+        size_t nextEnd = complete ? next.height : std::min(next.height, level.endRow / 2);
+        while (nextEnd > next.endRow &&
+               GetMipSourceRows(m_mipFilter, level.height, nextEnd - 1, nextEnd).second > level.endRow)
+        {
+            nextEnd--;
+        }
+
+        if (nextEnd > next.endRow)
+        {
+            const size_t nextRowBytes = next.width * 4;
+            next.rows.resize(next.rows.size() + (nextEnd - next.endRow) * nextRowBytes);
+            GenerateMipRows(level.rows.data(), level.firstRow, level.width, level.height, rowBytes,
+                            next.rows.data() + (next.endRow - next.firstRow) * nextRowBytes, nextRowBytes,
+                            next.endRow, nextEnd, m_mipFilter);
+            next.endRow = nextEnd;
+        }
+
+        if (next.endRow < next.height)
+        {
+            keepFrom = std::min(keepFrom, GetMipSourceRows(m_mipFilter, level.height, next.endRow, next.endRow + 1).first);
+        }
+    }
+
+    if (keepFrom > level.firstRow)
+    {
+        level.rows.erase(level.rows.begin(), level.rows.begin() + (keepFrom - level.firstRow) * rowBytes);
+        level.firstRow = keepFrom;
+    }
+    return S_OK;
+}
+
+HRESULT DdsStripWriter::CompressRows(Level& level, size_t rowBegin, size_t rowEnd)
+{
+    const size_t rowBytes = level.width * 4;
+    const size_t rowCount = rowEnd - rowBegin;
+    const size_t blockRows = (rowCount + 3) / 4;
+    const uint8_t* pixels = level.rows.data() + (rowBegin - level.firstRow) * rowBytes;
+    m_blocks.resize(blockRows * level.blockRowBytes);
+
+    std::vector<size_t> tiles((level.width + compress_tile_width - 1) / compress_tile_width);
+    std::iota(tiles.begin(), tiles.end(), size_t{0});
+
+    std::atomic<HRESULT> result = S_OK;
+    std::for_each(std::execution::par, tiles.begin(), tiles.end(), [&](size_t tile) {
+        const size_t x = tile * compress_tile_width;
+
+        DirectX::Image image;
+        image.width = std::min(compress_tile_width, level.width - x);
+        image.height = rowCount;
+        image.format = m_format;
+        image.rowPitch = rowBytes;
+        image.slicePitch = rowBytes * rowCount;
+        image.pixels = const_cast<uint8_t*>(pixels + 4 * x);
+
+        DirectX::ScratchImage compressed;
+        const HRESULT hr = DirectX::Compress(image, DXGI_FORMAT_BC3_UNORM, DirectX::TEX_COMPRESS_DEFAULT, 0.5f, compressed);
+        if (FAILED(hr))
+        {
+            result = hr;
+            return;
+        }
+
+        // Each block covers 4 pixels of a row and is 16 bytes.
+        const DirectX::Image* blocks = compressed.GetImage(0, 0, 0);
+        for (size_t row = 0; row < blockRows; row++)
+        {
+            memcpy(m_blocks.data() + row * level.blockRowBytes + x / 4 * 16, blocks->pixels + row * blocks->rowPitch,
+                   blocks->rowPitch);
+        }
+    });
+
+    if (FAILED(result))
+    {
+        return result;
+    }
+
+    m_file.seekp(level.fileOffset + rowBegin / 4 * level.blockRowBytes);
+    m_file.write(reinterpret_cast<const char*>(m_blocks.data()), m_blocks.size());
+    return m_file.good() ? S_OK : HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+}
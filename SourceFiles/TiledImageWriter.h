@@ -0,0 +1,86 @@
+#pragma once
+#include <wincodec.h>
+#include "DirectXTex/DirectXTex.h"
+#include "MipmapGenerator.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Image file writers that receive the image a strip of rows at a time, top to bottom, so that large
+// exports (the tiled map export) never need the whole image in memory. The pixels are 4 bytes each in
+// the format the writer was opened with.
+class ImageStripWriter
+{
+public:
+    virtual ~ImageStripWriter() = default;
+
+    // Appends rowCount rows below the ones already written.
+    virtual HRESULT WriteRows(const uint8_t* pixels, size_t rowPitch, size_t rowCount) = 0;
+
+    // Completes the file. Every row of the image must have been written.
+    virtual HRESULT Finish() = 0;
+};
+
+// Writes a PNG through the WIC encoder, which deflates each strip as it arrives.
+class PngStripWriter final : public ImageStripWriter
+{
+public:
+    // format must be R8G8B8A8_UNORM or B8G8R8A8_UNORM (or their sRGB variants).
+    HRESULT Open(const std::wstring& filename, size_t width, size_t height, DXGI_FORMAT format);
+
+    HRESULT WriteRows(const uint8_t* pixels, size_t rowPitch, size_t rowCount) override;
+    HRESULT Finish() override;
+
+private:
+    Microsoft::WRL::ComPtr<IWICStream> m_stream;
+    Microsoft::WRL::ComPtr<IWICBitmapEncoder> m_encoder;
+    Microsoft::WRL::ComPtr<IWICBitmapFrameEncode> m_frame;
+
+    size_t m_width = 0;
+    size_t m_height = 0;
+    size_t m_rowsWritten = 0;
+    bool m_swapRedBlue = false;
+    std::vector<uint8_t> m_swizzled;
+};
+
+// Writes a BC3 DDS with a full mip chain. Every level is filtered from the one above as soon as enough
+// of its rows are known and compressed 4 rows at a time, split into column tiles that are compressed in
+// parallel. Only the rows the next strip still needs are kept, and the blocks are written straight to
+// their place in the file.
+class DdsStripWriter final : public ImageStripWriter
+{
+public:
+    // format must be one of the formats GenerateMipChain filters itself.
+    HRESULT Open(const std::wstring& filename, size_t width, size_t height, DXGI_FORMAT format,
+                 MipFilter mipFilter);
+
+    HRESULT WriteRows(const uint8_t* pixels, size_t rowPitch, size_t rowCount) override;
+    HRESULT Finish() override;
+
+private:
+    struct Level
+    {
+        size_t width = 0;
+        size_t height = 0;
+        uint64_t fileOffset = 0;
+        size_t blockRowBytes = 0;
+
+        // Rows [firstRow, endRow) of the level, 4 * width bytes each.
+        std::vector<uint8_t> rows;
+        size_t firstRow = 0;
+        size_t endRow = 0;
+
+        // Rows before this one have been compressed and written.
+        size_t compressedRows = 0;
+    };
+
+    HRESULT ProcessLevel(size_t level);
+    HRESULT CompressRows(Level& level, size_t rowBegin, size_t rowEnd);
+
+    std::ofstream m_file;
+    std::vector<Level> m_levels;
+    DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+    MipFilter m_mipFilter = MipFilter::Box;
+    std::vector<uint8_t> m_blocks;
+};
@@ -0,0 +1,160 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed size thread pool where every worker owns a deque of tasks. Tasks submitted from a worker go
+// to the back of its own deque and the worker takes its newest task first, so the work a task spawns
+// stays on the thread that has its data in cache. Idle workers steal the oldest task of another
+// worker, which tends to be a large one (e.g. a whole map in the batch exporter).
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned num_threads = 0)
+    {
+        if (num_threads == 0)
+        {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (unsigned i = 0; i < num_threads; i++)
+        {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        for (unsigned i = 0; i < num_threads; i++)
+        {
+            m_threads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+        }
+    }
+
+    // Finishes every queued task before returning.
+    ~WorkStealingPool()
+    {
+        WaitIdle();
+        {
+            std::lock_guard<std::mutex> lock(m_wake_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t GetNumThreads() const { return m_threads.size(); }
+
+    void Submit(std::function<void()> task)
+    {
+        // Tasks from other threads are spread over the workers round robin.
+        const size_t index = t_pool == this ? t_worker_index : m_next_queue++ % m_queues.size();
+        m_pending++;
+        {
+            std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+            m_queues[index]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_wake_mutex);
+            m_num_queued++;
+        }
+        m_wake.notify_one();
+    }
+
+    // Blocks until every submitted task, including the ones they submitted, has finished.
+    void WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(m_wake_mutex);
+        m_idle.wait(lock, [this] { return m_pending == 0; });
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Takes the newest task of the worker's own queue, or steals the oldest one of another worker.
+    bool TryTake(size_t self, std::function<void()>& task)
+    {
+        {
+            Queue& own = *m_queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < m_queues.size(); i++)
+        {
+            Queue& victim = *m_queues[(self + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkerLoop(size_t index)
+    {
+        t_pool = this;
+        t_worker_index = index;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_wake_mutex);
+                m_wake.wait(lock, [this] { return m_num_queued > 0 || m_stopping; });
+                if (m_num_queued == 0)
+                {
+                    return;
+                }
+                m_num_queued--;
+            }
+
+            // A task is queued somewhere; the counter reserved it for this worker.
+            std::function<void()> task;
+            while (!TryTake(index, task))
+            {
+                std::this_thread::yield();
+            }
+            task();
+
+            if (--m_pending == 0)
+            {
+                std::lock_guard<std::mutex> lock(m_wake_mutex);
+                m_idle.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_next_queue{ 0 };
+    std::atomic<size_t> m_pending{ 0 };
+
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    size_t m_num_queued = 0;
+    bool m_stopping = false;
+
+    static inline thread_local WorkStealingPool* t_pool = nullptr;
+    static inline thread_local size_t t_worker_index = 0;
+};
@@ -385,6 +385,16 @@ void PublishCompletedSearch(const AnimationSearchRequest& request, std::vector<A
 }
 } // namespace
 
+/**
+ * @brief Checks a file's chunk ids (from the DAT content info) for BB9/FA1 animation chunks.
+ */
+static bool HasAnimationChunk(const std::vector<uint32_t>& chunkIds)
+{
+    return std::ranges::any_of(chunkIds, [](uint32_t chunkId) {
+        return chunkId == GW::Parsers::CHUNK_ID_BB9 || chunkId == GW::Parsers::CHUNK_ID_FA1;
+    });
+}
+
 /**
  * @brief Searches a file for BB9 or FA1 animation chunks with matching model hashes.
  */
@@ -527,6 +537,10 @@ static void RunAnimationSearchRequest(const AnimationSearchRequest& request)
             continue;
         }
 
+        // Once the content info pass is done the chunk ids of every file are known, so files
+        // without animation chunks can be skipped without decompressing them.
+        const bool has_chunk_ids = manager->is_content_info_ready();
+
         const auto& mft = manager->get_MFT();
         for (size_t i = 0; i < mft.size(); ++i)
         {
@@ -538,7 +552,8 @@ static void RunAnimationSearchRequest(const AnimationSearchRequest& request)
             const auto& entry = mft[i];
 
             // Skip files that cannot contain model animation chunks.
-            if (entry.uncompressedSize < 57 || entry.type != FFNA_Type2)
+            if (entry.uncompressedSize < 57 || entry.type != FFNA_Type2 ||
+                (has_chunk_ids && entry.has_content_info && !HasAnimationChunk(entry.chunk_ids)))
             {
                 g_animationState.filesProcessed.fetch_add(1);
                 continue;
@@ -695,29 +710,21 @@ static void LoadAnimationFromResult(
 
     try
     {
-        uint8_t* fileData = manager->read_file(result.mftIndex);
-        if (!fileData)
-            return;
-
-        const auto& mft = manager->get_MFT();
-        size_t fileSize = mft[result.mftIndex].uncompressedSize;
-
-        auto clipOpt = GW::Parsers::ParseAnimationFromFile(fileData, fileSize);
-        if (clipOpt)
+        // The model cache parses the clip and builds its animation groups and skeleton once; picking the
+        // same result again reuses them.
+        const auto model = manager->get_model_cache().GetAnimatedModel(result.mftIndex);
+        const auto fileData = manager->get_file(result.mftIndex);
+        if (model && fileData)
         {
-            auto clip = std::make_shared<GW::Animation::AnimationClip>(std::move(*clipOpt));
-
-            // Build animation groups for the new playback system
-            clip->BuildAnimationGroups();
+            const auto clip = model->animationClip;
 
             // Log sequence data for debugging
             LogSequenceData(*clip, result.fileId);
 
             // Scan for animation file references (BBC/BBD chunks)
-            ScanForAnimationReferences(fileData, fileSize, dat_managers);
+            ScanForAnimationReferences(fileData->data(), fileData->size(), dat_managers);
 
-            auto skeleton = std::make_shared<GW::Animation::Skeleton>(
-                GW::Parsers::BB9AnimationParser::CreateSkeleton(*clip));
+            const auto skeleton = model->skeleton;
 
             // Keep the model hashes from the original model
             uint32_t savedHash0 = g_animationState.modelHash0;
@@ -752,8 +759,6 @@ static void LoadAnimationFromResult(
                 g_animationState.soundManager->SetTimingFromClip(*clip);
             }
         }
-
-        delete[] fileData;
     }
     catch (...)
     {
@@ -784,26 +789,22 @@ static bool TryLoadAnimationFromSameFile(
             {
                 try
                 {
-                    uint8_t* fileData = manager->read_file(static_cast<int>(i));
-                    if (!fileData)
+                    const auto model = manager->get_model_cache().GetAnimatedModel(static_cast<uint32_t>(i));
+                    const auto fileData = manager->get_file(static_cast<int>(i));
+                    if (!model || !fileData)
                         continue;
 
-                    auto clipOpt = GW::Parsers::ParseAnimationFromFile(fileData, mft[i].uncompressedSize);
-                    if (clipOpt && clipOpt->IsValid())
+                    if (model->IsValid())
                     {
-                        auto clip = std::make_shared<GW::Animation::AnimationClip>(std::move(*clipOpt));
-
-                        // Build animation groups for the new playback system
-                        clip->BuildAnimationGroups();
+                        const auto clip = model->animationClip;
 
                         // Log sequence data for debugging
                         LogSequenceData(*clip, fileId);
 
                         // Scan for animation file references (BBC/BBD chunks)
-                        ScanForAnimationReferences(fileData, mft[i].uncompressedSize, dat_managers);
+                        ScanForAnimationReferences(fileData->data(), fileData->size(), dat_managers);
 
-                        auto skeleton = std::make_shared<GW::Animation::Skeleton>(
-                            GW::Parsers::BB9AnimationParser::CreateSkeleton(*clip));
+                        const auto skeleton = model->skeleton;
 
                         // Save model info
                         uint32_t savedHash0 = g_animationState.modelHash0;
@@ -837,19 +838,18 @@ static bool TryLoadAnimationFromSameFile(
                             g_animationState.soundManager->SetTimingFromClip(*clip);
                         }
 
-                        delete[] fileData;
                         return true;
                     }
-                    if (clipOpt && !clipOpt->IsValid())
+                    else
                     {
+                        const auto& chunkType = model->animationClip->sourceChunkType;
                         char msg[192];
                         sprintf_s(msg,
                             "AutoLoad: file 0x%X has no playable animation keyframes (chunk=%s), continuing search\n",
                             fileId,
-                            clipOpt->sourceChunkType.empty() ? "?" : clipOpt->sourceChunkType.c_str());
+                            chunkType.empty() ? "?" : chunkType.c_str());
                         LogBB8Debug(msg);
                     }
-                    delete[] fileData;
                 }
                 catch (...)
                 {
@@ -993,29 +993,19 @@ void LoadAnimationFromReference(int refIndex, std::map<int, std::unique_ptr<DATM
 
     try
     {
-        uint8_t* fileData = manager->read_file(source.mftIndex);
-        if (!fileData)
-            return;
-
-        const auto& mft = manager->get_MFT();
-        size_t fileSize = mft[source.mftIndex].uncompressedSize;
-
-        auto clipOpt = GW::Parsers::ParseAnimationFromFile(fileData, fileSize);
-        if (clipOpt)
+        const auto model = manager->get_model_cache().GetAnimatedModel(source.mftIndex);
+        const auto fileData = manager->get_file(source.mftIndex);
+        if (model && fileData)
         {
-            auto clip = std::make_shared<GW::Animation::AnimationClip>(std::move(*clipOpt));
-
-            // Build animation groups for the new playback system
-            clip->BuildAnimationGroups();
+            const auto clip = model->animationClip;
 
             // Log sequence data for debugging
             LogSequenceData(*clip, source.fileId);
 
             // Scan for animation file references in the new file
-            ScanForAnimationReferences(fileData, fileSize, dat_managers);
+            ScanForAnimationReferences(fileData->data(), fileData->size(), dat_managers);
 
-            auto skeleton = std::make_shared<GW::Animation::Skeleton>(
-                GW::Parsers::BB9AnimationParser::CreateSkeleton(*clip));
+            const auto skeleton = model->skeleton;
 
             // Keep the model hashes from the original model
             uint32_t savedHash0 = g_animationState.modelHash0;
@@ -1058,8 +1048,6 @@ void LoadAnimationFromReference(int refIndex, std::map<int, std::unique_ptr<DATM
                 LogBB8Debug(msg);
             }
         }
-
-        delete[] fileData;
     }
     catch (...)
     {
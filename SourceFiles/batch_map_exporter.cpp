@@ -0,0 +1,615 @@
+#include "pch.h"
+#include "batch_map_exporter.h"
+#include <sstream>
+
+namespace
+{
+const wchar_t* journal_filename = L"batch_export_journal.txt";
+
+std::vector<uint8_t> to_bytes(const std::string& text) { return std::vector<uint8_t>(text.begin(), text.end()); }
+
+std::wstring get_texture_filename(int file_hash) { return std::to_wstring(file_hash) + L".png"; }
+std::wstring get_model_filename(int file_hash) { return std::format(L"model_0x{:X}_gwmb.json", file_hash); }
+std::wstring get_map_directory_name(int map_filehash) { return L"map_" + std::to_wstring(map_filehash); }
+}
+
+batch_map_exporter::batch_map_exporter(DATManager* dat_manager,
+                                       const std::unordered_map<int, std::vector<int>>& hash_index,
+                                       const std::wstring& save_directory, unsigned num_threads,
+                                       gwmb_map_format map_format)
+    : m_dat_manager(dat_manager)
+    , m_hash_index(hash_index)
+    , m_save_directory(save_directory)
+    , m_files_directory(m_save_directory / L"files")
+    , m_map_format(map_format)
+    , m_pool(num_threads)
+{
+}
+
+bool batch_map_exporter::export_maps(const std::vector<int>& map_filehashes)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_files_directory, error);
+
+    load_journal();
+    m_journal.open(m_files_directory / journal_filename, std::ios::app);
+    if (!m_journal)
+    {
+        return false;
+    }
+
+    std::unordered_set<int> requested_maps;
+    for (const int map_filehash : map_filehashes)
+    {
+        if (!requested_maps.insert(map_filehash).second)
+        {
+            m_progress.maps_duplicate++;
+            continue;
+        }
+        if (m_exported_maps.contains(map_filehash))
+        {
+            m_progress.maps_skipped++;
+            continue;
+        }
+
+        begin_work();
+        m_pool.Submit([this, map_filehash] { export_map(map_filehash); });
+    }
+
+    // Every write has a completion that is counted as work, so once nothing is in flight the writer is
+    // empty and only the tails of the last tasks can still be running.
+    {
+        std::unique_lock<std::mutex> lock(m_work_mutex);
+        m_work_done.wait(lock, [this] { return m_work_in_flight == 0; });
+    }
+    m_pool.WaitIdle();
+    m_writer.Flush();
+    m_journal.close();
+
+    return m_progress.maps_failed == 0 && m_writer.GetNumFailed() == 0;
+}
+
+void batch_map_exporter::begin_work()
+{
+    std::lock_guard<std::mutex> lock(m_work_mutex);
+    m_work_in_flight++;
+}
+
+void batch_map_exporter::end_work()
+{
+    std::lock_guard<std::mutex> lock(m_work_mutex);
+    if (--m_work_in_flight == 0)
+    {
+        m_work_done.notify_all();
+    }
+}
+
+batch_map_exporter::export_item* batch_map_exporter::request_texture(const gwmb_file_ref& texture_ref,
+                                                                      bool keep_texture)
+{
+    export_item* item;
+    {
+        std::lock_guard<std::mutex> lock(m_registry_mutex);
+        auto& slot = m_textures[texture_ref.file_hash];
+        if (slot)
+        {
+            return slot.get();
+        }
+        slot = std::make_unique<export_item>();
+        slot->keep_texture = keep_texture;
+        item = slot.get();
+    }
+
+    begin_work();
+    m_pool.Submit([this, item, texture_ref] { export_texture(item, texture_ref); });
+    return item;
+}
+
+batch_map_exporter::export_item* batch_map_exporter::request_model(const gwmb_file_ref& model_ref)
+{
+    export_item* item;
+    {
+        std::lock_guard<std::mutex> lock(m_registry_mutex);
+        auto& slot = m_models[model_ref.file_hash];
+        if (slot)
+        {
+            return slot.get();
+        }
+        slot = std::make_unique<export_item>();
+        item = slot.get();
+    }
+
+    begin_work();
+    m_pool.Submit([this, item, model_ref] { export_model(item, model_ref); });
+    return item;
+}
+
+void batch_map_exporter::when_done(export_item* item, std::function<void()> callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(item->mutex);
+        if (!item->done)
+        {
+            item->waiters.push_back(std::move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
+void batch_map_exporter::when_all(const std::vector<export_item*>& items, std::function<void()> continuation)
+{
+    // One extra count so the continuation can't be submitted before every item has a waiter.
+    auto remaining = std::make_shared<std::atomic<size_t>>(items.size() + 1);
+    auto shared_continuation = std::make_shared<std::function<void()>>(std::move(continuation));
+    const auto arrive = [this, remaining, shared_continuation] {
+        if (--*remaining == 0)
+        {
+            // Items complete on the writer thread, so the continuation always goes back to the pool.
+            m_pool.Submit(std::move(*shared_continuation));
+        }
+    };
+
+    for (export_item* item : items)
+    {
+        when_done(item, arrive);
+    }
+    arrive();
+}
+
+void batch_map_exporter::complete(export_item* item, bool ok)
+{
+    std::vector<std::function<void()>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(item->mutex);
+        item->done = true;
+        item->ok = ok;
+        waiters.swap(item->waiters);
+    }
+    for (auto& waiter : waiters)
+    {
+        waiter();
+    }
+    end_work();
+}
+
+void batch_map_exporter::write_file(const std::filesystem::path& path, std::vector<uint8_t> data,
+                                    std::string journal_line, std::function<void(bool)> on_written)
+{
+    m_writer.Write(path, std::move(data),
+                   [this, journal_line = std::move(journal_line), on_written = std::move(on_written)](bool success) {
+                       if (success && !journal_line.empty())
+                       {
+                           std::lock_guard<std::mutex> lock(m_journal_mutex);
+                           m_journal << journal_line << '\n';
+                           m_journal.flush();
+                       }
+                       if (on_written)
+                       {
+                           on_written(success);
+                       }
+                   });
+}
+
+// The journal has one line per file that is complete on disk:
+//   texture <hash> <width> <height> <texture type>
+//   model <hash> <texture hash>...
+//   map <hash>
+void batch_map_exporter::load_journal()
+{
+    std::ifstream journal(m_files_directory / journal_filename);
+    std::string line;
+    while (std::getline(journal, line))
+    {
+        std::istringstream line_stream(line);
+        std::string kind;
+        int file_hash = 0;
+        if (!(line_stream >> kind >> file_hash))
+        {
+            continue;
+        }
+
+        if (kind == "texture")
+        {
+            int texture_type = 0;
+            auto item = std::make_unique<export_item>();
+            if (!(line_stream >> item->texture.width >> item->texture.height >> texture_type))
+            {
+                continue;
+            }
+            item->texture.file_hash = file_hash;
+            item->texture.texture_type = static_cast<TextureType>(texture_type);
+            item->done = true;
+            item->ok = true;
+            m_textures[file_hash] = std::move(item);
+        }
+        else if (kind == "model")
+        {
+            auto item = std::make_unique<export_item>();
+            int texture_hash = 0;
+            while (line_stream >> texture_hash)
+            {
+                item->texture_hashes.push_back(texture_hash);
+            }
+            item->done = true;
+            item->ok = true;
+            m_models[file_hash] = std::move(item);
+        }
+        else if (kind == "map")
+        {
+            m_exported_maps.insert(file_hash);
+        }
+    }
+}
+
+void batch_map_exporter::export_texture(export_item* item, gwmb_file_ref texture_ref)
+{
+    try
+    {
+        auto texture = std::make_shared<DatTexture>();
+        std::vector<uint8_t> png;
+        if (!decode_texture(m_dat_manager, texture_ref.mft_index, *texture) || !encode_png(*texture, png))
+        {
+            complete(item, false);
+            return;
+        }
+
+        item->texture.file_hash = texture_ref.file_hash;
+        item->texture.width = texture->width;
+        item->texture.height = texture->height;
+        item->texture.texture_type = texture->texture_type;
+        if (item->keep_texture)
+        {
+            // The atlas decodes the blocks again, which is cheaper than keeping the pixels.
+            if (texture->blocks)
+            {
+                texture->rgba_data.clear();
+                texture->rgba_data.shrink_to_fit();
+            }
+            item->kept_texture = std::move(texture);
+        }
+
+        const auto journal_line = std::format("texture {} {} {} {}", texture_ref.file_hash, item->texture.width,
+                                              item->texture.height, static_cast<int>(item->texture.texture_type));
+        write_file(m_files_directory / get_texture_filename(texture_ref.file_hash), std::move(png), journal_line,
+                   [this, item](bool success) {
+                       if (success)
+                       {
+                           m_progress.textures_exported++;
+                       }
+                       complete(item, success);
+                   });
+    }
+    catch (...)
+    {
+        complete(item, false);
+    }
+}
+
+void batch_map_exporter::export_model(export_item* item, gwmb_file_ref model_ref)
+{
+    try
+    {
+        auto model_file = m_dat_manager->parse_ffna_model_file(model_ref.mft_index);
+        auto model = std::make_shared<gwmb_model>();
+        if (!model_exporter::generate_gwmb_submodels(*model, &model_file, m_dat_manager, m_hash_index))
+        {
+            complete(item, false);
+            return;
+        }
+
+        std::vector<export_item*> texture_items;
+        for (const auto& texture_ref : model_exporter::get_texture_refs(&model_file, m_hash_index))
+        {
+            texture_items.push_back(request_texture(texture_ref, false));
+        }
+
+        when_all(texture_items, [this, item, model, model_ref, texture_items] {
+            try
+            {
+                for (const export_item* texture_item : texture_items)
+                {
+                    // Like model_exporter::export_model, a model with a texture that can't be saved fails.
+                    if (!texture_item->ok)
+                    {
+                        complete(item, false);
+                        return;
+                    }
+                    model->textures.push_back(texture_item->texture);
+                    item->texture_hashes.push_back(texture_item->texture.file_hash);
+                }
+
+                std::string journal_line = std::format("model {}", model_ref.file_hash);
+                for (const int texture_hash : item->texture_hashes)
+                {
+                    journal_line += std::format(" {}", texture_hash);
+                }
+
+                const nlohmann::json j = *model;
+                write_file(m_files_directory / get_model_filename(model_ref.file_hash), to_bytes(j.dump()),
+                           std::move(journal_line), [this, item](bool success) {
+                               if (success)
+                               {
+                                   m_progress.models_exported++;
+                               }
+                               complete(item, success);
+                           });
+            }
+            catch (...)
+            {
+                complete(item, false);
+            }
+        });
+    }
+    catch (...)
+    {
+        complete(item, false);
+    }
+}
+
+void batch_map_exporter::export_map(int map_filehash)
+{
+    try
+    {
+        const auto mft_entry_it = m_hash_index.find(map_filehash);
+        if (mft_entry_it == m_hash_index.end())
+        {
+            map_done(false);
+            return;
+        }
+
+        const auto map_file = m_dat_manager->parse_ffna_map_file_view(mft_entry_it->second.at(0));
+        auto map = std::make_shared<gwmb_map>();
+        map->filehash = map_filehash;
+        if (!map_exporter::generate_gwmb_terrain(*map, map_file))
+        {
+            map_done(false);
+            return;
+        }
+
+        const auto texture_refs = map_exporter::get_terrain_texture_refs(map_file, m_hash_index);
+        const auto model_refs = map_exporter::get_prop_model_refs(map_file, m_dat_manager, m_hash_index);
+        map_exporter::generate_gwmb_map_models(*map, map_file, model_refs);
+
+        std::vector<export_item*> texture_items;
+        for (const auto& texture_ref : texture_refs)
+        {
+            texture_items.push_back(request_texture(texture_ref, true));
+        }
+
+        // export_map doesn't fail a map because one of its models failed, so neither does this.
+        std::vector<export_item*> model_items;
+        for (const auto& model_ref : model_refs)
+        {
+            model_items.push_back(request_model(model_ref));
+        }
+
+        std::vector<export_item*> items = texture_items;
+        items.insert(items.end(), model_items.begin(), model_items.end());
+        when_all(items, [this, map, texture_refs, texture_items, model_refs, model_items] {
+            finish_map(map, texture_refs, texture_items, model_refs, model_items);
+        });
+    }
+    catch (...)
+    {
+        map_done(false);
+    }
+}
+
+void batch_map_exporter::finish_map(const std::shared_ptr<gwmb_map>& map, const std::vector<gwmb_file_ref>& texture_refs,
+                                    const std::vector<export_item*>& texture_items,
+                                    const std::vector<gwmb_file_ref>& model_refs,
+                                    const std::vector<export_item*>& model_items)
+{
+    try
+    {
+        std::vector<DatTexture> terrain_dat_textures;
+        for (size_t i = 0; i < texture_items.size(); i++)
+        {
+            const export_item* texture_item = texture_items[i];
+            if (!texture_item->ok)
+            {
+                continue;
+            }
+
+            if (texture_item->kept_texture)
+            {
+                terrain_dat_textures.push_back(*texture_item->kept_texture);
+            }
+            else
+            {
+                // The texture was exported by an earlier run or for a model, so nothing kept it.
+                DatTexture texture;
+                if (!decode_texture(m_dat_manager, texture_refs[i].mft_index, texture))
+                {
+                    continue;
+                }
+                terrain_dat_textures.push_back(std::move(texture));
+            }
+            map->terrain.textures.push_back(texture_item->texture);
+        }
+
+        const auto terrain_tex_atlas = map_exporter::build_terrain_atlas(std::move(terrain_dat_textures));
+        std::vector<uint8_t> atlas_png;
+        if (terrain_tex_atlas.width <= 0 || terrain_tex_atlas.height <= 0 || !encode_png(terrain_tex_atlas, atlas_png))
+        {
+            map_done(false);
+            return;
+        }
+
+        // Every model and texture the map needs is already on disk in the files directory.
+        std::vector<std::wstring> shared_filenames;
+        for (const export_item* texture_item : texture_items)
+        {
+            if (texture_item->ok)
+            {
+                shared_filenames.push_back(get_texture_filename(texture_item->texture.file_hash));
+            }
+        }
+        for (size_t i = 0; i < model_items.size(); i++)
+        {
+            if (!model_items[i]->ok)
+            {
+                continue;
+            }
+            shared_filenames.push_back(get_model_filename(model_refs[i].file_hash));
+            for (const int texture_hash : model_items[i]->texture_hashes)
+            {
+                shared_filenames.push_back(get_texture_filename(texture_hash));
+            }
+        }
+        std::sort(shared_filenames.begin(), shared_filenames.end());
+        shared_filenames.erase(std::unique(shared_filenames.begin(), shared_filenames.end()), shared_filenames.end());
+
+        const auto map_directory = m_save_directory / get_map_directory_name(map->filehash);
+        std::error_code error;
+        std::filesystem::create_directories(map_directory, error);
+        if (error || !link_shared_files(map_directory, shared_filenames))
+        {
+            map_done(false);
+            return;
+        }
+
+        // The writer keeps the order, so the atlas is on disk before the map is journaled.
+        auto atlas_written = std::make_shared<std::atomic<bool>>(false);
+        write_file(map_directory / (L"atlas_" + std::to_wstring(map->filehash) + L".png"), std::move(atlas_png), {},
+                   [atlas_written](bool success) { *atlas_written = success; });
+
+        std::ostringstream map_file;
+        if (m_map_format == gwmb_map_format::json)
+        {
+            const nlohmann::json j = *map;
+            map_file << j.dump();
+        }
+        else
+        {
+            map_exporter::write_gwmb_map_binary(map_file, *map, m_map_format == gwmb_map_format::binary_compressed);
+        }
+        write_file(map_directory / map_exporter::get_map_filename(map->filehash, m_map_format), to_bytes(map_file.str()),
+                   std::format("map {}", map->filehash),
+                   [this, atlas_written](bool success) { map_done(success && *atlas_written); });
+    }
+    catch (...)
+    {
+        map_done(false);
+    }
+}
+
+bool batch_map_exporter::link_shared_files(const std::filesystem::path& map_directory,
+                                           const std::vector<std::wstring>& filenames)
+{
+    for (const auto& filename : filenames)
+    {
+        const auto target = map_directory / filename;
+        std::error_code error;
+        // Left over from an interrupted run, link it again in case the shared file was rewritten since.
+        std::filesystem::remove(target, error);
+        std::filesystem::create_hard_link(m_files_directory / filename, target, error);
+        if (error)
+        {
+            // FAT volumes and some network shares have no hard links.
+            error.clear();
+            std::filesystem::copy_file(m_files_directory / filename, target,
+                                       std::filesystem::copy_options::overwrite_existing, error);
+            if (error)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void batch_map_exporter::map_done(bool success)
+{
+    if (success)
+    {
+        m_progress.maps_exported++;
+    }
+    else
+    {
+        m_progress.maps_failed++;
+    }
+    end_work();
+}
+
+bool batch_map_exporter::decode_texture(DATManager* dat_manager, int mft_index, DatTexture& texture_out)
+{
+    const auto& entry = dat_manager->get_MFT()[mft_index];
+    if (entry.type != DDS)
+    {
+        texture_out = dat_manager->parse_ffna_texture_file(mft_index, false);
+        return texture_out.width > 0 && texture_out.height > 0;
+    }
+
+    const auto dds_data = dat_manager->parse_dds_file(mft_index);
+    DirectX::TexMetadata metadata;
+    DirectX::ScratchImage image;
+    if (dds_data.empty() ||
+        FAILED(DirectX::LoadFromDDSMemory(dds_data.data(), dds_data.size(), DirectX::DDS_FLAGS_NONE, &metadata, image)))
+    {
+        return false;
+    }
+
+    constexpr DXGI_FORMAT target_format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    if (DirectX::IsCompressed(metadata.format))
+    {
+        DirectX::ScratchImage decompressed;
+        if (FAILED(DirectX::Decompress(*image.GetImage(0, 0, 0), target_format, decompressed)))
+        {
+            return false;
+        }
+        image = std::move(decompressed);
+    }
+    if (image.GetMetadata().format != target_format)
+    {
+        DirectX::ScratchImage converted;
+        if (FAILED(DirectX::Convert(*image.GetImage(0, 0, 0), target_format, DirectX::TEX_FILTER_DEFAULT,
+                                    DirectX::TEX_THRESHOLD_DEFAULT, converted)))
+        {
+            return false;
+        }
+        image = std::move(converted);
+    }
+
+    const DirectX::Image* top_level = image.GetImage(0, 0, 0);
+    texture_out.width = static_cast<int>(top_level->width);
+    texture_out.height = static_cast<int>(top_level->height);
+    texture_out.texture_type = DDSt;
+    texture_out.rgba_data.resize(top_level->width * top_level->height);
+    for (size_t y = 0; y < top_level->height; y++)
+    {
+        memcpy(&texture_out.rgba_data[y * top_level->width], top_level->pixels + y * top_level->rowPitch,
+               top_level->width * sizeof(RGBA));
+    }
+    return texture_out.width > 0 && texture_out.height > 0;
+}
+
+bool batch_map_exporter::encode_png(const DatTexture& texture, std::vector<uint8_t>& png_out)
+{
+    std::vector<RGBA> scratch;
+    const auto& pixels = texture.get_pixels(scratch);
+    if (pixels.size() < static_cast<size_t>(texture.width) * texture.height)
+    {
+        return false;
+    }
+
+    DirectX::Image image;
+    image.width = texture.width;
+    image.height = texture.height;
+    image.format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    image.rowPitch = image.width * sizeof(RGBA);
+    image.slicePitch = image.rowPitch * image.height;
+    image.pixels = const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(pixels.data()));
+
+    DirectX::Blob blob;
+    if (FAILED(DirectX::SaveToWICMemory(image, DirectX::WIC_FLAGS_FORCE_SRGB,
+                                        DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG), blob)))
+    {
+        return false;
+    }
+
+    const auto* bytes = static_cast<const uint8_t*>(blob.GetBufferPointer());
+    png_out.assign(bytes, bytes + blob.GetBufferSize());
+    return true;
+}
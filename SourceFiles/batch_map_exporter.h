@@ -0,0 +1,108 @@
+#pragma once
+#include "map_exporter.h"
+#include "AsyncFileWriter.h"
+#include "WorkStealingPool.h"
+
+struct batch_export_progress
+{
+    std::atomic<int> maps_exported{ 0 };
+    std::atomic<int> maps_failed{ 0 };
+    std::atomic<int> maps_skipped{ 0 }; // Already exported by an earlier run of the same job
+    std::atomic<int> maps_duplicate{ 0 }; // Listed more than once in this job, exported once
+    std::atomic<int> models_exported{ 0 };
+    std::atomic<int> textures_exported{ 0 };
+};
+
+// Exports many maps, each into its own map_<hash> subdirectory holding the same files map_exporter::export_map
+// writes, so every map can be imported on its own. Maps, models and textures are tasks on a work-stealing
+// pool and every model or texture is decoded and written once for the whole batch, into the shared files
+// subdirectory, however many maps use it. The map directories get hard links to the files they need (copies
+// on file systems without hard links). Files are written by a background writer and recorded in a journal
+// (files/batch_export_journal.txt) once they are on disk, so an interrupted job that is started again with
+// the same directory skips everything it already wrote. Doesn't need a window or a D3D device.
+class batch_map_exporter
+{
+public:
+    batch_map_exporter(DATManager* dat_manager, const std::unordered_map<int, std::vector<int>>& hash_index,
+                       const std::wstring& save_directory, unsigned num_threads = 0,
+                       gwmb_map_format map_format = gwmb_map_format::binary);
+
+    // Exports the maps and blocks until they are done. Returns false if any of them failed.
+    bool export_maps(const std::vector<int>& map_filehashes);
+
+    const batch_export_progress& get_progress() const { return m_progress; }
+
+private:
+    // A model or texture of the batch. The first task to ask for it exports it, the others wait for it.
+    struct export_item
+    {
+        std::mutex mutex;
+        bool done = false;
+        bool ok = false;
+        std::vector<std::function<void()>> waiters;
+
+        // Textures only. The terrain textures keep their DXT blocks around for the atlas of every map
+        // that uses them.
+        gwmb_texture texture{};
+        bool keep_texture = false;
+        std::shared_ptr<const DatTexture> kept_texture;
+
+        // Models only. The textures the model JSON refers to, which go into every map directory with it.
+        std::vector<int> texture_hashes;
+    };
+
+    export_item* request_texture(const gwmb_file_ref& texture_ref, bool keep_texture);
+    export_item* request_model(const gwmb_file_ref& model_ref);
+
+    void export_texture(export_item* item, gwmb_file_ref texture_ref);
+    void export_model(export_item* item, gwmb_file_ref model_ref);
+    void export_map(int map_filehash);
+    void finish_map(const std::shared_ptr<gwmb_map>& map, const std::vector<gwmb_file_ref>& texture_refs,
+                    const std::vector<export_item*>& texture_items, const std::vector<gwmb_file_ref>& model_refs,
+                    const std::vector<export_item*>& model_items);
+    // Links (or copies) the shared files into a map directory.
+    bool link_shared_files(const std::filesystem::path& map_directory, const std::vector<std::wstring>& filenames);
+    void map_done(bool success);
+
+    // Counts the maps, models and textures that have been started but aren't done yet.
+    void begin_work();
+    void end_work();
+
+    // Runs callback once item is done, right away if it already is.
+    void when_done(export_item* item, std::function<void()> callback);
+    // Submits continuation to the pool once every item is done.
+    void when_all(const std::vector<export_item*>& items, std::function<void()> continuation);
+    void complete(export_item* item, bool ok);
+
+    void write_file(const std::filesystem::path& path, std::vector<uint8_t> data, std::string journal_line,
+                    std::function<void(bool)> on_written);
+    void load_journal();
+
+    // Decodes a DDS or ATEX/ATTX texture. DDS textures are converted to the B8G8R8A8 layout DatTexture uses.
+    static bool decode_texture(DATManager* dat_manager, int mft_index, DatTexture& texture_out);
+    static bool encode_png(const DatTexture& texture, std::vector<uint8_t>& png_out);
+
+    DATManager* m_dat_manager;
+    const std::unordered_map<int, std::vector<int>>& m_hash_index;
+    std::filesystem::path m_save_directory;
+    std::filesystem::path m_files_directory; // The models and textures shared by the map directories
+    gwmb_map_format m_map_format;
+
+    std::mutex m_registry_mutex;
+    std::unordered_map<int, std::unique_ptr<export_item>> m_textures;
+    std::unordered_map<int, std::unique_ptr<export_item>> m_models;
+    std::unordered_set<int> m_exported_maps;
+
+    std::mutex m_journal_mutex;
+    std::ofstream m_journal;
+
+    std::mutex m_work_mutex;
+    std::condition_variable m_work_done;
+    int m_work_in_flight = 0;
+
+    batch_export_progress m_progress;
+
+    // Declared last so they are destroyed first, while the state their tasks use still exists.
+    AsyncFileWriter m_writer;
+    WorkStealingPool m_pool;
+};
@@ -2,6 +2,7 @@
 #include "byte_pattern_search_panel.h"
 #include <filesystem>
 #include <GuiGlobalConstants.h>
+#include <MurmurHash3.h>
 #include <thread>
 #include <mutex>
 #include <atomic>
@@ -220,7 +221,9 @@ void search_dat_files_worker(DATManager* dat_manager, int dat_alias,
 				current_result.uncompressed_size = entry.uncompressedSize;
 				current_result.type = type_str;
 				current_result.id = static_cast<int32_t>(j);
-				current_result.murmurhash3 = entry.murmurhash3;
+				// The file is already decompressed, so hash it here rather than waiting for the
+				// dat's content info pass.
+				MurmurHash3_x86_32(file_data, entry.uncompressedSize, 0, &current_result.murmurhash3);
 
 				{
 					std::lock_guard<std::mutex> lock(g_results_mutex);
@@ -95,7 +95,7 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 {
 	bool success = false;
 
-	const auto MFT = dat_manager->get_MFT();
+	const auto& MFT = dat_manager->get_MFT();
 	if (index >= MFT.size())
 		return false;
 
@@ -196,16 +196,14 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 		//case ATTXDXTA: Cannot parse this
 	case ATTXDXTL:
 	{
-		selected_dat_texture.dat_texture = dat_manager->parse_ffna_texture_file(index);
+		selected_dat_texture.dat_texture = dat_manager->parse_ffna_texture_file(index, false);
 		selected_dat_texture.file_id = entry->Hash;
 		if (selected_dat_texture.dat_texture.width > 0 && selected_dat_texture.dat_texture.height > 0)
 		{
-			map_renderer->GetTextureManager()->CreateTextureFromRGBA(
-				selected_dat_texture.dat_texture.width,
-				selected_dat_texture.dat_texture.height,
-				selected_dat_texture.dat_texture.rgba_data.
-				data(), &selected_dat_texture.texture_id,
-				entry->Hash);
+			// The pixels are shown on hover, the texture cache only keeps the blocks.
+			selected_dat_texture.dat_texture.decode_pixels();
+			map_renderer->GetTextureManager()->CreateTextureFromDatTexture(
+				selected_dat_texture.dat_texture, &selected_dat_texture.texture_id, entry->Hash);
 
 			success = true;
 		}
@@ -245,16 +243,21 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 		map_renderer->GetTextureManager()->Clear();
 		map_renderer->ClearSceneForModeSwitch();
 
-		// Check if this is an "other" model format (uses 0xBB* chunks instead of 0xFA*)
-		using_other_model_format = dat_manager->is_other_model_format(index);
-
-		if (using_other_model_format)
-		{
-			selected_ffna_model_file_other = dat_manager->parse_ffna_model_file_other(index);
-		}
-		else
+		// Parse from the data we already decompressed above instead of reading the file again.
 		{
-			selected_ffna_model_file = dat_manager->parse_ffna_model_file(index);
+			std::span<unsigned char> model_data(selected_raw_data.data(), selected_raw_data.size());
+
+			// Check if this is an "other" model format (uses 0xBB* chunks instead of 0xFA*)
+			using_other_model_format = IsOtherModelFormat(model_data);
+
+			if (using_other_model_format)
+			{
+				selected_ffna_model_file_other = FFNA_ModelFile_Other(0, model_data);
+			}
+			else
+			{
+				selected_ffna_model_file = FFNA_ModelFile(0, model_data);
+			}
 		}
 
 		// Cancel any in-flight animation search from the previous model.
@@ -277,8 +280,8 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 			else
 			{
 				// FA0 format: hashes are in sub_1.f0xC/f0x10
-				modelHash0 = selected_ffna_model_file.geometry_chunk.sub_1.f0xC;
-				modelHash1 = selected_ffna_model_file.geometry_chunk.sub_1.f0x10;
+				modelHash0 = selected_ffna_model_file.get_geometry_chunk().sub_1.f0xC;
+				modelHash1 = selected_ffna_model_file.get_geometry_chunk().sub_1.f0x10;
 			}
 
 			// Set model hashes
@@ -366,7 +369,7 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 			// Get models from the correct model file format
 			const auto& models = using_other_model_format ?
 				selected_ffna_model_file_other.geometry_chunk.models :
-				selected_ffna_model_file.geometry_chunk.models;
+				selected_ffna_model_file.get_geometry_chunk().models;
 
 			// Set up submesh info for animation panel
 			g_animationState.SetSubmeshInfo(models.size());
@@ -434,17 +437,17 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 			// Get geometry chunk for texture/shader info
 			const auto& geometry_chunk_uts0 = using_other_model_format ?
 				selected_ffna_model_file_other.geometry_chunk.tex_and_vertex_shader_struct.uts0 :
-				selected_ffna_model_file.geometry_chunk.tex_and_vertex_shader_struct.uts0;
+				selected_ffna_model_file.get_geometry_chunk().tex_and_vertex_shader_struct.uts0;
 			const auto& geometry_chunk_uts1 = using_other_model_format ?
 				selected_ffna_model_file_other.geometry_chunk.uts1 :
-				selected_ffna_model_file.geometry_chunk.uts1;
+				selected_ffna_model_file.get_geometry_chunk().uts1;
 
 			std::vector<int> sort_orders;
 			for (int i = 0; i < models.size(); i++)
 			{
 				AMAT_file amat_file;
 				// "Other" format doesn't have AMAT filenames chunk, only standard format does
-				if (!using_other_model_format && selected_ffna_model_file.AMAT_filenames_chunk.texture_filenames.size() > 0) {
+				if (!using_other_model_format && selected_ffna_model_file.get_AMAT_filenames_chunk().texture_filenames.size() > 0) {
 					int sub_model_index = models[i].unknown;
 					if (geometry_chunk_uts0.size() > 0)
 					{
@@ -452,8 +455,8 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 					}
 					const auto uts1 = geometry_chunk_uts1[sub_model_index % geometry_chunk_uts1.size()];
 
-					const int amat_file_index = ((uts1.some_flags0 >> 8) & 0xFF) % selected_ffna_model_file.AMAT_filenames_chunk.texture_filenames.size();
-					const auto amat_filename = selected_ffna_model_file.AMAT_filenames_chunk.texture_filenames[amat_file_index];
+					const int amat_file_index = ((uts1.some_flags0 >> 8) & 0xFF) % selected_ffna_model_file.get_AMAT_filenames_chunk().texture_filenames.size();
+					const auto amat_filename = selected_ffna_model_file.get_AMAT_filenames_chunk().texture_filenames[amat_file_index];
 
 					const auto decoded_filename = decode_filename(amat_filename.id0, amat_filename.id1);
 
@@ -678,13 +681,12 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 							}
 							else
 							{
-								dat_texture = dat_manager->parse_ffna_texture_file(file_index);
+								dat_texture = dat_manager->parse_ffna_texture_file(file_index, false);
 								// Create texture if it wasn't cached.
 								if (texture_id < 0)
 								{
-									auto HR = map_renderer->GetTextureManager()->CreateTextureFromRGBA(dat_texture.width,
-										dat_texture.height, dat_texture.rgba_data.data(), &texture_id,
-										decoded_filename);
+									auto HR = map_renderer->GetTextureManager()->CreateTextureFromDatTexture(dat_texture,
+										&texture_id, decoded_filename);
 								}
 
 								model_texture_types.insert({ texture_id, dat_texture.texture_type });
@@ -764,13 +766,13 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 								}
 								else
 								{
-									dat_texture = dat_manager->parse_ffna_texture_file(file_index);
+									dat_texture = dat_manager->parse_ffna_texture_file(file_index, false);
 									// Create GPU texture for non-DDS textures
-									if (dat_texture.width > 0 && dat_texture.height > 0 && !dat_texture.rgba_data.empty())
+									if (dat_texture.width > 0 && dat_texture.height > 0 &&
+										(!dat_texture.rgba_data.empty() || dat_texture.blocks))
 									{
-										map_renderer->GetTextureManager()->CreateTextureFromRGBA(
-											dat_texture.width, dat_texture.height,
-											dat_texture.rgba_data.data(), &texture_id, decoded_filename);
+										map_renderer->GetTextureManager()->CreateTextureFromDatTexture(
+											dat_texture, &texture_id, decoded_filename);
 									}
 								}
 
@@ -815,7 +817,7 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 				}
 				else
 				{
-					const auto& texture_filenames = selected_ffna_model_file.texture_filenames_chunk.texture_filenames;
+					const auto& texture_filenames = selected_ffna_model_file.get_texture_filenames_chunk().texture_filenames;
 					for (size_t j = 0; j < texture_filenames.size(); j++)
 					{
 						auto decoded_filename = decode_filename(texture_filenames[j].id0, texture_filenames[j].id1);
@@ -994,7 +996,7 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 			auto pixel_shader_type = PixelShaderType::OldModel;
 			const auto& unknown_tex_stuff1 = using_other_model_format ?
 				selected_ffna_model_file_other.geometry_chunk.unknown_tex_stuff1 :
-				selected_ffna_model_file.geometry_chunk.unknown_tex_stuff1;
+				selected_ffna_model_file.get_geometry_chunk().unknown_tex_stuff1;
 			if (unknown_tex_stuff1.size() > 0)
 			{
 				pixel_shader_type = PixelShaderType::NewModel;
@@ -1282,13 +1284,12 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 				if (mft_entry_it != hash_index.end())
 				{
 					auto type = dat_manager->get_MFT()[mft_entry_it->second.at(0)].type;
-					const DatTexture dat_texture = dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0));
+					const DatTexture dat_texture = dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0), false);
 					int texture_id = -1;
 					if (dat_texture.width > 0 && dat_texture.height > 0) {
 
-						auto HR = map_renderer->GetTextureManager()->CreateTextureFromRGBA(
-							dat_texture.width, dat_texture.height, dat_texture.rgba_data.data(),
-							&texture_id, decoded_filename);
+						auto HR = map_renderer->GetTextureManager()->CreateTextureFromDatTexture(
+							dat_texture, &texture_id, decoded_filename);
 						if (SUCCEEDED(HR) && texture_id >= 0) {
 							sky_textures[i] = map_renderer->GetTextureManager()->GetTexture(texture_id);
 						}
@@ -1339,13 +1340,12 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 				if (mft_entry_it != hash_index.end())
 				{
 					auto type = dat_manager->get_MFT()[mft_entry_it->second.at(0)].type;
-					const DatTexture dat_texture = dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0));
+					const DatTexture dat_texture = dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0), false);
 					int texture_id = -1;
 					if (dat_texture.width == 512 && dat_texture.height == 512) {
 
-						auto HR = map_renderer->GetTextureManager()->CreateTextureFromRGBA(
-							dat_texture.width, dat_texture.height, dat_texture.rgba_data.data(),
-							&texture_id, decoded_filename);
+						auto HR = map_renderer->GetTextureManager()->CreateTextureFromDatTexture(
+							dat_texture, &texture_id, decoded_filename);
 						if (SUCCEEDED(HR) && texture_id >= 0) {
 							cloud_textures[i] = map_renderer->GetTextureManager()->GetTexture(texture_id);
 						}
@@ -1383,11 +1383,10 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 						}
 					}
 					else {
-						dat_texture = dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0));
+						dat_texture = dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0), false);
 
-						auto HR = map_renderer->GetTextureManager()->CreateTextureFromRGBA(
-							dat_texture.width, dat_texture.height, dat_texture.rgba_data.data(),
-							&texture_id, decoded_filename);
+						auto HR = map_renderer->GetTextureManager()->CreateTextureFromDatTexture(
+							dat_texture, &texture_id, decoded_filename);
 						if (SUCCEEDED(HR) && texture_id >= 0) {
 							water_textures[i] = map_renderer->GetTextureManager()->GetTexture(texture_id);
 						}
@@ -1588,7 +1587,7 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 				if (type == FFNA_Type2)
 				{
 					selected_map_files.emplace_back(
-						dat_manager->parse_ffna_model_file(mft_entry_it->second.at(0)));
+						dat_manager->parse_ffna_model_file_lazy(mft_entry_it->second.at(0)));
 				}
 			}
 		}
@@ -1605,8 +1604,8 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 				auto type = dat_manager->get_MFT()[mft_entry_it->second.at(0)].type;
 				if (type == FFNA_Type2)
 				{
-					auto map_model = dat_manager->parse_ffna_model_file(mft_entry_it->second.at(0));
-					selected_map_files.emplace_back(map_model);
+					selected_map_files.emplace_back(
+						dat_manager->parse_ffna_model_file_lazy(mft_entry_it->second.at(0)));
 				}
 			}
 		}
@@ -1620,10 +1619,12 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 				if (auto ffna_model_file_ptr =
 					std::get_if<FFNA_ModelFile>(&selected_map_files[prop_info.filename_index]))
 				{
+					// Only models that are actually placed get decoded.
+					ffna_model_file_ptr->decode_all_chunks();
 
 					std::vector<std::vector<int>> per_mesh_tex_ids;
 					// Load geometry
-					const auto& geometry_chunk = ffna_model_file_ptr->geometry_chunk;
+					const auto& geometry_chunk = ffna_model_file_ptr->get_geometry_chunk();
 					prop_meshes.clear();
 
 					std::vector<int> sort_orders;
@@ -1633,7 +1634,7 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 
 						// Get AMAT file if any
 						AMAT_file amat_file;
-						if (ffna_model_file_ptr->AMAT_filenames_chunk.texture_filenames.size() > 0) {
+						if (ffna_model_file_ptr->get_AMAT_filenames_chunk().texture_filenames.size() > 0) {
 							int sub_model_index = models[j].unknown;
 							if (geometry_chunk.tex_and_vertex_shader_struct.uts0.size() > 0)
 							{
@@ -1641,8 +1642,8 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 							}
 							const auto uts1 = geometry_chunk.uts1[sub_model_index % geometry_chunk.uts1.size()];
 
-							const int amat_file_index = ((uts1.some_flags0 >> 8) & 0xFF) % ffna_model_file_ptr->AMAT_filenames_chunk.texture_filenames.size();
-							const auto amat_filename = ffna_model_file_ptr->AMAT_filenames_chunk.texture_filenames[amat_file_index];
+							const int amat_file_index = ((uts1.some_flags0 >> 8) & 0xFF) % ffna_model_file_ptr->get_AMAT_filenames_chunk().texture_filenames.size();
+							const auto amat_filename = ffna_model_file_ptr->get_AMAT_filenames_chunk().texture_filenames[amat_file_index];
 
 							const auto decoded_filename = decode_filename(amat_filename.id0, amat_filename.id1);
 
@@ -1692,11 +1693,11 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 						if (ffna_model_file_ptr->textures_parsed_correctly)
 						{
 							for (int j = 0;
-								j < ffna_model_file_ptr->texture_filenames_chunk.texture_filenames.size();
+								j < ffna_model_file_ptr->get_texture_filenames_chunk().texture_filenames.size();
 								j++)
 							{
 								auto texture_filename =
-									ffna_model_file_ptr->texture_filenames_chunk.texture_filenames[j];
+									ffna_model_file_ptr->get_texture_filenames_chunk().texture_filenames[j];
 								auto decoded_filename =
 									decode_filename(texture_filename.id0, texture_filename.id1);
 
@@ -1713,12 +1714,11 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 								{
 									// Get texture from .dat
 									auto dat_texture =
-										dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0));
+										dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0), false);
 
 									// Create texture
-									auto HR = map_renderer->GetTextureManager()->CreateTextureFromRGBA(
-										dat_texture.width, dat_texture.height, dat_texture.rgba_data.data(),
-										&texture_id, decoded_filename);
+									auto HR = map_renderer->GetTextureManager()->CreateTextureFromDatTexture(
+										dat_texture, &texture_id, decoded_filename);
 
 									model_texture_types.insert({ texture_id, dat_texture.texture_type });
 
@@ -1817,7 +1817,7 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 						}
 
 						auto pixel_shader_type = PixelShaderType::OldModel;
-						if (ffna_model_file_ptr->geometry_chunk.unknown_tex_stuff1.size() > 0)
+						if (ffna_model_file_ptr->get_geometry_chunk().unknown_tex_stuff1.size() > 0)
 						{
 							pixel_shader_type = PixelShaderType::NewModel;
 						}
@@ -1918,13 +1918,12 @@ bool parse_file(DATManager* dat_manager, int index, MapRenderer* map_renderer,
 			if (mft_entry_it != hash_index.end())
 			{
 				auto type = dat_manager->get_MFT()[mft_entry_it->second.at(0)].type;
-				const DatTexture dat_texture = dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0));
+				const DatTexture dat_texture = dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0), false);
 				int texture_id = -1;
 				if (dat_texture.width > 0 && dat_texture.height > 0) {
 
-					auto HR = map_renderer->GetTextureManager()->CreateTextureFromRGBA(
-						dat_texture.width, dat_texture.height, dat_texture.rgba_data.data(),
-						&texture_id, decoded_filename);
+					auto HR = map_renderer->GetTextureManager()->CreateTextureFromDatTexture(
+						dat_texture, &texture_id, decoded_filename);
 					if (SUCCEEDED(HR) && texture_id >= 0) {
 						shore_textures[i] = map_renderer->GetTextureManager()->GetTexture(texture_id);
 					}
@@ -2207,7 +2206,14 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 		}
 	}
 
-	if (dat_manager_changed || custom_file_info_changed) {
+	// Murmur hashes and chunk ids come from a background pass that is started when the browser is
+	// first shown. Rebuild the items once they are available.
+	static bool items_have_content_info = false;
+	const bool content_info_became_ready =
+		!items.empty() && !items_have_content_info && dat_manager->is_content_info_ready();
+	const bool items_changed = dat_manager_changed || content_info_became_ready;
+
+	if (items_changed || custom_file_info_changed) {
 		items.clear();
 		filtered_items.clear();
 		id_index.clear();
@@ -2218,6 +2224,7 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 		map_id_index.clear();
 		name_index.clear();
 		pvp_index.clear();
+		murmurhash3_index.clear();
 		chunk_id_index.clear();
 		all_unique_chunk_ids.clear();
 		selected_chunk_ids.clear();
@@ -2247,6 +2254,11 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 			// Create item list
 			if (items.size() == 0)
 			{
+				dat_manager->request_content_info();
+				// The content info workers write murmurhash3 and chunk_ids of the MFT entries until the
+				// pass has completed, so they are only read after that. The items are rebuilt then.
+				items_have_content_info = dat_manager->is_content_info_ready();
+
 				const auto& entries = dat_manager->get_MFT();
 				for (int i = 0; i < entries.size(); i++)
 				{
@@ -2258,10 +2270,14 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 					encode_filehash(entry.Hash, filename_id_0, filename_id_1);
 
 					DatBrowserItem new_item{
-						i, entry.Hash, static_cast<FileType>(entry.type), entry.Size, entry.uncompressedSize, filename_id_0, filename_id_1, {}, {}, {}, entry.murmurhash3, entry.chunk_ids
+						i, entry.Hash, static_cast<FileType>(entry.type), entry.Size, entry.uncompressedSize, filename_id_0, filename_id_1, {}, {}, {}, 0, {}
 					};
+					if (items_have_content_info) {
+						new_item.murmurhash3 = entry.murmurhash3;
+						new_item.chunk_ids = entry.chunk_ids;
+					}
 					auto custom_file_info_it = custom_file_info_map.find(entry.Hash);
-					if (custom_file_info_it == custom_file_info_map.end()) {
+					if (custom_file_info_it == custom_file_info_map.end() && items_have_content_info) {
 						// Files with file_id == 0 uses murmurhash3 instead when saved to custom file
 						custom_file_info_it = custom_file_info_map.find(entry.murmurhash3);
 					}
@@ -2348,7 +2364,7 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 
 			static bool filter_update_required = true;
 
-			if (dat_manager_changed || custom_file_info_changed) {
+			if (items_changed || custom_file_info_changed) {
 				filter_update_required = true;
 			}
 
@@ -2727,7 +2743,7 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 				// Sort our data if sort specs have been changed!
 				ImGuiTableSortSpecs* sorts_specs = ImGui::TableGetSortSpecs();
 				if (sorts_specs)
-					if (dat_manager_changed || custom_file_info_changed || filter_updated) {
+					if (items_changed || custom_file_info_changed || filter_updated) {
 						sorts_specs->SpecsDirty = true;
 					}
 
@@ -2807,7 +2823,7 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 							last_focused_item_index = row_n; // Update the last focused item index
 						}
 
-						if (dat_manager_changed || custom_file_info_changed) {
+						if (items_changed || custom_file_info_changed) {
 							// Find the index of the item with item.hash == selected_item_hash or item.murmurhash3 == selected_item_hash
 							int item_index = -1;
 							for (int i = 0; i < filtered_items.size(); ++i) {
@@ -2885,18 +2901,18 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 									if (!savePath.empty())
 									{
 										parse_file(dat_manager, item.id, map_renderer, hash_index);
-										const auto obj_file_str = write_obj_str(prop_meshes);
+										write_obj(savePath, prop_meshes);
+									}
+								}
 
-										std::ofstream outFile(savePath);
-										if (outFile.is_open())
-										{
-											outFile << obj_file_str;
-											outFile.close();
-										}
-										else
-										{
-											// Error handling
-										}
+								if (ImGui::MenuItem("Export Mesh as .ply"))
+								{
+									std::wstring savePath =
+										OpenFileDialog(std::format(L"model_mesh_0x{:X}", item.hash), L"ply");
+									if (!savePath.empty())
+									{
+										parse_file(dat_manager, item.id, map_renderer, hash_index);
+										write_ply(savePath, prop_meshes);
 									}
 								}
 
@@ -2910,7 +2926,6 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 											++prop_mesh_index)
 										{
 											const auto& prop_mesh = prop_meshes[prop_mesh_index];
-											const auto obj_file_str = write_obj_str(&prop_mesh);
 
 											// Generate unique file name
 											std::wstring filename = std::format(L"model_mesh_0x{:X}_{}.obj", item.hash, prop_mesh_index);
@@ -2918,16 +2933,7 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 											// Append the filename to the saveDir
 											std::wstring savePath = saveDir + L"\\" + filename;
 
-											std::ofstream outFile(savePath);
-											if (outFile.is_open())
-											{
-												outFile << obj_file_str;
-												outFile.close();
-											}
-											else
-											{
-												// Error handling
-											}
+											write_obj(savePath, prop_mesh, false);
 										}
 									}
 								}
@@ -2939,11 +2945,11 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 									{
 										parse_file(dat_manager, item.id, map_renderer, hash_index);
 
-										for (int tex_index = 0; tex_index < selected_ffna_model_file.texture_filenames_chunk.
+										for (int tex_index = 0; tex_index < selected_ffna_model_file.get_texture_filenames_chunk().
 											texture_filenames.
 											size(); tex_index++)
 										{
-											const auto& texture_filename = selected_ffna_model_file.texture_filenames_chunk.
+											const auto& texture_filename = selected_ffna_model_file.get_texture_filenames_chunk().
 												texture_filenames[tex_index];
 
 											auto decoded_filename = decode_filename(texture_filename.id0, texture_filename.id1);
@@ -2991,10 +2997,18 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 									const auto compression_format = CompressionFormat::None;
 									ExportDDS(dat_manager, item.id, item.hash, map_renderer, hash_index, compression_format);
 								}
+
+								if (ImGui::MenuItem("Export model textures (.dds) original DXT blocks"))
+								{
+									const auto compression_format = CompressionFormat::Original;
+									ExportDDS(dat_manager, item.id, item.hash, map_renderer, hash_index, compression_format);
+								}
 							}
 							else if (item.type == FFNA_Type3)
 							{
-								if (ImGui::MenuItem("Export full map"))
+								const bool export_full_map = ImGui::MenuItem("Export full map");
+								const bool export_full_map_json = ImGui::MenuItem("Export full map (JSON)");
+								if (export_full_map || export_full_map_json)
 								{
 									std::wstring savePath = OpenDirectoryDialog();
 									if (!savePath.empty())
@@ -3011,7 +3025,8 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 											create_directory(newDirPath);
 										}
 
-										map_exporter::export_map(newDirPath, item.hash, item.id, dat_manager, hash_index, map_renderer->GetTextureManager());
+										const auto format = export_full_map_json ? gwmb_map_format::json : gwmb_map_format::binary;
+										map_exporter::export_map(newDirPath, item.hash, item.id, dat_manager, hash_index, map_renderer->GetTextureManager(), false, format);
 									}
 								}
 								else if (ImGui::MenuItem("Export Terrain Mesh as .obj"))
@@ -3022,20 +3037,7 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 									{
 										parse_file(dat_manager, item.id, map_renderer, hash_index);
 										const auto& terrain_mesh = terrain.get()->get_mesh();
-										const auto obj_file_str = write_obj_str(terrain_mesh);
-
-										std::string savePathStr(savePath.begin(), savePath.end());
-
-										std::ofstream outFile(savePathStr);
-										if (outFile.is_open())
-										{
-											outFile << obj_file_str;
-											outFile.close();
-										}
-										else
-										{
-											// Error handling
-										}
+										write_obj(savePath, *terrain_mesh, false);
 									}
 								}
 								else if (ImGui::MenuItem("Export heightmap as .tiff"))
@@ -3151,6 +3153,10 @@ void draw_data_browser(DATManager* dat_manager, MapRenderer* map_renderer, const
 									const auto compression_format = CompressionFormat::None;
 									ExportDDS2(dat_manager, item, map_renderer, hash_index, compression_format);
 								}
+								else if (ImGui::MenuItem("Export texture as DDS (Original DXT blocks)")) {
+									const auto compression_format = CompressionFormat::Original;
+									ExportDDS2(dat_manager, item, map_renderer, hash_index, compression_format);
+								}
 								else if (ImGui::MenuItem("Export texture as png")) {
 
 									parse_file(dat_manager, item.id, map_renderer, hash_index);
@@ -3398,11 +3404,11 @@ void ExportDDS(DATManager* dat_manager, int mft_file_index, int file_id, MapRend
 	{
 		parse_file(dat_manager, mft_file_index, map_renderer, hash_index);
 
-		for (int tex_index = 0; tex_index < selected_ffna_model_file.texture_filenames_chunk.
+		for (int tex_index = 0; tex_index < selected_ffna_model_file.get_texture_filenames_chunk().
 			texture_filenames.
 			size(); tex_index++)
 		{
-			const auto& texture_filename = selected_ffna_model_file.texture_filenames_chunk.
+			const auto& texture_filename = selected_ffna_model_file.get_texture_filenames_chunk().
 				texture_filenames[tex_index];
 
 			auto decoded_filename = decode_filename(texture_filename.id0, texture_filename.id1);
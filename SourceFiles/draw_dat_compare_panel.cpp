@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "draw_dat_compare_panel.h"
+#include "DatContentIndex.h"
 #include <filesystem>
 #include <draw_dat_load_progress_bar.h>
 #include <comparer_dsl.h>
@@ -8,9 +9,8 @@
 
 std::vector<std::wstring> file_paths;
 std::map<std::wstring, int> filepath_to_alias; // Map to track filepath and its alias
-std::vector<std::unordered_map<uint32_t, DatCompareFileInfo>> fileid_to_compare_file_infos;
 std::unordered_set<uint32_t> filter_eval_result;
-std::set<uint32_t> all_dats_murmur3hashes; // all the murmur3hashs in fileid_to_compare_file_infos
+DatContentIndex dat_content_index; // Every file of every loaded dat by murmur3hash and size
 
 static bool show_how_to_use_guide = false;
 
@@ -66,11 +66,32 @@ void draw_dat_compare_panel(std::map<int, std::unique_ptr<DATManager>>& dat_mana
 
 	bool is_analyzing = total_additional_files_read < total_additional_files;
 
+	// Files are compared by murmur hash, which each dat computes in a background pass after its type
+	// scan. Only start those passes once the comparer is actually used.
+	const bool needs_content_info = GuiGlobalConstants::is_compare_panel_open || dat_managers.size() > 1;
+	bool all_content_info_ready = true;
+	int total_content_info_read = 0;
+	int total_content_info_files = 0;
+	for (const auto& [alias, dat_manager] : dat_managers) {
+		if (needs_content_info) {
+			dat_manager->request_content_info();
+		}
+		if (!dat_manager->is_content_info_ready()) {
+			all_content_info_ready = false;
+			total_content_info_read += dat_manager->get_num_files_content_info_read();
+			total_content_info_files += dat_manager->get_num_files();
+		}
+	}
+
 	// Show progress bar of loading additional dat files
 	// Draw a single progress bar for the cumulative progress
 	if (is_analyzing) {
 		draw_dat_load_progress_bar(total_additional_files_read, total_additional_files);
 	}
+	else if (needs_content_info && !all_content_info_ready) {
+		draw_dat_load_progress_bar(total_content_info_read, total_content_info_files);
+		is_analyzing = true;
+	}
 
 	if (GuiGlobalConstants::is_compare_panel_open) {
 		if (ImGui::Begin("Compare DAT files", &GuiGlobalConstants::is_compare_panel_open)) {
@@ -135,12 +156,12 @@ void draw_dat_compare_panel(std::map<int, std::unique_ptr<DATManager>>& dat_mana
 
 							// Remove DATManager if it exists
 							if (dat_managers.find(alias_to_remove) != dat_managers.end()) {
+								dat_content_index.remove_dat(dat_managers[alias_to_remove].get());
 								dat_managers.erase(alias_to_remove);
 
 								// Erase file from vectors and map
 								filepath_to_alias.erase(file_paths[i]);
 								file_paths.erase(file_paths.begin() + i);
-								fileid_to_compare_file_infos.clear();
 
 								// Reorder the aliases in the map
 								for (auto& pair : filepath_to_alias) {
@@ -212,13 +233,32 @@ void draw_dat_compare_panel(std::map<int, std::unique_ptr<DATManager>>& dat_mana
 						filter_eval_result.clear();
 						num_eval_errors = 0;
 
-						for (const auto murmur3hash : all_dats_murmur3hashes) {
+						dat_content_index.for_each([&](const DatContentKey& key, const std::vector<DatContentLocation>& locations) {
+							// We don't include files whose content occurs more than once within the same dat, since
+							// there is no way to tell which of them to compare with the other dats.
 							std::unordered_map<int, DatCompareFileInfo> file_infos;
-							for (int i = 0; i < dat_managers.size(); i++) {
-								const auto it = fileid_to_compare_file_infos[i].find(murmur3hash);
-								if (it != fileid_to_compare_file_infos[i].end()) {
-									file_infos.insert_or_assign(i, it->second);
+							std::unordered_set<int> duplicated_in_dat;
+							for (const auto& location : locations) {
+								const auto dat_manager_it = dat_managers.find(location.alias);
+								if (dat_manager_it == dat_managers.end()) {
+									continue;
 								}
+
+								if (!file_infos.contains(location.alias)) {
+									int filename_id_0 = 0;
+									int filename_id_1 = 0;
+									encode_filehash(dat_manager_it->second->get_MFT()[location.mft_index].Hash, filename_id_0, filename_id_1);
+									file_infos.emplace(location.alias, DatCompareFileInfo{ static_cast<int>(key.murmurhash3), static_cast<int>(key.size), filename_id_0, filename_id_1 });
+								}
+								else {
+									duplicated_in_dat.insert(location.alias);
+								}
+							}
+							for (const auto alias : duplicated_in_dat) {
+								file_infos.erase(alias);
+							}
+							if (file_infos.empty()) {
+								return;
 							}
 
 							try
@@ -226,13 +266,13 @@ void draw_dat_compare_panel(std::map<int, std::unique_ptr<DATManager>>& dat_mana
 								const auto should_include_file = comparer_dsl.parse(filter_expression, file_infos);
 
 								if (should_include_file)
-									filter_eval_result.emplace(murmur3hash);
+									filter_eval_result.emplace(key.murmurhash3);
 							}
 							catch (const std::exception&)
 							{
 								num_eval_errors += 1;
 							}
-						}
+						});
 
 						filter_result_changed_out = true;
 						dat_compare_filter_result_out = filter_eval_result;
@@ -270,43 +310,7 @@ void draw_dat_compare_panel(std::map<int, std::unique_ptr<DATManager>>& dat_mana
 
 	show_how_to_use_dat_comparer_guide(&show_how_to_use_guide);
 
-	// Create maps for each dat file mapping filehash(murmur3hash) to each entrys murmurhash.
-	// We don't include files where the murmur3hash is the same (i.e. many files have the murmur3hash 0) which I don't know how to compare between multiples dats
-	if (!is_analyzing && fileid_to_compare_file_infos.size() < dat_managers.size()) {
-		all_dats_murmur3hashes.clear();
-		fileid_to_compare_file_infos.clear();
-		for (int i = 0; i < dat_managers.size(); i++) {
-			std::set<uint32_t> seen_murmur3hashs;
-			std::unordered_map<uint32_t, DatCompareFileInfo> new_map;
-			const auto& mft = dat_managers[i]->get_MFT();
-			for (int j = 0; j < mft.size(); j++) {
-				const auto murmur3hash = mft[j].murmurhash3;
-				const auto seen_it = seen_murmur3hashs.find(murmur3hash);
-				if (seen_it != seen_murmur3hashs.end()) {
-					// remove the entry from the new_map if it is already there. Otherwise do nothing
-					// Basically we just don't want any entries in the map that has a murmur3hash that is shared.
-					const auto new_map_it = new_map.find(murmur3hash);
-					if (new_map_it != new_map.end()) {
-						new_map.erase(murmur3hash);
-						all_dats_murmur3hashes.erase(murmur3hash);
-					}
-				}
-				else {
-					int filename_id_0 = 0;
-					int filename_id_1 = 0;
-
-					// Update filename_id_0 and filename_id_1 with the proper values.
-					encode_filehash(mft[j].Hash, filename_id_0, filename_id_1);
-
-					DatCompareFileInfo file_info{ mft[j].murmurhash3, mft[j].uncompressedSize, filename_id_0, filename_id_1 };
-
-					new_map.emplace(murmur3hash, file_info);
-					seen_murmur3hashs.emplace(murmur3hash);
-					all_dats_murmur3hashes.emplace(murmur3hash);
-				}
-			}
-
-			fileid_to_compare_file_infos.emplace_back(new_map);
-		}
-	}
+	// Index the content of every dat once its murmur hashes are known, and drop the dats that were
+	// removed. Dats that are already indexed are not read again.
+	dat_content_index.sync(dat_managers);
 }
\ No newline at end of file
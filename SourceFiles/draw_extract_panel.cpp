@@ -2,10 +2,12 @@
 #include "draw_extract_panel.h"
 #include "GuiGlobalConstants.h"
 #include "GWUnpacker.h"
+#include "MurmurHash3.h"
 #include "FFNA_ModelFile_Other.h"
 #include "DirectXTex/DirectXTex.h"
 #include <thread>
 #include <atomic>
+#include <fstream>
 
 constexpr int max_pixel_per_tile_dir = 16384;
 
@@ -40,6 +42,17 @@ void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_ma
 				ImGui::InputInt("Pixels per Tile Y", &extract_panel_info.pixels_per_tile_y, 1, 5, ImGuiInputTextFlags_CharsDecimal);
 				extract_panel_info.pixels_per_tile_y = (extract_panel_info.pixels_per_tile_y > max_pixel_per_tile_dir) ? max_pixel_per_tile_dir : (extract_panel_info.pixels_per_tile_y < 1) ? 1 : extract_panel_info.pixels_per_tile_y; // Clamping value between 1 and max_pixel_per_tile_dir
 
+				// Filter for the mipmaps of DDS exports
+				int mip_filter = static_cast<int>(extract_panel_info.dds_mip_filter);
+				const char* mip_filters[] = { GetMipFilterName(MipFilter::Box), GetMipFilterName(MipFilter::Kaiser), GetMipFilterName(MipFilter::Median) };
+				if (ImGui::Combo("DDS Mipmap Filter", &mip_filter, mip_filters, IM_ARRAYSIZE(mip_filters))) {
+					extract_panel_info.dds_mip_filter = static_cast<MipFilter>(mip_filter);
+				}
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip("Box: 2x2 average.\nKaiser: sharper, keeps more detail in the smaller mipmaps.\nMedian: 3x3 median, removes single-pixel noise instead of blurring it in.");
+				}
+
 				// Buttons for extraction
 				if (ImGui::Button("Extract as DDS")) {
 					std::wstring saveDir = OpenDirectoryDialog();
@@ -141,9 +154,21 @@ void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_ma
 											extension = L".dds";
 										}
 
-										const auto filename = std::format(L"{}_{}_{}_{}{}", i, entry.Hash, entry.murmurhash3, typeToWString(entry.type), extension);
-										if (!std::filesystem::exists(std::filesystem::path(saveDir) / subfolder / filename)) {
-											dat_manager->save_raw_decompressed_data_to_file(i, std::filesystem::path(saveDir) / subfolder / filename);
+										std::unique_ptr<unsigned char[]> data(dat_manager->read_file(static_cast<int>(i)));
+										if (!data) {
+											continue;
+										}
+
+										// entry.murmurhash3 is only valid once the content info pass has run, so the
+										// file is hashed here.
+										uint32_t murmurhash3 = 0;
+										MurmurHash3_x86_32(data.get(), entry.uncompressedSize, 0, &murmurhash3);
+
+										const auto filepath = std::filesystem::path(saveDir) / subfolder /
+											std::format(L"{}_{}_{}_{}{}", i, entry.Hash, murmurhash3, typeToWString(entry.type), extension);
+										if (!std::filesystem::exists(filepath)) {
+											std::ofstream output_file(filepath, std::ios::out | std::ios::binary);
+											output_file.write(reinterpret_cast<const char*>(data.get()), entry.uncompressedSize);
 										}
 									}
 								}
@@ -271,6 +296,234 @@ void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_ma
 					}
 				}
 			}
+
+			if (ImGui::CollapsingHeader("Benchmarks")) {
+				static std::atomic<bool> is_benchmark_running{false};
+				static std::atomic<int> benchmark_files_done{0};
+				static DecompressionBenchmarkResult benchmark_result;
+				static bool has_benchmark_result = false;
+
+				if (is_benchmark_running.load()) {
+					ImGui::Text("Decompressing: %d / %d", benchmark_files_done.load(), dat_manager->get_num_files());
+				}
+				else {
+					if (ImGui::Button("Benchmark dat decompression")) {
+						is_benchmark_running.store(true);
+						benchmark_files_done.store(0);
+
+						std::thread([dat_manager]() {
+							benchmark_result = dat_manager->benchmark_decompression(&benchmark_files_done);
+							has_benchmark_result = true;
+							is_benchmark_running.store(false);
+						}).detach();
+					}
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("Decompresses every compressed file in the dat with both the fast and the reference decoder,\nverifies that their output is identical and reports their throughput.");
+					}
+
+					if (has_benchmark_result) {
+						ImGui::Text("Files: %d (%.1f MB compressed, %.1f MB decompressed)", benchmark_result.num_files,
+							benchmark_result.compressed_bytes / 1e6, benchmark_result.decompressed_bytes / 1e6);
+						ImGui::Text("UnpackGWDat: %.1f MB/s (%.2f s)", benchmark_result.mb_per_second(), benchmark_result.seconds);
+						ImGui::Text("Reference: %.1f MB/s (%.2f s)", benchmark_result.reference_mb_per_second(), benchmark_result.reference_seconds);
+						ImGui::Text("Mismatches: %d", benchmark_result.num_mismatches);
+					}
+				}
+
+				ImGui::Separator();
+
+				static std::atomic<bool> is_texture_benchmark_running{false};
+				static std::atomic<int> texture_benchmark_files_done{0};
+				static TextureDecodeBenchmarkResult texture_benchmark_result;
+				static bool has_texture_benchmark_result = false;
+
+				if (is_texture_benchmark_running.load()) {
+					ImGui::Text("Decoding textures: %d / %d", texture_benchmark_files_done.load(), dat_manager->get_num_files());
+				}
+				else {
+					if (ImGui::Button("Benchmark texture decoding")) {
+						is_texture_benchmark_running.store(true);
+						texture_benchmark_files_done.store(0);
+
+						std::thread([dat_manager]() {
+							texture_benchmark_result = dat_manager->benchmark_texture_decoding(&texture_benchmark_files_done);
+							has_texture_benchmark_result = true;
+							is_texture_benchmark_running.store(false);
+						}).detach();
+					}
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("Decodes the DXT blocks of every ATEX/ATTX texture in the dat with both the SIMD and the reference decoder,\nverifies that their output is identical and reports their throughput.");
+					}
+
+					if (has_texture_benchmark_result) {
+						ImGui::Text("Textures: %d (%.1f MPixels)", texture_benchmark_result.num_textures, texture_benchmark_result.num_pixels / 1e6);
+						ImGui::Text("%s: %.1f MPixels/s (%.2f s)", texture_benchmark_result.decoder_name,
+							texture_benchmark_result.mpixels_per_second(), texture_benchmark_result.seconds);
+						ImGui::Text("Reference: %.1f MPixels/s (%.2f s)", texture_benchmark_result.reference_mpixels_per_second(), texture_benchmark_result.reference_seconds);
+						ImGui::Text("Mismatches: %d", texture_benchmark_result.num_mismatches);
+					}
+				}
+
+				ImGui::Separator();
+
+				static std::atomic<bool> is_atex_benchmark_running{false};
+				static std::atomic<int> atex_benchmark_files_done{0};
+				static AtexDecompressBenchmarkResult atex_benchmark_result;
+				static bool has_atex_benchmark_result = false;
+				static AtexGoldenCorpusResult atex_golden_corpus_result;
+				static bool has_atex_golden_corpus_result = false;
+				static std::atomic<bool> atex_golden_corpus_saved{false};
+
+				if (is_atex_benchmark_running.load()) {
+					ImGui::Text("Decompressing textures: %d / %d", atex_benchmark_files_done.load(), dat_manager->get_num_files());
+				}
+				else {
+					if (ImGui::Button("Benchmark ATEX decompression")) {
+						is_atex_benchmark_running.store(true);
+						atex_benchmark_files_done.store(0);
+
+						std::thread([dat_manager]() {
+							atex_benchmark_result = dat_manager->benchmark_atex_decompression(&atex_benchmark_files_done);
+							has_atex_benchmark_result = true;
+							is_atex_benchmark_running.store(false);
+						}).detach();
+					}
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("Runs the entropy stage of every ATEX/ATTX texture in the dat through both the new and the reference decompressor,\nverifies that they produce the same DXT blocks and reports their throughput.");
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Save ATEX golden corpus")) {
+						std::wstring saveDir = OpenDirectoryDialog();
+						if (!saveDir.empty()) {
+							is_atex_benchmark_running.store(true);
+							atex_benchmark_files_done.store(0);
+
+							std::thread([dat_manager, saveDir]() {
+								atex_golden_corpus_saved.store(dat_manager->save_atex_golden_corpus(
+									std::filesystem::path(saveDir) / L"atex_golden_corpus.gwag", &atex_benchmark_files_done));
+								is_atex_benchmark_running.store(false);
+							}).detach();
+						}
+					}
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("Saves a hash of the DXT blocks the reference decompressor produces for every texture in the dat,\nto check later versions of the decompressor against.");
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Check ATEX golden corpus")) {
+						std::wstring corpusDir = OpenDirectoryDialog();
+						if (!corpusDir.empty()) {
+							is_atex_benchmark_running.store(true);
+							atex_benchmark_files_done.store(0);
+
+							std::thread([dat_manager, corpusDir]() {
+								atex_golden_corpus_result = dat_manager->check_atex_golden_corpus(
+									std::filesystem::path(corpusDir) / L"atex_golden_corpus.gwag", &atex_benchmark_files_done);
+								has_atex_golden_corpus_result = true;
+								is_atex_benchmark_running.store(false);
+							}).detach();
+						}
+					}
+
+					if (has_atex_benchmark_result) {
+						ImGui::Text("Textures: %d (%.1f MBlocks)", atex_benchmark_result.num_textures, atex_benchmark_result.num_blocks / 1e6);
+						ImGui::Text("AtexDecompress: %.1f MBlocks/s (%.2f s)", atex_benchmark_result.mblocks_per_second(), atex_benchmark_result.seconds);
+						ImGui::Text("Reference: %.1f MBlocks/s (%.2f s)", atex_benchmark_result.reference_mblocks_per_second(), atex_benchmark_result.reference_seconds);
+						ImGui::Text("Mismatches: %d", atex_benchmark_result.num_mismatches);
+					}
+					if (atex_golden_corpus_saved.load()) {
+						ImGui::Text("Golden corpus saved");
+					}
+					if (has_atex_golden_corpus_result) {
+						if (atex_golden_corpus_result.loaded) {
+							ImGui::Text("Golden corpus: %d of %d textures checked, %d mismatches", atex_golden_corpus_result.num_checked,
+								atex_golden_corpus_result.num_entries, atex_golden_corpus_result.num_mismatches);
+						}
+						else if (atex_golden_corpus_result.corrupt) {
+							ImGui::Text("atex_golden_corpus.gwag is corrupt");
+						}
+						else {
+							ImGui::Text("Could not read atex_golden_corpus.gwag");
+						}
+					}
+				}
+
+				ImGui::Separator();
+
+				// The dat's file cache, which every map, model, texture and animation read goes through.
+				auto& file_cache = dat_manager->get_file_cache();
+				const auto file_cache_stats = file_cache.GetStats();
+				ImGui::Text("File cache: %zu files, %.1f of %.1f MB", file_cache_stats.totalFiles,
+					file_cache_stats.totalMemory / (1024.0 * 1024.0), file_cache_stats.maxMemory / (1024.0 * 1024.0));
+				ImGui::Text("%llu hits, %llu misses, %llu evictions, %llu coalesced", file_cache_stats.totalHits,
+					file_cache_stats.totalMisses, file_cache_stats.totalEvictions, file_cache_stats.totalCoalesced);
+
+				int cache_policy = static_cast<int>(file_cache.GetPolicy());
+				const char* cache_policies[] = { GW::Cache::GetCachePolicyName(GW::Cache::CachePolicyType::LRU),
+					GW::Cache::GetCachePolicyName(GW::Cache::CachePolicyType::WTinyLFU),
+					GW::Cache::GetCachePolicyName(GW::Cache::CachePolicyType::GDSF) };
+				if (ImGui::Combo("File cache policy", &cache_policy, cache_policies, IM_ARRAYSIZE(cache_policies))) {
+					file_cache.SetPolicy(static_cast<GW::Cache::CachePolicyType>(cache_policy));
+				}
+
+				static std::vector<GW::Cache::CacheTraceEvent> cache_trace;
+				static std::atomic<bool> is_cache_replay_running{false};
+				static std::vector<GW::Cache::CacheReplayResult> cache_replay_results;
+				static int cache_replay_capacity_mb = static_cast<int>(file_cache.GetMaxMemory() / (1024 * 1024));
+
+				if (dat_manager->is_recording_cache_trace()) {
+					ImGui::Text("Recording file reads: %zu", dat_manager->get_cache_trace_event_count());
+					if (ImGui::Button("Stop recording")) {
+						cache_trace = dat_manager->stop_cache_trace();
+					}
+				}
+				else if (is_cache_replay_running.load()) {
+					ImGui::Text("Replaying %zu file reads...", cache_trace.size());
+				}
+				else {
+					if (ImGui::Button("Record file reads")) {
+						cache_replay_results.clear();
+						dat_manager->start_cache_trace();
+					}
+					if (ImGui::IsItemHovered())
+					{
+						ImGui::SetTooltip("Records every request to the file cache while you use the app (browse maps, run searches...).\nThe recording can then be replayed against each cache eviction policy to compare their hit rates.");
+					}
+
+					if (!cache_trace.empty()) {
+						ImGui::SameLine();
+						ImGui::Text("%zu reads recorded", cache_trace.size());
+
+						ImGui::InputInt("Cache size (MB)", &cache_replay_capacity_mb, 16, 64);
+						cache_replay_capacity_mb = std::clamp(cache_replay_capacity_mb, 1, 16384);
+
+						if (ImGui::Button("Replay against cache policies")) {
+							is_cache_replay_running.store(true);
+							const size_t capacity = static_cast<size_t>(cache_replay_capacity_mb) * 1024 * 1024;
+							std::thread([capacity]() {
+								cache_replay_results = GW::Cache::ReplayCacheTraceAllPolicies(cache_trace, capacity);
+								is_cache_replay_running.store(false);
+							}).detach();
+						}
+						ImGui::SameLine();
+						if (ImGui::Button("Save recording")) {
+							std::wstring saveDir = OpenDirectoryDialog();
+							if (!saveDir.empty()) {
+								GW::Cache::SaveCacheTrace(std::filesystem::path(saveDir) / L"cache_trace.gwct", cache_trace);
+							}
+						}
+					}
+
+					for (const auto& result : cache_replay_results) {
+						ImGui::Text("%-10s hit rate %5.1f%%  byte hit rate %5.1f%%  load time saved %5.1f%%",
+							GW::Cache::GetCachePolicyName(result.policy), result.HitRate() * 100,
+							result.ByteHitRate() * 100, result.CostSavedRate() * 100);
+					}
+				}
+			}
 		}
 		ImGui::End();
 	}
@@ -1,5 +1,6 @@
 #pragma once
 #include "DATManager.h"
+#include "MipmapGenerator.h"
 
 namespace ExtractPanel {
     enum ExtractPanelMapFileType {
@@ -22,6 +23,7 @@ struct ExtractPanelInfo {
     std::wstring save_directory = L"";
     ExtractPanel::ExtractPanelMapFileType map_render_extract_file_type = ExtractPanel::DDS;
     ExtractPanel::ExtractMapType map_render_extract_map_type = ExtractPanel::CurrentMapNoViewChange;
+    MipFilter dds_mip_filter = MipFilter::Box;
 };
 
 void draw_extract_panel(ExtractPanelInfo& extract_panel_info, DATManager* dat_manager);
\ No newline at end of file
@@ -153,7 +153,7 @@ void draw_left_panel(MapRenderer* map_renderer)
 
                 int i = 0;
                 int k = 0;
-                for (const auto& file_data : selected_map_files)
+                for (auto& file_data : selected_map_files)
                 {
                     i++;
                     if (auto ffna_model_file_ptr = std::get_if<FFNA_ModelFile>(&file_data))
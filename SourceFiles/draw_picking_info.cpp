@@ -122,7 +122,7 @@ void draw_picking_info(const PickingInfo& info, MapRenderer* map_renderer, DATMa
                     std::get_if<FFNA_ModelFile>(&selected_map_files[prop_info.filename_index]))
                 {
                     ImGui::Separator();
-                    const std::vector<GeometryModel> models = ffna_model_file_ptr->geometry_chunk.models;
+                    const std::vector<GeometryModel> models = ffna_model_file_ptr->get_geometry_chunk().models;
                     ImGui::Text("Num models: %d", models.size());
 
                     // Show info per sub-model:
@@ -137,7 +137,7 @@ void draw_picking_info(const PickingInfo& info, MapRenderer* map_renderer, DATMa
 
                         if (ImGui::TreeNodeEx(treeNodeLabel.c_str(), flags))
                         {
-                            const auto uts1 = ffna_model_file_ptr->geometry_chunk.uts1;
+                            const auto uts1 = ffna_model_file_ptr->get_geometry_chunk().uts1;
                             if (uts1.size() > 0)
                             {
                                 ImGui::Text("some_flags0: %u", uts1[i % uts1.size()].some_flags0);
@@ -171,7 +171,7 @@ void draw_picking_info(const PickingInfo& info, MapRenderer* map_renderer, DATMa
                                         ImGui::Text("Has Tex Coord %d: %s", j, first_vertex.has_tex_coord[j] ? "True" : "False");
                                     }
 
-                                    const auto& uts0 = ffna_model_file_ptr->geometry_chunk.tex_and_vertex_shader_struct.uts0;
+                                    const auto& uts0 = ffna_model_file_ptr->get_geometry_chunk().tex_and_vertex_shader_struct.uts0;
                                     if (model.unknown >= uts0.size()) { ImGui::Text("model index: %d (%d) >= uts0.size(): %d", i, model.unknown, uts0.size()); }
 
                                     if (uts0.size() > 0)
@@ -184,14 +184,14 @@ void draw_picking_info(const PickingInfo& info, MapRenderer* map_renderer, DATMa
                                         ImGui::Text("uts0.f6: %d", uts0_j.pixel_shader_id);
                                         ImGui::Text("uts0.f7 (num textures): %d", uts0_j.f0x7);
 
-                                        const auto& blend_states = ffna_model_file_ptr->geometry_chunk.
+                                        const auto& blend_states = ffna_model_file_ptr->get_geometry_chunk().
                                             tex_and_vertex_shader_struct.blend_state;
                                         for (int j = tex_index; j < std::min(tex_index + (int)uts0_j.f0x7, (int)blend_states.size()); ++j)
                                         {
                                             ImGui::Text("Blend flag %d: %d", j, blend_states[j]);
                                         }
 
-                                        const auto& texture_flags = ffna_model_file_ptr->geometry_chunk.
+                                        const auto& texture_flags = ffna_model_file_ptr->get_geometry_chunk().
                                             tex_and_vertex_shader_struct.flags0;
                                         for (int j = tex_index; j < std::min(tex_index + (int)uts0_j.f0x7, (int)texture_flags.size()); ++j)
                                         {
@@ -284,11 +284,11 @@ void draw_picking_info(const PickingInfo& info, MapRenderer* map_renderer, DATMa
                             {
                                 parse_file(dat_manager, file_index, map_renderer, hash_index);
 
-                                for (int tex_index = 0; tex_index < ffna_model_file_ptr->texture_filenames_chunk.
+                                for (int tex_index = 0; tex_index < ffna_model_file_ptr->get_texture_filenames_chunk().
                                     texture_filenames.
                                     size(); tex_index++)
                                 {
-                                    const auto& texture_filename = ffna_model_file_ptr->texture_filenames_chunk.
+                                    const auto& texture_filename = ffna_model_file_ptr->get_texture_filenames_chunk().
                                         texture_filenames[tex_index];
 
                                     auto decoded_filename = decode_filename(texture_filename.id0, texture_filename.id1);
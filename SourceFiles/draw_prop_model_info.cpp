@@ -1,14 +1,14 @@
 #include "pch.h"
 #include "draw_prop_model_info.h"
 
-void draw_prop_model_info(const FFNA_ModelFile& model)
+void draw_prop_model_info(FFNA_ModelFile& model)
 {
     ImGui::Text("FFNA Signature: %.4s", model.ffna_signature);
     ImGui::Text("FFNA Type: %d", model.ffna_type);
 
     if (ImGui::TreeNode("Geometry Chunk"))
     {
-        const GeometryChunk& geometry_chunk = model.geometry_chunk;
+        const GeometryChunk& geometry_chunk = model.get_geometry_chunk();
         ImGui::Text("Chunk ID: %u", geometry_chunk.chunk_id);
         ImGui::Text("Chunk Size: %u", geometry_chunk.chunk_size);
 
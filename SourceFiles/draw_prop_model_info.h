@@ -1,4 +1,4 @@
 #pragma once
 #include "FFNA_ModelFile.h"
 
-void draw_prop_model_info(const FFNA_ModelFile& model);
+void draw_prop_model_info(FFNA_ModelFile& model);
@@ -108,6 +108,16 @@ void draw_texture_panel(MapRenderer* map_renderer)
                     TexPanelExportDDS(texture_data, savePath, compression_format);
                 }
             }
+            ImGui::SameLine();
+            if (ImGui::Button("Export Texture as DDS (Original DXT blocks)")) {
+                const auto texture_data = map_renderer->GetTextureManager()->GetTextureDataByHash(selected_dat_texture.file_id);
+                if (texture_data.has_value()) {
+                    std::wstring savePath = OpenFileDialog(std::format(L"texture_{}", selected_dat_texture.file_id), L"dds");
+
+                    const auto compression_format = CompressionFormat::Original;
+                    TexPanelExportDDS(texture_data, savePath, compression_format);
+                }
+            }
         }
 
         // Display model textures (from texture_filenames_chunk) for "other" model format
@@ -402,6 +402,10 @@ void draw_ui(std::map<int, std::unique_ptr<DATManager>>& dat_managers, int& dat_
 		{
 			draw_dat_load_progress_bar(dat_files_read, dat_total_files);
 		}
+		if (dat_managers[dat_manager_to_show]->is_reading_content_info())
+		{
+			draw_dat_load_progress_bar(dat_managers[dat_manager_to_show]->get_num_files_content_info_read(), dat_total_files);
+		}
 		if (initialization_state == InitializationState::Completed)
 		{
 			draw_data_browser(dat_managers[dat_manager_to_show].get(), map_renderer, dat_manager_to_show_changed, dat_compare_filter_result, dat_compare_filter_result_changed, csv_data, custom_file_info_changed);
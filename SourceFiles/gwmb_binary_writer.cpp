@@ -0,0 +1,86 @@
+#include "pch.h"
+#include "gwmb_binary_writer.h"
+
+// Defined in writeHeighMapBMP.cpp, which compiles the stb_image_write implementation.
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+namespace
+{
+// Compressing chunks smaller than this isn't worth the time.
+constexpr size_t min_compressed_chunk_size = 4096;
+// Compression level of stbi_zlib_compress.
+constexpr int zlib_quality = 5;
+}
+
+gwmb_binary_writer::gwmb_binary_writer(std::ostream& out, std::string_view content, bool compress_chunks)
+    : m_out(out)
+    , m_compress_chunks(compress_chunks)
+{
+    char header[16] = { 'G', 'W', 'M', 'B' };
+    memcpy(header + 4, &version, sizeof(version));
+    memcpy(header + 8, content.data(), std::min<size_t>(content.size(), 4));
+    write_bytes(header, sizeof(header));
+}
+
+bool gwmb_binary_writer::write_chunk(std::string_view id, const void* data, size_t size)
+{
+    chunk_entry entry{};
+    memcpy(entry.id, id.data(), std::min<size_t>(id.size(), 4));
+    entry.compression = stored;
+    entry.offset = m_offset;
+    entry.size = size;
+    entry.stored_size = size;
+
+    const void* stored_data = data;
+    unsigned char* compressed = nullptr;
+    if (m_compress_chunks && size >= min_compressed_chunk_size && size <= INT_MAX)
+    {
+        int compressed_size = 0;
+        compressed = stbi_zlib_compress(static_cast<unsigned char*>(const_cast<void*>(data)), static_cast<int>(size),
+                                        &compressed_size, zlib_quality);
+        if (compressed && static_cast<size_t>(compressed_size) < size)
+        {
+            entry.compression = zlib;
+            entry.stored_size = compressed_size;
+            stored_data = compressed;
+        }
+    }
+
+    // The chunk header is the table entry without the offset.
+    write_bytes(entry.id, sizeof(entry.id));
+    write_bytes(&entry.compression, sizeof(entry.compression));
+    write_bytes(&entry.stored_size, sizeof(entry.stored_size));
+    write_bytes(&entry.size, sizeof(entry.size));
+    write_bytes(stored_data, static_cast<size_t>(entry.stored_size));
+    free(compressed);
+
+    m_chunks.push_back(entry);
+    return static_cast<bool>(m_out);
+}
+
+bool gwmb_binary_writer::finish()
+{
+    const uint64_t chunk_table_offset = m_offset;
+    for (const auto& entry : m_chunks)
+    {
+        write_bytes(entry.id, sizeof(entry.id));
+        write_bytes(&entry.compression, sizeof(entry.compression));
+        write_bytes(&entry.offset, sizeof(entry.offset));
+        write_bytes(&entry.stored_size, sizeof(entry.stored_size));
+        write_bytes(&entry.size, sizeof(entry.size));
+    }
+
+    const uint32_t num_chunks = static_cast<uint32_t>(m_chunks.size());
+    write_bytes(&chunk_table_offset, sizeof(chunk_table_offset));
+    write_bytes(&num_chunks, sizeof(num_chunks));
+    write_bytes("GWMT", 4);
+
+    m_out.flush();
+    return static_cast<bool>(m_out);
+}
+
+void gwmb_binary_writer::write_bytes(const void* data, size_t size)
+{
+    m_out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    m_offset += size;
+}
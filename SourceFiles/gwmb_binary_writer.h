@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// GWMB binary container, the binary alternative to the .json exports. All values are little-endian.
+//
+//   file header: char magic[4] = "GWMB", uint32 version, char content[4] ("MAP " for maps), uint32 reserved
+//   chunks:      chunk header { char id[4], uint32 compression, uint64 stored_size, uint64 size },
+//                followed by stored_size bytes
+//   chunk table: { char id[4], uint32 compression, uint64 offset, uint64 stored_size, uint64 size } per chunk,
+//                offset being the offset of the chunk header
+//   footer:      uint64 chunk_table_offset, uint32 num_chunks, char magic[4] = "GWMT"
+//
+// Readers can walk the chunks from the start or jump to them through the footer. Unknown chunks are
+// skipped, so new ones can be added without a version bump. compression is 0 (stored) or 1 (zlib).
+class gwmb_binary_writer
+{
+public:
+    static constexpr uint32_t version = 1;
+
+    enum compression_type : uint32_t
+    {
+        stored = 0,
+        zlib = 1,
+    };
+
+    // Writes the file header. With compress_chunks, chunks are zlib compressed when that makes them smaller.
+    gwmb_binary_writer(std::ostream& out, std::string_view content, bool compress_chunks);
+
+    // Writes a chunk straight to the stream. id must be 4 characters.
+    bool write_chunk(std::string_view id, const void* data, size_t size);
+
+    template <typename T>
+    bool write_array_chunk(std::string_view id, const std::vector<T>& elements)
+    {
+        return write_chunk(id, elements.data(), elements.size() * sizeof(T));
+    }
+
+    // Writes the chunk table and the footer. Returns false if any write failed.
+    bool finish();
+
+private:
+    struct chunk_entry
+    {
+        char id[4];
+        uint32_t compression;
+        uint64_t offset;
+        uint64_t stored_size;
+        uint64_t size;
+    };
+
+    void write_bytes(const void* data, size_t size);
+
+    std::ostream& m_out;
+    bool m_compress_chunks;
+    uint64_t m_offset = 0;
+    std::vector<chunk_entry> m_chunks;
+};
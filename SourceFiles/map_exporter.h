@@ -1,6 +1,7 @@
 #pragma once
 #include "model_exporter.h"
 #include "Terrain.h"
+#include "gwmb_binary_writer.h"
 
 struct gwmb_map_vertex
 {
@@ -51,6 +52,17 @@ struct gwmb_map
     float min_x, max_x, min_y, max_y, min_z, max_z;
 };
 
+// The chunks write_gwmb_map_binary writes the map as. The arrays are written as they are in memory.
+static_assert(sizeof(gwmb_map_vertex) == 14 * sizeof(float), "TVTX stores gwmb_map_vertex as 14 packed floats");
+static_assert(sizeof(gwmb_map_model) == sizeof(int) + 13 * sizeof(float), "MODL stores gwmb_map_model packed");
+
+enum class gwmb_map_format
+{
+    binary, // map_<hash>.gwmb, see gwmb_binary_writer.h
+    binary_compressed, // The same with the large chunks zlib compressed
+    json, // map_<hash>.json, the format from before the binary one
+};
+
 namespace nlohmann {
     template<>
     struct adl_serializer<gwmb_map_vertex> {
@@ -150,255 +162,312 @@ namespace nlohmann {
 class map_exporter
 {
 public:
-    static bool export_map(const std::wstring& save_directory, const int map_filehash, const int map_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const bool json_pretty_print = false) {
+    static bool export_map(const std::wstring& save_directory, const int map_filehash, const int map_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const bool json_pretty_print = false, const gwmb_map_format format = gwmb_map_format::binary) {
         // Build model
         gwmb_map map;
         const bool success = generate_gwmb_map(save_directory, map, map_mft_index, dat_manager, hash_index, texture_manager, map_filehash);
         if (!success)
             return false;
 
-        const nlohmann::json j = map;
-
-        std::filesystem::path file_path = std::filesystem::path(save_directory) / ("map_" + std::to_string(map_filehash) + ".json");
+        std::filesystem::path file_path = std::filesystem::path(save_directory) / get_map_filename(map_filehash, format);
 
-        std::ofstream file(file_path);
+        std::ofstream file(file_path, std::ios::binary);
         if (!file) {
             return false;
         }
 
-        file << (json_pretty_print ? j.dump(4) : j.dump());
+        if (format == gwmb_map_format::json) {
+            const nlohmann::json j = map;
+            file << (json_pretty_print ? j.dump(4) : j.dump());
+        }
+        else if (!write_gwmb_map_binary(file, map, format == gwmb_map_format::binary_compressed)) {
+            return false;
+        }
         file.close();
 
         return true; // Successfully exported the model
     }
 
-private:
-    static bool generate_gwmb_map(const std::wstring& save_directory, gwmb_map& map, int map_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, int map_filehash) {
-        auto map_file = dat_manager->parse_ffna_map_file(map_mft_index);
+    static std::wstring get_map_filename(const int map_filehash, const gwmb_map_format format) {
+        return L"map_" + std::to_wstring(map_filehash) + (format == gwmb_map_format::json ? L".json" : L".gwmb");
+    }
 
-        map.filehash = map_filehash;
+    // Writes the map as a GWMB binary file with the content type "MAP ". The chunks are
+    //   INFO: int32 filehash, int32 terrain width, int32 terrain height, float min_x, max_x, min_y, max_y, min_z, max_z
+    //   TVTX: the terrain vertices, 14 floats each: pos, normal, uv_coord0, uv_coord1, uv_coord2, uv_coord3
+    //   TIDX: the terrain indices, uint32 each
+    //   TTEX: the terrain textures, int32 file_hash, width, height, texture_type each
+    //   MODL: the props, int32 model_hash followed by 13 floats: world_pos, model_right, model_up, model_look, scale
+    static bool write_gwmb_map_binary(std::ostream& out, const gwmb_map& map, const bool compress_chunks) {
+        gwmb_binary_writer writer(out, "MAP ", compress_chunks);
+
+        const int32_t info_ints[3] = { map.filehash, map.terrain.width, map.terrain.height };
+        const float info_bounds[6] = { map.min_x, map.max_x, map.min_y, map.max_y, map.min_z, map.max_z };
+        char info[sizeof(info_ints) + sizeof(info_bounds)];
+        memcpy(info, info_ints, sizeof(info_ints));
+        memcpy(info + sizeof(info_ints), info_bounds, sizeof(info_bounds));
+        writer.write_chunk("INFO", info, sizeof(info));
+
+        writer.write_array_chunk("TVTX", map.terrain.vertices);
+        writer.write_array_chunk("TIDX", map.terrain.indices);
+
+        std::vector<int32_t> textures;
+        textures.reserve(map.terrain.textures.size() * 4);
+        for (const auto& texture : map.terrain.textures) {
+            textures.insert(textures.end(), { texture.file_hash, texture.width, texture.height, static_cast<int32_t>(texture.texture_type) });
+        }
+        writer.write_array_chunk("TTEX", textures);
 
-        if (map_file.terrain_chunk.terrain_heightmap.size() > 0 &&
-            map_file.terrain_chunk.terrain_heightmap.size() ==
-            map_file.terrain_chunk.terrain_x_dims *
-            map_file.terrain_chunk.terrain_y_dims)
+        writer.write_array_chunk("MODL", map.models);
+
+        return writer.finish();
+    }
+
+    // The terrain textures of the map that are in the dat, in the order the terrain uses them.
+    static std::vector<gwmb_file_ref> get_terrain_texture_refs(const FFNA_MapFileView& map_file, const std::unordered_map<int, std::vector<int>>& hash_index) {
+        std::vector<gwmb_file_ref> texture_refs;
+        for (const auto& texture_filename : map_file.terrain_texture_filenames.array)
         {
-            // First add terrain textures
-            gwmb_terrain new_terrain;
-            const auto& terrain_texture_filenames = map_file.terrain_texture_filenames.array;
-            std::vector<DatTexture> terrain_dat_textures;
-            for (int i = 0; i < terrain_texture_filenames.size(); i++)
+            const auto decoded_filename = decode_filename(texture_filename.filename.id0, texture_filename.filename.id1);
+
+            // Jade Quarry, Island of Jade. Each on them uses a normal map as their first texture.
+            if (decoded_filename == 0x25e09 || decoded_filename == 0x00028615)
             {
-                auto decoded_filename =
-                    decode_filename(map_file.terrain_texture_filenames.array[i].filename.id0,
-                        map_file.terrain_texture_filenames.array[i].filename.id1);
+                continue;
+            }
 
-                // Jade Quarry, Island of Jade. Each on them uses a normal map as their first texture.
-                if (decoded_filename == 0x25e09 || decoded_filename == 0x00028615)
-                {
-                    continue;
-                }
+            const auto mft_entry_it = hash_index.find(decoded_filename);
+            if (mft_entry_it != hash_index.end())
+            {
+                texture_refs.push_back({ static_cast<int>(decoded_filename), mft_entry_it->second.at(0) });
+            }
+        }
+        return texture_refs;
+    }
 
-                auto mft_entry_it = hash_index.find(decoded_filename);
+    // The prop models of the map that are in the dat. Each one is exported to its own model_0x<hash>_gwmb.json
+    // and the props of the map refer to them by their index in this list.
+    static std::vector<gwmb_file_ref> get_prop_model_refs(const FFNA_MapFileView& map_file, DATManager* dat_manager, const std::unordered_map<int, std::vector<int>>& hash_index) {
+        std::vector<gwmb_file_ref> model_refs;
+        const auto add_models = [&](const auto& filenames) {
+            for (const auto& prop_filename : filenames)
+            {
+                const auto decoded_filename = decode_filename(prop_filename.filename.id0, prop_filename.filename.id1);
+                const auto mft_entry_it = hash_index.find(decoded_filename);
                 if (mft_entry_it != hash_index.end())
                 {
-                    const DatTexture dat_texture =
-                        dat_manager->parse_ffna_texture_file(mft_entry_it->second.at(0));
-                    int texture_id = -1;
-                    auto HR = texture_manager->CreateTextureFromRGBA(dat_texture.width,
-                        dat_texture.height, dat_texture.rgba_data.data(), &texture_id,
-                        decoded_filename);
-
-                    if (dat_texture.width > 0 && dat_texture.height > 0) {
-                        gwmb_texture gwmb_texture_i;
-                        gwmb_texture_i.file_hash = decoded_filename;
-                        gwmb_texture_i.height = dat_texture.height;
-                        gwmb_texture_i.width = dat_texture.width;
-                        gwmb_texture_i.texture_type = dat_texture.texture_type;
-
-                        ID3D11ShaderResourceView* texture = texture_manager->GetTexture(texture_id);
-
-                        std::wstring texture_save_path = save_directory + L"\\" + std::to_wstring(gwmb_texture_i.file_hash) + L".png";
-                        std::wstring texture_save_pathw = std::wstring(texture_save_path.begin(), texture_save_path.end());
-
-                        if (!SaveTextureToPng(texture, texture_save_pathw, texture_manager))
-                        {
-                            throw "Unable to save texture to png while creating terrain texture";
-                        }
-
-                        terrain_dat_textures.push_back(dat_texture);
-                        new_terrain.textures.push_back(gwmb_texture_i);
+                    const auto& entry = dat_manager->get_MFT()[mft_entry_it->second.at(0)];
+                    if (entry.type == FFNA_Type2) {
+                        model_refs.push_back({ static_cast<int>(decoded_filename), mft_entry_it->second.at(0) });
                     }
                 }
             }
+        };
+        add_models(map_file.prop_filenames_chunk.array);
+        add_models(map_file.more_filnames_chunk.array);
+        return model_refs;
+    }
 
-            // Insert transparent texture at slot 0 (neutral texture)
-            // The terrain generation uses tex_idx -1 -> atlas_idx 0 for neutral/transparent
-            // and tex_idx 0+ -> atlas_idx 1+ for actual textures
-            DatTexture neutral_texture;
-            neutral_texture.width = 256;
-            neutral_texture.height = 256;
-            neutral_texture.rgba_data.resize(256 * 256, {0, 0, 0, 0}); // Fully transparent
-            terrain_dat_textures.insert(terrain_dat_textures.begin(), neutral_texture);
+    // Builds the terrain atlas from the terrain textures, with a transparent texture in slot 0.
+    static DatTexture build_terrain_atlas(std::vector<DatTexture> terrain_dat_textures) {
+        // Insert transparent texture at slot 0 (neutral texture)
+        // The terrain generation uses tex_idx -1 -> atlas_idx 0 for neutral/transparent
+        // and tex_idx 0+ -> atlas_idx 1+ for actual textures
+        DatTexture neutral_texture;
+        neutral_texture.width = 256;
+        neutral_texture.height = 256;
+        neutral_texture.rgba_data.resize(256 * 256, {0, 0, 0, 0}); // Fully transparent
+        terrain_dat_textures.insert(terrain_dat_textures.begin(), neutral_texture);
+
+        return TextureManager::BuildTextureAtlas(terrain_dat_textures, 8, 8);
+    }
 
-            // Save terrain textures in texture atlas
-            int terrain_tex_atlas_tex_id = -1;
-            const auto terrain_tex_atlas = texture_manager->BuildTextureAtlas(terrain_dat_textures, 8, 8);
+    // Fills in the terrain mesh, its size and the map bounds. Returns false if the map has no valid heightmap.
+    // The terrain textures are left to the caller.
+    static bool generate_gwmb_terrain(gwmb_map& map, const FFNA_MapFileView& map_file) {
+        if (map_file.terrain_chunk.terrain_heightmap.size() == 0 ||
+            map_file.terrain_chunk.terrain_heightmap.size() !=
+            map_file.terrain_chunk.terrain_x_dims *
+            map_file.terrain_chunk.terrain_y_dims)
+        {
+            return false;
+        }
 
-            if (terrain_tex_atlas.width > 0 && terrain_tex_atlas.height > 0)
-            {
-                texture_manager->CreateTextureFromRGBA(
-                    terrain_tex_atlas.width,
-                    terrain_tex_atlas.height,
-                    terrain_tex_atlas.rgba_data.data(), 
-                    &terrain_tex_atlas_tex_id,
-                    -1);
-            }
-            else {
-                throw "terrain texture atlas could not be created";
-            }
+        auto& terrain_texture_indices =
+            map_file.terrain_chunk.terrain_texture_indices_maybe;
+
+        auto& terrain_shadow_map =
+            map_file.terrain_chunk.terrain_shadow_map;
+
+        // Create terrain
+        const auto terrain = std::make_unique<Terrain>(map_file.terrain_chunk.terrain_x_dims,
+            map_file.terrain_chunk.terrain_y_dims,
+            map_file.terrain_chunk.terrain_heightmap,
+            terrain_texture_indices, terrain_shadow_map,
+            map_file.map_info_chunk.map_bounds);
+
+        map.min_x = terrain->m_bounds.map_min_x;
+        map.max_x = terrain->m_bounds.map_max_x;
+        map.min_y = terrain->m_bounds.map_min_y;
+        map.max_y = terrain->m_bounds.map_max_y;
+        map.min_z = terrain->m_bounds.map_min_z;
+        map.max_z = terrain->m_bounds.map_max_z;
+
+        auto& new_terrain = map.terrain;
+        const auto terrain_mesh = terrain->get_mesh();
+        new_terrain.vertices.resize(terrain_mesh->vertices.size());
+        for (int i = 0; i < terrain_mesh->vertices.size(); i++) {
+            const auto& vertex = terrain_mesh->vertices[i];
+
+            gwmb_map_vertex new_gwmb_map_vertex;
+            new_gwmb_map_vertex.pos = { vertex.position.x, vertex.position.y, vertex.position.z };
+            new_gwmb_map_vertex.normal = { vertex.normal.x, vertex.normal.y, vertex.normal.z };
+
+            // Copy all 4 UV coordinates pre-computed during terrain generation
+            new_gwmb_map_vertex.uv_coord0 = { vertex.tex_coord0.x, vertex.tex_coord0.y };
+            new_gwmb_map_vertex.uv_coord1 = { vertex.tex_coord1.x, vertex.tex_coord1.y };
+            new_gwmb_map_vertex.uv_coord2 = { vertex.tex_coord2.x, vertex.tex_coord2.y };
+            new_gwmb_map_vertex.uv_coord3 = { vertex.tex_coord3.x, vertex.tex_coord3.y };
+
+            new_terrain.vertices[i] = new_gwmb_map_vertex;
+        }
 
-            ID3D11ShaderResourceView* texture =
-                texture_manager->GetTexture(terrain_tex_atlas_tex_id);
+        new_terrain.indices.resize(terrain_mesh->indices.size());
+        for (int i = 0; i < terrain_mesh->indices.size(); i++) {
+            const auto index = terrain_mesh->indices[i];
+            new_terrain.indices[i] = index;
+        }
 
-            std::wstring texture_save_path = save_directory + L"\\" + L"atlas_" + std::to_wstring(map_filehash) + L".png";
-            std::wstring texture_save_pathw = std::wstring(texture_save_path.begin(), texture_save_path.end());
+        new_terrain.width = terrain->m_grid_dim_x;
+        new_terrain.height = terrain->m_grid_dim_z;
 
-            if (!SaveTextureToPng(texture, texture_save_pathw, texture_manager))
+        return true;
+    }
+
+    // Adds the model transform of every prop to the map. model_refs is what get_prop_model_refs returned.
+    static void generate_gwmb_map_models(gwmb_map& map, const FFNA_MapFileView& map_file, const std::vector<gwmb_file_ref>& model_refs) {
+        for (int i = 0; i < map_file.props_info_chunk.prop_array.props_info.size(); i++)
+        {
+            const auto& prop_info = map_file.props_info_chunk.prop_array.props_info[i];
+            const int model_filename_index = prop_info.filename_index;
+            if (model_filename_index < 0 || model_filename_index >= model_refs.size())
             {
-                throw "Unable to save texture to png while terrain texture atlas";
+                continue;
             }
+            const int model_hash = model_refs[model_filename_index].file_hash;
 
+            // rotation
+            XMFLOAT3 translation(prop_info.x, prop_info.y, prop_info.z);
 
-            // Now add the terrain mesh
-            auto& terrain_texture_indices =
-                map_file.terrain_chunk.terrain_texture_indices_maybe;
+            XMFLOAT3 vec1{ prop_info.f4, -prop_info.f6, prop_info.f5 };
+            XMFLOAT3 vec2{ prop_info.sin_angle, -prop_info.f9, prop_info.cos_angle };
 
-            auto& terrain_shadow_map =
-                map_file.terrain_chunk.terrain_shadow_map;
+            // Load vectors into XMVECTORs
+            XMVECTOR v2 = XMLoadFloat3(&vec1);
+            XMVECTOR v3 = XMLoadFloat3(&vec2);
 
-            // Create terrain
-            const auto terrain = std::make_unique<Terrain>(map_file.terrain_chunk.terrain_x_dims,
-                map_file.terrain_chunk.terrain_y_dims,
-                map_file.terrain_chunk.terrain_heightmap,
-                terrain_texture_indices, terrain_shadow_map,
-                map_file.map_info_chunk.map_bounds);
+            // Compute the third orthogonal vector with cross product
+            // Note: This is for left-handed coordinate systems
+            XMVECTOR v1 = XMVector3Cross(v3, v2);
 
-            map.min_x = terrain->m_bounds.map_min_x;
-            map.max_x = terrain->m_bounds.map_max_x;
-            map.min_y = terrain->m_bounds.map_min_y;
-            map.max_y = terrain->m_bounds.map_max_y;
-            map.min_z = terrain->m_bounds.map_min_z;
-            map.max_z = terrain->m_bounds.map_max_z;
+            // Ensure all vectors are normalized
+            v1 = XMVector3Normalize(v1); // Right
+            v2 = XMVector3Normalize(v2); // Up
+            v3 = XMVector3Normalize(v3); // Look
 
-            const auto terrain_mesh = terrain->get_mesh();
-            new_terrain.vertices.resize(terrain_mesh->vertices.size());
-            for (int i = 0; i < terrain_mesh->vertices.size(); i++) {
-                const auto& vertex = terrain_mesh->vertices[i];
+            gwmb_map_model new_map_model;
+            new_map_model.model_hash = model_hash;
+            new_map_model.scale = prop_info.scaling_factor;
+            new_map_model.world_pos = { prop_info.x, prop_info.y, prop_info.z };
+            new_map_model.model_right = { -v1.m128_f32[0], -v1.m128_f32[1], v1.m128_f32[2] };
+            new_map_model.model_up = { v2.m128_f32[0], v2.m128_f32[1], v2.m128_f32[2] };
+            new_map_model.model_look = { -v3.m128_f32[0], -v3.m128_f32[1], v3.m128_f32[2] };
 
-                gwmb_map_vertex new_gwmb_map_vertex;
-                new_gwmb_map_vertex.pos = { vertex.position.x, vertex.position.y, vertex.position.z };
-                new_gwmb_map_vertex.normal = { vertex.normal.x, vertex.normal.y, vertex.normal.z };
+            map.models.push_back(new_map_model);
+        }
+    }
 
-                // Copy all 4 UV coordinates pre-computed during terrain generation
-                new_gwmb_map_vertex.uv_coord0 = { vertex.tex_coord0.x, vertex.tex_coord0.y };
-                new_gwmb_map_vertex.uv_coord1 = { vertex.tex_coord1.x, vertex.tex_coord1.y };
-                new_gwmb_map_vertex.uv_coord2 = { vertex.tex_coord2.x, vertex.tex_coord2.y };
-                new_gwmb_map_vertex.uv_coord3 = { vertex.tex_coord3.x, vertex.tex_coord3.y };
+private:
+    static bool generate_gwmb_map(const std::wstring& save_directory, gwmb_map& map, int map_mft_index, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, int map_filehash) {
+        const auto map_file = dat_manager->parse_ffna_map_file_view(map_mft_index);
 
-                new_terrain.vertices[i] = new_gwmb_map_vertex;
-            }
+        map.filehash = map_filehash;
 
-            new_terrain.indices.resize(terrain->get_mesh()->indices.size());
-            for (int i = 0; i < terrain_mesh->indices.size(); i++) {
-                const auto index = terrain_mesh->indices[i];
-                new_terrain.indices[i] = index;
-            }
+        if (!generate_gwmb_terrain(map, map_file))
+        {
+            return false;
+        }
 
-            // Now export all the models into their own separate JSON files.
-            std::vector<int> model_hashes;
-            for (int i = 0; i < map_file.prop_filenames_chunk.array.size(); i++)
-            {
-                auto decoded_filename =
-                    decode_filename(map_file.prop_filenames_chunk.array[i].filename.id0,
-                        map_file.prop_filenames_chunk.array[i].filename.id1);
-                auto mft_entry_it = hash_index.find(decoded_filename);
-                if (mft_entry_it != hash_index.end())
-                {
-                    const auto entry = dat_manager->get_MFT()[mft_entry_it->second.at(0)];
-                    if (entry.type == FFNA_Type2) {
-                        // Export model to map folder
-                        model_exporter::export_model(save_directory, std::format(L"model_0x{:X}_gwmb.json", decoded_filename), mft_entry_it->second.at(0), dat_manager, hash_index, texture_manager);
-                        model_hashes.push_back(decoded_filename);
-                    }
-                }
-            }
+        // First add terrain textures
+        std::vector<DatTexture> terrain_dat_textures;
+        for (const auto& texture_ref : get_terrain_texture_refs(map_file, hash_index))
+        {
+            const DatTexture dat_texture =
+                dat_manager->parse_ffna_texture_file(texture_ref.mft_index, false);
+            int texture_id = -1;
+            auto HR = texture_manager->CreateTextureFromDatTexture(dat_texture, &texture_id, texture_ref.file_hash);
 
-            for (int i = 0; i < map_file.more_filnames_chunk.array.size(); i++)
-            {
-                auto decoded_filename =
-                    decode_filename(map_file.more_filnames_chunk.array[i].filename.id0,
-                        map_file.more_filnames_chunk.array[i].filename.id1);
-                auto mft_entry_it = hash_index.find(decoded_filename);
-                if (mft_entry_it != hash_index.end())
+            if (dat_texture.width > 0 && dat_texture.height > 0) {
+                gwmb_texture gwmb_texture_i;
+                gwmb_texture_i.file_hash = texture_ref.file_hash;
+                gwmb_texture_i.height = dat_texture.height;
+                gwmb_texture_i.width = dat_texture.width;
+                gwmb_texture_i.texture_type = dat_texture.texture_type;
+
+                ID3D11ShaderResourceView* texture = texture_manager->GetTexture(texture_id);
+
+                std::wstring texture_save_path = save_directory + L"\\" + std::to_wstring(gwmb_texture_i.file_hash) + L".png";
+                std::wstring texture_save_pathw = std::wstring(texture_save_path.begin(), texture_save_path.end());
+
+                if (!SaveTextureToPng(texture, texture_save_pathw, texture_manager))
                 {
-                    const auto entry = dat_manager->get_MFT()[mft_entry_it->second.at(0)];
-                    if (entry.type == FFNA_Type2) {
-                        // Export model to map folder
-                        model_exporter::export_model(save_directory, std::format(L"model_0x{:X}_gwmb.json", decoded_filename), mft_entry_it->second.at(0), dat_manager, hash_index, texture_manager);
-                        model_hashes.push_back(decoded_filename);
-                    }
+                    throw "Unable to save texture to png while creating terrain texture";
                 }
-            }
 
-            // Finally add the model transform info to the map
-            for (int i = 0; i < map_file.props_info_chunk.prop_array.props_info.size(); i++)
-            {
-                PropInfo prop_info = map_file.props_info_chunk.prop_array.props_info[i];
-                const int model_filename_index = prop_info.filename_index;
-                const int model_hash = model_hashes[model_filename_index];
-
-                // rotation
-                XMFLOAT3 translation(prop_info.x, prop_info.y, prop_info.z);
-
-                XMFLOAT3 vec1{ prop_info.f4, -prop_info.f6, prop_info.f5 };
-                XMFLOAT3 vec2{ prop_info.sin_angle, -prop_info.f9, prop_info.cos_angle };
-
-                // Load vectors into XMVECTORs
-                XMVECTOR v2 = XMLoadFloat3(&vec1);
-                XMVECTOR v3 = XMLoadFloat3(&vec2);
-
-                // Compute the third orthogonal vector with cross product
-                // Note: This is for left-handed coordinate systems
-                XMVECTOR v1 = XMVector3Cross(v3, v2);
-
-                // Ensure all vectors are normalized
-                v1 = XMVector3Normalize(v1); // Right
-                v2 = XMVector3Normalize(v2); // Up
-                v3 = XMVector3Normalize(v3); // Look
-
-                gwmb_map_model new_map_model;
-                new_map_model.model_hash = model_hash;
-                new_map_model.scale = prop_info.scaling_factor;
-                new_map_model.world_pos = { prop_info.x, prop_info.y, prop_info.z };
-                new_map_model.model_right = { -v1.m128_f32[0], -v1.m128_f32[1], v1.m128_f32[2] };
-                new_map_model.model_up = { v2.m128_f32[0], v2.m128_f32[1], v2.m128_f32[2] };
-                new_map_model.model_look = { -v3.m128_f32[0], -v3.m128_f32[1], v3.m128_f32[2] };
-
-                map.models.push_back(new_map_model);
+                terrain_dat_textures.push_back(dat_texture);
+                map.terrain.textures.push_back(gwmb_texture_i);
             }
+        }
+
+        // Save terrain textures in texture atlas
+        int terrain_tex_atlas_tex_id = -1;
+        const auto terrain_tex_atlas = build_terrain_atlas(std::move(terrain_dat_textures));
 
-            new_terrain.width = terrain->m_grid_dim_x;
-            new_terrain.height = terrain->m_grid_dim_z;
+        if (terrain_tex_atlas.width > 0 && terrain_tex_atlas.height > 0)
+        {
+            texture_manager->CreateTextureFromRGBA(
+                terrain_tex_atlas.width,
+                terrain_tex_atlas.height,
+                terrain_tex_atlas.rgba_data.data(), 
+                &terrain_tex_atlas_tex_id,
+                -1);
+        }
+        else {
+            throw "terrain texture atlas could not be created";
+        }
+
+        ID3D11ShaderResourceView* texture =
+            texture_manager->GetTexture(terrain_tex_atlas_tex_id);
+
+        std::wstring texture_save_path = save_directory + L"\\" + L"atlas_" + std::to_wstring(map_filehash) + L".png";
+        std::wstring texture_save_pathw = std::wstring(texture_save_path.begin(), texture_save_path.end());
 
-            map.terrain = new_terrain;
+        if (!SaveTextureToPng(texture, texture_save_pathw, texture_manager))
+        {
+            throw "Unable to save texture to png while terrain texture atlas";
         }
-        else
+
+        // Now export all the models into their own separate JSON files.
+        const auto model_refs = get_prop_model_refs(map_file, dat_manager, hash_index);
+        for (const auto& model_ref : model_refs)
         {
-            return false;
+            // Export model to map folder
+            model_exporter::export_model(save_directory, std::format(L"model_0x{:X}_gwmb.json", model_ref.file_hash), model_ref.mft_index, dat_manager, hash_index, texture_manager);
         }
 
+        // Finally add the model transform info to the map
+        generate_gwmb_map_models(map, map_file, model_refs);
+
         return true;
     }
 };
-
@@ -90,6 +90,13 @@ struct gwmb_submodel {
     PixelShaderType pixel_shader_type;
 };
 
+// A file referenced by a model or map that was found in the dat.
+struct gwmb_file_ref
+{
+    int file_hash;
+    int mft_index;
+};
+
 // GW Map Browser model contains the info required for the export
 struct gwmb_model
 {
@@ -263,99 +270,27 @@ public:
         return export_model_to_file(save_dir, filename, model_file, dat_manager, hash_index, texture_manager, json_pretty_print);
     }
 
-private:
-    static bool export_model_to_file(const std::wstring& save_dir, const std::wstring& filename, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const bool json_pretty_print) {
-        std::wstring saveFilePath = save_dir + L"\\" + filename;
-        if (std::filesystem::exists(saveFilePath)) {
-            return true; // Return immediately if the file already exists
-        }
-
-        gwmb_model model;
-        const bool success = generate_gwmb_model(model, model_file, dat_manager, hash_index, texture_manager, save_dir);
-        if (!success) {
-            return false; // Failed to build the model
-        }
-
-        const nlohmann::json j = model;
-        std::ofstream file(saveFilePath);
-        if (!file) {
-            return false; // Failed to open the file for writing
-        }
-
-        if (json_pretty_print) {
-            file << j.dump(4);
-        }
-        else {
-            file << j.dump();
+    // The textures of the model that are in the dat, in the order gwmb_submodel::texture_indices refers to them.
+    static std::vector<gwmb_file_ref> get_texture_refs(FFNA_ModelFile* model_file, const std::unordered_map<int, std::vector<int>>& hash_index) {
+        std::vector<gwmb_file_ref> texture_refs;
+        for (const auto& texture_filename : model_file->get_texture_filenames_chunk().texture_filenames) {
+            const auto decoded_filename = decode_filename(texture_filename.id0, texture_filename.id1);
+            const auto mft_entry_it = hash_index.find(decoded_filename);
+            if (mft_entry_it != hash_index.end()) {
+                texture_refs.push_back({ static_cast<int>(decoded_filename), mft_entry_it->second.at(0) });
+            }
         }
-        file.close();
-
-        return true; // Successfully exported the model
+        return texture_refs;
     }
 
-    static bool generate_gwmb_model(gwmb_model& model_out, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const std::wstring& save_dir) {
-
+    // Adds the submodels (geometry, LODs and material info) of model_file to model_out. Doesn't touch the textures.
+    static bool generate_gwmb_submodels(gwmb_model& model_out, FFNA_ModelFile* model_file, DATManager* dat_manager, const std::unordered_map<int, std::vector<int>>& hash_index) {
         if (!model_file->parsed_correctly)
             return false;
         if (!model_file->textures_parsed_correctly)
             return false;
 
-        const auto& texture_filenames = model_file->texture_filenames_chunk.texture_filenames;
-
-        // Build gwmb_textures
-        for (int i = 0; i < texture_filenames.size(); i++) {
-            const auto texture_filename = texture_filenames[i];
-            auto decoded_filename = decode_filename(texture_filename.id0, texture_filename.id1);
-
-            auto mft_entry_it = hash_index.find(decoded_filename);
-            if (mft_entry_it != hash_index.end())
-            {
-                auto file_index = mft_entry_it->second.at(0);
-                const auto* entry = &(dat_manager->get_MFT()[file_index]);
-
-                if (!entry)
-                    return false;
-
-                int texture_id = -1;
-                DatTexture dat_texture;
-                if (entry->type == DDS)
-                {
-                    const auto ddsData = dat_manager->parse_dds_file(file_index);
-                    size_t ddsDataSize = ddsData.size();
-                    const auto hr = texture_manager->
-                        CreateTextureFromDDSInMemory(ddsData.data(), ddsDataSize, &texture_id, &dat_texture.width,
-                            &dat_texture.height, dat_texture.rgba_data, entry->Hash);
-                    dat_texture.texture_type = DDSt;
-                }
-                else
-                {
-                    dat_texture = dat_manager->parse_ffna_texture_file(file_index);
-                    auto HR = texture_manager->CreateTextureFromRGBA(dat_texture.width,
-                        dat_texture.height, dat_texture.rgba_data.data(), &texture_id,
-                        decoded_filename);
-                }
-
-                gwmb_texture gwmb_texture_i;
-                gwmb_texture_i.file_hash = decoded_filename;
-                gwmb_texture_i.height = dat_texture.height;
-                gwmb_texture_i.width = dat_texture.width;
-                gwmb_texture_i.texture_type = dat_texture.texture_type;
-
-                ID3D11ShaderResourceView* texture =
-                    texture_manager->GetTexture(texture_id);
-
-                std::wstring texture_save_path = save_dir + L"\\" + std::to_wstring(gwmb_texture_i.file_hash) + L".png";
-
-                if (!SaveTextureToPng(texture, texture_save_path, texture_manager))
-                {
-                    throw "Unable to save texture to png while exporting model";
-                }
-
-                model_out.textures.push_back(gwmb_texture_i);
-            }
-        }
-
-        const auto& geometry_chunk = model_file->geometry_chunk;
+        const auto& geometry_chunk = model_file->get_geometry_chunk();
 
         // Loop over each submodel
         for (int i = 0; i < geometry_chunk.models.size(); i++) {
@@ -422,7 +357,7 @@ private:
             }
 
             AMAT_file amat_file;
-            if (model_file->AMAT_filenames_chunk.texture_filenames.size() > 0) {
+            if (model_file->get_AMAT_filenames_chunk().texture_filenames.size() > 0) {
                 int sub_model_index = geometry_chunk.models[i].unknown;
                 if (geometry_chunk.tex_and_vertex_shader_struct.uts0.size() > 0)
                 {
@@ -430,8 +365,8 @@ private:
                 }
                 const auto uts1 = geometry_chunk.uts1[sub_model_index % geometry_chunk.uts1.size()];
 
-                const int amat_file_index = ((uts1.some_flags0 >> 8) & 0xFF) % model_file->AMAT_filenames_chunk.texture_filenames.size();
-                const auto amat_filename = model_file->AMAT_filenames_chunk.texture_filenames[amat_file_index];
+                const int amat_file_index = ((uts1.some_flags0 >> 8) & 0xFF) % model_file->get_AMAT_filenames_chunk().texture_filenames.size();
+                const auto amat_filename = model_file->get_AMAT_filenames_chunk().texture_filenames[amat_file_index];
 
                 const auto decoded_filename = decode_filename(amat_filename.id0, amat_filename.id1);
 
@@ -462,7 +397,7 @@ private:
             int draw_order = 0;
 
             auto pixel_shader_type = PixelShaderType::OldModel;
-            if (model_file->geometry_chunk.unknown_tex_stuff1.size() > 0)
+            if (model_file->get_geometry_chunk().unknown_tex_stuff1.size() > 0)
             {
                 pixel_shader_type = PixelShaderType::NewModel;
                 draw_order = amat_file.GRMT_chunk.sort_order;
@@ -476,4 +411,86 @@ private:
 
         return true;
     }
+
+private:
+    static bool export_model_to_file(const std::wstring& save_dir, const std::wstring& filename, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const bool json_pretty_print) {
+        std::wstring saveFilePath = save_dir + L"\\" + filename;
+        if (std::filesystem::exists(saveFilePath)) {
+            return true; // Return immediately if the file already exists
+        }
+
+        gwmb_model model;
+        const bool success = generate_gwmb_model(model, model_file, dat_manager, hash_index, texture_manager, save_dir);
+        if (!success) {
+            return false; // Failed to build the model
+        }
+
+        const nlohmann::json j = model;
+        std::ofstream file(saveFilePath);
+        if (!file) {
+            return false; // Failed to open the file for writing
+        }
+
+        if (json_pretty_print) {
+            file << j.dump(4);
+        }
+        else {
+            file << j.dump();
+        }
+        file.close();
+
+        return true; // Successfully exported the model
+    }
+
+    static bool generate_gwmb_model(gwmb_model& model_out, FFNA_ModelFile* model_file, DATManager* dat_manager, std::unordered_map<int, std::vector<int>>& hash_index, TextureManager* texture_manager, const std::wstring& save_dir) {
+
+        if (!model_file->parsed_correctly)
+            return false;
+        if (!model_file->textures_parsed_correctly)
+            return false;
+
+        // Build gwmb_textures
+        for (const auto& texture_ref : get_texture_refs(model_file, hash_index)) {
+            const auto file_index = texture_ref.mft_index;
+            const auto decoded_filename = texture_ref.file_hash;
+            const auto* entry = &(dat_manager->get_MFT()[file_index]);
+
+            int texture_id = -1;
+            DatTexture dat_texture;
+            if (entry->type == DDS)
+            {
+                const auto ddsData = dat_manager->parse_dds_file(file_index);
+                size_t ddsDataSize = ddsData.size();
+                const auto hr = texture_manager->
+                    CreateTextureFromDDSInMemory(ddsData.data(), ddsDataSize, &texture_id, &dat_texture.width,
+                        &dat_texture.height, dat_texture.rgba_data, entry->Hash);
+                dat_texture.texture_type = DDSt;
+            }
+            else
+            {
+                dat_texture = dat_manager->parse_ffna_texture_file(file_index, false);
+                auto HR = texture_manager->CreateTextureFromDatTexture(dat_texture, &texture_id, decoded_filename);
+            }
+
+            gwmb_texture gwmb_texture_i;
+            gwmb_texture_i.file_hash = decoded_filename;
+            gwmb_texture_i.height = dat_texture.height;
+            gwmb_texture_i.width = dat_texture.width;
+            gwmb_texture_i.texture_type = dat_texture.texture_type;
+
+            ID3D11ShaderResourceView* texture =
+                texture_manager->GetTexture(texture_id);
+
+            std::wstring texture_save_path = save_dir + L"\\" + std::to_wstring(gwmb_texture_i.file_hash) + L".png";
+
+            if (!SaveTextureToPng(texture, texture_save_path, texture_manager))
+            {
+                throw "Unable to save texture to png while exporting model";
+            }
+
+            model_out.textures.push_back(gwmb_texture_i);
+        }
+
+        return generate_gwmb_submodels(model_out, model_file, dat_manager, hash_index);
+    }
 };
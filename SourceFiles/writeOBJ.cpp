@@ -1,2 +1,215 @@
 #include "pch.h"
 #include "writeOBJ.h"
+#include <charconv>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+
+mesh_text_writer::mesh_text_writer(const std::wstring& path)
+    : m_buffer(256 * 1024)
+{
+    m_fd = _wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+
+mesh_text_writer::~mesh_text_writer() { close(); }
+
+void mesh_text_writer::put(std::string_view text)
+{
+    while (!text.empty())
+    {
+        reserve(1);
+        const size_t count = std::min(text.size(), m_buffer.size() - m_size);
+        memcpy(m_buffer.data() + m_size, text.data(), count);
+        m_size += count;
+        text.remove_prefix(count);
+    }
+}
+
+void mesh_text_writer::put(char c)
+{
+    reserve(1);
+    m_buffer[m_size++] = c;
+}
+
+void mesh_text_writer::put(float value)
+{
+    reserve(max_number_length);
+    char* const begin = m_buffer.data() + m_size;
+    m_size = std::to_chars(begin, begin + max_number_length, value).ptr - m_buffer.data();
+}
+
+void mesh_text_writer::put(uint64_t value)
+{
+    reserve(max_number_length);
+    char* const begin = m_buffer.data() + m_size;
+    m_size = std::to_chars(begin, begin + max_number_length, value).ptr - m_buffer.data();
+}
+
+void mesh_text_writer::flush()
+{
+    if (m_size > 0 && m_fd >= 0 && !m_failed)
+    {
+        m_failed = _write(m_fd, m_buffer.data(), static_cast<unsigned int>(m_size)) != static_cast<int>(m_size);
+    }
+    m_size = 0;
+}
+
+bool mesh_text_writer::close()
+{
+    if (m_fd < 0)
+    {
+        return false;
+    }
+
+    flush();
+    m_failed |= _close(m_fd) != 0;
+    m_fd = -1;
+    return !m_failed;
+}
+
+namespace
+{
+void put_vec3(mesh_text_writer& out, std::string_view prefix, float x, float y, float z)
+{
+    out.put(prefix);
+    out.put(x);
+    out.put(' ');
+    out.put(y);
+    out.put(' ');
+    out.put(z);
+    out.put('\n');
+}
+
+// OBJ indices are 1-based and every vertex has a position, normal and texture coordinate with the same index.
+void put_face_vertex(mesh_text_writer& out, uint64_t index)
+{
+    out.put(index);
+    out.put('/');
+    out.put(index);
+    out.put('/');
+    out.put(index);
+}
+}
+
+void obj_writer::write_mesh(const Mesh& mesh, bool flip_v)
+{
+    for (const auto& vertex : mesh.vertices)
+    {
+        put_vec3(m_out, "v ", vertex.position.x, vertex.position.y, -vertex.position.z);
+        put_vec3(m_out, "vn ", vertex.normal.x, vertex.normal.y, -vertex.normal.z);
+        m_out.put("vt ");
+        m_out.put(vertex.tex_coord0.x);
+        m_out.put(' ');
+        m_out.put(flip_v ? 1 - vertex.tex_coord0.y : vertex.tex_coord0.y);
+        m_out.put('\n');
+    }
+
+    // Mirroring z flips the winding, so the faces are written as 0 2 1.
+    const uint64_t first_index = m_vertex_offset + 1;
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        m_out.put("f ");
+        put_face_vertex(m_out, mesh.indices[i] + first_index);
+        m_out.put(' ');
+        put_face_vertex(m_out, mesh.indices[i + 2] + first_index);
+        m_out.put(' ');
+        put_face_vertex(m_out, mesh.indices[i + 1] + first_index);
+        m_out.put('\n');
+    }
+
+    m_vertex_offset += mesh.vertices.size();
+}
+
+bool write_obj(const std::wstring& path, const Mesh& mesh, bool flip_v)
+{
+    obj_writer writer(path);
+    if (!writer.is_open())
+    {
+        return false;
+    }
+
+    writer.write_mesh(mesh, flip_v);
+    return writer.close();
+}
+
+bool write_obj(const std::wstring& path, const std::vector<Mesh>& meshes, bool flip_v)
+{
+    obj_writer writer(path);
+    if (!writer.is_open())
+    {
+        return false;
+    }
+
+    for (const Mesh& mesh : meshes)
+    {
+        writer.write_mesh(mesh, flip_v);
+    }
+    return writer.close();
+}
+
+bool write_ply(const std::wstring& path, const std::vector<Mesh>& meshes)
+{
+    mesh_text_writer out(path);
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    uint64_t num_vertices = 0;
+    uint64_t num_faces = 0;
+    for (const Mesh& mesh : meshes)
+    {
+        num_vertices += mesh.vertices.size();
+        num_faces += mesh.indices.size() / 3;
+    }
+
+    out.put("ply\nformat ascii 1.0\nelement vertex ");
+    out.put(num_vertices);
+    out.put("\nproperty float x\nproperty float y\nproperty float z\n"
+            "property float nx\nproperty float ny\nproperty float nz\n"
+            "property float s\nproperty float t\n"
+            "element face ");
+    out.put(num_faces);
+    out.put("\nproperty list uchar uint vertex_indices\nend_header\n");
+
+    for (const Mesh& mesh : meshes)
+    {
+        for (const auto& vertex : mesh.vertices)
+        {
+            out.put(vertex.position.x);
+            out.put(' ');
+            out.put(vertex.position.y);
+            out.put(' ');
+            out.put(-vertex.position.z);
+            out.put(' ');
+            out.put(vertex.normal.x);
+            out.put(' ');
+            out.put(vertex.normal.y);
+            out.put(' ');
+            out.put(-vertex.normal.z);
+            out.put(' ');
+            out.put(vertex.tex_coord0.x);
+            out.put(' ');
+            out.put(1 - vertex.tex_coord0.y);
+            out.put('\n');
+        }
+    }
+
+    uint64_t vertex_offset = 0;
+    for (const Mesh& mesh : meshes)
+    {
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            out.put("3 ");
+            out.put(mesh.indices[i] + vertex_offset);
+            out.put(' ');
+            out.put(mesh.indices[i + 2] + vertex_offset);
+            out.put(' ');
+            out.put(mesh.indices[i + 1] + vertex_offset);
+            out.put('\n');
+        }
+        vertex_offset += mesh.vertices.size();
+    }
+
+    return out.close();
+}
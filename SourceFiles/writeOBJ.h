@@ -1,72 +1,70 @@
 #pragma once
 #include "Mesh.h"
-#include <sstream>
+#include <string_view>
+#include <vector>
 
-inline std::string write_obj_str(const Mesh* mesh)
+// Buffered text output for the mesh writers. Numbers are formatted with std::to_chars into a fixed size
+// buffer that goes to the file whenever it fills up, so memory use doesn't grow with the size of the export.
+class mesh_text_writer
 {
-    std::stringstream objStream;
+public:
+    explicit mesh_text_writer(const std::wstring& path);
+    ~mesh_text_writer();
 
-    // Write vertices and vertex normals to the string stream
-    for (const auto& vertex : mesh->vertices)
-    {
-        objStream << "v " << vertex.position.x << " " << vertex.position.y << " " << -vertex.position.z
-                  << "\n";
-        objStream << "vn " << vertex.normal.x << " " << vertex.normal.y << " " << -vertex.normal.z << "\n";
-        objStream << "vt " << vertex.tex_coord0.x << " " << vertex.tex_coord0.y << "\n";
-    }
+    mesh_text_writer(const mesh_text_writer&) = delete;
+    mesh_text_writer& operator=(const mesh_text_writer&) = delete;
 
-    // Write faces (triangles) to the string stream
-    for (size_t i = 0; i < mesh->indices.size(); i += 3)
-    {
-        objStream << "f " << (mesh->indices[i] + 1) << "/" << (mesh->indices[i] + 1) << "/"
-                  << (mesh->indices[i] + 1) << " " << (mesh->indices[i + 2] + 1) << "/"
-                  << (mesh->indices[i + 2] + 1) << "/" << (mesh->indices[i + 2] + 1) << " "
-                  << (mesh->indices[i + 1] + 1) << "/" << (mesh->indices[i + 1] + 1) << "/"
-                  << (mesh->indices[i + 1] + 1) << "\n";
-    }
+    bool is_open() const { return m_fd >= 0; }
 
-    return objStream.str();
-}
+    void put(std::string_view text);
+    void put(char c);
+    void put(float value);
+    void put(uint64_t value);
 
-inline std::string write_obj_str(const std::vector<Mesh>& meshes)
-{
-    std::stringstream objStream;
+    // Flushes the buffer and closes the file. Returns false if any write failed.
+    bool close();
 
-    size_t vertex_offset = 0;
-    size_t texture_offset = 0;
-    size_t normal_offset = 0;
+private:
+    // Room for the longest number to_chars can produce.
+    static constexpr size_t max_number_length = 32;
 
-    for (const Mesh& mesh : meshes)
+    void flush();
+    void reserve(size_t size)
     {
-        // Write vertices, normals and texture coordinates to the string stream
-        for (const auto& vertex : mesh.vertices)
+        if (m_buffer.size() - m_size < size)
         {
-            objStream << "v " << vertex.position.x << " " << vertex.position.y << " " << -vertex.position.z
-                      << "\n";
-            objStream << "vn " << vertex.normal.x << " " << vertex.normal.y << " " << -vertex.normal.z
-                      << "\n";
-            objStream << "vt " << vertex.tex_coord0.x << " " << 1-vertex.tex_coord0.y << "\n";
+            flush();
         }
+    }
 
-        // Write faces (triangles) to the string stream, offsetting the indices
-        for (size_t i = 0; i < mesh.indices.size(); i += 3)
-        {
-            objStream << "f " << (mesh.indices[i] + 1 + vertex_offset) << "/"
-                      << (mesh.indices[i] + 1 + texture_offset) << "/"
-                      << (mesh.indices[i] + 1 + normal_offset) << " "
-                      << (mesh.indices[i + 2] + 1 + vertex_offset) << "/"
-                      << (mesh.indices[i + 2] + 1 + texture_offset) << "/"
-                      << (mesh.indices[i + 2] + 1 + normal_offset) << " "
-                      << (mesh.indices[i + 1] + 1 + vertex_offset) << "/"
-                      << (mesh.indices[i + 1] + 1 + texture_offset) << "/"
-                      << (mesh.indices[i + 1] + 1 + normal_offset) << "\n";
-        }
+    int m_fd = -1;
+    std::vector<char> m_buffer;
+    size_t m_size = 0;
+    bool m_failed = false;
+};
 
-        // Update the offsets for the next mesh
-        vertex_offset += mesh.vertices.size();
-        texture_offset += mesh.vertices.size(); // Assuming same number of texture coordinates as vertices
-        normal_offset += mesh.vertices.size(); // Assuming same number of normals as vertices
-    }
+// Writes meshes to an OBJ file one at a time, numbering their vertices after the ones already written.
+// Only the mesh being written needs to be in memory.
+class obj_writer
+{
+public:
+    explicit obj_writer(const std::wstring& path) : m_out(path) {}
+
+    bool is_open() const { return m_out.is_open(); }
+
+    // flip_v writes 1 - v as the texture coordinate, which is what Blender and most other tools expect.
+    void write_mesh(const Mesh& mesh, bool flip_v = true);
+
+    bool close() { return m_out.close(); }
+
+private:
+    mesh_text_writer m_out;
+    uint64_t m_vertex_offset = 0;
+};
+
+bool write_obj(const std::wstring& path, const Mesh& mesh, bool flip_v = true);
+bool write_obj(const std::wstring& path, const std::vector<Mesh>& meshes, bool flip_v = true);
 
-    return objStream.str();
-}
+// Writes the meshes as a single ASCII PLY with positions, normals and texture coordinates. Like the OBJ
+// writer, z is mirrored and the winding reversed.
+bool write_ply(const std::wstring& path, const std::vector<Mesh>& meshes);
@@ -759,8 +759,507 @@ public:
     }
 };
 
-void UnpackGWDat(unsigned char* input, int insize, unsigned char*& output, int& outsize)
+// Table-driven decoder used by UnpackGWDat. It implements the same bitstream format as the
+// Decompress port above but reads bits through a 64-bit buffer, resolves most codes (including
+// many of the >8 bit ones) with a single kFastBits lookup and reuses its scratch memory between
+// blocks. The output is byte-identical to Decompress::DecompressFile, which is kept as
+// UnpackGWDatReference so the two can be compared (see DATManager::benchmark_decompression).
+namespace
 {
+constexpr unsigned int kFastBits = 10;
+constexpr unsigned int kFastSize = 1u << kFastBits;
+constexpr unsigned int kHelperSize = 0x48;
+constexpr unsigned int kLengthTableSize = sizeof(TableData3) - 0x1DC;
+constexpr unsigned int kDistanceTableSize = sizeof(Table5);
+
+// MSB-first reader over the little-endian 32-bit words of a compressed file. Bits past the end
+// of the input read as zero, like the original decompressor.
+class GWBitReader
+{
+public:
+    GWBitReader(const unsigned char* input, size_t word_count)
+        : m_ptr(input)
+        , m_end(input + word_count * 4)
+    {
+        refill();
+    }
+
+    // Same value as ESIplusC in the original decoder.
+    unsigned int peek32() const { return (unsigned int)(m_buffer >> 32); }
+
+    // n must be in [1, 32]
+    unsigned int peek(unsigned int n) const { return (unsigned int)(m_buffer >> (64 - n)); }
+
+    // n must be in [0, 31]
+    void consume(unsigned int n)
+    {
+        m_buffer <<= n;
+        m_count -= n;
+        refill();
+    }
+
+    unsigned int read(unsigned int n)
+    {
+        const unsigned int value = peek(n);
+        consume(n);
+        return value;
+    }
+
+private:
+    void refill()
+    {
+        if (m_count < 32)
+        {
+            if (m_ptr != m_end)
+            {
+                unsigned int word;
+                memcpy(&word, m_ptr, 4);
+                m_ptr += 4;
+                m_buffer |= (uint64_t)word << (32 - m_count);
+            }
+            m_count += 32;
+        }
+    }
+
+    const unsigned char* m_ptr;
+    const unsigned char* m_end;
+    uint64_t m_buffer = 0;
+    int m_count = 0;
+};
+
+struct FastEntry
+{
+    unsigned short symbol;
+    unsigned char length;
+    unsigned char slow; // Needs the full HelperArray search
+};
+
+struct FastHuffmanTree
+{
+    // Same contents as HuffmanData, including the state it keeps between blocks.
+    unsigned int HuffmanTable[0x200];
+    unsigned int HelperArray[kHelperSize];
+    std::vector<unsigned int> TempArray;
+
+    FastEntry Fast[kFastSize];
+};
+
+// Port of Decompress::SetupNodesandTree. Returns false where the original fails; returning true
+// early leaves the tables in the same (possibly partial) state the original would.
+bool SetupTree(GWBitReader& bits, FastHuffmanTree& tree, std::vector<unsigned int>& next)
+{
+    tree.TempArray.clear();
+
+    const unsigned int symbol_count = bits.read(0x10);
+    next.assign(symbol_count, 0);
+
+    unsigned int length_head[0x20];
+    memset(length_head, 0xff, sizeof(length_head));
+
+    unsigned int total = 0;
+    unsigned int pos = symbol_count - 1;
+    const unsigned int last = symbol_count - 1;
+
+    if (symbol_count != 0)
+    {
+        do
+        {
+            const unsigned int c = bits.peek32();
+            int i = 0;
+            while (c < Table1[i])
+            {
+                i += 2;
+            }
+
+            const unsigned int j = (i * 4 + 0x18) >> 3;
+            unsigned int code = Table2[Table1[i + 1] - ((c - Table1[i]) >> (0x20 - j))];
+            if (j >= 0x20)
+                return false;
+            bits.consume(j);
+
+            unsigned int repeat = code >> 5;
+            code &= 0x1f;
+
+            if (repeat > pos)
+                return true;
+
+            if (code || symbol_count < 2)
+            {
+                total += repeat + 1;
+                do
+                {
+                    if (pos >= symbol_count)
+                        return false;
+
+                    next[pos] = length_head[code];
+                    length_head[code] = pos;
+                    pos--;
+                } while (repeat-- != 0 && pos != 0xFFFFFFFF);
+            }
+            else
+            {
+                pos -= repeat + 1;
+            }
+        } while (pos != 0xFFFFFFFF);
+    }
+
+    if (symbol_count && !total)
+    {
+        next[last] = length_head[0];
+        length_head[0] = last;
+        total = 1;
+    }
+
+    memset(tree.HuffmanTable, 0, sizeof(tree.HuffmanTable));
+
+    unsigned int length = 0;
+    unsigned int assigned = 0;
+    unsigned int code = 0;
+    unsigned int fill_bits = 8;
+
+    do
+    {
+        unsigned int v = length_head[length];
+        if (v != 0xFFFFFFFF)
+        {
+            const unsigned int limit = 1u << length;
+            do
+            {
+                if (code >= limit || v >= symbol_count)
+                    return true;
+
+                const unsigned int first = code << (8 - length);
+                for (int i = (1 << fill_bits) - 1; i >= 0; i--)
+                {
+                    if ((first | i) >= 0x100)
+                        return false;
+                    tree.HuffmanTable[(first | i) * 2] = length;
+                    tree.HuffmanTable[(first | i) * 2 + 1] = v;
+                }
+
+                v = next[v];
+                assigned++;
+                code--;
+            } while (v != 0xFFFFFFFF);
+        }
+
+        fill_bits--;
+        code = 2 * code + 1;
+        length++;
+    } while (length <= 8);
+
+    if (assigned > total)
+        return false;
+
+    if (assigned == total)
+        return true;
+
+    const unsigned int long_count = total - assigned;
+    tree.TempArray.assign(long_count, 0);
+
+    unsigned int v = 0;
+    unsigned int helper = 0;
+    for (; length <= 0x1f; length++, code += code + 1)
+    {
+        unsigned int e = length_head[length];
+        if (e == 0xFFFFFFFF)
+            continue;
+
+        const unsigned int limit = 1u << length;
+        do
+        {
+            if (code > limit || e > symbol_count)
+                return true;
+
+            const unsigned int first = code >> (length - 8);
+            if (first >= 0x100)
+                return false;
+            tree.HuffmanTable[first * 2] = 0xFFFFFFFF;
+
+            if (v >= long_count)
+                return false;
+            tree.TempArray[v] = e;
+            e = next[e];
+            v++;
+            code--;
+        } while (e != 0xFFFFFFFF);
+
+        tree.HelperArray[helper] = (code + 1) << (0x20 - length);
+        tree.HelperArray[helper + 1] = v - 1;
+        tree.HelperArray[helper + 2] = length;
+        helper += 3;
+    }
+
+    return true;
+}
+
+// Resolves every kFastBits prefix to a symbol and code length when the prefix alone determines
+// the result of the original's 8-bit table lookup and HelperArray search.
+void BuildFastTable(FastHuffmanTree& tree)
+{
+    constexpr unsigned int low_mask = (1u << (32 - kFastBits)) - 1;
+
+    for (unsigned int p = 0; p < kFastSize; p++)
+    {
+        FastEntry& entry = tree.Fast[p];
+        const unsigned int first = p >> (kFastBits - 8);
+        const unsigned int first_length = tree.HuffmanTable[first * 2];
+
+        if (first_length != 0xFFFFFFFF)
+        {
+            entry = {(unsigned short)tree.HuffmanTable[first * 2 + 1], (unsigned char)first_length, 0};
+            continue;
+        }
+
+        entry = {0, 0, 1};
+
+        const unsigned int c = p << (32 - kFastBits);
+        for (unsigned int i = 0; i + 2 < kHelperSize; i += 3)
+        {
+            const unsigned int threshold = tree.HelperArray[i];
+            if (threshold & low_mask)
+                break;
+            if (c < threshold)
+                continue;
+
+            const unsigned int length = tree.HelperArray[i + 2];
+            if (length == 0 || length > kFastBits)
+                break;
+
+            const unsigned int index = tree.HelperArray[i + 1] - ((c - threshold) >> (0x20 - length));
+            if (index >= tree.TempArray.size())
+                break;
+
+            entry = {(unsigned short)tree.TempArray[index], (unsigned char)length, 0};
+            break;
+        }
+    }
+}
+
+inline bool DecodeSymbol(GWBitReader& bits, const FastHuffmanTree& tree, unsigned int& symbol)
+{
+    const FastEntry entry = tree.Fast[bits.peek(kFastBits)];
+    if (!entry.slow)
+    {
+        symbol = entry.symbol;
+        bits.consume(entry.length);
+        return true;
+    }
+
+    const unsigned int c = bits.peek32();
+    unsigned int i = 0;
+    while (c < tree.HelperArray[i])
+    {
+        i += 3;
+        if (i + 2 >= kHelperSize)
+            return false;
+    }
+
+    const unsigned int length = tree.HelperArray[i + 2];
+    if (length == 0 || length >= 0x20)
+        return false;
+
+    const unsigned int index = tree.HelperArray[i + 1] - ((c - tree.HelperArray[i]) >> (0x20 - length));
+    if (index >= tree.TempArray.size())
+        return false;
+
+    symbol = tree.TempArray[index];
+    bits.consume(length);
+    return true;
+}
+
+inline void CopyMatch(unsigned char* out, size_t distance, size_t length)
+{
+    const unsigned char* src = out - distance;
+    if (distance == 1)
+    {
+        memset(out, src[0], length);
+        return;
+    }
+
+    size_t i = 0;
+    if (distance >= 8)
+    {
+        for (; i + 8 <= length; i += 8)
+        {
+            memcpy(out + i, src + i, 8);
+        }
+    }
+    for (; i < length; i++)
+    {
+        out[i] = src[i];
+    }
+}
+
+enum class BlockResult
+{
+    Ok,
+    Error,
+    Truncated // Invalid back-reference, the original keeps what it has decoded so far
+};
+
+// Decodes one block of symbols. Works on a local copy of the bit reader so its state can stay
+// in registers for the whole loop.
+//
+// Decoding stops once out reaches out_stop. out_size is the size of the whole file; matches are
+// validated against it rather than against out_stop, so stopping early yields exactly the same
+// leading bytes as a full decode.
+BlockResult DecodeBlock(GWBitReader& bits_in, const FastHuffmanTree& literal_tree, const FastHuffmanTree& distance_tree,
+                        unsigned int base_length, unsigned char* const out_begin, unsigned char*& out_ref,
+                        unsigned char* const out_stop, size_t out_size)
+{
+    GWBitReader bits = bits_in;
+    unsigned char* out = out_ref;
+    BlockResult result = BlockResult::Ok;
+
+    for (unsigned int count = (bits.read(4) + 1) << 12; count && out != out_stop; count--)
+    {
+        unsigned int symbol;
+        if (!DecodeSymbol(bits, literal_tree, symbol))
+        {
+            result = BlockResult::Error;
+            break;
+        }
+
+        if (symbol < 0x100)
+        {
+            *out++ = (unsigned char)symbol;
+            continue;
+        }
+
+        if (symbol >= kLengthTableSize)
+        {
+            result = BlockResult::Error;
+            break;
+        }
+
+        const unsigned int length_bits = Table4[symbol];
+        unsigned int length = Table3[symbol];
+        if (length_bits)
+            length |= bits.read(length_bits);
+        length += base_length + 1;
+
+        if (!DecodeSymbol(bits, distance_tree, symbol) || symbol >= kDistanceTableSize)
+        {
+            result = BlockResult::Error;
+            break;
+        }
+
+        const unsigned int distance_bits = Table5[symbol];
+        unsigned int backtrack = Table6[symbol];
+        if (distance_bits)
+            backtrack |= bits.read(distance_bits);
+
+        const size_t written = (size_t)(out - out_begin);
+        if (length > out_size - written || backtrack >= written)
+        {
+            result = BlockResult::Truncated;
+            break;
+        }
+
+        length = (unsigned int)std::min<size_t>(length, (size_t)(out_stop - out));
+        CopyMatch(out, (size_t)backtrack + 1, length);
+        out += length;
+    }
+
+    bits_in = bits;
+    out_ref = out;
+    return result;
+}
+
+// Decodes the first out_stop bytes of the stream into out_begin. outsize is the size of the
+// whole file as stored in the stream's last word.
+BlockResult DecodeStream(const unsigned char* input, int insize, unsigned char* out_begin, size_t out_stop,
+                         size_t outsize)
+{
+    GWBitReader bits(input, (size_t)insize >> 2);
+    bits.consume(4);
+    const unsigned int base_length = bits.read(4);
+
+    if (!out_stop)
+        return BlockResult::Ok;
+
+    auto trees = std::make_unique<FastHuffmanTree[]>(2);
+    FastHuffmanTree& literal_tree = trees[0];
+    FastHuffmanTree& distance_tree = trees[1];
+    std::vector<unsigned int> next;
+
+    unsigned char* out = out_begin;
+    unsigned char* const out_end = out_begin + out_stop;
+
+    do
+    {
+        if (!SetupTree(bits, literal_tree, next))
+            return BlockResult::Error;
+        BuildFastTable(literal_tree);
+
+        if (!SetupTree(bits, distance_tree, next))
+            return BlockResult::Error;
+        BuildFastTable(distance_tree);
+
+        const BlockResult result =
+          DecodeBlock(bits, literal_tree, distance_tree, base_length, out_begin, out, out_end, outsize);
+        if (result != BlockResult::Ok)
+            return result;
+    } while (out != out_end);
+
+    return BlockResult::Ok;
+}
+
+// The output size is stored in the last word of the stream.
+bool ReadOutputSize(const unsigned char* input, int insize, int& outsize)
+{
+    outsize = 0;
+    if (insize < 8)
+        return false;
+
+    const size_t word_count = (size_t)insize >> 2;
+    memcpy(&outsize, input + (word_count - 1) * 4, 4);
+    return outsize >= 0;
+}
+
+unsigned char* DecompressFast(const unsigned char* input, int insize, int& outsize)
+{
+    if (!ReadOutputSize(input, insize, outsize))
+    {
+        outsize = 0;
+        return nullptr;
+    }
+
+    std::unique_ptr<unsigned char[]> output(new unsigned char[outsize]());
+
+    // A truncated stream keeps what was decoded so far, like the original.
+    if (DecodeStream(input, insize, output.get(), (size_t)outsize, (size_t)outsize) == BlockResult::Error)
+        return nullptr;
+
+    return output.release();
+}
+} // namespace
+
+void UnpackGWDat(const unsigned char* input, int insize, unsigned char*& output, int& outsize)
+{
+    output = DecompressFast(input, insize, outsize);
+}
+
+int UnpackGWDatPrefix(const unsigned char* input, int insize, unsigned char* output, int max_outsize, int& full_outsize)
+{
+    if (!ReadOutputSize(input, insize, full_outsize) || max_outsize < 0)
+    {
+        full_outsize = 0;
+        return -1;
+    }
+
+    const int prefix_size = std::min(max_outsize, full_outsize);
+    memset(output, 0, prefix_size);
+    if (DecodeStream(input, insize, output, (size_t)prefix_size, (size_t)full_outsize) == BlockResult::Error)
+        return -1;
+
+    return prefix_size;
+}
+
+void UnpackGWDatReference(const unsigned char* input, int insize, unsigned char*& output, int& outsize)
+{
+    // The decompressor never writes to its input, so this can point straight into the mapped dat.
     Decompress d;
     output = d.DecompressFile((unsigned int*)input, insize, outsize);
 }
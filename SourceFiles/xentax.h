@@ -1,3 +1,14 @@
 #pragma once
 
-void UnpackGWDat(unsigned char* input, int insize, unsigned char*& output, int& outsize);
+void UnpackGWDat(const unsigned char* input, int insize, unsigned char*& output, int& outsize);
+
+// Decodes only the first max_outsize bytes of a file into output, which must have room for that
+// many bytes. Decoding stops as soon as they have been written, so this is much cheaper than
+// UnpackGWDat when only the file header is needed. full_outsize receives the size of the whole
+// file, which is stored at the end of the stream. Returns the number of bytes written
+// (min(max_outsize, full_outsize)) or -1 if the stream is corrupt.
+int UnpackGWDatPrefix(const unsigned char* input, int insize, unsigned char* output, int max_outsize, int& full_outsize);
+
+// Straight port of the game's decompressor. UnpackGWDat produces identical output using a faster
+// table-driven decoder; this is kept to verify that and to benchmark against.
+void UnpackGWDatReference(const unsigned char* input, int insize, unsigned char*& output, int& outsize);
@@ -1,10 +1,10 @@
 bl_info = {
     "name": "Guild Wars Map Browser Map Importer",
     "author": "Jonathan Bjorn Greve",
-    "version": (2, 0, 0),
+    "version": (2, 1, 0),
     "blender": (5, 0, 0),
     "location": "File > Import > GW Map Browser Map Folder",
-    "description": "Import a Guild Wars Map from a JSON file provided by Guild Wars Map Browser.",
+    "description": "Import a Guild Wars Map from a .gwmb or JSON file provided by Guild Wars Map Browser.",
     "warning": "This might take a long time.",
     "wiki_url": "github.com/Jonathan-Greve/GuildWarsMapBrowser",
     "category": "Import-Export",
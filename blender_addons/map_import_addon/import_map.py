@@ -2,7 +2,11 @@ import bpy
 import json
 import time
 import os
+import struct
+import sys
 import traceback
+import zlib
+from array import array
 from mathutils import Vector, Matrix
 
 # Blender 5.0 compatible version - V2 with new terrain format (4 UV layers)
@@ -487,6 +491,79 @@ def set_custom_normals(mesh, normals):
     mesh.normals_split_custom_set_from_vertices(normals)
 
 
+def read_gwmb_chunks(filepath):
+    """
+    Read a GWMB binary file (see gwmb_binary_writer.h in the map browser).
+    Returns the 4 character content type and a dict of chunk id -> uncompressed chunk bytes.
+    """
+    with open(filepath, 'rb') as f:
+        data = f.read()
+
+    if len(data) < 32 or data[0:4] != b'GWMB' or data[-4:] != b'GWMT':
+        raise ValueError(f"{filepath} is not a GWMB file")
+
+    version, content = struct.unpack_from('<I4s', data, 4)
+    table_offset, num_chunks = struct.unpack_from('<QI', data, len(data) - 16)
+
+    chunks = {}
+    for i in range(num_chunks):
+        chunk_id, compression, offset, stored_size, size = struct.unpack_from('<4sIQQQ', data, table_offset + i * 32)
+        start = offset + 24  # Skip the chunk header
+        chunk = data[start:start + stored_size]
+        if compression == 1:
+            chunk = zlib.decompress(chunk)
+        elif compression != 0:
+            raise ValueError(f"Unknown compression {compression} of chunk {chunk_id} in {filepath}")
+        chunks[chunk_id.decode('ascii')] = chunk
+
+    log(f"Read GWMB version {version} '{content.decode('ascii')}' with {num_chunks} chunks")
+    return content.decode('ascii'), chunks
+
+
+def read_array(typecode, data):
+    values = array(typecode)
+    values.frombytes(data)
+    if sys.byteorder != 'little':
+        values.byteswap()
+    return values
+
+
+def load_gwmb_map(filepath):
+    """
+    Load a map_<hash>.gwmb file into the same layout as the map JSON, except that the terrain
+    vertices are kept as one flat array of 14 floats per vertex in terrain['vertex_floats'].
+    """
+    content, chunks = read_gwmb_chunks(filepath)
+    if content != 'MAP ':
+        raise ValueError(f"{filepath} is not a GWMB map")
+
+    filehash, width, height, min_x, max_x, min_y, max_y, min_z, max_z = struct.unpack('<3i6f', chunks['INFO'])
+
+    def vec3(values):
+        return {'x': values[0], 'y': values[1], 'z': values[2]}
+
+    textures = [{'file_hash': t[0], 'width': t[1], 'height': t[2], 'texture_type': t[3]}
+                for t in struct.iter_unpack('<4i', chunks.get('TTEX', b''))]
+    models = [{'model_hash': m[0], 'world_pos': vec3(m[1:4]), 'model_right': vec3(m[4:7]),
+               'model_up': vec3(m[7:10]), 'model_look': vec3(m[10:13]), 'scale': m[13]}
+              for m in struct.iter_unpack('<i13f', chunks.get('MODL', b''))]
+
+    return {
+        'filehash': filehash,
+        'terrain': {
+            'width': width,
+            'height': height,
+            'vertex_floats': read_array('f', chunks.get('TVTX', b'')),
+            'indices': read_array('i', chunks.get('TIDX', b'')),
+            'textures': textures,
+        },
+        'models': models,
+        'min_x': min_x, 'max_x': max_x,
+        'min_y': min_y, 'max_y': max_y,
+        'min_z': min_z, 'max_z': max_z,
+    }
+
+
 def create_map_from_json(context, directory, filename):
     """
     Import map with new terrain format (V2):
@@ -511,8 +588,11 @@ def create_map_from_json(context, directory, filename):
         log(f"Object {obj_name} already exists. Skipping.")
         return {'FINISHED'}
 
-    with open(filepath, 'r') as f:
-        data = json.load(f)
+    if filepath.lower().endswith('.gwmb'):
+        data = load_gwmb_map(filepath)
+    else:
+        with open(filepath, 'r') as f:
+            data = json.load(f)
 
     if 'terrain' not in data:
         log(f"The key 'terrain' is not in the JSON data. Available keys: {list(data.keys())}")
@@ -539,30 +619,38 @@ def create_map_from_json(context, directory, filename):
 
     # Get terrain data - new format has pre-computed vertices and indices
     vertices_data = terrain_data.get('vertices', [])
+    vertex_floats = terrain_data.get('vertex_floats')  # Binary .gwmb maps
     indices = terrain_data.get('indices', [])
 
-    log(f"Reading {len(vertices_data)} vertices and {len(indices)} indices")
+    num_vertices = len(vertex_floats) // 14 if vertex_floats is not None else len(vertices_data)
+    log(f"Reading {num_vertices} vertices and {len(indices)} indices")
 
     # Check if this is the new format (has uv_coord0) or old format (has texture_index)
-    is_new_format = len(vertices_data) > 0 and 'uv_coord0' in vertices_data[0]
+    is_new_format = vertex_floats is not None or (len(vertices_data) > 0 and 'uv_coord0' in vertices_data[0])
     log(f"Detected format: {'NEW (pre-computed UVs)' if is_new_format else 'OLD (texture_index)'}")
 
     if is_new_format:
         # NEW FORMAT: Vertices already have 4 UV coords, indices are pre-computed
         # Convert vertices to Blender format (swap Y and Z)
-        blender_vertices = [swap_axes(v['pos']) for v in vertices_data]
-        blender_normals = [swap_axes_normal(v.get('normal')) for v in vertices_data]
+        if vertex_floats is not None:
+            # 14 floats per vertex: pos, normal, uv_coord0, uv_coord1, uv_coord2, uv_coord3
+            blender_vertices = list(zip(vertex_floats[0::14], vertex_floats[2::14], vertex_floats[1::14]))
+            blender_normals = list(zip(vertex_floats[3::14], vertex_floats[5::14], vertex_floats[4::14]))
+            uv0_coords, uv1_coords, uv2_coords, uv3_coords = [
+                list(zip(vertex_floats[6 + 2 * layer::14], [1.0 - v for v in vertex_floats[7 + 2 * layer::14]]))
+                for layer in range(4)]
+        else:
+            blender_vertices = [swap_axes(v['pos']) for v in vertices_data]
+            blender_normals = [swap_axes_normal(v.get('normal')) for v in vertices_data]
 
-        # Extract all 4 UV layers
-        uv0_coords = [(v['uv_coord0']['x'], 1.0 - v['uv_coord0']['y']) for v in vertices_data]
-        uv1_coords = [(v['uv_coord1']['x'], 1.0 - v['uv_coord1']['y']) for v in vertices_data]
-        uv2_coords = [(v['uv_coord2']['x'], 1.0 - v['uv_coord2']['y']) for v in vertices_data]
-        uv3_coords = [(v['uv_coord3']['x'], 1.0 - v['uv_coord3']['y']) for v in vertices_data]
+            # Extract all 4 UV layers
+            uv0_coords = [(v['uv_coord0']['x'], 1.0 - v['uv_coord0']['y']) for v in vertices_data]
+            uv1_coords = [(v['uv_coord1']['x'], 1.0 - v['uv_coord1']['y']) for v in vertices_data]
+            uv2_coords = [(v['uv_coord2']['x'], 1.0 - v['uv_coord2']['y']) for v in vertices_data]
+            uv3_coords = [(v['uv_coord3']['x'], 1.0 - v['uv_coord3']['y']) for v in vertices_data]
 
         # Convert indices to faces (triangles)
-        faces = []
-        for i in range(0, len(indices), 3):
-            faces.append((indices[i], indices[i+1], indices[i+2]))
+        faces = list(zip(indices[0::3], indices[1::3], indices[2::3]))
 
         log(f"Creating mesh with {len(blender_vertices)} vertices and {len(faces)} faces")
 
@@ -578,10 +666,12 @@ def create_map_from_json(context, directory, filename):
         uv_layer_names = ["UV_Atlas", "UV_Blend1", "UV_Blend2", "UV_Shadow"]
         uv_data_lists = [uv0_coords, uv1_coords, uv2_coords, uv3_coords]
 
+        loop_vertex_indices = [0] * len(mesh.loops)
+        mesh.loops.foreach_get("vertex_index", loop_vertex_indices)
+
         for layer_idx, (layer_name, uv_data) in enumerate(zip(uv_layer_names, uv_data_lists)):
             uv_layer = mesh.uv_layers.new(name=layer_name)
-            for i, loop in enumerate(mesh.loops):
-                uv_layer.data[i].uv = uv_data[loop.vertex_index]
+            uv_layer.data.foreach_set("uv", [c for vertex_index in loop_vertex_indices for c in uv_data[vertex_index]])
             log(f"Created UV layer: {layer_name}")
 
         mesh.update()
@@ -1001,11 +1091,11 @@ class IMPORT_OT_GWMBMap(bpy.types.Operator):
             return {'CANCELLED'}
 
         try:
-            file_list = [f for f in os.listdir(self.directory) if f.lower().endswith('.json')]
-            log(f"Found {len(file_list)} JSON files in directory")
+            file_list = [f for f in os.listdir(self.directory) if f.lower().endswith(('.json', '.gwmb'))]
+            log(f"Found {len(file_list)} JSON/GWMB files in directory")
 
             if len(file_list) == 0:
-                self.report({'WARNING'}, "No JSON files found in directory")
+                self.report({'WARNING'}, "No JSON or GWMB files found in directory")
                 return {'CANCELLED'}
 
             map_filename = None
@@ -1020,7 +1110,9 @@ class IMPORT_OT_GWMBMap(bpy.types.Operator):
                         log(traceback.format_exc())
 
                 elif filename.lower().startswith("map_"):
-                    map_filename = filename
+                    # Prefer the binary map if the folder has both
+                    if map_filename is None or filename.lower().endswith('.gwmb'):
+                        map_filename = filename
 
             if map_filename:
                 log(f"Processing map file: {map_filename}")